@@ -0,0 +1,43 @@
+//! Interpreter throughput benchmark for standalone_miri (no std required, see `nocore_shim.rs`)
+//!
+//! A loop of field updates, calls, and enum matching. Run with `standalone_miri --stats` for the instruction rate,
+//! and with `--no-bytecode` as well to compare against direct MIR interpretation.
+#![no_core]
+#![feature(no_core,lang_items,start)]
+extern crate nocore_shim;
+use nocore_shim::*;
+
+struct Pair { a: u32, b: u32 }
+struct State { sum: u32, p: Pair, q: Pair }
+enum Step { Add(u32), Skip }
+
+fn bump(p: &mut Pair, v: u32) {
+    p.a = p.a + v;
+    p.b = p.b + 1;
+}
+fn pick(i: u32) -> Step {
+    if i % 3 == 0 { Step::Skip } else { Step::Add(i) }
+}
+
+#[start]
+fn main(_argc: isize, _argv: *const *const u8) -> isize {
+    let mut st = State { sum: 0, p: Pair { a: 0, b: 0 }, q: Pair { a: 0, b: 0 } };
+    let mut i = 0u32;
+    while i < 5000 {
+        let mut j = 0usize;
+        while j < 8 {
+            bump(&mut st.p, 1);
+            st.q.a = st.q.a + st.p.b % 5;
+            j = j + 1;
+        }
+        match pick(i) {
+            Step::Add(v) => { st.sum = st.sum + (v % 7); }
+            Step::Skip => {}
+        }
+        i = i + 1;
+    }
+    // 3333 `Add` steps (every `i` that isn't a multiple of 3), each adding `i % 7`
+    if st.p.b != 40000 { return 1; }
+    if st.sum != 9997 { return 2; }
+    0
+}
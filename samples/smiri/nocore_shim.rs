@@ -0,0 +1,59 @@
+//! Minimal `no_core` support crate for the standalone_miri samples that don't need std
+//!
+//! Provides just the lang items and operator impls that those samples use, so they can be run without first
+//! building the standard library. Also marked as the allocator crate (which executables require).
+#![no_core]
+#![feature(no_core,lang_items,allocator)]
+#![allocator]
+#![crate_type="lib"]
+#![crate_name="nocore_shim"]
+
+#[lang="sized"] pub trait Sized {}
+#[lang="copy"] pub trait Copy {}
+#[lang="drop"] pub trait Drop { fn drop(&mut self); }
+#[lang="clone"] pub trait Clone: Sized { fn clone(&self) -> Self; }
+#[lang="unsize"] pub trait Unsize<T: ?Sized> {}
+#[lang="coerce_unsized"] pub trait CoerceUnsized<T> {}
+#[lang="receiver"] pub trait Receiver {}
+#[lang="add"] pub trait Add<R=Self> { type Output; fn add(self, r: R) -> Self::Output; }
+#[lang="sub"] pub trait Sub<R=Self> { type Output; fn sub(self, r: R) -> Self::Output; }
+#[lang="mul"] pub trait Mul<R=Self> { type Output; fn mul(self, r: R) -> Self::Output; }
+#[lang="rem"] pub trait Rem<R=Self> { type Output; fn rem(self, r: R) -> Self::Output; }
+#[lang="not"] pub trait Not { type Output; fn not(self) -> Self::Output; }
+#[lang="eq"] pub trait PartialEq<R: ?Sized=Self> { fn eq(&self, r: &R) -> bool; fn ne(&self, r: &R) -> bool; }
+#[lang="partial_ord"] pub trait PartialOrd<R: ?Sized=Self>: PartialEq<R> { fn lt(&self, r: &R) -> bool; }
+#[lang="index"] pub trait Index<I> { type Output: ?Sized; fn index(&self, i: I) -> &Self::Output; }
+#[lang="index_mut"] pub trait IndexMut<I>: Index<I> { fn index_mut(&mut self, i: I) -> &mut Self::Output; }
+
+#[panic_implementation]
+pub fn panic_impl(_p: usize) -> u32 { 0 }
+
+impl Copy for bool {}
+impl Copy for u8 {}
+impl Copy for u32 {}
+impl Copy for usize {}
+impl<T: ?Sized> Copy for *const T {}
+impl<T: ?Sized> Copy for *mut T {}
+
+impl Not for bool { type Output = bool; fn not(self) -> bool { !self } }
+
+impl Add for u8 { type Output = u8; fn add(self, r: u8) -> u8 { self + r } }
+impl PartialEq for u8 { fn eq(&self, r: &u8) -> bool { *self == *r } fn ne(&self, r: &u8) -> bool { *self != *r } }
+impl PartialOrd for u8 { fn lt(&self, r: &u8) -> bool { *self < *r } }
+
+impl Add for u32 { type Output = u32; fn add(self, r: u32) -> u32 { self + r } }
+impl Sub for u32 { type Output = u32; fn sub(self, r: u32) -> u32 { self - r } }
+impl Mul for u32 { type Output = u32; fn mul(self, r: u32) -> u32 { self * r } }
+impl Rem for u32 { type Output = u32; fn rem(self, r: u32) -> u32 { self % r } }
+impl PartialEq for u32 { fn eq(&self, r: &u32) -> bool { *self == *r } fn ne(&self, r: &u32) -> bool { *self != *r } }
+impl PartialOrd for u32 { fn lt(&self, r: &u32) -> bool { *self < *r } }
+
+impl Add for usize { type Output = usize; fn add(self, r: usize) -> usize { self + r } }
+impl Mul for usize { type Output = usize; fn mul(self, r: usize) -> usize { self * r } }
+impl Rem for usize { type Output = usize; fn rem(self, r: usize) -> usize { self % r } }
+impl PartialEq for usize { fn eq(&self, r: &usize) -> bool { *self == *r } fn ne(&self, r: &usize) -> bool { *self != *r } }
+impl PartialOrd for usize { fn lt(&self, r: &usize) -> bool { *self < *r } }
+
+impl<T> Index<usize> for [T] { type Output = T; fn index(&self, i: usize) -> &T { &self[i] } }
+impl<T> IndexMut<usize> for [T] { fn index_mut(&mut self, i: usize) -> &mut T { &mut self[i] } }
+impl<T, const N: usize> Index<usize> for [T; N] { type Output = T; fn index(&self, i: usize) -> &T { &self[i] } }
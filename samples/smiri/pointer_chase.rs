@@ -0,0 +1,103 @@
+//! Pointer-chasing microbenchmark for standalone_miri (no std required, see `nocore_shim.rs`)
+//!
+//! Exercises allocations holding many pointers (a linked cycle of heap nodes, and a chained hash table of boxed
+//! values), where each pointer read needs a relocation lookup in the containing allocation. Run with
+//! `standalone_miri --stats` to get the instruction rate.
+#![no_core]
+#![feature(no_core,lang_items,start,intrinsics)]
+extern crate nocore_shim;
+use nocore_shim::*;
+
+extern "C" {
+    fn __rust_alloc(size: usize, align: usize) -> *mut u8;
+}
+extern "rust-intrinsic" {
+    fn size_of<T>() -> usize;
+    fn min_align_of<T>() -> usize;
+}
+fn alloc<T>() -> *mut T {
+    unsafe { __rust_alloc(size_of::<T>(), min_align_of::<T>()) as *mut T }
+}
+
+const COUNT: usize = 2048;
+const BUCKETS: usize = 64;
+
+struct Node {
+    value: u32,
+    next: *mut Node,
+}
+struct Entry {
+    key: u32,
+    value: *mut u32,
+    next: *mut Entry,
+}
+
+#[start]
+fn main(_argc: isize, _argv: *const *const u8) -> isize {
+    unsafe {
+        // A permutation cycle through heap nodes (`i -> (i * 1597 + 1) % COUNT` visits every node)
+        let nodes = alloc::<[*mut Node; COUNT]>();
+        let mut i = 0;
+        while i < COUNT {
+            let n = alloc::<Node>();
+            (*n).value = (i % 13) as u32;
+            (*nodes)[i] = n;
+            i = i + 1;
+        }
+        i = 0;
+        while i < COUNT {
+            (*(*nodes)[i]).next = (*nodes)[(i * 1597 + 1) % COUNT];
+            i = i + 1;
+        }
+        let mut n = (*nodes)[0];
+        let mut sum = 0u32;
+        let mut step = 0usize;
+        while step < 20000 {
+            sum = sum + (*n).value;
+            n = (*n).next;
+            step = step + 1;
+        }
+
+        // Boxed values behind a chained hash table
+        let buckets = alloc::<[*mut Entry; BUCKETS]>();
+        let mut lengths = [0usize; BUCKETS];
+        i = 0;
+        while i < BUCKETS {
+            (*buckets)[i] = 0 as *mut Entry;
+            i = i + 1;
+        }
+        let mut k = 0u32;
+        while k < 512 {
+            let b = (k % BUCKETS as u32) as usize;
+            let e = alloc::<Entry>();
+            let v = alloc::<u32>();
+            *v = k * 3;
+            (*e).key = k;
+            (*e).value = v;
+            (*e).next = (*buckets)[b];
+            (*buckets)[b] = e;
+            lengths[b] = lengths[b] + 1;
+            k = k + 1;
+        }
+        let mut map_sum = 0u32;
+        k = 0;
+        while k < 4096 {
+            let key = k % 512;
+            let b = (key % BUCKETS as u32) as usize;
+            let mut e = (*buckets)[b];
+            let mut j = 0;
+            while j < lengths[b] {
+                if (*e).key == key {
+                    map_sum = map_sum + *(*e).value;
+                }
+                e = (*e).next;
+                j = j + 1;
+            }
+            k = k + 1;
+        }
+
+        if sum != 119722 { return 1; }
+        if map_sum != 3139584 { return 2; }
+    }
+    0
+}
@@ -0,0 +1,54 @@
+//! Threading sample for standalone_miri (no std required, see `nocore_shim.rs`)
+//!
+//! Spawns several threads through the emulated `pthread_create` that contend on a shared pthread mutex, then joins
+//! them and checks both the shared total and a value returned through `pthread_join`.
+#![no_core]
+#![feature(no_core,lang_items,start)]
+extern crate nocore_shim;
+use nocore_shim::*;
+
+extern "C" {
+    fn pthread_create(t: *mut usize, attr: *const u8, f: extern "C" fn(*mut u8) -> *mut u8, arg: *mut u8) -> i32;
+    fn pthread_join(t: usize, rv: *mut *mut u8) -> i32;
+    fn pthread_mutex_lock(m: *mut u8) -> i32;
+    fn pthread_mutex_unlock(m: *mut u8) -> i32;
+}
+
+// Zero-initialised, the same as `PTHREAD_MUTEX_INITIALIZER` (oversized to fit any host's `pthread_mutex_t`)
+static mut MUTEX: [u8; 64] = [0; 64];
+static mut COUNTER: u32 = 0;
+
+extern "C" fn worker(arg: *mut u8) -> *mut u8 {
+    let mut i = 0u32;
+    while i < 3000 {
+        unsafe {
+            pthread_mutex_lock(&mut MUTEX as *mut [u8; 64] as *mut u8);
+            // NOTE: Split read and write, so that an unprotected update would be able to lose increments
+            let v = COUNTER;
+            COUNTER = v + 1;
+            pthread_mutex_unlock(&mut MUTEX as *mut [u8; 64] as *mut u8);
+        }
+        i = i + 1;
+    }
+    arg
+}
+
+#[start]
+fn main(_argc: isize, _argv: *const *const u8) -> isize {
+    let mut h1 = 0usize;
+    let mut h2 = 0usize;
+    let mut h3 = 0usize;
+    let mut r1 = 0 as *mut u8;
+    let mut tag = 7u8;
+    unsafe {
+        pthread_create(&mut h1, 0 as *const u8, worker, &mut tag as *mut u8);
+        pthread_create(&mut h2, 0 as *const u8, worker, 0 as *mut u8);
+        pthread_create(&mut h3, 0 as *const u8, worker, 0 as *mut u8);
+        pthread_join(h1, &mut r1);
+        pthread_join(h2, 0 as *mut *mut u8);
+        pthread_join(h3, 0 as *mut *mut u8);
+        if COUNTER != 9000 { return 1; }
+        if *r1 != 7 { return 2; }
+    }
+    0
+}
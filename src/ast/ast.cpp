@@ -115,7 +115,7 @@ std::string Attribute::parse_paren_string() const
 {
     TTStream    lex(this->m_span, ParseState(), this->data());
     lex.getTokenCheck(TOK_PAREN_OPEN);
-    auto rv = lex.getTokenCheck(TOK_STRING).str();
+    auto rv = lex.getTokenCheck(TOK_STRING).str_owned();
     lex.getTokenCheck(TOK_PAREN_CLOSE);
     return rv;
 }
@@ -29,6 +29,7 @@ class ExprNode
     Span    m_span;
 public:
     virtual ~ExprNode() = 0;
+    MEMORY_STATS_ALLOCATOR(AstExprNode)
 
     virtual void visit(NodeVisitor& nv) = 0;
     virtual void print(::std::ostream& os) const = 0;
@@ -190,6 +190,12 @@ Ordering ord(const ::std::map<T,U>& l, const ::std::map<T,U>& r)
 }
 #define ORD(a,b)    do { Ordering ORD_rv = ::ord(a,b); if( ORD_rv != ::OrdEqual )   return ORD_rv; } while(0)
 
+/// Mix `v` into the hash `h` (same mixing as boost's `hash_combine`)
+static inline void hash_combine(size_t& h, size_t v)
+{
+    h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+}
+
 
 template <typename T>
 struct LList
@@ -7,17 +7,34 @@
  */
 #include <debug_inner.hpp>
 #include <debug.hpp>
+#include <memory_stats.hpp>
 #include <set>
 #include <iostream>
 #include <iomanip>
 #include <common.hpp>   // FmtEscaped
 #include <cstring>	// strchr
+#include <cstdlib>  // malloc, atexit
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <new>
+#ifdef _WIN32
+# define NOGDI
+# include <Windows.h>
+# include <Psapi.h>
+# ifdef _MSC_VER
+#  pragma comment(lib, "psapi.lib")
+# endif
+#else
+# include <sys/resource.h>
+#endif
 
 // TODO: Inline debug filter/caching
 // - Cache messages for the current phase, clearing the cache (dropping) when various signatures match
 //  > Similar to the `log_get_last_function.py` script
 
-int g_debug_indent_level = 0;
+thread_local int g_debug_indent_level = 0;
 bool g_debug_enabled = true;
 ::std::string g_cur_phase;
 ::std::set< ::std::string>    g_debug_disable_map;
@@ -85,12 +102,169 @@ bool debug_enabled()
     return ::std::cout << g_cur_phase << "- " << RepeatLitStr { " ", indent } << function << ": ";
 }
 
+// --------------------------------------------------------------------
+// Phase statistics
+// --------------------------------------------------------------------
+namespace {
+    struct PhaseStats {
+        const char* name;
+        double  wall_s;
+        double  cpu_s;
+        uint64_t    peak_rss_kb;
+        uint64_t    peak_rss_delta_kb;
+        uint64_t    allocs;
+        uint64_t    alloc_bytes;
+    };
+    ::std::string   g_phase_stats_path;
+    ::std::vector<PhaseStats>   g_phase_stats;
+
+    // Allocation counters, only updated once phase stats are enabled (set before any worker threads start)
+    bool    g_count_allocations = false;
+    ::std::atomic<uint64_t> g_allocation_count { 0 };
+    ::std::atomic<uint64_t> g_allocation_bytes { 0 };
+
+    double get_wall_time() {
+        return ::std::chrono::duration<double>(::std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#ifdef _WIN32
+    double get_cpu_time() {
+        FILETIME    create, exit, kernel, user;
+        if( !GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user) )
+            return 0;
+        auto to_u64 = [](const FILETIME& ft) { return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime; };
+        // 100ns units
+        return static_cast<double>(to_u64(kernel) + to_u64(user)) / 1e7;
+    }
+    uint64_t get_peak_rss_kb() {
+        PROCESS_MEMORY_COUNTERS pmc;
+        if( !GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) )
+            return 0;
+        return pmc.PeakWorkingSetSize / 1024;
+    }
+#else
+    double get_cpu_time() {
+        struct rusage   ru;
+        if( getrusage(RUSAGE_SELF, &ru) != 0 )
+            return 0;
+        return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    }
+    uint64_t get_peak_rss_kb() {
+        struct rusage   ru;
+        if( getrusage(RUSAGE_SELF, &ru) != 0 )
+            return 0;
+# ifdef __APPLE__
+        return ru.ru_maxrss / 1024; // bytes
+# else
+        return ru.ru_maxrss;    // kilobytes
+# endif
+    }
+#endif
+
+    void write_phase_stats()
+    {
+        ::std::ofstream os(g_phase_stats_path);
+        if( !os.good() ) {
+            ::std::cerr << "Unable to open " << g_phase_stats_path << " for writing" << ::std::endl;
+            return ;
+        }
+        // NOTE: One phase per line, minicargo relies on this when aggregating
+        os << "{\n";
+        os << "\"phases\": [\n";
+        for(size_t i = 0; i < g_phase_stats.size(); i ++)
+        {
+            const auto& ps = g_phase_stats[i];
+            os << "{"
+                << "\"name\": \"" << FmtEscaped(ps.name) << "\", "
+                << ::std::fixed << ::std::setprecision(6)
+                << "\"wall_s\": " << ps.wall_s << ", "
+                << "\"cpu_s\": " << ps.cpu_s << ", "
+                << "\"peak_rss_kb\": " << ps.peak_rss_kb << ", "
+                << "\"peak_rss_delta_kb\": " << ps.peak_rss_delta_kb << ", "
+                << "\"allocs\": " << ps.allocs << ", "
+                << "\"alloc_bytes\": " << ps.alloc_bytes
+                << "}" << (i + 1 < g_phase_stats.size() ? "," : "") << "\n";
+        }
+        os << "],\n";
+        // One counter per line, summed by minicargo
+        os << "\"counters\": [\n";
+        for(const auto* c = DebugCounter::first(); c; c = c->next())
+        {
+            os << "{\"counter\": \"" << FmtEscaped(c->name()) << "\", \"value\": " << c->value() << "}"
+                << (c->next() ? "," : "") << "\n";
+        }
+        os << "]\n";
+        os << "}\n";
+    }
+
+    DebugCounter*   g_first_counter;
+}
+
+bool DebugCounter::s_enabled = false;
+DebugCounter::DebugCounter(const char* name):
+    m_name(name),
+    m_value(0),
+    m_next(g_first_counter)
+{
+    // NOTE: Only called during static initialisation, so no locking needed
+    g_first_counter = this;
+}
+const DebugCounter* DebugCounter::first()
+{
+    return g_first_counter;
+}
+
+void debug_enable_phase_stats(const ::std::string& path)
+{
+    if( g_phase_stats_path == "" ) {
+        ::std::atexit(write_phase_stats);
+    }
+    g_phase_stats_path = path;
+    g_count_allocations = true;
+    DebugCounter::s_enabled = true;
+}
+
+// Replacement global allocator, counts allocations for phase stats
+// - Array and sized/nothrow variants all forward to these by default
+void* operator new(size_t size)
+{
+    if( g_count_allocations ) {
+        g_allocation_count.fetch_add(1, ::std::memory_order_relaxed);
+        g_allocation_bytes.fetch_add(size, ::std::memory_order_relaxed);
+    }
+    if( size == 0 )
+        size = 1;
+    if( void* rv = ::std::malloc(size) )
+        return rv;
+    throw ::std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept
+{
+    ::std::free(ptr);
+}
+void operator delete(void* ptr, size_t ) noexcept
+{
+    ::std::free(ptr);
+}
+
 DebugTimedPhase::DebugTimedPhase(const char* name):
-    m_name(name)
+    m_name(name),
+    m_start_wall(0),
+    m_start_cpu(0),
+    m_start_peak_rss(0),
+    m_start_allocs(0),
+    m_start_alloc_bytes(0)
 {
     ::std::cout << m_name << ": V V V" << ::std::endl;
     g_cur_phase = m_name;
     g_debug_enabled = debug_enabled_update();
+    if( g_phase_stats_path != "" )
+    {
+        m_start_wall = get_wall_time();
+        m_start_cpu = get_cpu_time();
+        m_start_peak_rss = get_peak_rss_kb();
+        m_start_allocs = g_allocation_count;
+        m_start_alloc_bytes = g_allocation_bytes;
+    }
     m_start = clock();
 }
 DebugTimedPhase::~DebugTimedPhase()
@@ -99,6 +273,21 @@ DebugTimedPhase::~DebugTimedPhase()
     g_cur_phase = "";
     g_debug_enabled = debug_enabled_update();
 
+    if( g_phase_stats_path != "" )
+    {
+        auto peak_rss = get_peak_rss_kb();
+        g_phase_stats.push_back(PhaseStats {
+            m_name,
+            get_wall_time() - m_start_wall,
+            get_cpu_time() - m_start_cpu,
+            peak_rss,
+            peak_rss - m_start_peak_rss,
+            g_allocation_count - m_start_allocs,
+            g_allocation_bytes - m_start_alloc_bytes
+            });
+    }
+    memory_stats::snapshot(m_name);
+
     // TODO: Show wall time too?
     ::std::cout << "(" << ::std::fixed << ::std::setprecision(2) << static_cast<double>(end - m_start) / static_cast<double>(CLOCKS_PER_SEC) << " s) ";
     ::std::cout << m_name << ": DONE";
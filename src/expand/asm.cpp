@@ -74,7 +74,7 @@ public:
             {
                 //auto name = get_string(sp, lex);
                 GET_CHECK_TOK(tok, lex, TOK_STRING);
-                auto name = mv$(tok.str());
+                auto name = tok.str_owned();
 
                 GET_CHECK_TOK(tok, lex, TOK_PAREN_OPEN);
                 auto val = Parse_Expr0(lex);
@@ -105,7 +105,7 @@ public:
             while( lex.lookahead(0) == TOK_STRING )
             {
                 GET_CHECK_TOK(tok, lex, TOK_STRING);
-                auto name = mv$(tok.str());
+                auto name = tok.str_owned();
 
                 GET_CHECK_TOK(tok, lex, TOK_PAREN_OPEN);
                 auto val = Parse_Expr0(lex);
@@ -135,7 +135,7 @@ public:
             while( lex.lookahead(0) == TOK_STRING )
             {
                 GET_CHECK_TOK(tok, lex, TOK_STRING);
-                clobbers.push_back( mv$(tok.str()) );
+                clobbers.push_back( tok.str_owned() );
 
                 if( lex.lookahead(0) != TOK_COMMA )
                     break;
@@ -159,7 +159,7 @@ public:
             while( lex.lookahead(0) == TOK_STRING )
             {
                 GET_CHECK_TOK(tok, lex, TOK_STRING);
-                flags.push_back( mv$(tok.str()) );
+                flags.push_back( tok.str_owned() );
 
                 if( lex.lookahead(0) != TOK_COMMA )
                     break;
@@ -356,7 +356,7 @@ public:
                     reg_spec = AsmCommon::RegisterSpec::make_Class(get_reg_class(lex.point_span(), tok.ident().name));
                 }
                 else if( tok.type() == TOK_STRING ) {
-                    reg_spec = AsmCommon::RegisterSpec::make_Explicit(tok.str());
+                    reg_spec = AsmCommon::RegisterSpec::make_Explicit(tok.str_owned());
                 }
                 else {
                     throw ParseError::Unexpected(lex, tok, { TOK_IDENT, TOK_STRING });
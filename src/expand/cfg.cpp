@@ -73,7 +73,7 @@ namespace {
             }
             else {
                 GET_CHECK_TOK(tok, lex, TOK_STRING);
-                val = tok.str();
+                val = tok.str_owned();
             }
             // Equality
             auto its = g_cfg_values.equal_range(name.c_str());
@@ -414,14 +414,14 @@ class CHandler_Link:
                 auto key = lex.getTokenCheck(TOK_IDENT).ident().name;
                 if( key == "name" ) {
                     lex.getTokenCheck(TOK_EQUAL);
-                    auto v = lex.getTokenCheck(TOK_STRING).str();
+                    auto v = lex.getTokenCheck(TOK_STRING).str_owned();
                     if(v == "")
                         ERROR(sp, E0000, "Empty name on extern block");
                     link.lib_name = v;
                 }
                 else if( key == "kind" ) {
                     lex.getTokenCheck(TOK_EQUAL);
-                    auto v = lex.getTokenCheck(TOK_STRING).str();
+                    auto v = lex.getTokenCheck(TOK_STRING).str_owned();
                     if(v == "")
                         ERROR(sp, E0000, "Empty `kind` on extern block #[link]");
                     // TODO: save and use the kind
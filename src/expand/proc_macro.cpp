@@ -415,8 +415,8 @@ namespace {
                 case TOK_INTEGER:   m_pmi.send_int(tok.datatype(), tok.intval());   break;
                 case TOK_CHAR:      m_pmi.send_char(tok.intval().truncate_u64());  break;
                 case TOK_FLOAT:     m_pmi.send_float(tok.datatype(), tok.floatval());   break;
-                case TOK_STRING:        m_pmi.send_string(tok.str());       break;
-                case TOK_BYTESTRING:    m_pmi.send_bytestring(tok.str());   break;
+                case TOK_STRING:        m_pmi.send_string(tok.str_owned());       break;
+                case TOK_BYTESTRING:    m_pmi.send_bytestring(tok.str_owned());   break;
 
                 case TOK_HASH:      m_pmi.send_symbol("#"); break;
                 case TOK_UNDERSCORE:m_pmi.send_symbol("_"); break;
@@ -14,17 +14,17 @@ namespace {
 #include "hir.hpp"
 #include "main_bindings.hpp"
 #include <mir/mir.hpp>
+#include <mir/optimise_cache.hpp>
 #include <macro_rules/macro_rules.hpp>
 #include "serialise_lowlevel.hpp"
 #include <typeinfo>
+#include <fstream>
 
 namespace {
     bool des_debug_enabled() {
-        static unsigned enabled = 0;
-        if( enabled == 0 ) {
-            enabled = (getenv("MRUSTC_DEBUG_DESERIALISE") ? 2 : 1);
-        }
-        return enabled > 1;
+        // NOTE: Lazily-loaded MIR can be deserialised from multiple threads, so rely on thread-safe static init
+        static const bool enabled = getenv("MRUSTC_DEBUG_DESERIALISE") != nullptr;
+        return enabled;
     }
 }
 
@@ -35,6 +35,20 @@ namespace {
     {
     };
 
+    /// Deserialises MIR from a lazy region of a metadata file on first use
+    class LazyMirLoader:
+        public ::MIR::FunctionLoader
+    {
+        ::HIR::serialise::Reader    m_in;
+        RcString    m_crate_name;
+    public:
+        LazyMirLoader(const ::HIR::serialise::Reader& parent, size_t region_start, RcString crate_name):
+            m_in(parent, region_start),
+            m_crate_name(mv$(crate_name))
+        {}
+        ::MIR::Function* load() override;
+    };
+
     class HirDeserialiser
     {
         RcString m_crate_name;
@@ -44,6 +58,11 @@ namespace {
         HirDeserialiser(::HIR::serialise::Reader& in):
             m_in(in)
         {}
+        /// Deserialiser for a lazy region (the crate name is normally read from the start of the file)
+        HirDeserialiser(::HIR::serialise::Reader& in, RcString crate_name):
+            m_crate_name(mv$(crate_name)),
+            m_in(in)
+        {}
 
         RcString read_istring() { return m_in.read_istring(); }
         ::std::string read_string() { return m_in.read_string(); }
@@ -479,7 +498,7 @@ namespace {
             case ::Token::Data::TAG_None:
                 return ::Token::Data::make_None({});
             case ::Token::Data::TAG_String:
-                return ::Token::Data::make_String( m_in.read_string() );
+                return ::Token::Data::make_String( RcString(m_in.read_string()) );
             case ::Token::Data::TAG_Ident: {
                 auto hygine = deserialise_hygine();
                 auto name = m_in.read_istring();
@@ -512,7 +531,55 @@ namespace {
             rv.m_erased_types = deserialise_vec< ::HIR::TypeRef>();
             return rv;
         }
+        /// Counterpart to `HirSerialiser::serialise_lazy`, MIR is left in the file until first used
+        ::HIR::ExprPtr deserialise_exprptr_lazy()
+        {
+            ::HIR::ExprPtr  rv;
+            auto _ = m_in.open_object("HIR::ExprPtr");
+            if( m_in.read_bool() )
+            {
+                auto region_start = m_in.skip_lazy();
+                rv.m_mir = ::MIR::FunctionPointer(::std::unique_ptr<::MIR::FunctionLoader>(
+                    new LazyMirLoader(m_in, region_start, m_crate_name)
+                    ));
+            }
+            rv.m_erased_types = deserialise_vec< ::HIR::TypeRef>();
+            return rv;
+        }
         ::MIR::FunctionPointer deserialise_mir();
+        bool deserialise_mir_cache(uint64_t environment_hash, ::MIR::OptimiseCache& rv)
+        {
+            // NOTE: Not stored in `rv` until checked, as the caller saves the new cache with the current environment hash
+            if( m_in.read_u64() != environment_hash )
+            {
+                // Don't bother loading the rest, none of it can be used (and it may be from a different compiler version)
+                return false;
+            }
+            rv.environment_hash = environment_hash;
+            size_t n = m_in.read_count();
+            rv.entries.reserve(n);
+            rv.bodies.reserve(n);
+            for(size_t i = 0; i < n; i ++)
+            {
+                auto _ = m_in.open_object("MIR::OptimiseCache::Entry");
+                ::MIR::OptimiseCache::Entry e;
+                e.path = m_in.read_string();
+                e.original_hash = m_in.read_u64();
+                e.result_hash = m_in.read_u64();
+                e.interface_hash = m_in.read_u64();
+                size_t n_deps = m_in.read_count();
+                e.deps.reserve(n_deps);
+                for(size_t j = 0; j < n_deps; j ++)
+                {
+                    auto path = m_in.read_string();
+                    auto hash = m_in.read_u64();
+                    e.deps.push_back(::MIR::OptimiseCache::Dependency { mv$(path), hash });
+                }
+                rv.entries.push_back(mv$(e));
+                rv.bodies.push_back(deserialise_mir());
+            }
+            return true;
+        }
         ::MIR::BasicBlock deserialise_mir_basicblock();
         ::MIR::Statement deserialise_mir_statement();
         AsmCommon::Options deserialise_asm_options();
@@ -773,7 +840,7 @@ namespace {
             rv.m_args = deserialise_fcnargs();
             rv.m_variadic = m_in.read_bool();
             rv.m_return = deserialise_type();
-            rv.m_code = deserialise_exprptr();
+            rv.m_code = deserialise_exprptr_lazy();
             return rv;
         }
         ::HIR::Function::Markings deserialise_function_markings()
@@ -801,7 +868,7 @@ namespace {
             ::HIR::Constant rv;
             rv.m_params = deserialise_genericparams();
             rv.m_type = deserialise_type();
-            rv.m_value = deserialise_exprptr();
+            rv.m_value = deserialise_exprptr_lazy();
             if(m_in.read_bool())
             {
                 rv.m_value_res = deserialise_encodedliteral();
@@ -830,7 +897,7 @@ namespace {
             auto rv = ::HIR::Static(mv$(linkage), is_mut, mv$(ty), {});
             if(params.is_generic())
             {
-                rv.m_value = deserialise_exprptr();
+                rv.m_value = deserialise_exprptr_lazy();
             }
             rv.m_params = ::std::move(params);
             if(save_literal)
@@ -952,6 +1019,7 @@ namespace {
     template<> DEF_D( ::HIR::TypeRef, return d.deserialise_type(); )
     template<> DEF_D( ::HIR::SimplePath, return d.deserialise_simplepath(); )
     template<> DEF_D( ::HIR::GenericPath, return d.deserialise_genericpath(); )
+    template<> DEF_D( ::HIR::Path, return d.deserialise_path(); )
     template<> DEF_D( ::HIR::TraitPath, return d.deserialise_traitpath(); )
 
     template<> DEF_D( ::HIR::TypeParamDef, return d.deserialise_typaramdef(); )
@@ -1007,6 +1075,7 @@ namespace {
         rv.named = d.deserialise_pathmap< ::std::vector<::std::unique_ptr<T> > >();
         rv.non_named = d.deserialise_vec< ::std::unique_ptr<T> >();
         rv.generic = d.deserialise_vec< ::std::unique_ptr<T> >();
+        rv.rebuild_index();
         return rv;
         )
     template<> DEF_D( ::HIR::ExternLibrary, return d.deserialise_extlib(); )
@@ -1413,6 +1482,13 @@ namespace {
 
         return ::MIR::FunctionPointer( new ::MIR::Function(mv$(rv)) );
     }
+    ::MIR::Function* LazyMirLoader::load()
+    {
+        TRACE_FUNCTION_F(m_crate_name << " @" << m_in.get_pos());
+        HirDeserialiser s { m_in, m_crate_name };
+        auto rv = s.deserialise_mir();
+        return new ::MIR::Function(mv$(*rv));
+    }
     ::MIR::BasicBlock HirDeserialiser::deserialise_mir_basicblock()
     {
         TRACE_FUNCTION;
@@ -1672,6 +1748,7 @@ namespace {
 
         rv.m_ext_libs = deserialise_vec< ::HIR::ExternLibrary>();
         rv.m_link_paths = deserialise_vec< ::std::string>();
+        rv.m_shared_generics = deserialise_set< ::HIR::Path>();
 
         //rv.m_proc_macros = deserialise_vec< ::HIR::ProcMacro>();
 
@@ -1735,3 +1812,23 @@ RcString HIR_Deserialise_JustName(const ::std::string& filename)
     #endif
 }
 
+
+bool HIR_DeserialiseMirCache(const ::std::string& filename, uint64_t environment_hash, ::MIR::OptimiseCache& out_cache)
+{
+    if( !::std::ifstream(filename).good() )
+    {
+        return false;
+    }
+    try
+    {
+        ::HIR::serialise::Reader    in{ filename };
+        HirDeserialiser  s { in };
+        return s.deserialise_mir_cache(environment_hash, out_cache);
+    }
+    catch(const ::std::runtime_error& e)
+    {
+        // A stale/corrupt cache just means a full rebuild
+        ::std::cerr << "Unable to load MIR cache from " << filename << ": " << e.what() << ::std::endl;
+        return false;
+    }
+}
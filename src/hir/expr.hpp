@@ -60,6 +60,7 @@ public:
         m_span( mv$(sp) )
     {}
     virtual ~ExprNode();
+    MEMORY_STATS_ALLOCATOR(HirExprNode)
 
     const char* type_name() const;
 };
@@ -13,6 +13,7 @@
 
 #include <cassert>
 #include <unordered_map>
+#include <set>
 #include <vector>
 #include <memory>
 
@@ -29,6 +30,7 @@
 #include <hir/crate_ptr.hpp>
 #include <hir/encoded_literal.hpp>
 #include <hir/inherent_cache.hpp>
+#include <hir/impl_index.hpp>
 
 #define ABI_RUST    "Rust"
 #define CRATE_BUILTINS  "#builtins" // used for macro re-exports of builtins
@@ -625,32 +627,56 @@ public:
     {
         typedef ::std::vector<T> list_t;
         ::std::map<::HIR::SimplePath, list_t>   named;
-        list_t  non_named; // TODO: use a map of HIR::TypeRef::Data::Tag
+        list_t  non_named;
         list_t  generic;
+        /// Index of `non_named`, keyed on the type tag (NOT SERIALISED, rebuilt on load)
+        ImplTypeIndex   non_named_index;
 
-        const list_t* get_list_for_type(const ::HIR::TypeRef& ty) const {
-            static list_t empty;
+        /// Get the list of impls for a named type (nullptr if `ty` isn't named, or there are no impls)
+        const list_t* get_named_list(const ::HIR::TypeRef& ty) const {
             if( const auto* p = ty.get_sort_path() ) {
                 auto it = named.find(*p);
                 if( it != named.end() )
                     return &it->second;
-                else
-                    return nullptr;
+            }
+            return nullptr;
+        }
+        /// Visit the impls in `named`/`non_named` that could apply to `ty` (excluding `generic`), stopping when `cb` returns true
+        template<typename Cb>
+        bool iterate_for_type(const ::HIR::TypeRef& ty, t_cb_resolve_type ty_res, Cb cb) const {
+            if( ty.get_sort_path() ) {
+                if( const auto* l = get_named_list(ty) ) {
+                    for(const auto& i : *l)
+                        if( cb(i) )
+                            return true;
+                }
+                return false;
             }
             else {
-                // TODO: Sort these by type tag, use the `Primitive` group if `ty` is Infer
-                return &non_named;
+                return non_named_index.visit(ty, ty_res, non_named.size(), [&](unsigned idx){ return cb(non_named[idx]); });
             }
         }
-        list_t& get_list_for_type_mut(const ::HIR::TypeRef& ty) {
+
+        /// Add an impl to the named or non-named list (based on the sort path of its type), returning the stored entry
+        T& push(T v) {
+            const auto& ty = v->m_type;
             if( const auto* p = ty.get_sort_path() ) {
-                return named[*p];
+                auto& l = named[*p];
+                l.push_back(mv$(v));
+                return l.back();
             }
             else {
-                // TODO: Ivars match with core types
-                return non_named;
+                non_named_index.insert(ty, static_cast<unsigned>(non_named.size()));
+                non_named.push_back(mv$(v));
+                return non_named.back();
             }
         }
+        /// Re-create `non_named_index` after `non_named` has been replaced or modified
+        void rebuild_index() {
+            non_named_index.clear();
+            for(size_t i = 0; i < non_named.size(); i ++)
+                non_named_index.insert(non_named[i]->m_type, static_cast<unsigned>(i));
+        }
     };
     /// Impl blocks on just a type, split into three groups
     // - Named type (sorted on the path)
@@ -685,6 +711,8 @@ public:
     ::std::vector<ExternLibrary>    m_ext_libs;
     /// Extra paths for the linker
     ::std::vector<::std::string>    m_link_paths;
+    /// Monomorphised generic functions that this crate's codegen emits for use by downstream crates (`-Z share-generics`)
+    ::std::set<::HIR::Path> m_shared_generics;
 
     /// Method called to populate runtime state after deserialisation
     /// See hir/crate_post_load.cpp
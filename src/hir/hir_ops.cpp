@@ -1050,6 +1050,14 @@ namespace
         }
         return false;
     }
+    /// Search the impls in `named`/`non_named` that could apply to `type` (using the sort path or type index)
+    template<typename ImplType, typename T>
+    bool find_impls_group(const ::HIR::Crate::ImplGroup<T>& ig, const ::HIR::TypeRef& type, ::HIR::t_cb_resolve_type ty_res, ::std::function<bool(const ImplType&)> callback)
+    {
+        return ig.iterate_for_type(type, ty_res, [&](const T& impl) {
+            return impl->matches_type(type, ty_res) && callback(*impl);
+            });
+    }
 }
 namespace
 {
@@ -1062,11 +1070,8 @@ namespace
         if( it != crate.m_trait_impls.end() )
         {
             // 1. Find named impls (associated with named types)
-            if( const auto* impl_list = it->second.get_list_for_type(type) )
-            {
-                if( find_impls_list(*impl_list, type, ty_res, callback) )
-                    return true;
-            }
+            if( find_impls_group(it->second, type, ty_res, callback) )
+                return true;
             // - If the type is an ivar, search all types
             if( type.data().is_Infer() && !type.data().as_Infer().is_lit() )
             {
@@ -1147,11 +1152,8 @@ bool ::HIR::Crate::find_trait_impls(const ::HIR::SimplePath& trait, const ::HIR:
         if( it != this->m_all_trait_impls.end() )
         {
             // 1. Find named impls (associated with named types)
-            if( const auto* impl_list = it->second.get_list_for_type(type) )
-            {
-                if( find_impls_list(*impl_list, type, ty_res, callback) )
-                    return true;
-            }
+            if( find_impls_group(it->second, type, ty_res, callback) )
+                return true;
             // - If the type is an ivar, search all types
             if( type.data().is_Infer() && !type.data().as_Infer().is_lit() )
             {
@@ -1196,11 +1198,8 @@ namespace
         if( it != crate.m_marker_impls.end() )
         {
             // 1. Find named impls (associated with named types)
-            if( const auto* impl_list = it->second.get_list_for_type(type) )
-            {
-                if( find_impls_list(*impl_list, type, ty_res, callback) )
-                    return true;
-            }
+            if( find_impls_group(it->second, type, ty_res, callback) )
+                return true;
 
             // 2. Search fully generic list.
             if( find_impls_list(it->second.generic, type, ty_res, callback) )
@@ -1217,11 +1216,8 @@ bool ::HIR::Crate::find_auto_trait_impls(const ::HIR::SimplePath& trait, const :
         if( it != this->m_all_marker_impls.end() )
         {
             // 1. Find named impls (associated with named types)
-            if( const auto* impl_list = it->second.get_list_for_type(type) )
-            {
-                if( find_impls_list(*impl_list, type, ty_res, callback) )
-                    return true;
-            }
+            if( find_impls_group(it->second, type, ty_res, callback) )
+                return true;
 
             // 2. Search fully generic list.
             if( find_impls_list(it->second.generic, type, ty_res, callback) )
@@ -1249,11 +1245,8 @@ namespace
     bool find_type_impls_int(const ::HIR::Crate& crate, const ::HIR::TypeRef& type, ::HIR::t_cb_resolve_type ty_res, ::std::function<bool(const ::HIR::TypeImpl&)> callback)
     {
         // 1. Find named impls (associated with named types)
-        if( const auto* impl_list = crate.m_type_impls.get_list_for_type(type) )
-        {
-            if( find_impls_list(*impl_list, type, ty_res, callback) )
-                return true;
-        }
+        if( find_impls_group(crate.m_type_impls, type, ty_res, callback) )
+            return true;
 
         // 2. Search fully generic list?
         if( find_impls_list(crate.m_type_impls.generic, type, ty_res, callback) )
@@ -1266,11 +1259,8 @@ bool ::HIR::Crate::find_type_impls(const ::HIR::TypeRef& type, t_cb_resolve_type
 {
     if( m_all_trait_impls.size() > 0 ) {
         // 1. Find named impls (associated with named types)
-        if( const auto* impl_list = this->m_all_type_impls.get_list_for_type(type) )
-        {
-            if( find_impls_list(*impl_list, type, ty_res, callback) )
-                return true;
-        }
+        if( find_impls_group(this->m_all_type_impls, type, ty_res, callback) )
+            return true;
 
         // 2. Search fully generic list?
         if( find_impls_list(this->m_all_type_impls.generic, type, ty_res, callback) )
@@ -1339,6 +1329,8 @@ const ::MIR::Function* HIR::Crate::get_or_gen_mir(const ::HIR::ItemPath& ip, con
                 ms.m_item_generics = ep.m_state->m_item_generics;
                 ms.m_traits = ep.m_state->m_traits;
                 ms.m_mod_paths.push_back(ep.m_state->m_mod_path);
+                if( Typecheck_ProfileEnabled() )
+                    ms.m_item_name = FMT(ip);
                 Typecheck_Code(ms, const_cast<::HIR::Function::args_t&>(args), ret_ty, ep_mut);
                 //Debug_SetStagePre("Expand HIR Annotate");
                 HIR_Expand_AnnotateUsage_Expr(*this, ep_mut);
@@ -0,0 +1,171 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir/impl_index.cpp
+ * - Index of impls on types without a sort path (primitives, references, slices, ...)
+ */
+#include "impl_index.hpp"
+
+namespace {
+    bool s_index_enabled = true;
+
+    /// Get the inner type used for the second level of the index (nullptr if the tag isn't split further)
+    const ::HIR::TypeRef* get_indexed_inner(const ::HIR::TypeData& td)
+    {
+        TU_MATCH_HDRA( (td), {)
+        default:
+            return nullptr;
+        TU_ARMA(Borrow, e)  return &e.inner;
+        TU_ARMA(Pointer, e) return &e.inner;
+        TU_ARMA(Slice, e)   return &e.inner;
+        TU_ARMA(Array, e)   return &e.inner;
+        }
+        throw "";
+    }
+
+    /// Merge-visit two ascending position lists
+    bool visit_merged(const ::std::vector<unsigned>& a, const ::std::vector<unsigned>& b, const ::std::function<bool(unsigned)>& cb)
+    {
+        auto it_a = a.begin();
+        auto it_b = b.begin();
+        while( it_a != a.end() || it_b != b.end() )
+        {
+            unsigned idx;
+            if( it_b == b.end() || (it_a != a.end() && *it_a < *it_b) )
+                idx = *it_a++;
+            else
+                idx = *it_b++;
+            if( cb(idx) )
+                return true;
+        }
+        return false;
+    }
+    bool visit_list(const ::std::vector<unsigned>& l, const ::std::function<bool(unsigned)>& cb)
+    {
+        for(unsigned idx : l)
+        {
+            if( cb(idx) )
+                return true;
+        }
+        return false;
+    }
+}
+
+void HIR::ImplTypeIndex::set_enabled(bool enabled)
+{
+    s_index_enabled = enabled;
+}
+
+void HIR::ImplTypeIndex::insert(const ::HIR::TypeRef& impl_ty, unsigned idx)
+{
+    auto& grp = m_groups[impl_ty.data().tag()];
+    grp.all.push_back(idx);
+
+    if( const auto* ct = impl_ty.data().opt_Primitive() )
+    {
+        grp.by_core[*ct].push_back(idx);
+    }
+    else if( const auto* inner = get_indexed_inner(impl_ty.data()) )
+    {
+        const auto& itd = inner->data();
+        if( const auto* ct = itd.opt_Primitive() )
+        {
+            grp.by_core[*ct].push_back(idx);
+        }
+        else if( const auto* p = inner->get_sort_path() )
+        {
+            grp.by_path[*p].push_back(idx);
+        }
+        // Generics (and unexpanded associated types) could match anything
+        else if( itd.is_Generic() || itd.is_Path() || itd.is_Infer() || itd.is_ErasedType() )
+        {
+            grp.wildcard.push_back(idx);
+        }
+        else
+        {
+            grp.by_tag[itd.tag()].push_back(idx);
+        }
+    }
+    else
+    {
+        // Not split any further, will only be found via `all`
+    }
+}
+
+bool HIR::ImplTypeIndex::visit(const ::HIR::TypeRef& ty_in, t_cb_resolve_type ty_res, size_t list_size, ::std::function<bool(unsigned)> cb) const
+{
+    static const ::std::vector<unsigned> empty;
+    // NOTE: Mirrors `matches_type_int` - which only uses `ty_res` on ivars
+    const auto& ty = ty_in.data().is_Infer() ? ty_res(ty_in) : ty_in;
+
+    bool search_all = !s_index_enabled;
+    if( const auto* e = ty.data().opt_Infer() )
+    {
+        // Integer/float literals can only be primitives, anything else could be any type
+        if( e->is_lit() ) {
+            auto it = m_groups.find(::HIR::TypeData::TAG_Primitive);
+            return it != m_groups.end() && visit_list(it->second.all, cb);
+        }
+        search_all = true;
+    }
+    // Generics, unknown paths, and erased types are left to the matching code
+    else if( ty.data().is_Generic() || ty.data().is_Path() || ty.data().is_ErasedType() || ty.data().is_Diverge() )
+    {
+        search_all = true;
+    }
+
+    if( search_all )
+    {
+        for(size_t i = 0; i < list_size; i ++)
+        {
+            if( cb(static_cast<unsigned>(i)) )
+                return true;
+        }
+        return false;
+    }
+
+    auto it = m_groups.find(ty.data().tag());
+    if( it == m_groups.end() )
+        return false;
+    const auto& grp = it->second;
+
+    if( const auto* ct = ty.data().opt_Primitive() )
+    {
+        auto it_c = grp.by_core.find(*ct);
+        return it_c != grp.by_core.end() && visit_list(it_c->second, cb);
+    }
+    else if( const auto* inner_in = get_indexed_inner(ty.data()) )
+    {
+        const auto& inner = inner_in->data().is_Infer() ? ty_res(*inner_in) : *inner_in;
+        const auto& itd = inner.data();
+        const ::std::vector<unsigned>* specific = &empty;
+        if( const auto* ct = itd.opt_Primitive() )
+        {
+            auto it_c = grp.by_core.find(*ct);
+            if( it_c != grp.by_core.end() )
+                specific = &it_c->second;
+        }
+        else if( const auto* p = inner.get_sort_path() )
+        {
+            auto it_p = grp.by_path.find(*p);
+            if( it_p != grp.by_path.end() )
+                specific = &it_p->second;
+        }
+        else if( itd.is_Generic() || itd.is_Path() || itd.is_Infer() || itd.is_ErasedType() || itd.is_Diverge() )
+        {
+            return visit_list(grp.all, cb);
+        }
+        else
+        {
+            auto it_t = grp.by_tag.find(itd.tag());
+            if( it_t != grp.by_tag.end() )
+                specific = &it_t->second;
+        }
+        return visit_merged(*specific, grp.wildcard, cb);
+    }
+    else
+    {
+        return visit_list(grp.all, cb);
+    }
+}
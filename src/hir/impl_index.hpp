@@ -0,0 +1,53 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * hir/impl_index.hpp
+ * - Index of impls on types without a sort path (primitives, references, slices, ...)
+ */
+#pragma once
+#include "type.hpp"
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace HIR {
+
+/// Index into a list of impls that are on un-named types (the `non_named` list of `HIR::Crate::ImplGroup`)
+///
+/// Impls are grouped on the outer type tag, then (for primitives, and for references/pointers/slices/arrays) on the
+/// core type, sort path or tag of the inner type. Impls whose inner type could match anything (e.g. `&T`) are kept
+/// in a wildcard list that is visited alongside the specific group.
+///
+/// Entries are positions in the indexed list, so lookups visit candidates in the same order as a linear scan.
+class ImplTypeIndex
+{
+    struct TagGroup
+    {
+        /// Every impl with this outer tag
+        ::std::vector<unsigned> all;
+        /// Impls where the inner type could match any type
+        ::std::vector<unsigned> wildcard;
+        ::std::map<::HIR::CoreType, ::std::vector<unsigned>>    by_core;
+        ::std::map<::HIR::SimplePath, ::std::vector<unsigned>>  by_path;
+        /// Inner types that aren't a primitive or a named type, keyed on `TypeData::Tag`
+        ::std::map<unsigned, ::std::vector<unsigned>>   by_tag;
+    };
+    ::std::map<unsigned, TagGroup>  m_groups;
+
+public:
+    /// Disable use of the index (lookups scan the entire list), used for benchmarking and debugging
+    static void set_enabled(bool enabled);
+
+    void clear() {
+        m_groups.clear();
+    }
+    /// Record that the impl at position `idx` is on type `impl_ty`
+    void insert(const ::HIR::TypeRef& impl_ty, unsigned idx);
+
+    /// Visit the positions (in ascending order, out of `list_size` total) of impls that could match `ty`
+    /// - Returns true if `cb` returned true (stopping the visit)
+    bool visit(const ::HIR::TypeRef& ty, t_cb_resolve_type ty_res, size_t list_size, ::std::function<bool(unsigned)> cb) const;
+};
+
+}
@@ -23,10 +23,11 @@ void HIR::InherentCache::Lowest::insert(const Span& sp, const HIR::TypeImpl& imp
     }
     else
     {
+        this->non_named_index.insert(type, static_cast<unsigned>(this->non_named.size()));
         this->non_named.push_back(&impl);
     }
 }
-void HIR::InherentCache::Lowest::iterate(const HIR::TypeRef& type, InherentCache::inner_callback_t& cb) const
+void HIR::InherentCache::Lowest::iterate(const HIR::TypeRef& type, t_cb_resolve_type ty_res, InherentCache::inner_callback_t& cb) const
 {
     auto visit = [&](const list_t& l) {
         for(const HIR::TypeImpl* impl_ptr : l)
@@ -51,7 +52,10 @@ void HIR::InherentCache::Lowest::iterate(const HIR::TypeRef& type, InherentCache
     }
     else
     {
-        visit(this->non_named);
+        this->non_named_index.visit(type, ty_res, this->non_named.size(), [&](unsigned idx) {
+            cb(type, *this->non_named[idx]);
+            return false;
+            });
     }
 }
 
@@ -113,7 +117,7 @@ void HIR::InherentCache::Inner::insert(const Span& sp, const HIR::TypeRef& cur_t
 void HIR::InherentCache::Inner::find(const Span& sp, const HIR::TypeRef& cur_ty_act, t_cb_resolve_type ty_res, InherentCache::inner_callback_t& cb) const
 {
     const auto& cur_ty = ty_res(cur_ty_act);
-    m_byvalue.iterate(cur_ty, cb);
+    m_byvalue.iterate(cur_ty, ty_res, cb);
 
     const Inner* inner = nullptr;
     const HIR::TypeRef* inner_ty = nullptr;
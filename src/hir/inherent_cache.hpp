@@ -8,6 +8,7 @@
 #pragma once
 #include "../include/range_vec_map.hpp"
 #include "type_ref.hpp"
+#include "impl_index.hpp"
 #include <map>
 
 namespace HIR {
@@ -26,11 +27,12 @@ private:
 		// Same as HIR::Crate::ImplGroup
 		typedef ::std::vector<const HIR::TypeImpl*>	list_t;
 		::std::map<::HIR::SimplePath, list_t>   named;
-		list_t  non_named; // TODO: use a map of HIR::TypeRef::Data::Tag
+		list_t  non_named;
 		list_t  generic;
+		ImplTypeIndex	non_named_index;
 
 		void insert(const Span& sp, const HIR::TypeImpl& impl);
-		void iterate(const HIR::TypeRef& ty, inner_callback_t& cb) const;
+		void iterate(const HIR::TypeRef& ty, t_cb_resolve_type ty_res, inner_callback_t& cb) const;
 	};
 
 	/// <summary>
@@ -10,11 +10,25 @@
 #include "crate_ptr.hpp"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <set>
+#include <cstdint>
 
 class RcString;
 namespace AST {
     class Crate;
 }
+namespace HIR {
+    struct SimplePath;
+    class TypeRef;
+    class GenericParams;
+    class ExprPtr;
+    struct Pattern;
+}
+namespace MIR {
+    class Function;
+    struct OptimiseCache;
+}
 
 extern void HIR_Dump(::std::ostream& sink, const ::HIR::Crate& crate);
 extern ::HIR::CratePtr  LowerHIR_FromAST(::AST::Crate crate);
@@ -22,3 +36,23 @@ extern void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& cra
 
 extern ::HIR::CratePtr HIR_Deserialise(const ::std::string& filename);
 extern RcString HIR_Deserialise_JustName(const ::std::string& filename);
+
+/// Hash of the serialised form of a MIR body, optionally collecting the paths it refers to
+extern uint64_t HIR_HashMir(const ::MIR::Function& fcn, ::std::set<::HIR::SimplePath>* out_paths=nullptr);
+/// Hash of a body's signature (generics and argument/return types), collecting the paths it refers to
+extern uint64_t HIR_HashSignature(const ::HIR::GenericParams* impl_generics, const ::HIR::GenericParams* item_generics, const ::std::vector<const ::HIR::TypeRef*>& types, ::std::set<::HIR::SimplePath>* out_paths);
+/// Hash of the item at `path` (or the enum/trait containing it), and the impls on it if it's a type
+/// - Bodies are only included for extern functions (local bodies are tracked by the caller)
+/// - For structs/enums/unions/aliases, the paths referenced by the definition (e.g. field types) are added to `out_paths`
+/// - Returns false if the path doesn't resolve to an item
+/// - `interface_only` leaves out what typecheck and lowering fill in, so the hash is the same before and after them
+extern bool HIR_HashItem(const ::HIR::Crate& crate, const ::HIR::SimplePath& path, uint64_t& out_hash, ::std::set<::HIR::SimplePath>* out_paths, bool interface_only=false);
+/// Hash of all impls that aren't on a named type (on primitives, or generic), from this crate and all extern crates
+extern uint64_t HIR_HashUnnamedImpls(const ::HIR::Crate& crate, bool interface_only=false);
+/// Hash of a function body from before typecheck (with its argument patterns and the traits in scope), collecting the
+/// paths it names
+/// - Returns false if the body contains something that isn't hashed (closures, generators, inline assembly)
+extern bool HIR_HashExpr(const ::HIR::ExprPtr& expr, const ::std::vector<const ::HIR::Pattern*>& args, uint64_t& out_hash, ::std::set<::HIR::SimplePath>* out_paths);
+extern void HIR_SerialiseMirCache(const ::std::string& filename, const ::MIR::OptimiseCache& cache, const ::std::vector<const ::MIR::Function*>& bodies);
+/// Returns false if the cache doesn't exist, can't be loaded, or was saved with a different environment hash
+extern bool HIR_DeserialiseMirCache(const ::std::string& filename, uint64_t environment_hash, ::MIR::OptimiseCache& out_cache);
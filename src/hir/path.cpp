@@ -112,6 +112,13 @@ namespace HIR {
 {
     return SimplePath( m_crate_name, m_components );
 }
+size_t HIR::SimplePath::hash() const
+{
+    size_t  rv = ::std::hash<RcString>()(m_crate_name);
+    for(const auto& c : m_components)
+        hash_combine(rv, ::std::hash<RcString>()(c));
+    return rv;
+}
 
 ::HIR::PathParams::PathParams()
 {
@@ -129,6 +136,15 @@ namespace HIR {
         rv.m_values.push_back( t.clone() );
     return rv;
 }
+size_t HIR::PathParams::hash() const
+{
+    size_t  rv = m_types.size();
+    for(const auto& t : m_types)
+        hash_combine(rv, t.hash());
+    // NOTE: Values aren't hashed, just counted
+    hash_combine(rv, m_values.size());
+    return rv;
+}
 bool ::HIR::PathParams::operator==(const ::HIR::PathParams& x) const
 {
     if( m_types.size() != x.m_types.size() )
@@ -162,6 +178,12 @@ bool ::HIR::PathParams::operator==(const ::HIR::PathParams& x) const
 {
     return GenericPath(m_path.clone(), m_params.clone());
 }
+size_t HIR::GenericPath::hash() const
+{
+    size_t  rv = m_path.hash();
+    hash_combine(rv, m_params.hash());
+    return rv;
+}
 bool ::HIR::GenericPath::operator==(const GenericPath& x) const
 {
     if( m_path != x.m_path )
@@ -429,4 +451,30 @@ Ordering HIR::Path::ord(const ::HIR::Path& x) const
 bool ::HIR::Path::operator==(const Path& x) const {
     return this->ord(x) == ::OrdEqual;
 }
+size_t HIR::Path::hash() const
+{
+    size_t  rv = static_cast<size_t>(m_data.tag());
+    TU_MATCH_HDRA( (m_data), {)
+    TU_ARMA(Generic, e) {
+        hash_combine(rv, e.hash());
+        }
+    TU_ARMA(UfcsInherent, e) {
+        hash_combine(rv, e.type.hash());
+        hash_combine(rv, ::std::hash<RcString>()(e.item));
+        hash_combine(rv, e.params.hash());
+        }
+    TU_ARMA(UfcsKnown, e) {
+        hash_combine(rv, e.type.hash());
+        hash_combine(rv, e.trait.hash());
+        hash_combine(rv, ::std::hash<RcString>()(e.item));
+        hash_combine(rv, e.params.hash());
+        }
+    TU_ARMA(UfcsUnknown, e) {
+        hash_combine(rv, e.type.hash());
+        hash_combine(rv, ::std::hash<RcString>()(e.item));
+        hash_combine(rv, e.params.hash());
+        }
+    }
+    return rv;
+}
 
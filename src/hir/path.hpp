@@ -118,6 +118,7 @@ struct SimplePath
     bool operator<(const SimplePath& x) const {
         return ord(x) == OrdLess;
     }
+    size_t hash() const;
     Ordering ord(const SimplePath& x) const {
         auto rv = ::ord(m_crate_name, x.m_crate_name);
         if(rv != OrdEqual)  return rv;
@@ -153,6 +154,7 @@ struct PathParams
 
     bool operator==(const PathParams& x) const;
     bool operator!=(const PathParams& x) const { return !(*this == x); }
+    size_t hash() const;
     bool operator<(const PathParams& x) const { return ord(x) == OrdLess; }
     Ordering ord(const PathParams& x) const {
         if(auto cmp = ::ord(m_types, x.m_types)) return cmp;
@@ -179,6 +181,7 @@ public:
 
     bool operator==(const GenericPath& x) const;
     bool operator!=(const GenericPath& x) const { return !(*this == x); }
+    size_t hash() const;
     bool operator<(const GenericPath& x) const { return ord(x) == OrdLess; }
 
     Ordering ord(const GenericPath& x) const {
@@ -310,6 +313,8 @@ public:
 
     bool operator==(const Path& x) const;
     bool operator!=(const Path& x) const { return !(*this == x); }
+    /// Structural hash, consistent with `==` (for use in unordered containers)
+    size_t hash() const;
     bool operator<(const Path& x) const { return ord(x) == OrdLess; }
 
     friend ::std::ostream& operator<<(::std::ostream& os, const Path& x);
@@ -317,5 +322,12 @@ public:
 
 }   // namespace HIR
 
+namespace std {
+    template<> struct hash<::HIR::Path>
+    {
+        size_t operator()(const ::HIR::Path& p) const { return p.hash(); }
+    };
+}
+
 #endif
 
@@ -9,7 +9,11 @@
 #include "main_bindings.hpp"
 #include <macro_rules/macro_rules.hpp>
 #include <mir/mir.hpp>
+#include <mir/optimise_cache.hpp>
 #include "serialise_lowlevel.hpp"
+#include "expr.hpp"
+#include "expr_state.hpp"
+#include <algorithm>
 
 //namespace {
     class HirSerialiser
@@ -17,6 +21,15 @@
         ::std::map<HIR::TypeRef, size_t>    m_types;
         ::HIR::serialise::Writer&   m_out;
     public:
+        /// If set, all paths written are also added to this set (used to find the dependencies of an item)
+        ::std::set<::HIR::SimplePath>*  m_paths = nullptr;
+        /// Leave out state that typecheck and later passes fill in (bodies, vtable layouts), so that an item hashes the
+        /// same before typecheck as after MIR lowering
+        bool    m_interface_only = false;
+        /// Hashing HIR from before typecheck, where paths and constants may not be resolved yet
+        bool    m_pre_typecheck = false;
+        /// Cleared if `serialise_expr_tree` met an expression it doesn't hash
+        bool    m_expr_hash_ok = true;
         HirSerialiser(::HIR::serialise::Writer& out):
             m_out( out )
         {}
@@ -191,7 +204,10 @@
             m_out.write_tag( ty.data().tag() );
             TU_MATCH_HDRA( (ty.data()), {)
             TU_ARMA(Infer, e) {
-                // BAAD
+                // BAAD (except when hashing pre-typecheck expressions)
+                if( m_pre_typecheck ) {
+                    m_out.write_tag( static_cast<int>(e.ty_class) );
+                }
                 }
             TU_ARMA(Diverge, e) {
                 }
@@ -254,6 +270,9 @@
         void serialise_simplepath(const ::HIR::SimplePath& path)
         {
             TRACE_FUNCTION_F(path);
+            if( m_paths ) {
+                m_paths->insert(path);
+            }
             m_out.write_string(path.m_crate_name);
             serialise_vec(path.m_components);
         }
@@ -311,7 +330,11 @@
                 ),
             (UfcsUnknown,
                 DEBUG("-- UfcsUnknown - " << path);
-                assert(!"Unexpected UfcsUnknown");
+                assert(m_pre_typecheck && "Unexpected UfcsUnknown");
+                m_out.write_tag(3);
+                serialise_type(e.type);
+                m_out.write_string(e.item);
+                serialise_pathparams(e.params);
                 )
             )
         }
@@ -404,6 +427,7 @@
             }
             serialise_vec(crate.m_ext_libs);
             serialise_vec(crate.m_link_paths);
+            serialise(crate.m_shared_generics);
         }
         void serialise(const ::HIR::ExternLibrary& lib)
         {
@@ -508,6 +532,9 @@
         void serialise(const ::HIR::TraitPath& p) {
             serialise_traitpath(p);
         }
+        void serialise(const ::HIR::Path& p) {
+            serialise_path(p);
+        }
         void serialise(const ::std::string& v) {
             m_out.write_string(v);
         }
@@ -617,7 +644,7 @@
             TU_ARM(td, None, _e) {
                 } break;
             TU_ARM(td, String, e) {
-                m_out.write_string(e);
+                m_out.write_string(e.size(), e.c_str());
                 } break;
             TU_ARM(td, Ident, e) {
                 serialise(e.hygiene);
@@ -661,8 +688,13 @@
             TU_ARMA(Infer, e) {
                 }
             TU_ARMA(Unevaluated, e) {
-                ASSERT_BUG(e->span(), e->m_mir, "Encountered non-translated value in ConstGeneric");
-                serialise(*e);
+                if( m_pre_typecheck && !e->m_mir ) {
+                    serialise_expr_tree(*e);
+                }
+                else {
+                    ASSERT_BUG(e->span(), e->m_mir, "Encountered non-translated value in ConstGeneric");
+                    serialise(*e);
+                }
                 }
             TU_ARMA(Generic, e)
                 serialise(e);
@@ -671,15 +703,38 @@
             }
         }
 
+        /// Hash an expression tree (only valid when `m_pre_typecheck` is set, defined after `ExprHasher`)
+        void serialise_expr_tree(const ::HIR::ExprPtr& exp);
         void serialise(const ::HIR::ExprPtr& exp, bool save_mir=true)
         {
             auto _ = m_out.open_object("HIR::ExprPtr");
-            save_mir &= static_cast<bool>(exp.m_mir);
+            save_mir &= static_cast<bool>(exp.m_mir) && !m_interface_only;
             m_out.write_bool( save_mir );
             if( save_mir ) {
                 serialise(*exp.m_mir);
             }
-            serialise_vec( exp.m_erased_types );
+            if( !m_interface_only ) {
+                serialise_vec( exp.m_erased_types );
+            }
+        }
+        /// Serialise an expression with the MIR in a lazily-loaded region (read with `deserialise_exprptr_lazy`)
+        void serialise_lazy(const ::HIR::ExprPtr& exp, bool save_mir=true)
+        {
+            auto _ = m_out.open_object("HIR::ExprPtr");
+            save_mir &= static_cast<bool>(exp.m_mir) && !m_interface_only;
+            m_out.write_bool( save_mir );
+            if( save_mir ) {
+                auto lazy = m_out.open_lazy();
+                // The region is read on its own, so it can't refer to types cached outside of it
+                auto saved_types = mv$(m_types);
+                m_types.clear();
+                serialise(*exp.m_mir);
+                m_types = mv$(saved_types);
+                m_out.close_lazy(lazy);
+            }
+            if( !m_interface_only ) {
+                serialise_vec( exp.m_erased_types );
+            }
         }
         void serialise(const ::MIR::Function& mir)
         {
@@ -689,6 +744,28 @@
             serialise_vec( mir.drop_flags );
             serialise_vec( mir.blocks );
         }
+        void serialise(const ::MIR::OptimiseCache& cache, const ::std::vector<const ::MIR::Function*>& bodies)
+        {
+            assert(cache.entries.size() == bodies.size());
+            m_out.write_u64(cache.environment_hash);
+            m_out.write_count(cache.entries.size());
+            for(size_t i = 0; i < cache.entries.size(); i ++)
+            {
+                const auto& e = cache.entries[i];
+                auto _ = m_out.open_object("MIR::OptimiseCache::Entry");
+                m_out.write_string(e.path);
+                m_out.write_u64(e.original_hash);
+                m_out.write_u64(e.result_hash);
+                m_out.write_u64(e.interface_hash);
+                m_out.write_count(e.deps.size());
+                for(const auto& d : e.deps)
+                {
+                    m_out.write_string(d.path);
+                    m_out.write_u64(d.hash);
+                }
+                serialise(*bodies[i]);
+            }
+        }
         void serialise(const ::MIR::BasicBlock& block)
         {
             serialise_vec( block.statements );
@@ -1124,7 +1201,7 @@
             m_out.write_bool(fcn.m_variadic);
             serialise(fcn.m_return);
 
-            serialise(fcn.m_code, fcn.m_save_code || fcn.m_const);
+            serialise_lazy(fcn.m_code, fcn.m_save_code || fcn.m_const);
         }
         void serialise(const ::HIR::Function::Markings& m)
         {
@@ -1138,7 +1215,7 @@
 
             serialise_generics(item.m_params);
             serialise(item.m_type);
-            serialise(item.m_value);
+            serialise_lazy(item.m_value);
             bool write_val = item.m_value_state == ::HIR::Constant::ValueState::Known;
             m_out.write_bool(write_val);
             if( write_val )
@@ -1163,11 +1240,11 @@
 
             if( item.m_params.is_generic() )
             {
-                serialise(item.m_value);
+                serialise_lazy(item.m_value);
             }
             // NOTE: Value not stored (What if the static is generic? It can't be.)
             // - Need to store if the item was from a const (special linkage?)
-            if(item.m_save_literal)
+            if(item.m_save_literal && !m_interface_only)
             {
                 serialise(item.m_value_res);
             }
@@ -1303,10 +1380,17 @@
             m_out.write_bool( item.m_is_marker );
             serialise_strmap( item.m_types );
             serialise_strmap( item.m_values );
-            serialise_strmap( item.m_value_indexes );
-            serialise_strmap( item.m_type_indexes );
+            // The vtable layout is filled in after typecheck
+            if( !m_interface_only )
+            {
+                serialise_strmap( item.m_value_indexes );
+                serialise_strmap( item.m_type_indexes );
+            }
             serialise_vec( item.m_all_parent_traits );
-            serialise( item.m_vtable_path );
+            if( !m_interface_only )
+            {
+                serialise( item.m_vtable_path );
+            }
         }
         void serialise(const ::HIR::TraitValueItem& tvi)
         {
@@ -1336,6 +1420,360 @@
     };
 //}
 
+namespace {
+    /// Hashes an expression tree from before typecheck (see `HIR_HashExpr`)
+    class ExprHasher:
+        public ::HIR::ExprVisitor
+    {
+        HirSerialiser&  m_s;
+        ::HIR::serialise::Writer&   m_out;
+    public:
+        /// Cleared if the tree contains something that isn't hashed
+        bool    m_ok = true;
+
+        ExprHasher(HirSerialiser& s, ::HIR::serialise::Writer& out):
+            m_s(s),
+            m_out(out)
+        {}
+
+        void hash_node(::HIR::ExprNode* node) {
+            m_out.write_bool(node != nullptr);
+            if( node ) {
+                node->visit(*this);
+            }
+        }
+        void hash_node(const ::HIR::ExprNodeP& node) {
+            hash_node(node.get());
+        }
+        void hash_nodes(const ::std::vector<::HIR::ExprNodeP>& nodes) {
+            m_out.write_count(nodes.size());
+            for(const auto& n : nodes)
+                hash_node(n);
+        }
+        /// Module paths aren't items, so aren't added to the dependency list
+        void hash_module_path(const ::HIR::SimplePath& p) {
+            m_out.write_string(p.m_crate_name);
+            m_out.write_count(p.m_components.size());
+            for(const auto& c : p.m_components)
+                m_out.write_string(c);
+        }
+        void hash_trait_list(const ::HIR::t_trait_list& traits) {
+            m_out.write_count(traits.size());
+            for(const auto& t : traits)
+            {
+                // NULL entries separate the traits of nested modules
+                m_out.write_bool(t.first != nullptr);
+                if( t.first )
+                    m_s.serialise_simplepath(*t.first);
+            }
+        }
+        void hash_pattern_value(const ::HIR::Pattern::Value& v) {
+            m_out.write_tag(v.tag());
+            TU_MATCH_HDRA( (v), {)
+            TU_ARMA(Integer, e) {
+                m_out.write_tag(static_cast<int>(e.type));
+                m_out.write_u128(e.value);
+                }
+            TU_ARMA(Float, e) {
+                m_out.write_tag(static_cast<int>(e.type));
+                m_out.write_double(e.value);
+                }
+            TU_ARMA(String, e) {
+                m_out.write_string(e);
+                }
+            TU_ARMA(ByteString, e) {
+                m_out.write_string(e.v);
+                }
+            TU_ARMA(Named, e) {
+                m_s.serialise_path(e.path);
+                }
+            }
+        }
+        void hash_patterns(const ::std::vector<::HIR::Pattern>& pats) {
+            m_out.write_count(pats.size());
+            for(const auto& p : pats)
+                hash_pattern(p);
+        }
+        void hash_binding(const ::HIR::PatternBinding& b) {
+            m_out.write_bool(b.m_mutable);
+            m_out.write_tag(static_cast<int>(b.m_type));
+            m_out.write_string(b.m_name);
+            m_out.write_count(b.m_slot);
+            m_out.write_count(b.m_implicit_deref_count);
+        }
+        void hash_pattern(const ::HIR::Pattern& pat) {
+            m_out.write_count(pat.m_bindings.size());
+            for(const auto& b : pat.m_bindings)
+                hash_binding(b);
+            m_out.write_count(pat.m_implicit_deref_count);
+            m_out.write_tag(pat.m_data.tag());
+            TU_MATCH_HDRA( (pat.m_data), {)
+            TU_ARMA(Any, e) {
+                }
+            TU_ARMA(Box, e) {
+                hash_pattern(*e.sub);
+                }
+            TU_ARMA(Ref, e) {
+                m_out.write_tag(static_cast<int>(e.type));
+                hash_pattern(*e.sub);
+                }
+            TU_ARMA(Tuple, e) {
+                hash_patterns(e.sub_patterns);
+                }
+            TU_ARMA(SplitTuple, e) {
+                hash_patterns(e.leading);
+                hash_patterns(e.trailing);
+                m_out.write_count(e.total_size);
+                }
+            TU_ARMA(PathValue, e) {
+                m_s.serialise_path(e.path);
+                }
+            TU_ARMA(PathTuple, e) {
+                m_s.serialise_path(e.path);
+                hash_patterns(e.leading);
+                m_out.write_bool(e.is_split);
+                hash_patterns(e.trailing);
+                m_out.write_count(e.total_size);
+                }
+            TU_ARMA(PathNamed, e) {
+                m_s.serialise_path(e.path);
+                m_out.write_count(e.sub_patterns.size());
+                for(const auto& sp : e.sub_patterns) {
+                    m_out.write_string(sp.first);
+                    hash_pattern(sp.second);
+                }
+                m_out.write_bool(e.is_exhaustive);
+                }
+            TU_ARMA(Or, e) {
+                hash_patterns(e);
+                }
+            TU_ARMA(Value, e) {
+                hash_pattern_value(e.val);
+                }
+            TU_ARMA(Range, e) {
+                m_out.write_bool(static_cast<bool>(e.start));
+                if( e.start )
+                    hash_pattern_value(*e.start);
+                m_out.write_bool(static_cast<bool>(e.end));
+                if( e.end )
+                    hash_pattern_value(*e.end);
+                m_out.write_bool(e.is_inclusive);
+                }
+            TU_ARMA(Slice, e) {
+                hash_patterns(e.sub_patterns);
+                }
+            TU_ARMA(SplitSlice, e) {
+                hash_patterns(e.leading);
+                hash_binding(e.extra_bind);
+                hash_patterns(e.trailing);
+                }
+            }
+        }
+
+        void visit_node(::HIR::ExprNode& node) override {
+            m_out.write_string(::std::string(node.type_name()));
+            m_s.serialise_type(node.m_res_type);
+        }
+
+        void visit(::HIR::ExprNode_Block& node) override {
+            m_out.write_bool(node.m_is_unsafe);
+            hash_nodes(node.m_nodes);
+            hash_node(node.m_value_node);
+            hash_module_path(node.m_local_mod);
+            hash_trait_list(node.m_traits);
+        }
+        // Inline assembly isn't hashed (and is rare enough to not be worth caching)
+        void visit(::HIR::ExprNode_Asm& node) override {
+            m_ok = false;
+        }
+        void visit(::HIR::ExprNode_Asm2& node) override {
+            m_ok = false;
+        }
+        void visit(::HIR::ExprNode_Return& node) override {
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Yield& node) override {
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Let& node) override {
+            hash_pattern(node.m_pattern);
+            m_s.serialise_type(node.m_type);
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Loop& node) override {
+            m_out.write_string(node.m_label);
+            m_out.write_bool(node.m_require_label);
+            hash_node(node.m_code);
+        }
+        void visit(::HIR::ExprNode_LoopControl& node) override {
+            m_out.write_string(node.m_label);
+            m_out.write_bool(node.m_continue);
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Match& node) override {
+            hash_node(node.m_value);
+            m_out.write_count(node.m_arms.size());
+            for(const auto& arm : node.m_arms) {
+                hash_patterns(arm.m_patterns);
+                hash_node(arm.m_cond);
+                hash_node(arm.m_code);
+            }
+        }
+        void visit(::HIR::ExprNode_If& node) override {
+            hash_node(node.m_cond);
+            hash_node(node.m_true);
+            hash_node(node.m_false);
+        }
+
+        void visit(::HIR::ExprNode_Assign& node) override {
+            m_out.write_tag(static_cast<int>(node.m_op));
+            hash_node(node.m_slot);
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_BinOp& node) override {
+            m_out.write_tag(static_cast<int>(node.m_op));
+            hash_node(node.m_left);
+            hash_node(node.m_right);
+        }
+        void visit(::HIR::ExprNode_UniOp& node) override {
+            m_out.write_tag(static_cast<int>(node.m_op));
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Borrow& node) override {
+            m_out.write_tag(static_cast<int>(node.m_type));
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_RawBorrow& node) override {
+            m_out.write_tag(static_cast<int>(node.m_type));
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Cast& node) override {
+            hash_node(node.m_value);
+            m_s.serialise_type(node.m_dst_type);
+        }
+        void visit(::HIR::ExprNode_Unsize& node) override {
+            hash_node(node.m_value);
+            m_s.serialise_type(node.m_dst_type);
+        }
+        void visit(::HIR::ExprNode_Index& node) override {
+            hash_node(node.m_value);
+            hash_node(node.m_index);
+        }
+        void visit(::HIR::ExprNode_Deref& node) override {
+            hash_node(node.m_value);
+        }
+        void visit(::HIR::ExprNode_Emplace& node) override {
+            m_out.write_tag(static_cast<int>(node.m_type));
+            hash_node(node.m_place);
+            hash_node(node.m_value);
+        }
+
+        void visit(::HIR::ExprNode_TupleVariant& node) override {
+            m_s.serialise_genericpath(node.m_path);
+            m_out.write_bool(node.m_is_struct);
+            hash_nodes(node.m_args);
+        }
+        void visit(::HIR::ExprNode_CallPath& node) override {
+            m_s.serialise_path(node.m_path);
+            hash_nodes(node.m_args);
+        }
+        void visit(::HIR::ExprNode_CallValue& node) override {
+            hash_node(node.m_value);
+            hash_nodes(node.m_args);
+        }
+        void visit(::HIR::ExprNode_CallMethod& node) override {
+            hash_node(node.m_value);
+            m_out.write_string(node.m_method);
+            m_s.serialise_pathparams(node.m_params);
+            hash_nodes(node.m_args);
+        }
+        void visit(::HIR::ExprNode_Field& node) override {
+            hash_node(node.m_value);
+            m_out.write_string(node.m_field);
+        }
+
+        void visit(::HIR::ExprNode_Literal& node) override {
+            m_out.write_tag(node.m_data.tag());
+            TU_MATCH_HDRA( (node.m_data), {)
+            TU_ARMA(Integer, e) {
+                m_out.write_tag(static_cast<int>(e.m_type));
+                m_out.write_u128(e.m_value);
+                }
+            TU_ARMA(Float, e) {
+                m_out.write_tag(static_cast<int>(e.m_type));
+                m_out.write_double(e.m_value);
+                }
+            TU_ARMA(Boolean, e) {
+                m_out.write_bool(e);
+                }
+            TU_ARMA(String, e) {
+                m_out.write_string(e);
+                }
+            TU_ARMA(ByteString, e) {
+                m_out.write_string(e.size(), e.data());
+                }
+            }
+        }
+        void visit(::HIR::ExprNode_UnitVariant& node) override {
+            m_s.serialise_genericpath(node.m_path);
+            m_out.write_bool(node.m_is_struct);
+        }
+        void visit(::HIR::ExprNode_PathValue& node) override {
+            m_s.serialise_path(node.m_path);
+            m_out.write_tag(static_cast<int>(node.m_target));
+        }
+        void visit(::HIR::ExprNode_Variable& node) override {
+            m_out.write_string(node.m_name);
+            m_out.write_count(node.m_slot);
+        }
+        void visit(::HIR::ExprNode_ConstParam& node) override {
+            m_out.write_string(node.m_name);
+            m_out.write_count(node.m_binding);
+        }
+
+        void visit(::HIR::ExprNode_StructLiteral& node) override {
+            m_s.serialise_type(node.m_type);
+            m_out.write_bool(node.m_is_struct);
+            hash_node(node.m_base_value);
+            m_out.write_count(node.m_values.size());
+            for(const auto& v : node.m_values) {
+                m_out.write_string(v.first);
+                hash_node(v.second);
+            }
+        }
+        void visit(::HIR::ExprNode_Tuple& node) override {
+            hash_nodes(node.m_vals);
+        }
+        void visit(::HIR::ExprNode_ArrayList& node) override {
+            hash_nodes(node.m_vals);
+        }
+        void visit(::HIR::ExprNode_ArraySized& node) override {
+            hash_node(node.m_val);
+            m_s.serialise_arraysize(node.m_size);
+        }
+
+        // Closures and generators become new items (numbered within the module), so bodies containing them aren't
+        // cached
+        void visit(::HIR::ExprNode_Closure& node) override {
+            m_ok = false;
+        }
+        void visit(::HIR::ExprNode_Generator& node) override {
+            m_ok = false;
+        }
+        void visit(::HIR::ExprNode_GeneratorWrapper& node) override {
+            m_ok = false;
+        }
+    };
+}
+
+void HirSerialiser::serialise_expr_tree(const ::HIR::ExprPtr& exp)
+{
+    assert(m_pre_typecheck);
+    ExprHasher  h { *this, m_out };
+    h.hash_node(exp.get());
+    m_expr_hash_ok &= h.m_ok;
+}
+
 void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate)
 {
     ::HIR::serialise::Writer    out;
@@ -1346,3 +1784,227 @@ void HIR_Serialise(const ::std::string& filename, const ::HIR::Crate& crate)
     s.serialise_crate(crate);
 }
 
+
+namespace {
+    const ::HIR::Crate* get_crate_for_path(const ::HIR::Crate& crate, const ::HIR::SimplePath& path)
+    {
+        if( path.m_crate_name == crate.m_crate_name )
+            return &crate;
+        auto it = crate.m_ext_crates.find(path.m_crate_name);
+        return it == crate.m_ext_crates.end() ? nullptr : &*it->second.m_data;
+    }
+    /// Hash the bodies of extern functions (they're not otherwise serialised, but can be inlined)
+    void hash_extern_body(HirSerialiser& s, const ::HIR::Function& fcn)
+    {
+        if( fcn.m_code.m_mir ) {
+            s.serialise(*fcn.m_code.m_mir);
+        }
+    }
+    template<typename Impl>
+    void hash_extern_bodies(HirSerialiser& s, const Impl& impl)
+    {
+        for(const auto& m : impl.m_methods)
+            hash_extern_body(s, m.second.data);
+    }
+    void hash_extern_bodies(HirSerialiser& , const ::HIR::MarkerImpl& )
+    {
+    }
+    /// Extern crates in name order (`m_ext_crates` is unordered, and the hashes must be stable between runs)
+    ::std::vector<const ::HIR::Crate*> sorted_ext_crates(const ::HIR::Crate& crate)
+    {
+        ::std::vector<const ::HIR::Crate*>  rv;
+        for(const auto& ec : crate.m_ext_crates)
+            rv.push_back(&*ec.second.m_data);
+        ::std::sort(rv.begin(), rv.end(), [](const ::HIR::Crate* a, const ::HIR::Crate* b){ return a->m_crate_name < b->m_crate_name; });
+        return rv;
+    }
+    template<typename Impl>
+    void hash_impl_list(HirSerialiser& s, const ::std::vector<::std::unique_ptr<Impl>>& list, bool is_extern)
+    {
+        for(const auto& i : list)
+        {
+            s.serialise(*i);
+            if( is_extern )
+                hash_extern_bodies(s, *i);
+        }
+    }
+}
+
+uint64_t HIR_HashMir(const ::MIR::Function& fcn, ::std::set<::HIR::SimplePath>* out_paths)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    s.m_paths = out_paths;
+    out.open_hash();
+    s.serialise(fcn);
+    return out.get_hash();
+}
+uint64_t HIR_HashSignature(const ::HIR::GenericParams* impl_generics, const ::HIR::GenericParams* item_generics, const ::std::vector<const ::HIR::TypeRef*>& types, ::std::set<::HIR::SimplePath>* out_paths)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    s.m_paths = out_paths;
+    // NOTE: Also used before typecheck (by the lowering cache)
+    s.m_pre_typecheck = true;
+    out.open_hash();
+    for(const auto* g : { impl_generics, item_generics })
+    {
+        out.write_bool(g != nullptr);
+        if( g )
+            s.serialise_generics(*g);
+    }
+    for(const auto* ty : types)
+        s.serialise_type(*ty);
+    return out.get_hash();
+}
+bool HIR_HashExpr(const ::HIR::ExprPtr& expr, const ::std::vector<const ::HIR::Pattern*>& args, uint64_t& out_hash, ::std::set<::HIR::SimplePath>* out_paths)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    s.m_paths = out_paths;
+    s.m_pre_typecheck = true;
+    out.open_hash();
+    ExprHasher  h { s, out };
+
+    // The module and traits in scope (used to resolve methods)
+    const auto& state = *expr.m_state;
+    h.hash_module_path(state.m_mod_path);
+    h.hash_trait_list(state.m_traits);
+
+    out.write_count(args.size());
+    for(const auto* a : args)
+        h.hash_pattern(*a);
+    h.hash_node(expr.get());
+    if( !h.m_ok || !s.m_expr_hash_ok )
+        return false;
+    out_hash = out.get_hash();
+    return true;
+}
+bool HIR_HashItem(const ::HIR::Crate& crate, const ::HIR::SimplePath& path, uint64_t& out_hash, ::std::set<::HIR::SimplePath>* out_paths, bool interface_only/*=false*/)
+{
+    const auto* c = get_crate_for_path(crate, path);
+    if( !c || path.m_components.empty() )
+        return false;
+    bool is_extern = c != &crate;
+
+    // Find the item, or the enum/trait/... containing it (for variant and associated item paths)
+    const ::HIR::Module*    mod = &c->m_root_module;
+    const ::HIR::TypeItem*  ti = nullptr;
+    const ::HIR::ValueItem* vi = nullptr;
+    for(size_t i = 0; i < path.m_components.size(); i ++)
+    {
+        const auto& name = path.m_components[i];
+        auto it = mod->m_mod_items.find(name);
+        if( i == path.m_components.size() - 1 )
+        {
+            if( it != mod->m_mod_items.end() )
+                ti = &it->second->ent;
+            auto vit = mod->m_value_items.find(name);
+            if( vit != mod->m_value_items.end() )
+                vi = &vit->second->ent;
+            break;
+        }
+        if( it == mod->m_mod_items.end() )
+            return false;
+        if( const auto* m = it->second->ent.opt_Module() ) {
+            mod = m;
+            continue;
+        }
+        ti = &it->second->ent;
+        break;
+    }
+    if( ti && ti->is_Module() )
+        ti = nullptr;
+    if( !ti && !vi )
+        return false;
+
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    // Interface hashes are taken before typecheck
+    s.m_interface_only = interface_only;
+    s.m_pre_typecheck = interface_only;
+    out.open_hash();
+
+    // The definition (only the contents of types are followed, for layout and `Copy`/`Drop`)
+    if( ti && (ti->is_Struct() || ti->is_Enum() || ti->is_Union() || ti->is_TypeAlias()) )
+        s.m_paths = out_paths;
+    if( ti ) {
+        s.serialise(*ti);
+    }
+    if( vi ) {
+        s.serialise(*vi);
+        if( is_extern && vi->is_Function() )
+            hash_extern_body(s, vi->as_Function());
+    }
+    s.m_paths = nullptr;
+
+    // Impls on a type (from any crate) can change what its uses resolve to
+    if( ti && (ti->is_Struct() || ti->is_Enum() || ti->is_Union() || ti->is_ExternType()) )
+    {
+        auto hash_impls = [&](const ::HIR::Crate& c, bool is_extern) {
+            auto it = c.m_type_impls.named.find(path);
+            if( it != c.m_type_impls.named.end() )
+                hash_impl_list(s, it->second, is_extern);
+            for(const auto& ig : c.m_trait_impls)
+            {
+                auto it = ig.second.named.find(path);
+                if( it != ig.second.named.end() ) {
+                    s.serialise_simplepath(ig.first);
+                    hash_impl_list(s, it->second, is_extern);
+                }
+            }
+            for(const auto& ig : c.m_marker_impls)
+            {
+                auto it = ig.second.named.find(path);
+                if( it != ig.second.named.end() ) {
+                    s.serialise_simplepath(ig.first);
+                    hash_impl_list(s, it->second, is_extern);
+                }
+            }
+            };
+        hash_impls(crate, false);
+        for(const auto* ec : sorted_ext_crates(crate))
+            hash_impls(*ec, true);
+    }
+    out_hash = out.get_hash();
+    return true;
+}
+uint64_t HIR_HashUnnamedImpls(const ::HIR::Crate& crate, bool interface_only/*=false*/)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    // Interface hashes are taken before typecheck
+    s.m_interface_only = interface_only;
+    s.m_pre_typecheck = interface_only;
+    out.open_hash();
+    auto hash_impls = [&](const ::HIR::Crate& c, bool is_extern) {
+        s.serialise(c.m_crate_name);
+        hash_impl_list(s, c.m_type_impls.non_named, is_extern);
+        hash_impl_list(s, c.m_type_impls.generic, is_extern);
+        for(const auto& ig : c.m_trait_impls)
+        {
+            s.serialise_simplepath(ig.first);
+            hash_impl_list(s, ig.second.non_named, is_extern);
+            hash_impl_list(s, ig.second.generic, is_extern);
+        }
+        for(const auto& ig : c.m_marker_impls)
+        {
+            s.serialise_simplepath(ig.first);
+            hash_impl_list(s, ig.second.non_named, is_extern);
+            hash_impl_list(s, ig.second.generic, is_extern);
+        }
+        };
+    hash_impls(crate, false);
+    for(const auto* ec : sorted_ext_crates(crate))
+        hash_impls(*ec, true);
+    return out.get_hash();
+}
+void HIR_SerialiseMirCache(const ::std::string& filename, const ::MIR::OptimiseCache& cache, const ::std::vector<const ::MIR::Function*>& bodies)
+{
+    ::HIR::serialise::Writer    out;
+    HirSerialiser  s { out };
+    s.serialise(cache, bodies);
+    s.clear();
+    out.open(filename);
+    s.serialise(cache, bodies);
+}
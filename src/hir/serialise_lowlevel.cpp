@@ -7,12 +7,18 @@
  */
 #include <debug.hpp>
 #include "serialise_lowlevel.hpp"
-#include <zlib.h>
 #include <fstream>
 #include <string.h>   // memcpy
 #include <common.hpp>
 #include <algorithm>
 #include <iomanip>
+#ifdef _WIN32
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 namespace HIR {
 namespace serialise {
@@ -20,19 +26,18 @@ namespace serialise {
 class WriterInner
 {
     ::std::ofstream m_backing;
-    z_stream    m_zstream;
-    ::std::vector<unsigned char> m_buffer;
-
-    unsigned int    m_byte_out_count = 0;
-    unsigned int    m_byte_in_count = 0;
 public:
     WriterInner(const ::std::string& filename);
-    ~WriterInner();
     void write(const void* buf, size_t len);
+    /// Overwrite previously written data
+    void patch(size_t pos, const void* buf, size_t len);
 };
 
 Writer::Writer():
-    m_inner(nullptr)
+    m_inner(nullptr),
+    m_hashing(false),
+    m_hash(0),
+    m_pos(0)
 {
 }
 Writer::~Writer()
@@ -50,8 +55,11 @@ void Writer::open(const ::std::string& filename)
     ::std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b){ return a.second > b.second; });
 
     m_objname_cache.clear();
+    assert(m_objname_cache_stack.empty());
 
     m_inner = new WriterInner(filename);
+    m_pos = 0;
+    this->write(MAGIC, sizeof(MAGIC));
     // 3. Reset m_istring_cache to use the same value
     this->write_count(sorted.size());
     for(size_t i = 0; i < sorted.size(); i ++)
@@ -66,22 +74,62 @@ void Writer::open(const ::std::string& filename)
         assert(e.second < sorted.size());
     }
 }
+void Writer::open_hash()
+{
+    assert(!m_inner);
+    m_hashing = true;
+    m_hash = 0xcbf29ce484222325;
+}
 void Writer::write(const void* buf, size_t len)
 {
+    m_pos += len;
     if( m_inner ) {
         DEBUG("write(" << FMT_CB(ss, for(size_t i = 0; i < len; i ++) ss << std::setw(2) << std::setfill('0') << std::hex << unsigned( ((const uint8_t*)buf)[i] )) << ")");
         m_inner->write(buf, len);
     }
+    else if( m_hashing ) {
+        // FNV-1a
+        for(size_t i = 0; i < len; i ++)
+        {
+            m_hash ^= static_cast<const uint8_t*>(buf)[i];
+            m_hash *= 0x100000001b3;
+        }
+    }
     else {
         // No-op, pre caching
     }
 }
+size_t Writer::open_lazy()
+{
+    size_t rv = m_pos;
+    // Placeholder length, patched in `close_lazy`
+    write_u64(0);
+    m_objname_cache_stack.push_back(::std::move(m_objname_cache));
+    m_objname_cache.clear();
+    return rv;
+}
+void Writer::close_lazy(size_t handle)
+{
+    assert(!m_objname_cache_stack.empty());
+    m_objname_cache = ::std::move(m_objname_cache_stack.back());
+    m_objname_cache_stack.pop_back();
+    if( m_inner ) {
+        uint64_t len = m_pos - (handle + 8);
+        uint8_t buf[8];
+        for(int i = 0; i < 8; i ++)
+            buf[i] = static_cast<uint8_t>(len >> (8*i));
+        m_inner->patch(handle, buf, sizeof(buf));
+    }
+}
 void Writer::write_string(const RcString& v)
 {
     if( m_inner ) {
         // Emit ID from the cache
         this->write_count( m_istring_cache.at(v) );
     }
+    else if( m_hashing ) {
+        this->write_string(v.size(), v.c_str());
+    }
     else {
         // Find/add in cache
         m_istring_cache.insert(::std::make_pair(v, 0)).first->second += 1;
@@ -90,251 +138,128 @@ void Writer::write_string(const RcString& v)
 
 
 WriterInner::WriterInner(const ::std::string& filename):
-    m_backing( filename, ::std::ios_base::out | ::std::ios_base::binary),
-    m_zstream(),
-    m_buffer( 16*1024 )
-    //m_buffer( 4*1024 )
+    m_backing( filename, ::std::ios_base::out | ::std::ios_base::binary)
 {
-    m_zstream.zalloc = Z_NULL;
-    m_zstream.zfree = Z_NULL;
-    m_zstream.opaque = Z_NULL;
-
-    const int COMPRESSION_LEVEL = Z_BEST_COMPRESSION;
-    int ret = deflateInit(&m_zstream, COMPRESSION_LEVEL);
-    if(ret != Z_OK)
-        throw ::std::runtime_error("zlib init failure");
-
-    m_zstream.avail_out = m_buffer.size();
-    m_zstream.next_out = m_buffer.data();
+    if( !m_backing.is_open() )
+        throw ::std::runtime_error("Unable to open file for writing");
 }
-WriterInner::~WriterInner()
+void WriterInner::write(const void* buf, size_t len)
 {
-    assert( m_zstream.avail_in == 0 );
-
-    // Complete the compression
-    int ret;
-    do
-    {
-        ret = deflate(&m_zstream, Z_FINISH);
-        if(ret == Z_STREAM_ERROR) {
-            ::std::cerr << "ERROR: zlib deflate stream error (cleanup)";
-            abort();
-        }
-        if( m_zstream.avail_out != m_buffer.size() )
-        {
-            size_t rem = m_buffer.size() - m_zstream.avail_out;
-            m_byte_out_count += rem;
-            m_backing.write( reinterpret_cast<char*>(m_buffer.data()), rem );
-
-            m_zstream.avail_out = m_buffer.size();
-            m_zstream.next_out = m_buffer.data();
-        }
-    } while(ret == Z_OK);
-    deflateEnd(&m_zstream);
+    m_backing.write( reinterpret_cast<const char*>(buf), len );
 }
-
-void WriterInner::write(const void* buf, size_t len)
+void WriterInner::patch(size_t pos, const void* buf, size_t len)
 {
-    m_zstream.avail_in = len;
-    m_zstream.next_in = reinterpret_cast<unsigned char*>( const_cast<void*>(buf) );
-
-    size_t last_avail_in = m_zstream.avail_in;
-
-    // While there's data to compress
-    while( m_zstream.avail_in > 0 )
-    {
-        assert(m_zstream.avail_out != 0);
-
-        // Compress the data
-        int ret = deflate(&m_zstream, Z_NO_FLUSH);
-        if(ret == Z_STREAM_ERROR)
-            throw ::std::runtime_error("zlib deflate stream error");
-
-        size_t used_this_time = last_avail_in - m_zstream.avail_in;
-        last_avail_in = m_zstream.avail_in;
-        m_byte_in_count += used_this_time;
-
-        // If the entire input wasn't consumed, then it was likely due to a lack of output space
-        // - Flush the output buffer to the file
-        if( m_zstream.avail_in > 0 )
-        {
-            size_t bytes = m_buffer.size() - m_zstream.avail_out;
-            m_backing.write( reinterpret_cast<char*>(m_buffer.data()), bytes );
-            m_byte_out_count += bytes;
-
-            m_zstream.avail_out = m_buffer.size();
-            m_zstream.next_out = m_buffer.data();
-        }
-    }
-
-    // Flush stream contents if the output buffer is full.
-    while( m_zstream.avail_out == 0 )
-    {
-        size_t bytes = m_buffer.size() - m_zstream.avail_out;
-        m_backing.write( reinterpret_cast<char*>(m_buffer.data()), bytes );
-        m_byte_out_count += bytes;
-
-        m_zstream.avail_out = m_buffer.size();
-        m_zstream.next_out = m_buffer.data();
-
-        int ret = deflate(&m_zstream, Z_NO_FLUSH);
-        if(ret == Z_STREAM_ERROR)
-            throw ::std::runtime_error("zlib deflate stream error");
-    }
+    auto end = m_backing.tellp();
+    m_backing.seekp(pos);
+    m_backing.write( reinterpret_cast<const char*>(buf), len );
+    m_backing.seekp(end);
 }
 
 
 // --------------------------------------------------------------------
+/// A read-only view of an entire file (memory-mapped where possible)
 class ReaderInner
 {
-    ::std::ifstream m_backing;
-    z_stream    m_zstream;
-    ::std::vector<unsigned char> m_buffer;
-
-    unsigned int    m_byte_out_count = 0;
-    unsigned int    m_byte_in_count = 0;
+#ifdef _WIN32
+    ::std::vector<uint8_t>  m_buffer;
+#else
+    void*   m_map;
+#endif
+    const uint8_t*  m_data;
+    size_t  m_size;
 public:
     ReaderInner(const ::std::string& filename);
+    ReaderInner(const ReaderInner&) = delete;
     ~ReaderInner();
-    size_t read(void* buf, size_t len);
-};
 
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
 
-ReadBuffer::ReadBuffer(size_t cap):
-    m_ofs(0)
+#ifdef _WIN32
+ReaderInner::ReaderInner(const ::std::string& filename)
 {
-    m_backing.reserve(cap);
+    ::std::ifstream is(filename, ::std::ios_base::in|::std::ios_base::binary);
+    if( !is.is_open() )
+        throw ::std::runtime_error("Unable to open file");
+    is.seekg(0, ::std::ios_base::end);
+    m_buffer.resize(static_cast<size_t>(is.tellg()));
+    is.seekg(0);
+    is.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
 }
-size_t ReadBuffer::read(void* dst, size_t len)
+ReaderInner::~ReaderInner()
 {
-    size_t rem = m_backing.size() - m_ofs;
-    if( rem >= len )
-    {
-        memcpy(dst, m_backing.data() + m_ofs, len);
-        m_ofs += len;
-        return len;
+}
+#else
+ReaderInner::ReaderInner(const ::std::string& filename):
+    m_map(nullptr),
+    m_data(nullptr),
+    m_size(0)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if( fd < 0 )
+        throw ::std::runtime_error("Unable to open file");
+    struct stat st;
+    if( ::fstat(fd, &st) != 0 ) {
+        ::close(fd);
+        throw ::std::runtime_error("Unable to stat file");
     }
-    else
+    m_size = static_cast<size_t>(st.st_size);
+    if( m_size > 0 )
     {
-        memcpy(dst, m_backing.data() + m_ofs, rem);
-        m_ofs = m_backing.size();
-        return rem;
+        m_map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( m_map == MAP_FAILED ) {
+            ::close(fd);
+            throw ::std::runtime_error("Unable to map file");
+        }
+        m_data = static_cast<const uint8_t*>(m_map);
     }
+    // NOTE: The mapping stays valid after the descriptor is closed
+    ::close(fd);
 }
-void ReadBuffer::populate(ReaderInner& is)
+ReaderInner::~ReaderInner()
 {
-    m_backing.resize( m_backing.capacity(), 0 );
-    auto len = is.read(m_backing.data(), m_backing.size());
-    m_backing.resize( len );
-    m_ofs = 0;
+    if( m_map )
+    {
+        ::munmap(m_map, m_size);
+    }
 }
+#endif
 
 
 Reader::Reader(const ::std::string& filename):
-    m_inner( new ReaderInner(filename) ),
-    m_buffer(1024),
+    m_inner( ::std::make_shared<ReaderInner>(filename) ),
+    m_data( m_inner->data() ),
+    m_size( m_inner->size() ),
     m_pos(0)
 {
+    char    magic[sizeof(MAGIC)];
+    if( m_size < sizeof(MAGIC) || (read(magic, sizeof(magic)), memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) )
+        throw ::std::runtime_error("Not a metadata file, or from an incompatible version of the compiler");
+
     size_t n_strings = read_count();
-    m_strings.reserve(n_strings);
+    auto strings = ::std::make_shared<::std::vector<RcString>>();
+    strings->reserve(n_strings);
     DEBUG("n_strings = " << n_strings);
     for(size_t i = 0; i < n_strings; i ++)
     {
         auto s = read_string();
-        m_strings.push_back( RcString::new_interned(s) );
-    }
-}
-Reader::~Reader()
-{
-    delete m_inner, m_inner = nullptr;
-}
-
-void Reader::read(void* buf, size_t len)
-{
-    auto used = m_buffer.read(buf, len);
-    if( used == len ) {
-        m_pos += len;
-        return ;
-    }
-    buf = reinterpret_cast<uint8_t*>(buf) + used;
-    len -= used;
-
-    if( len >= m_buffer.capacity() )
-    {
-        m_inner->read(buf, len);
-    }
-    else
-    {
-        m_buffer.populate( *m_inner );
-        used = m_buffer.read(buf, len);
-        if( used != len )
-            throw ::std::runtime_error( FMT("Reader::read - Requested " << len << " bytes from buffer, got " << used) );
+        strings->push_back( RcString::new_interned(s) );
     }
-
-    m_pos += len;
+    m_strings = ::std::move(strings);
 }
-
-
-ReaderInner::ReaderInner(const ::std::string& filename):
-    m_backing(filename, ::std::ios_base::in|::std::ios_base::binary),
-    m_zstream(),
-    m_buffer(16*1024)
+Reader::Reader(const Reader& parent, size_t region_start):
+    m_inner( parent.m_inner ),
+    m_data( parent.m_data ),
+    m_size( parent.m_size ),
+    m_pos( region_start ),
+    m_strings( parent.m_strings )
 {
-    if( !m_backing.is_open() )
-        throw ::std::runtime_error("Unable to open file");
-
-    m_zstream.zalloc = Z_NULL;
-    m_zstream.zfree = Z_NULL;
-    m_zstream.opaque = Z_NULL;
-
-    int ret = inflateInit(&m_zstream);
-    if(ret != Z_OK)
-        throw ::std::runtime_error("zlib init failure");
-
-    m_zstream.avail_in = 0;
 }
-ReaderInner::~ReaderInner()
-{
-    inflateEnd(&m_zstream);
-}
-size_t ReaderInner::read(void* buf, size_t len)
+Reader::~Reader()
 {
-    m_zstream.avail_out = len;
-    m_zstream.next_out = reinterpret_cast<unsigned char*>(buf);
-    do {
-        // Reset input buffer if empty
-        if( m_zstream.avail_in == 0 )
-        {
-            m_backing.read( reinterpret_cast<char*>(m_buffer.data()), m_buffer.size() );
-            m_zstream.avail_in = m_backing.gcount();
-            if( m_zstream.avail_in == 0 ) {
-                m_byte_out_count += len  - m_zstream.avail_out;
-                //::std::cerr << "Out of bytes, " << m_zstream.avail_out << " needed" << ::std::endl;
-                return len - m_zstream.avail_out;
-            }
-            m_zstream.next_in = const_cast<unsigned char*>(m_buffer.data());
-
-            m_byte_in_count += m_zstream.avail_in;
-        }
-
-        int ret = inflate(&m_zstream, Z_NO_FLUSH);
-        if(ret == Z_STREAM_ERROR)
-            throw ::std::runtime_error("zlib inflate stream error");
-        switch(ret)
-        {
-        case Z_NEED_DICT:
-            ret = Z_DATA_ERROR;
-        case Z_DATA_ERROR:
-        case Z_MEM_ERROR:
-            throw ::std::runtime_error("zlib inflate error");
-        default:
-            break;
-        }
-
-    } while( m_zstream.avail_out > 0 );
-    m_byte_out_count += len;
-
-    return len;
 }
 
 }   // namespace serialise
@@ -7,6 +7,9 @@
  */
 #pragma once
 
+// File layout: `MAGIC` followed by the string table, then the (uncompressed) serialised data. Files are memory mapped
+// by the reader, and "lazy" regions (see `Writer::open_lazy`) let large items (e.g. MIR) be skipped until first use.
+//
 // Encoding protocol ideas:
 // > Semi-typed data format (encode length in the format)
 // Purpose: Allows internal consistency checking and recovery (recovery not needed here)
@@ -22,6 +25,9 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <stdexcept>
+#include <cstring>  // memcpy
 #include <stddef.h>
 #include <assert.h>
 #include <rc_string.hpp>
@@ -32,11 +38,19 @@ namespace serialise {
 class WriterInner;
 class ReaderInner;
 
+/// Identifies the uncompressed (mappable) format, bump the final digit when the layout changes
+static const char MAGIC[8] = { 'M','R','S','H','I','R','0','2' };
+
 class Writer
 {
     WriterInner*    m_inner;
     ::std::map<RcString, unsigned>  m_istring_cache;
     ::std::map<const char*, unsigned>  m_objname_cache;
+    // Object name caches of enclosing lazy regions (each region starts with an empty cache)
+    ::std::vector<::std::map<const char*, unsigned>>    m_objname_cache_stack;
+    bool    m_hashing;
+    uint64_t    m_hash;
+    size_t  m_pos;
 public:
     Writer();
     Writer(const Writer&) = delete;
@@ -44,8 +58,18 @@ public:
     ~Writer();
 
     void open(const ::std::string& filename);
+    /// Hash the written data instead of storing it (strings are hashed by value)
+    void open_hash();
+    uint64_t get_hash() const { return m_hash; }
     void write(const void* data, size_t count);
 
+    /// Start a lazily-loaded region, returns a handle to pass to `close_lazy`
+    ///
+    /// The region is prefixed with its length (so the reader can skip it), and must be self-contained, i.e. not refer
+    /// to any cached values (object names, or higher-level caches) from outside of it.
+    size_t open_lazy();
+    void close_lazy(size_t handle);
+
     void write_u8(uint8_t v) {
         write(reinterpret_cast<const char*>(&v), 1);
     }
@@ -223,34 +247,40 @@ public:
 };
 
 
-class ReadBuffer
-{
-    ::std::vector<uint8_t>  m_backing;
-    unsigned int    m_ofs;
-public:
-    ReadBuffer(size_t size);
-
-    size_t capacity() const { return m_backing.capacity(); }
-    size_t read(void* dst, size_t len);
-    void populate(ReaderInner& is);
-};
-
 class Reader
 {
-    ReaderInner*    m_inner;
-    ReadBuffer  m_buffer;
+    /// Mapped file contents (shared with readers for lazily-loaded regions)
+    ::std::shared_ptr<ReaderInner>  m_inner;
+    const uint8_t*  m_data;
+    size_t  m_size;
     size_t  m_pos;
-    ::std::vector<RcString> m_strings;
+    ::std::shared_ptr<const ::std::vector<RcString>>    m_strings;
 
     ::std::vector<std::string>  m_objname_cache;
 public:
     Reader(const ::std::string& path);
+    /// Reader for a lazy region (see `skip_lazy`) in the same file as `parent`
+    Reader(const Reader& parent, size_t region_start);
     Reader(const Writer&) = delete;
     Reader(Writer&&) = delete;
     ~Reader();
 
     size_t get_pos() const { return m_pos; }
-    void read(void* dst, size_t count);
+    void read(void* dst, size_t count) {
+        if( count > m_size - m_pos )
+            throw ::std::runtime_error("Reader::read - Unexpected end of file");
+        memcpy(dst, m_data + m_pos, count);
+        m_pos += count;
+    }
+    /// Skip over a lazy region (written by `Writer::open_lazy`), returning the start position of its contents
+    size_t skip_lazy() {
+        auto len = read_u64();
+        if( len > m_size - m_pos )
+            throw ::std::runtime_error("Reader::skip_lazy - Region extends past end of file");
+        auto rv = m_pos;
+        m_pos += len;
+        return rv;
+    }
 
     uint8_t read_u8() {
         uint8_t v;
@@ -362,7 +392,7 @@ public:
     }
     RcString read_istring() {
         size_t idx = read_count();
-        return m_strings.at(idx);
+        return m_strings->at(idx);
     }
     ::std::string read_string() {
         size_t len = read_u8();
@@ -8,6 +8,8 @@
 #include "type.hpp"
 #include <span.hpp>
 #include "expr.hpp" // Hack for cloning array types
+#include <mutex>
+#include <set>
 
 namespace HIR {
 
@@ -254,6 +256,9 @@ bool ::HIR::TypeRef::operator==(const ::HIR::TypeRef& x) const
     
     if( !m_ptr || !x.m_ptr )
         return false;
+    // Interned types are unique, so different pointers means different types
+    if( m_ptr->m_is_interned && x.m_ptr->m_is_interned )
+        return false;
     if( data().tag() != x.data().tag() )
         return false;
 
@@ -342,6 +347,68 @@ bool ::HIR::TypeRef::operator==(const ::HIR::TypeRef& x) const
     )
     throw "";
 }
+size_t HIR::TypeRef::hash() const
+{
+    // NOTE: Only fields that are checked by `operator==` can be included
+    size_t  rv = static_cast<size_t>(data().tag());
+    TU_MATCH_HDRA( (data()), {)
+    TU_ARMA(Infer, e) {
+        hash_combine(rv, e.index);
+        }
+    TU_ARMA(Diverge, e) {
+        }
+    TU_ARMA(Primitive, e) {
+        hash_combine(rv, static_cast<size_t>(e));
+        }
+    TU_ARMA(Path, e) {
+        hash_combine(rv, e.path.hash());
+        }
+    TU_ARMA(Generic, e) {
+        hash_combine(rv, e.binding);
+        }
+    TU_ARMA(TraitObject, e) {
+        hash_combine(rv, e.m_trait.m_path.hash());
+        hash_combine(rv, e.m_markers.size());
+        }
+    TU_ARMA(ErasedType, e) {
+        hash_combine(rv, e.m_origin.hash());
+        }
+    TU_ARMA(Array, e) {
+        hash_combine(rv, e.inner.hash());
+        if( e.size.is_Known() )
+            hash_combine(rv, static_cast<size_t>(e.size.as_Known()));
+        }
+    TU_ARMA(Slice, e) {
+        hash_combine(rv, e.inner.hash());
+        }
+    TU_ARMA(Tuple, e) {
+        for(const auto& t : e)
+            hash_combine(rv, t.hash());
+        }
+    TU_ARMA(Borrow, e) {
+        hash_combine(rv, static_cast<size_t>(e.type));
+        hash_combine(rv, e.inner.hash());
+        }
+    TU_ARMA(Pointer, e) {
+        hash_combine(rv, static_cast<size_t>(e.type));
+        hash_combine(rv, e.inner.hash());
+        }
+    TU_ARMA(Function, e) {
+        hash_combine(rv, e.is_unsafe);
+        hash_combine(rv, ::std::hash<::std::string>()(e.m_abi));
+        for(const auto& t : e.m_arg_types)
+            hash_combine(rv, t.hash());
+        hash_combine(rv, e.m_rettype.hash());
+        }
+    TU_ARMA(Closure, e) {
+        hash_combine(rv, reinterpret_cast<::std::uintptr_t>(e.node));
+        }
+    TU_ARMA(Generator, e) {
+        hash_combine(rv, reinterpret_cast<::std::uintptr_t>(e.node));
+        }
+    }
+    return rv;
+}
 Ordering HIR::TypeRef::ord(const ::HIR::TypeRef& x) const
 {
     Ordering    rv;
@@ -1019,6 +1086,200 @@ const ::HIR::TraitMarkings* HIR::TypePathBinding::get_trait_markings() const
     }
     throw "";
 }
+
+namespace {
+    bool type_is_internable(const ::HIR::TypeRef& ty);
+    bool lifetime_is_internable(const ::HIR::LifetimeRef& lft) {
+        return lft.binding == ::HIR::LifetimeRef::UNKNOWN || lft.binding == ::HIR::LifetimeRef::STATIC;
+    }
+    bool params_are_internable(const ::HIR::PathParams& pp) {
+        for(const auto& t : pp.m_types)
+            if( !type_is_internable(t) )
+                return false;
+        for(const auto& v : pp.m_values)
+            if( !v.is_Evaluated() )
+                return false;
+        return true;
+    }
+    bool path_is_internable(const ::HIR::Path& p) {
+        TU_MATCH_HDRA( (p.m_data), {)
+        TU_ARMA(Generic, pe) {
+            return params_are_internable(pe.m_params);
+            }
+        TU_ARMA(UfcsInherent, pe) {
+            return type_is_internable(pe.type) && params_are_internable(pe.params) && params_are_internable(pe.impl_params);
+            }
+        TU_ARMA(UfcsKnown, pe) {
+            return type_is_internable(pe.type) && params_are_internable(pe.trait.m_params) && params_are_internable(pe.params);
+            }
+        TU_ARMA(UfcsUnknown, pe) {
+            return false;
+            }
+        }
+        throw "";
+    }
+    /// Check if a type is fully resolved (no generics/ivars, and bound) so can be shared globally
+    bool type_is_internable(const ::HIR::TypeRef& ty) {
+        if( ty.is_interned() )
+            return true;
+        TU_MATCH_HDRA( (ty.data()), {)
+        TU_ARMA(Infer, e)   return false;
+        TU_ARMA(Generic, e) return false;
+        TU_ARMA(ErasedType, e)  return false;
+        TU_ARMA(Closure, e) return false;
+        TU_ARMA(Generator, e)   return false;
+        TU_ARMA(Diverge, e) return true;
+        TU_ARMA(Primitive, e)   return true;
+        TU_ARMA(Path, e) {
+            // NOTE: The binding isn't part of the comparison, so an unbound path can't be merged with a bound one
+            return !e.binding.is_Unbound() && path_is_internable(e.path);
+            }
+        TU_ARMA(TraitObject, e) {
+            if( !e.m_trait.m_trait_ptr || !e.m_trait.m_trait_bounds.empty() )
+                return false;
+            if( !params_are_internable(e.m_trait.m_path.m_params) )
+                return false;
+            for(const auto& b : e.m_trait.m_type_bounds)
+                if( !params_are_internable(b.second.source_trait.m_params) || !type_is_internable(b.second.type) )
+                    return false;
+            for(const auto& m : e.m_markers)
+                if( !params_are_internable(m.m_params) )
+                    return false;
+            return lifetime_is_internable(e.m_lifetime);
+            }
+        TU_ARMA(Array, e) {
+            return e.size.is_Known() && type_is_internable(e.inner);
+            }
+        TU_ARMA(Slice, e) {
+            return type_is_internable(e.inner);
+            }
+        TU_ARMA(Tuple, e) {
+            for(const auto& t : e)
+                if( !type_is_internable(t) )
+                    return false;
+            return true;
+            }
+        TU_ARMA(Borrow, e) {
+            return lifetime_is_internable(e.lifetime) && type_is_internable(e.inner);
+            }
+        TU_ARMA(Pointer, e) {
+            return type_is_internable(e.inner);
+            }
+        TU_ARMA(Function, e) {
+            for(const auto& t : e.m_arg_types)
+                if( !type_is_internable(t) )
+                    return false;
+            return type_is_internable(e.m_rettype);
+            }
+        }
+        throw "";
+    }
+
+    void intern_params(::HIR::PathParams& pp) {
+        for(auto& t : pp.m_types)
+            t = t.intern();
+    }
+    /// Replace all directly-contained types with their interned versions
+    void intern_children(::HIR::TypeData& data) {
+        TU_MATCH_HDRA( (data), {)
+        default:
+            break;
+        TU_ARMA(Path, e) {
+            TU_MATCH_HDRA( (e.path.m_data), {)
+            TU_ARMA(Generic, pe) {
+                intern_params(pe.m_params);
+                }
+            TU_ARMA(UfcsInherent, pe) {
+                pe.type = pe.type.intern();
+                intern_params(pe.params);
+                intern_params(pe.impl_params);
+                }
+            TU_ARMA(UfcsKnown, pe) {
+                pe.type = pe.type.intern();
+                intern_params(pe.trait.m_params);
+                intern_params(pe.params);
+                }
+            TU_ARMA(UfcsUnknown, pe) {
+                }
+            }
+            }
+        TU_ARMA(TraitObject, e) {
+            intern_params(e.m_trait.m_path.m_params);
+            }
+        TU_ARMA(Array, e) {
+            e.inner = e.inner.intern();
+            }
+        TU_ARMA(Slice, e) {
+            e.inner = e.inner.intern();
+            }
+        TU_ARMA(Tuple, e) {
+            for(auto& t : e)
+                t = t.intern();
+            }
+        TU_ARMA(Borrow, e) {
+            e.inner = e.inner.intern();
+            }
+        TU_ARMA(Pointer, e) {
+            e.inner = e.inner.intern();
+            }
+        TU_ARMA(Function, e) {
+            for(auto& t : e.m_arg_types)
+                t = t.intern();
+            e.m_rettype = e.m_rettype.intern();
+            }
+        }
+    }
+
+    bool    s_interning_enabled = true;
+    // NOTE: Interned types are never freed
+    ::std::mutex    s_interned_types_lock;
+    ::std::set<::HIR::TypeRef>  s_interned_types;
+
+    /// Look up the interned version of `ty` (caller must hold the lock)
+    const ::HIR::TypeRef* find_interned(const ::HIR::TypeRef& ty) {
+        auto it = s_interned_types.find(ty);
+        if( it == s_interned_types.end() )
+            return nullptr;
+        // `ord` ignores some fields that `==` checks (e.g. trait object lifetimes), and neither look at the binding.
+        // If those differ, this type can't be interned.
+        bool same_binding = !ty.data().is_Path() || ty.data().as_Path().binding.tag() == it->data().as_Path().binding.tag();
+        if( !(*it == ty && same_binding) )
+            return nullptr;
+        return &*it;
+    }
+}
+void HIR::TypeRef::set_interning_enabled(bool enabled)
+{
+    s_interning_enabled = enabled;
+}
+::HIR::TypeRef HIR::TypeRef::intern() const
+{
+    if( !m_ptr || m_ptr->m_is_interned || !s_interning_enabled )
+        return this->clone();
+    if( !type_is_internable(*this) )
+        return this->clone();
+
+    {
+        ::std::lock_guard<::std::mutex> lh { s_interned_types_lock };
+        if( const auto* existing = find_interned(*this) )
+            return existing->clone();
+    }
+
+    // Not yet known: intern the children first so they're shared (and later comparisons can short-circuit on pointer
+    // equality), then add this type.
+    auto rv = this->clone_shallow();
+    intern_children(rv.m_ptr->m_data);
+
+    ::std::lock_guard<::std::mutex> lh { s_interned_types_lock };
+    if( const auto* existing = find_interned(rv) )
+        return existing->clone();
+    // Same ordering as an existing entry, but not equal - leave un-interned
+    if( s_interned_types.count(rv) )
+        return rv;
+    rv.m_ptr->m_is_interned = true;
+    s_interned_types.insert(rv.clone());
+    return rv;
+}
 ::HIR::Compare HIR::TypeRef::compare_with_placeholders(const Span& sp, const ::HIR::TypeRef& x, t_cb_resolve_type resolve_placeholder) const
 {
     //TRACE_FUNCTION_F(*this << " ?= " << x);
@@ -211,12 +211,17 @@ public:
     // Existing TypeRef
 
 private:
-    unsigned    m_refcount;
+    ::std::atomic<unsigned>    m_refcount;
+    // Set if this is the globally unique instance from `TypeRef::intern`, the data must not be modified
+    bool    m_is_interned;
 public:
     TypeData   m_data;
+
+    MEMORY_STATS_ALLOCATOR(HirTypeRef)
 private:
     TypeInner(TypeData d):
         m_refcount(1),
+        m_is_interned(false),
         m_data(mv$(d))
     {
     }
@@ -239,8 +244,7 @@ inline TypeRef::~TypeRef()
 {
     if(m_ptr)
     {
-        m_ptr->m_refcount -= 1;
-        if(m_ptr->m_refcount == 0)
+        if( (m_ptr->m_refcount -= 1) == 0 )
         {
             delete m_ptr;
             m_ptr = nullptr;
@@ -248,7 +252,8 @@ inline TypeRef::~TypeRef()
     }
 }
 inline const TypeData& TypeRef::data() const { assert(m_ptr); return m_ptr->m_data; }
-inline TypeData& TypeRef::data_mut() { assert(m_ptr); return m_ptr->m_data; }
+inline TypeData& TypeRef::data_mut() { assert(m_ptr); if(m_ptr->m_is_interned) *this = this->clone_shallow(); return m_ptr->m_data; }
+inline bool TypeRef::is_interned() const { return m_ptr && m_ptr->m_is_interned; }
 inline TypeData& TypeRef::get_unique() { assert(m_ptr); if(m_ptr->m_refcount != 1) *this = this->clone_shallow(); return m_ptr->m_data; }
 
 
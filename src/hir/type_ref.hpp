@@ -100,6 +100,12 @@ public:
     TypeRef clone() const;
     // Duplicate data, inner refcount
     TypeRef clone_shallow() const;
+    /// Get the globally unique instance of this type (or a plain clone if it's not fully resolved)
+    /// - Interned types are compared by pointer, and are copied on `data_mut`
+    TypeRef intern() const;
+    bool is_interned() const;
+    /// Disable `intern` (for debugging), must be called before any types are interned
+    static void set_interning_enabled(bool enabled);
     /// Duplicate recursively
     //TypeRef clone_deep() const;
     void fmt(::std::ostream& os) const;
@@ -108,6 +114,8 @@ public:
     bool operator!=(const ::HIR::TypeRef& x) const { return !(*this == x); }
     bool operator<(const ::HIR::TypeRef& x) const { return ord(x) == OrdLess; }
     Ordering ord(const ::HIR::TypeRef& x) const;
+    /// Structural hash, consistent with `==` (for use in unordered containers)
+    size_t hash() const;
 
 
     //void match_generics(const Span& sp, const ::HIR::TypeRef& x_in, t_cb_resolve_type resolve_placeholder, MatchGenerics& callback) const;
@@ -121,4 +129,11 @@ public:
     const ::HIR::SimplePath* get_sort_path() const;
 };
 
-}
\ No newline at end of file
+}
+
+namespace std {
+    template<> struct hash<::HIR::TypeRef>
+    {
+        size_t operator()(const ::HIR::TypeRef& ty) const { return ty.hash(); }
+    };
+}
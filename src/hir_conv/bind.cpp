@@ -644,10 +644,28 @@ namespace {
 
                 this->m_in_expr --;
             }
+            // External expression, MIR not loaded yet (bind once it's loaded)
+            else if( expr.m_mir && !expr.m_mir.is_loaded() )
+            {
+                const auto* crate = &m_crate;
+                expr.m_mir.set_post_load([crate](::MIR::Function& mir) {
+                    ConvertHIR_Bind_Mir(*crate, mir);
+                    });
+            }
             // External expression (has MIR)
             else if( auto* mir = expr.get_ext_mir_mut() )
             {
-                for(auto& ty : mir->locals)
+                visit_mir(*mir);
+            }
+            else
+            {
+            }
+        }
+
+        void visit_mir(::MIR::Function& mir)
+        {
+            {
+                for(auto& ty : mir.locals)
                     this->visit_type(ty);
                 struct MirVisitor: public ::MIR::visit::VisitorMut
                 {
@@ -670,7 +688,7 @@ namespace {
                     }
                 };
                 MirVisitor  mv(*this);
-                for(auto& block : mir->blocks)
+                for(auto& block : mir.blocks)
                 {
                     for(auto& stmt : block.statements)
                     {
@@ -679,9 +697,6 @@ namespace {
                     mv.visit_terminator(block.terminator);
                 }
             }
-            else
-            {
-            }
         }
     };
 
@@ -890,3 +905,8 @@ void ConvertHIR_Bind(::HIR::Crate& crate)
     // Populate supertrait list
     Visitor_EnumSuperTraits(crate).visit_crate(crate);
 }
+void ConvertHIR_Bind_Mir(const ::HIR::Crate& crate, ::MIR::Function& mir)
+{
+    Visitor exp { crate };
+    exp.visit_mir(mir);
+}
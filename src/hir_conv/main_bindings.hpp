@@ -17,10 +17,15 @@ namespace HIR {
     class GenericParams;
     struct PathParams;
 };
+namespace MIR {
+    class Function;
+};
 
 extern void ConvertHIR_ExpandAliases(::HIR::Crate& crate);
 extern void ConvertHIR_ExpandAliases_Self(::HIR::Crate& crate);
 extern void ConvertHIR_Bind(::HIR::Crate& crate);
+/// Bind paths in a MIR body loaded from disk (e.g. the incremental cache)
+extern void ConvertHIR_Bind_Mir(const ::HIR::Crate& crate, ::MIR::Function& mir);
 extern void ConvertHIR_ResolveUFCS_SortImpls(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS_Outer(::HIR::Crate& crate);
 extern void ConvertHIR_ResolveUFCS(::HIR::Crate& crate);
@@ -935,7 +935,7 @@ namespace resolve_ufcs {
             }
             else
             {
-                ig.non_named.push_back(mv$(ty_impl));
+                ig.push(mv$(ty_impl));
             }
             return true;
             });
@@ -956,7 +956,9 @@ namespace resolve_ufcs {
         for(const auto& e : src.named) {
             push_index_impl_group_list(dst.named[e.first], e.second);
         }
-        push_index_impl_group_list(dst.non_named, src.non_named);
+        for(const auto& e : src.non_named) {
+            dst.push(&*e);
+        }
         push_index_impl_group_list(dst.generic  , src.generic  );
     }
     void push_index_impls(::HIR::Crate& dst, const ::HIR::Crate& src)
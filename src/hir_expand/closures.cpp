@@ -60,10 +60,8 @@ namespace {
     void OutState::push_new_impls(const Span& sp, ::HIR::Crate& crate)
     {
         auto push_trait_impl = [&](const ::HIR::SimplePath& p, std::unique_ptr<::HIR::TraitImpl> ptr) {
-            auto& trait_impl_list_r = crate.m_all_trait_impls[p].get_list_for_type_mut(ptr->m_type);
-            trait_impl_list_r.push_back(ptr.get());
-            auto& trait_impl_list   = crate.m_trait_impls[p].get_list_for_type_mut(ptr->m_type);
-            trait_impl_list.push_back(mv$(ptr));
+            crate.m_all_trait_impls[p].push(ptr.get());
+            crate.m_trait_impls[p].push(mv$(ptr));
             };
         for(auto& impl : this->impls_closure)
         {
@@ -880,8 +878,7 @@ namespace {
             if( node.m_is_copy )
             {
                 auto lang_Copy = m_resolve.m_crate.get_lang_item_path(sp, "copy");
-                auto& v = const_cast<::HIR::Crate&>(m_resolve.m_crate).m_trait_impls[lang_Copy].get_list_for_type_mut(closure_type);
-                v.push_back(box$(::HIR::TraitImpl {
+                const auto& impl_ptr = const_cast<::HIR::Crate&>(m_resolve.m_crate).m_trait_impls[lang_Copy].push(box$(::HIR::TraitImpl {
                     params.clone(), {}, closure_type.clone(),
                     {},
                     {},
@@ -889,7 +886,7 @@ namespace {
                     {},
                     /*source module*/::HIR::SimplePath(m_resolve.m_crate.m_crate_name, {})
                     }));
-                const_cast<::HIR::Crate&>(m_resolve.m_crate).m_all_trait_impls[lang_Copy].get_list_for_type_mut(closure_type).push_back( v.back().get() );
+                const_cast<::HIR::Crate&>(m_resolve.m_crate).m_all_trait_impls[lang_Copy].push( impl_ptr.get() );
             }
 
             // ---
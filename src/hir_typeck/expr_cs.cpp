@@ -10,6 +10,9 @@
 #include <hir/hir.hpp>
 #include <hir/visitor.hpp>
 #include <algorithm>    // std::find_if
+#include <chrono>
+#include <fstream>
+#include <mutex>
 
 #include <hir_typeck/static.hpp>
 #include "helpers.hpp"
@@ -7048,6 +7051,102 @@ namespace
 
 
 
+// --------------------------------------------------------------------
+// Inference profiling (`-Z typeck-profile=<file>`)
+// --------------------------------------------------------------------
+namespace {
+    /// Statistics for one run of the fixed-point loop in `Typecheck_Code_CS`
+    struct InferenceProfile
+    {
+        ::std::string   item;
+        ::std::string   location;
+        double  time_s = 0;
+        unsigned    passes = 0;
+        size_t  ivars = 0;
+        // Rule counts after enumeration
+        size_t  rules_coerce = 0;
+        size_t  rules_assoc = 0;
+        size_t  rules_revisit = 0;
+        size_t  rules_adv_revisit = 0;
+        // Total number of times a rule was checked/revisited (summed across all passes)
+        uint64_t    rule_checks = 0;
+        // Number of passes where each of the fallback stages ran (i.e. nothing else made progress)
+        unsigned    fallback_ivar_poss = 0;
+        unsigned    fallback_assume = 0;
+        unsigned    fallback_ignore_disable = 0;
+        unsigned    fallback_revisit = 0;
+        unsigned    fallback_final = 0;
+        unsigned    fallback_defaults = 0;
+        unsigned    fallback_coerce_consume = 0;
+
+        size_t total_rules() const {
+            return rules_coerce + rules_assoc + rules_revisit + rules_adv_revisit;
+        }
+        /// Flag bodies where each pass re-checks most of the rules and the pass count grows with the rule count
+        bool is_quadratic() const {
+            auto n = total_rules();
+            return n >= 32 && rule_checks >= n * n / 8;
+        }
+    };
+
+    ::std::string   g_typeck_profile_path;
+    ::std::mutex    g_typeck_profile_lock;
+    ::std::vector<InferenceProfile> g_typeck_profiles;
+
+    void write_typeck_profile()
+    {
+        ::std::ofstream os(g_typeck_profile_path);
+        if( !os.good() ) {
+            ::std::cerr << "Unable to open " << g_typeck_profile_path << " for writing" << ::std::endl;
+            return ;
+        }
+        // Slowest first, ties broken by location so the output is stable
+        ::std::sort(g_typeck_profiles.begin(), g_typeck_profiles.end(), [](const InferenceProfile& a, const InferenceProfile& b) {
+            if( a.time_s != b.time_s )
+                return a.time_s > b.time_s;
+            return a.location < b.location;
+            });
+        // NOTE: Tab-separated with a header line, for use with `sort -t$'\t' -k<n>` and spreadsheets
+        os << "time_us\tpasses\tivars\trules_coerce\trules_assoc\trules_revisit\trules_adv_revisit\trule_checks"
+            << "\tfb_ivar_poss\tfb_assume\tfb_ignore_disable\tfb_revisit\tfb_final\tfb_defaults\tfb_coerce_consume"
+            << "\tquadratic\tlocation\titem\n";
+        for(const auto& p : g_typeck_profiles)
+        {
+            os << static_cast<uint64_t>(p.time_s * 1e6)
+                << "\t" << p.passes
+                << "\t" << p.ivars
+                << "\t" << p.rules_coerce
+                << "\t" << p.rules_assoc
+                << "\t" << p.rules_revisit
+                << "\t" << p.rules_adv_revisit
+                << "\t" << p.rule_checks
+                << "\t" << p.fallback_ivar_poss
+                << "\t" << p.fallback_assume
+                << "\t" << p.fallback_ignore_disable
+                << "\t" << p.fallback_revisit
+                << "\t" << p.fallback_final
+                << "\t" << p.fallback_defaults
+                << "\t" << p.fallback_coerce_consume
+                << "\t" << (p.is_quadratic() ? "yes" : "no")
+                << "\t" << p.location
+                << "\t" << p.item
+                << "\n";
+        }
+    }
+}
+
+void Typecheck_EnableProfile(const ::std::string& path)
+{
+    if( g_typeck_profile_path == "" ) {
+        ::std::atexit(write_typeck_profile);
+    }
+    g_typeck_profile_path = path;
+}
+bool Typecheck_ProfileEnabled()
+{
+    return g_typeck_profile_path != "";
+}
+
 void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr)
 {
     TRACE_FUNCTION;
@@ -7056,9 +7155,18 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
     assert(!ms.m_mod_paths.empty());
     Context context { ms.m_crate, ms.m_impl_generics, ms.m_item_generics, ms.m_mod_paths.back(), ms.m_current_trait };
 
+    const bool profile_enabled = Typecheck_ProfileEnabled();
+    InferenceProfile    prof;
+    auto prof_start = profile_enabled ? ::std::chrono::steady_clock::now() : ::std::chrono::steady_clock::time_point();
+
     // - Build up ruleset from node tree
     Typecheck_Code_CS__EnumerateRules(context, ms, args, result_type, expr, root_ptr);
 
+    prof.rules_coerce = context.link_coerce.size();
+    prof.rules_assoc = context.link_assoc.size();
+    prof.rules_revisit = context.to_visit.size();
+    prof.rules_adv_revisit = context.adv_revisits.size();
+
     const unsigned int MAX_ITERATIONS = 1000;
     unsigned int count = 0;
     while( context.take_changed() /*&& context.has_rules()*/ && count < MAX_ITERATIONS )
@@ -7072,6 +7180,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         if( ! context.m_ivars.peek_changed() )
         {
             DEBUG("--- Coercion checking");
+            prof.rule_checks += context.link_coerce.size();
             for(size_t i = 0; i < context.link_coerce.size(); )
             {
                 auto ent = mv$(context.link_coerce[i]);
@@ -7097,6 +7206,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
             for(unsigned int i = 0; i < context.link_assoc.size(); ) {
                 // - Move out (and back in later) to avoid holding a bad pointer if the list is updated
                 auto rule = mv$(context.link_assoc[i]);
+                prof.rule_checks += 1;
 
                 DEBUG("- " << rule);
                 for( auto& ty : rule.params.m_types ) {
@@ -7136,6 +7246,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         if( ! context.m_ivars.peek_changed() )
         {
             DEBUG("--- Node revisits");
+            prof.rule_checks += context.to_visit.size() + context.adv_revisits.size();
             for( auto it = context.to_visit.begin(); it != context.to_visit.end(); )
             {
                 ::HIR::ExprNode& node = **it;
@@ -7175,6 +7286,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         {
             // Check the possible equations
             DEBUG("--- IVar possibilities");
+            prof.fallback_ivar_poss += 1;
             // TODO: De-duplicate this with the block ~80 lines below
             //for(unsigned int i = context.possible_ivar_vals.size(); i --; ) // NOTE: Ordering is a hack for libgit2
             for(unsigned int i = 0; i < context.possible_ivar_vals.size(); i ++ )
@@ -7220,6 +7332,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         {
             // Check the possible equations
             DEBUG("--- IVar possibilities (fallback 1)");
+            prof.fallback_assume += 1;
             //for(unsigned int i = context.possible_ivar_vals.size(); i --; ) // NOTE: Ordering is a hack for libgit2
             for(unsigned int i = 0; i < context.possible_ivar_vals.size(); i ++ )
             {
@@ -7235,6 +7348,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         {
             // Check the possible equations
             DEBUG("--- IVar possibilities (fallback)");
+            prof.fallback_ignore_disable += 1;
             //for(unsigned int i = context.possible_ivar_vals.size(); i --; ) // NOTE: Ordering is a hack for libgit2
             for(unsigned int i = 0; i < context.possible_ivar_vals.size(); i ++ )
             {
@@ -7251,6 +7365,8 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         if( !context.m_ivars.peek_changed() )
         {
             DEBUG("--- Node revisits (fallback)");
+            prof.fallback_revisit += 1;
+            prof.rule_checks += context.to_visit.size() + context.adv_revisits.size();
             for( auto it = context.to_visit.begin(); it != context.to_visit.end(); )
             {
                 ::HIR::ExprNode& node = **it;
@@ -7289,6 +7405,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         {
             // Check the possible equations
             DEBUG("--- IVar possibilities (final fallback)");
+            prof.fallback_final += 1;
             //for(unsigned int i = context.possible_ivar_vals.size(); i --; ) // NOTE: Ordering is a hack for libgit2
             for(unsigned int i = 0; i < context.possible_ivar_vals.size(); i ++ )
             {
@@ -7323,6 +7440,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         if( !context.m_ivars.peek_changed() )
         {
             DEBUG("- Applying defaults");
+            prof.fallback_defaults += 1;
             if( context.m_ivars.apply_defaults() ) {
                 context.m_ivars.mark_change();
             }
@@ -7360,6 +7478,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
             DEBUG("--- Coercion consume");
             if( ! context.link_coerce.empty() )
             {
+                prof.fallback_coerce_consume += 1;
                 auto ent = mv$(context.link_coerce.front());
                 context.link_coerce.erase( context.link_coerce.begin() );
 
@@ -7383,6 +7502,18 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         count ++;
         context.m_resolve.compact_ivars(context.m_ivars);
     }
+    if( profile_enabled )
+    {
+        prof.item = ms.m_item_name;
+        const auto& sp = root_ptr->span();
+        // NOTE: Function bodies can have a generated root block with no location
+        prof.location = sp->filename == "" ? ::std::string("-") : FMT(sp->filename << ":" << sp->start_line);
+        prof.passes = count;
+        prof.ivars = context.m_ivars.m_ivars.size();
+        prof.time_s = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - prof_start).count();
+        ::std::lock_guard<::std::mutex> lh { g_typeck_profile_lock };
+        g_typeck_profiles.push_back(mv$(prof));
+    }
     if( count == MAX_ITERATIONS ) {
         BUG(root_ptr->span(), "Typecheck ran for too many iterations, max - " << MAX_ITERATIONS);
     }
@@ -7476,50 +7607,60 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
         StaticTraitResolve  static_resolve(ms.m_crate);
         static_resolve.set_both_generics_raw(ms.m_impl_generics, ms.m_item_generics);
         Typecheck_Expressions_ValidateOne(static_resolve, args, result_type, expr);
+    }
+}
 
-        DEBUG("=== Method const params ===");
-        struct VisitMethodConst: public HIR::ExprVisitorDef {
-            const typeck::ModuleState&  ms;
-            const StaticTraitResolve& static_resolve;
+/// Evaluate any un-evaluated const generic parameters on method calls
+///
+/// Separate from `Typecheck_Code_CS`, as this runs constant evaluation (which can access other items)
+void Typecheck_Code_CS_MethodConstParams(const typeck::ModuleState& ms, ::HIR::ExprPtr& expr)
+{
+    TRACE_FUNCTION;
+    StaticTraitResolve  static_resolve(ms.m_crate);
+    static_resolve.set_both_generics_raw(ms.m_impl_generics, ms.m_item_generics);
 
-            VisitMethodConst(const typeck::ModuleState& ms, const StaticTraitResolve& static_resolve)
-                : ms(ms)
-                , static_resolve(static_resolve)
-            {
-            }
+    DEBUG("=== Method const params ===");
+    struct VisitMethodConst: public HIR::ExprVisitorDef {
+        const typeck::ModuleState&  ms;
+        const StaticTraitResolve& static_resolve;
 
-            void visit(HIR::ExprNode_CallMethod& node) override {
-                HIR::ExprVisitorDef::visit(node);
+        VisitMethodConst(const typeck::ModuleState& ms, const StaticTraitResolve& static_resolve)
+            : ms(ms)
+            , static_resolve(static_resolve)
+        {
+        }
 
-                HIR::PathParams*    params_ptr = nullptr;
-                TU_MATCH_HDRA( (node.m_method_path.m_data), {)
-                TU_ARMA(Generic, _pe)   BUG(node.span(), "");
-                TU_ARMA(UfcsUnknown, _pe)   BUG(node.span(), "");
-                TU_ARMA(UfcsKnown, pe)  params_ptr = &pe.params;
-                TU_ARMA(UfcsInherent, pe)  params_ptr = &pe.params;
-                }
-                assert(params_ptr);
+        void visit(HIR::ExprNode_CallMethod& node) override {
+            HIR::ExprVisitorDef::visit(node);
 
-                bool found = false;
-                for(auto& v : params_ptr->m_values)
-                {
-                    if(v.is_Unevaluated())
-                    {
-                        found = true;
-                    }
-                }
-                if(found)
+            HIR::PathParams*    params_ptr = nullptr;
+            TU_MATCH_HDRA( (node.m_method_path.m_data), {)
+            TU_ARMA(Generic, _pe)   BUG(node.span(), "");
+            TU_ARMA(UfcsUnknown, _pe)   BUG(node.span(), "");
+            TU_ARMA(UfcsKnown, pe)  params_ptr = &pe.params;
+            TU_ARMA(UfcsInherent, pe)  params_ptr = &pe.params;
+            }
+            assert(params_ptr);
+
+            bool found = false;
+            for(auto& v : params_ptr->m_values)
+            {
+                if(v.is_Unevaluated())
                 {
-                    TRACE_FUNCTION_FR("Method const params: " << node.m_method_path, "Method const params");
-                    MonomorphState  out_params;
-                    auto val_ref = static_resolve.get_value(node.span(), node.m_method_path, out_params, /*signature_only=*/true, nullptr);
-                    const HIR::Function& fcn = *val_ref.as_Function();
-                    const HIR::GenericParams& gp_def = fcn.m_params;
-                    ConvertHIR_ConstantEvaluate_MethodParams(node.span(), ms.m_crate, ms.m_mod_paths.back(), ms.m_impl_generics, ms.m_item_generics, gp_def, *params_ptr);
+                    found = true;
                 }
             }
-        } v(ms, static_resolve);
-        expr->visit(v);
-    }
+            if(found)
+            {
+                TRACE_FUNCTION_FR("Method const params: " << node.m_method_path, "Method const params");
+                MonomorphState  out_params;
+                auto val_ref = static_resolve.get_value(node.span(), node.m_method_path, out_params, /*signature_only=*/true, nullptr);
+                const HIR::Function& fcn = *val_ref.as_Function();
+                const HIR::GenericParams& gp_def = fcn.m_params;
+                ConvertHIR_ConstantEvaluate_MethodParams(node.span(), ms.m_crate, ms.m_mod_paths.back(), ms.m_impl_generics, ms.m_item_generics, gp_def, *params_ptr);
+            }
+        }
+    } v(ms, static_resolve);
+    expr->visit(v);
 }
 
@@ -10,12 +10,17 @@
 #include <hir/visitor.hpp>
 #include "expr_visit.hpp"
 #include <hir/expr_state.hpp>
+#include <parallel.hpp>
+#include <memory>
+#include <set>
+#include <sstream>
 
 void Typecheck_Code(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr) {
     if( expr.m_state->stage < ::HIR::ExprState::Stage::Typecheck )
     {
         //Typecheck_Code_Simple(ms, args, result_type, expr);
         Typecheck_Code_CS(ms, args, result_type, expr);
+        Typecheck_Code_CS_MethodConstParams(ms, expr);
     }
 }
 
@@ -105,17 +110,67 @@ namespace typeck {
 
 namespace {
 
+    /// A single expression to be typechecked by `Typecheck_Expressions` when running on multiple threads
+    struct TypecheckJob
+    {
+        // NOTE: Owned copies of state that the serial visitor has on its stack
+        ::typeck::ModuleState   ms;
+        ::std::unique_ptr<::HIR::GenericPath>   current_trait;
+        t_args  tmp_args;
+        t_args* args;
+        ::HIR::TypeRef  result_type;
+        ::HIR::ExprPtr* expr;
+
+        // Diagnostics emitted by this job, printed in job order once all jobs are complete
+        ::std::stringstream diagnostics;
+        bool    failed = false;
+        bool    aborted = false;
+
+        TypecheckJob(const ::typeck::ModuleState& ms):
+            ms(ms),
+            args(nullptr),
+            expr(nullptr)
+        {
+        }
+    };
 
     class OuterVisitor:
         public ::HIR::Visitor
     {
         ::typeck::ModuleState m_ms;
+        // If non-null, expressions are collected instead of being checked immediately
+        ::std::vector<::std::unique_ptr<TypecheckJob>>* m_jobs;
+        ::std::set<const ::HIR::ExprPtr*>   m_seen_exprs;
     public:
-        OuterVisitor(::HIR::Crate& crate):
-            m_ms(crate)
+        OuterVisitor(::HIR::Crate& crate, ::std::vector<::std::unique_ptr<TypecheckJob>>* jobs=nullptr):
+            m_ms(crate),
+            m_jobs(jobs)
         {
         }
 
+    private:
+        void typecheck(const ::HIR::ItemPath* p, t_args* args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr)
+        {
+            m_ms.m_item_name = p && Typecheck_ProfileEnabled() ? FMT(*p) : ::std::string();
+            if( !m_jobs ) {
+                t_args  tmp;
+                Typecheck_Code(m_ms, args ? *args : tmp, result_type, expr);
+                return ;
+            }
+            // NOTE: Types can share an array size expression, so only check each expression once
+            if( expr.m_state->stage >= ::HIR::ExprState::Stage::Typecheck || !m_seen_exprs.insert(&expr).second )
+                return ;
+            auto job = ::std::unique_ptr<TypecheckJob>(new TypecheckJob(m_ms));
+            if( m_ms.m_current_trait ) {
+                job->current_trait.reset(new ::HIR::GenericPath(m_ms.m_current_trait->clone()));
+                job->ms.m_current_trait = job->current_trait.get();
+            }
+            job->args = args ? args : &job->tmp_args;
+            job->result_type = result_type.clone();
+            job->expr = &expr;
+            m_jobs->push_back(mv$(job));
+        }
+
 
     public:
         void visit_module(::HIR::ItemPath p, ::HIR::Module& mod) override
@@ -186,10 +241,9 @@ namespace {
             {
                 this->visit_type( e->inner );
                 DEBUG("Array size " << ty);
-                t_args  tmp;
                 if( auto* se = e->size.opt_Unevaluated() ) {
                     if( se->is_Unevaluated() ) {
-                        Typecheck_Code( m_ms, tmp, ::HIR::TypeRef(::HIR::CoreType::Usize), *se->as_Unevaluated() );
+                        this->typecheck( nullptr, nullptr, ::HIR::TypeRef(::HIR::CoreType::Usize), *se->as_Unevaluated() );
                     }
                 }
             }
@@ -205,7 +259,7 @@ namespace {
             if( item.m_code )
             {
                 DEBUG("Function code " << p);
-                Typecheck_Code( m_ms, item.m_args, item.m_return, item.m_code );
+                this->typecheck( &p, &item.m_args, item.m_return, item.m_code );
             }
             else
             {
@@ -217,8 +271,7 @@ namespace {
             if( item.m_value )
             {
                 DEBUG("Static value " << p);
-                t_args  tmp;
-                Typecheck_Code(m_ms, tmp, item.m_type, item.m_value);
+                this->typecheck(&p, nullptr, item.m_type, item.m_value);
             }
         }
         void visit_constant(::HIR::ItemPath p, ::HIR::Constant& item) override {
@@ -226,8 +279,7 @@ namespace {
             if( item.m_value )
             {
                 DEBUG("Const value " << p);
-                t_args  tmp;
-                Typecheck_Code(m_ms, tmp, item.m_type, item.m_value);
+                this->typecheck(&p, nullptr, item.m_type, item.m_value);
             }
         }
         void visit_enum(::HIR::ItemPath p, ::HIR::Enum& item) override {
@@ -242,8 +294,8 @@ namespace {
                     DEBUG("Enum value " << p << " - " << var.name);
                     if( var.expr )
                     {
-                        t_args  tmp;
-                        Typecheck_Code(m_ms, tmp, enum_type, var.expr);
+                        auto var_p = p + var.name;
+                        this->typecheck(&var_p, nullptr, enum_type, var.expr);
                     }
                 }
             }
@@ -251,8 +303,84 @@ namespace {
     };
 }
 
-void Typecheck_Expressions(::HIR::Crate& crate)
+void Typecheck_Expressions(::HIR::Crate& crate, unsigned num_threads)
 {
-    OuterVisitor    visitor { crate };
-    visitor.visit_crate( crate );
+    // Debug output is only readable when run serially
+    if( debug_enabled() )
+    {
+        num_threads = 1;
+    }
+    if( num_threads <= 1 )
+    {
+        OuterVisitor    visitor { crate };
+        visitor.visit_crate( crate );
+        return ;
+    }
+
+    // Multi-threaded: Enumerate all bodies (in the same order as the serial version) then check them in parallel
+    ::std::vector<::std::unique_ptr<TypecheckJob>>  jobs;
+    {
+        OuterVisitor    visitor { crate, &jobs };
+        visitor.visit_crate( crate );
+    }
+    DEBUG(jobs.size() << " bodies across " << num_threads << " threads");
+
+    // NOTE: Inherent method lookup and trait impl lists are only read here (they're populated by earlier passes),
+    // and the auto trait cache in `TraitMarkings` is locked.
+    try
+    {
+        parallel_for_each_index(num_threads, jobs.size(), [&](size_t idx) {
+            auto& job = *jobs[idx];
+            // Errors are captured (and thrown as `Span::Abort`) so they can be reported in a stable order
+            Span::CaptureDiagnostics    capture { job.diagnostics };
+            try
+            {
+                Typecheck_Code_CS(job.ms, *job.args, job.result_type, *job.expr);
+            }
+            catch(const Span::Abort& )
+            {
+                job.failed = true;
+                job.aborted = true;
+                throw;
+            }
+            catch(...)
+            {
+                job.failed = true;
+                throw;
+            }
+            });
+    }
+    catch(...)
+    {
+        // Emit diagnostics up to (and including) the first failed body, matching what a serial run prints
+        for(const auto& job : jobs)
+        {
+            ::std::cerr << job->diagnostics.str();
+            if( job->failed )
+            {
+                ::std::cerr.flush();
+                // A reported error/bug terminates (same as `Span::error`), anything else propagates
+                if( job->aborted )
+                {
+#ifndef _WIN32
+                    abort();
+#else
+                    exit(1);
+#endif
+                }
+                break;
+            }
+        }
+        throw;
+    }
+    for(const auto& job : jobs)
+    {
+        ::std::cerr << job->diagnostics.str();
+    }
+
+    // Method const parameters run constant evaluation (which can access any item), so are done serially afterwards
+    for(auto& job : jobs)
+    {
+        Typecheck_Code_CS_MethodConstParams(job->ms, *job->expr);
+    }
 }
@@ -19,6 +19,8 @@ namespace typeck {
 
         ::std::vector< ::std::pair< const ::HIR::SimplePath*, const ::HIR::Trait* > >   m_traits;
         ::std::vector<HIR::SimplePath>  m_mod_paths;
+        // Path of the item being checked, only populated when profiling (see `Typecheck_ProfileEnabled`)
+        ::std::string   m_item_name;
 
         ModuleState(const ::HIR::Crate& crate):
             m_crate(crate),
@@ -82,4 +84,6 @@ typedef ::std::vector< ::std::pair<::HIR::Pattern, ::HIR::TypeRef> >    t_args;
 // Needs to mutate the pattern
 extern void Typecheck_Code(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr);
 extern void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr);
+extern void Typecheck_Code_CS_MethodConstParams(const typeck::ModuleState& ms, ::HIR::ExprPtr& expr);
+extern bool Typecheck_ProfileEnabled();
 extern void Typecheck_Code_Simple(const typeck::ModuleState& ms, t_args& args, const ::HIR::TypeRef& result_type, ::HIR::ExprPtr& expr);
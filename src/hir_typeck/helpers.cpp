@@ -7,6 +7,7 @@
  */
 #include "helpers.hpp"
 #include <algorithm>
+#include <mutex>
 
 // --------------------------------------------------------------------
 // HMTypeInferrence
@@ -2634,6 +2635,10 @@ bool TraitResolution::find_trait_impls_bound(const Span& sp, const ::HIR::Simple
     }
     return false;
 }
+namespace {
+    // Protects `HIR::TraitMarkings::auto_impls` (a cache shared between threads running expression typecheck)
+    ::std::mutex    s_auto_impls_lock;
+}
 bool TraitResolution::find_trait_impls_crate(const Span& sp,
         const ::HIR::SimplePath& trait, const ::HIR::PathParams* params_ptr,
         const ::HIR::TypeRef& type,
@@ -2675,7 +2680,8 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         StackHandle& operator=(const StackHandle&) = delete;
         ~StackHandle() { if(stack) stack->pop_back(); stack = nullptr; }
     };
-    static std::vector<StackEnt>    s_recurse_stack;
+    // NOTE: Thread-local, as expression typecheck can run on multiple threads
+    static thread_local std::vector<StackEnt>    s_recurse_stack;
     auto se = StackEnt(trait, params_ptr, type);
     // NOTE: Allow 1 level of recursion (EAT being run)
     if( std::count(s_recurse_stack.begin(), s_recurse_stack.end(), se) > 1 ) {
@@ -2691,7 +2697,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
     if( m_crate.get_trait_by_path(sp, trait).m_is_marker )
     {
         // Detect recursion and return true if detected
-        static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
+        static thread_local ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
         for(const auto& ent : stack ) {
             if( *::std::get<0>(ent) != trait )
                 continue ;
@@ -2727,13 +2733,17 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         // - Cache populated after destructure
         if( markings )
         {
+            ::std::unique_lock<::std::mutex>    lh { s_auto_impls_lock };
             auto it = markings->auto_impls.find( trait );
             if( it != markings->auto_impls.end() )
             {
-                if( ! it->second.conditions.empty() ) {
+                bool has_conditions = !it->second.conditions.empty();
+                bool is_impled = it->second.is_impled;
+                lh.unlock();
+                if( has_conditions ) {
                     TODO(sp, "Conditional auto trait impl");
                 }
-                else if( it->second.is_impled ) {
+                else if( is_impled ) {
                     return callback( ImplRef(&type, params_ptr, &null_assoc), ::HIR::Compare::Equal );
                 }
                 else {
@@ -2807,6 +2817,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         {
             if( markings ) {
                 ASSERT_BUG(sp, cmp == ::HIR::Compare::Equal, "Auto trait with no params returned a fuzzy match from destructure - " << trait << " for " << type);
+                ::std::lock_guard<::std::mutex>    lh { s_auto_impls_lock };
                 markings->auto_impls.insert( ::std::make_pair(trait, ::HIR::TraitMarkings::AutoMarking { {}, true }) );
             }
             return callback( ImplRef(&type, params_ptr, &null_assoc), cmp );
@@ -2814,6 +2825,7 @@ bool TraitResolution::find_trait_impls_crate(const Span& sp,
         else
         {
             if( markings ) {
+                ::std::lock_guard<::std::mutex>    lh { s_auto_impls_lock };
                 markings->auto_impls.insert( ::std::make_pair(trait, ::HIR::TraitMarkings::AutoMarking { {}, false }) );
             }
             return false;
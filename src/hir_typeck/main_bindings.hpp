@@ -6,11 +6,14 @@
  * - Functions in HIR typecheck called by main
  */
 #pragma once
+#include <string>
 
 namespace HIR {
     class Crate;
 };
 
 extern void Typecheck_ModuleLevel(::HIR::Crate& crate);
-extern void Typecheck_Expressions(::HIR::Crate& crate);
+extern void Typecheck_Expressions(::HIR::Crate& crate, unsigned num_threads);
 extern void Typecheck_Expressions_Validate(::HIR::Crate& crate);
+/// Record per-body inference statistics, written to `path` (tab-separated) on exit
+extern void Typecheck_EnableProfile(const ::std::string& path);
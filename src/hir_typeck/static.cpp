@@ -8,6 +8,18 @@
 #include "static.hpp"
 #include <algorithm>
 #include <hir/expr.hpp>
+#include <debug_inner.hpp>  // DebugCounter
+
+namespace {
+    DebugCounter    s_copy_cache_hit("StaticTraitResolve copy cache hit");
+    DebugCounter    s_copy_cache_miss("StaticTraitResolve copy cache miss");
+    DebugCounter    s_clone_cache_hit("StaticTraitResolve clone cache hit");
+    DebugCounter    s_clone_cache_miss("StaticTraitResolve clone cache miss");
+    DebugCounter    s_drop_cache_hit("StaticTraitResolve drop cache hit");
+    DebugCounter    s_drop_cache_miss("StaticTraitResolve drop cache miss");
+    DebugCounter    s_aty_cache_hit("StaticTraitResolve aty cache hit");
+    DebugCounter    s_aty_cache_miss("StaticTraitResolve aty cache miss");
+}
 
 bool StaticTraitResolve::find_impl(
     const Span& sp,
@@ -75,30 +87,35 @@ bool StaticTraitResolve::find_impl(
             }
             else {
             }
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
-            if(assoc_unit.empty()) {
-                assoc_unit.insert(std::make_pair( RcString::new_interned("Discriminant"), HIR::TraitPath::AtyEqual {
+            // NOTE: Initialised using a lambda so the initialisation is thread-safe
+            static const ::HIR::TraitPath::assoc_list_t   assoc_unit = [&]() {
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( RcString::new_interned("Discriminant"), HIR::TraitPath::AtyEqual {
                     m_lang_DiscriminantKind,
                     HIR::TypeRef::new_unit()
                     } ));
-            }
+                return rv;
+                }();
             return found_cb( ImplRef(&type, trait_params, &assoc_unit), false );
         }
         else if( TARGETVER_LEAST_1_54 && trait_path == m_lang_Pointee ) {
-            static ::HIR::TraitPath::assoc_list_t   assoc_unit;
-            static ::HIR::TraitPath::assoc_list_t   assoc_slice;
-            static RcString name_Metadata;
-            if(assoc_unit.empty()) {
-                name_Metadata = RcString::new_interned("Metadata");
-                assoc_unit.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
+            static const RcString name_Metadata = RcString::new_interned("Metadata");
+            static const ::HIR::TraitPath::assoc_list_t   assoc_unit = [&]() {
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
                     m_lang_Pointee,
                     HIR::TypeRef::new_unit()
                     } ));
-                assoc_slice.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
+                return rv;
+                }();
+            static const ::HIR::TraitPath::assoc_list_t   assoc_slice = [&]() {
+                ::HIR::TraitPath::assoc_list_t  rv;
+                rv.insert(std::make_pair( name_Metadata, HIR::TraitPath::AtyEqual {
                     m_lang_Pointee,
                     HIR::CoreType::Usize
                     } ));
-            }
+                return rv;
+                }();
             // Generics (or opaque ATYs)
             if( type.data().is_Generic() || (type.data().is_Path() && type.data().as_Path().binding.is_Opaque()) ) {
                 // If the type is `Sized` return `()` as the type
@@ -498,7 +515,7 @@ bool StaticTraitResolve::find_impl(
             return rv;
 
         // Detect recursion and return true if detected
-        static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
+        thread_local static ::std::vector< ::std::tuple< const ::HIR::SimplePath*, const ::HIR::PathParams*, const ::HIR::TypeRef*> >    stack;
         for(const auto& ent : stack ) {
             if( *::std::get<0>(ent) != trait_path )
                 continue ;
@@ -1163,11 +1180,13 @@ void StaticTraitResolve::expand_associated_types_inner(const Span& sp, ::HIR::Ty
             auto it = m_aty_cache.find(e.path);
             if( it != m_aty_cache.end() )
             {
+                s_aty_cache_hit.inc();
                 DEBUG("Cached " << it->second);
                 input = it->second.clone();
             }
             else
             {
+                s_aty_cache_miss.inc();
                 auto p = e.path.clone();
                 this->expand_associated_types__UfcsKnown(sp, input);
                 m_aty_cache.insert(std::make_pair( std::move(p), input.clone() ));
@@ -1606,8 +1625,10 @@ bool StaticTraitResolve::type_is_copy(const Span& sp, const ::HIR::TypeRef& ty)
             auto it = m_copy_cache.find(ty);
             if( it != m_copy_cache.end() )
             {
+                s_copy_cache_hit.inc();
                 return it->second;
             }
+            s_copy_cache_miss.inc();
         }
         auto pp = ::HIR::PathParams();
         bool rv = this->find_impl__bounds(sp, m_lang_Copy, &pp, ty, [&](auto , bool ){ return true; });
@@ -1637,7 +1658,11 @@ bool StaticTraitResolve::type_is_copy(const Span& sp, const ::HIR::TypeRef& ty)
         {
             auto it = m_copy_cache.find(ty);
             if( it != m_copy_cache.end() )
+            {
+                s_copy_cache_hit.inc();
                 return it->second;
+            }
+            s_copy_cache_miss.inc();
         }
         auto pp = ::HIR::PathParams();
         bool rv = this->find_impl(sp, m_lang_Copy, &pp, ty, [&](auto , bool){ return true; }, true);
@@ -1722,8 +1747,10 @@ bool StaticTraitResolve::type_is_clone(const Span& sp, const ::HIR::TypeRef& ty)
             auto it = m_clone_cache.find(ty);
             if( it != m_clone_cache.end() )
             {
+                s_clone_cache_hit.inc();
                 return it->second;
             }
+            s_clone_cache_miss.inc();
         }
         auto pp = ::HIR::PathParams();
         bool rv = this->find_impl__bounds(sp, m_lang_Clone, &pp, ty, [&](auto , bool ){ return true; });
@@ -1734,7 +1761,11 @@ bool StaticTraitResolve::type_is_clone(const Span& sp, const ::HIR::TypeRef& ty)
         if(true) {
             auto it = m_clone_cache.find(ty);
             if( it != m_clone_cache.end() )
+            {
+                s_clone_cache_hit.inc();
                 return it->second;
+            }
+            s_clone_cache_miss.inc();
         }
         if( e.is_closure() )
         {
@@ -2372,8 +2403,10 @@ bool StaticTraitResolve::type_needs_drop_glue(const Span& sp, const ::HIR::TypeR
         auto it = m_drop_cache.find(ty);
         if( it != m_drop_cache.end() )
         {
+            s_drop_cache_hit.inc();
             return it->second;
         }
+        s_drop_cache_miss.inc();
 
         auto pp = ::HIR::PathParams();
         bool has_direct_drop = this->find_impl(sp, m_lang_Drop, &pp, ty, [&](auto , bool){ return true; }, true);
@@ -11,6 +11,7 @@
 #include "common.hpp"
 #include "impl_ref.hpp"
 #include <range_vec_map.hpp>
+#include <unordered_map>
 #include "resolve_common.hpp"
 
 enum class MetadataType {
@@ -36,10 +37,10 @@ static inline std::ostream& operator<<(std::ostream& os, const MetadataType& x)
 class StaticTraitResolve:
     public TraitResolveCommon
 {
-    mutable ::std::map< ::HIR::TypeRef, bool >  m_copy_cache;
-    mutable ::std::map< ::HIR::TypeRef, bool >  m_clone_cache;
-    mutable ::std::map< ::HIR::TypeRef, bool >  m_drop_cache;
-    mutable ::std::map< ::HIR::Path, HIR::TypeRef>  m_aty_cache;
+    mutable ::std::unordered_map< ::HIR::TypeRef, bool >  m_copy_cache;
+    mutable ::std::unordered_map< ::HIR::TypeRef, bool >  m_clone_cache;
+    mutable ::std::unordered_map< ::HIR::TypeRef, bool >  m_drop_cache;
+    mutable ::std::unordered_map< ::HIR::Path, HIR::TypeRef>  m_aty_cache;
 
 public:
     explicit StaticTraitResolve(const ::HIR::Crate& crate):
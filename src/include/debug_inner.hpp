@@ -2,14 +2,53 @@
  */
 #pragma once
 #include <ctime>
+#include <cstdint>
+#include <string>
 #include <initializer_list>
+#include <atomic>
 
 extern void debug_init_phases(const char* env_var_name, std::initializer_list<const char*> il);
+/// Record wall/CPU time, peak RSS, and allocation counts for each `DebugTimedPhase`, written as JSON to `path` on exit
+extern void debug_enable_phase_stats(const ::std::string& path);
+
+/// Named event counter (e.g. cache hits), reported in the `--phase-stats` output
+///
+/// Instances must have static storage duration, they are linked into a global list on construction.
+/// Counting is only done when phase stats are enabled.
+class DebugCounter
+{
+    const char* m_name;
+    ::std::atomic<uint64_t> m_value;
+    DebugCounter*   m_next;
+public:
+    DebugCounter(const char* name);
+    DebugCounter(const DebugCounter&) = delete;
+
+    static bool s_enabled;
+    void inc() {
+        add(1);
+    }
+    void add(uint64_t n) {
+        if( s_enabled )
+            m_value.fetch_add(n, ::std::memory_order_relaxed);
+    }
+
+    const char* name() const { return m_name; }
+    uint64_t value() const { return m_value; }
+    const DebugCounter* next() const { return m_next; }
+    static const DebugCounter* first();
+};
 
 class DebugTimedPhase
 {
     const char* m_name;
     clock_t m_start;
+    // Only populated if phase stats are enabled
+    double  m_start_wall;
+    double  m_start_cpu;
+    uint64_t    m_start_peak_rss;
+    uint64_t    m_start_allocs;
+    uint64_t    m_start_alloc_bytes;
 public:
     DebugTimedPhase(const char* name);
     ~DebugTimedPhase();
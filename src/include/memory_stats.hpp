@@ -0,0 +1,56 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/memory_stats.hpp
+ * - Per-type heap accounting (cross-platform replacement for minidump analysis)
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+namespace memory_stats {
+
+/// Categories of heap allocations that are tracked
+enum class Tag
+{
+    HirTypeRef, // HIR::TypeInner
+    MirFunction,
+    Span,   // SpanInner
+    RcString,
+    AstExprNode,
+    HirExprNode,
+};
+static const unsigned NUM_TAGS = static_cast<unsigned>(Tag::HirExprNode) + 1;
+
+/// Set once heap accounting has been enabled (before any worker threads are started)
+extern bool g_enabled;
+
+extern void on_alloc(Tag tag, size_t size);
+extern void on_free(Tag tag, size_t size);
+
+/// Start counting tagged allocations, writing the snapshots (as JSON) to `path` on exit
+extern void enable(const ::std::string& path);
+/// Record the current counts, labelled with the given phase name
+extern void snapshot(const char* phase);
+
+/// Allocate memory and count it against the given tag
+static inline void* alloc(Tag tag, size_t size) {
+    if( g_enabled )
+        on_alloc(tag, size);
+    return ::operator new(size);
+}
+static inline void free(Tag tag, void* ptr, size_t size) {
+    if( g_enabled )
+        on_free(tag, size);
+    ::operator delete(ptr);
+}
+
+}   // namespace memory_stats
+
+/// Class-specific operator new/delete that counts allocations of this class (and derived classes) against `tag`
+#define MEMORY_STATS_ALLOCATOR(tag) \
+    static void* operator new(size_t size) { return ::memory_stats::alloc(::memory_stats::Tag::tag, size); } \
+    static void operator delete(void* ptr, size_t size) { ::memory_stats::free(::memory_stats::Tag::tag, ptr, size); }
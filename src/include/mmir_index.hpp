@@ -0,0 +1,124 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/mmir_index.hpp
+ * - Binary function index for monomorphised MIR (`.mir.idx`), shared with standalone_miri
+ *
+ * Written by the MMIR backend (`-C mmir-index`) alongside `foo.mir` as `foo.mir.idx`, it lets a loader skip over
+ * function bodies without lexing them (and parse them on first use instead).
+ *
+ * Layout (native endian, all records naturally aligned, so the file can be used directly from a mmap):
+ * - `Header`
+ * - `Header::function_count` x `FunctionEnt`, sorted by name
+ * - String table (`Header::strtab_size` bytes), containing the function names (not NUL terminated)
+ */
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <istream>
+
+namespace mmir_index {
+
+static const char MAGIC[8] = { 'M','M','I','R','I','D','X','2' };
+
+struct Header
+{
+    char    magic[8];
+    /// Size and contents hash (see `hash_file`) of the `.mir` file this index was generated for (used to detect a
+    /// stale index)
+    uint64_t    mir_size;
+    uint64_t    mir_hash;
+    uint32_t    function_count;
+    uint32_t    strtab_size;
+};
+static_assert(sizeof(Header) == 32, "mmir_index::Header must be packed");
+
+struct FunctionEnt
+{
+    /// Name (as written after `fn` in the .mir file), as a range in the string table
+    uint32_t    name_ofs;
+    uint32_t    name_len;
+    /// Byte range of the body (from the opening `{` to after the closing `}`) in the .mir file
+    uint64_t    body_ofs;
+    uint64_t    body_len;
+};
+static_assert(sizeof(FunctionEnt) == 24, "mmir_index::FunctionEnt must be packed");
+
+/// FNV-1a hash of the rest of the stream (the .mir file that an index refers to)
+inline uint64_t hash_file(::std::istream& is)
+{
+    uint64_t    rv = 0xcbf29ce484222325;
+    char    buf[64*1024];
+    while( is.read(buf, sizeof(buf)) || is.gcount() > 0 )
+    {
+        for(::std::streamsize i = 0; i < is.gcount(); i ++)
+        {
+            rv ^= static_cast<uint8_t>(buf[i]);
+            rv *= 0x100000001b3;
+        }
+    }
+    return rv;
+}
+
+/// Read-only view of a loaded index
+class View
+{
+    const Header*   m_hdr = nullptr;
+    const FunctionEnt*  m_ents = nullptr;
+    const char* m_strtab = nullptr;
+public:
+    View() {}
+    /// Validate the buffer `data` (of `len` bytes) as an index for the .mir file read from `mir_file`
+    /// - Returns an empty view if the buffer isn't a valid/current index
+    /// - The .mir file is only hashed if the index is otherwise valid and the size matches
+    View(const void* data, size_t len, ::std::istream& mir_file)
+    {
+        if( len < sizeof(Header) )
+            return ;
+        const auto* hdr = static_cast<const Header*>(data);
+        if( ::std::memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) != 0 )
+            return ;
+        if( len != sizeof(Header) + hdr->function_count * sizeof(FunctionEnt) + hdr->strtab_size )
+            return ;
+        // The size catches most edits cheaply, the hash catches the rest (e.g. an edit that keeps the length)
+        mir_file.seekg(0, ::std::ios::end);
+        if( !mir_file.good() || static_cast<uint64_t>(mir_file.tellg()) != hdr->mir_size )
+            return ;
+        mir_file.seekg(0);
+        if( hash_file(mir_file) != hdr->mir_hash )
+            return ;
+        m_hdr = hdr;
+        m_ents = reinterpret_cast<const FunctionEnt*>(hdr + 1);
+        m_strtab = reinterpret_cast<const char*>(m_ents + hdr->function_count);
+    }
+
+    bool is_valid() const { return m_hdr != nullptr; }
+
+    /// Look up the body of the function `name` (binary search), returning nullptr if it's not indexed
+    const FunctionEnt* find(const char* name, size_t name_len) const
+    {
+        if( !m_hdr )
+            return nullptr;
+        size_t lo = 0, hi = m_hdr->function_count;
+        while( lo < hi )
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            const auto& e = m_ents[mid];
+            int cmp = ::std::memcmp(m_strtab + e.name_ofs, name, ::std::min<size_t>(e.name_len, name_len));
+            if( cmp == 0 )
+                cmp = (e.name_len < name_len ? -1 : (e.name_len > name_len ? 1 : 0));
+            if( cmp == 0 )
+                return &e;
+            if( cmp < 0 )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return nullptr;
+    }
+};
+
+}   // namespace mmir_index
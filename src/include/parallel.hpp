@@ -0,0 +1,73 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/parallel.hpp
+ * - Helpers for running compiler passes across multiple threads
+ */
+#pragma once
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <cstdint>  // SIZE_MAX
+
+/// Run `cb(idx)` for every index in `0 .. count`, spread across up to `num_threads` threads
+///
+/// - Indexes are claimed in increasing order, so when a job starts all lower-indexed jobs have at least been started.
+/// - If any job throws, no new jobs are started and the exception from the lowest index is re-thrown on the calling
+///   thread once all workers have finished.
+/// - With `num_threads <= 1` (or only a single job) this runs inline on the calling thread.
+template<typename Cb>
+void parallel_for_each_index(unsigned num_threads, size_t count, Cb cb)
+{
+    if( num_threads <= 1 || count <= 1 )
+    {
+        for(size_t i = 0; i < count; i ++)
+            cb(i);
+        return ;
+    }
+    if( num_threads > count )
+        num_threads = static_cast<unsigned>(count);
+
+    ::std::atomic<size_t>   next_idx { 0 };
+    ::std::atomic<bool>     failed { false };
+    ::std::mutex    err_lock;
+    size_t  err_idx = SIZE_MAX;
+    ::std::exception_ptr    err;
+
+    auto worker = [&]() {
+        while( !failed )
+        {
+            size_t idx = next_idx ++;
+            if( idx >= count )
+                break;
+            try
+            {
+                cb(idx);
+            }
+            catch(...)
+            {
+                ::std::lock_guard<::std::mutex> lh { err_lock };
+                if( idx < err_idx ) {
+                    err_idx = idx;
+                    err = ::std::current_exception();
+                }
+                failed = true;
+            }
+        }
+        };
+
+    ::std::vector<::std::thread>    threads;
+    threads.reserve(num_threads - 1);
+    for(unsigned i = 1; i < num_threads; i ++)
+        threads.push_back( ::std::thread(worker) );
+    // The calling thread is also a worker
+    worker();
+    for(auto& t : threads)
+        t.join();
+
+    if( err )
+        ::std::rethrow_exception(err);
+}
@@ -9,15 +9,21 @@
 
 #include <cstring>
 #include <ostream>
+#include <atomic>
 #include "../common.hpp"
 
 class RcString
 {
     struct Inner {
-        unsigned int    refcount;
+        ::std::atomic<unsigned int> refcount;
         unsigned int    size;
-        unsigned int    ordering;   // Populated only for interned strings, 0 otherwise
+        ::std::atomic<unsigned int> ordering;   // Populated only for interned strings, 0 otherwise
         unsigned int    data[1];    // Actually arbitary
+
+        static size_t alloc_size(size_t len) {
+            size_t nwords = (len+1 + sizeof(unsigned int)-1) / sizeof(unsigned int);
+            return sizeof(Inner) + (nwords - 1) * sizeof(unsigned int);
+        }
     }*  m_ptr;
 public:
     RcString():
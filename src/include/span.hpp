@@ -8,8 +8,11 @@
 #pragma once
 
 #include <rc_string.hpp>
+#include <memory_stats.hpp>
 #include <functional>
 #include <memory>
+#include <atomic>
+#include <cstdint>
 
 enum ErrorType
 {
@@ -30,44 +33,30 @@ struct ProtoSpan
     unsigned int start_line;
     unsigned int start_ofs;
 };
+/// Source location, as a 32-bit index into the global (append-only) span table
+///
+/// Spans are never freed, so copying one is free. Identical spans share a table entry (see `alloc_span`), so the table
+/// grows with the number of distinct locations rather than the number of spans created.
 struct Span
 {
 private:
-    SpanInner*  m_ptr;
+    /// Index into the span table, zero is the empty span
+    uint32_t    m_id;
     static SpanInner    s_empty_span;
+
+    static const SpanInner& get(uint32_t id);
 public:
     Span():
-        m_ptr(&s_empty_span)
+        m_id(0)
     {}
     Span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs);
     Span(Span parent, const Position& position);
-    ~Span();
-
-    Span(const Span& x);
-    Span(Span&& x):
-        m_ptr(x.m_ptr)
-    {
-        x.m_ptr = nullptr;
-    }
-
-    Span& operator=(const Span& x)
-    {
-        this->~Span();
-        new (this) Span(x);
-        return *this;
-    }
-    Span& operator=(Span&& x)
-    {
-        this->~Span();
-        new (this) Span(std::move(x));
-        return *this;
-    }
 
-    bool operator==(const Span& x) const { return m_ptr == x.m_ptr; }
+    bool operator==(const Span& x) const { return m_id == x.m_id; }
     bool operator!=(const Span& x) const { return !(*this == x); }
 
-    const SpanInner& operator*() const { return *m_ptr; }
-    const SpanInner* operator->() const { return m_ptr; }
+    inline const SpanInner& operator*() const;
+    inline const SpanInner* operator->() const;
 
     void bug(::std::function<void(::std::ostream&)> msg) const;
     void error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const;
@@ -75,13 +64,23 @@ public:
     void note(::std::function<void(::std::ostream&)> msg) const;
 
     friend ::std::ostream& operator<<(::std::ostream& os, const Span& sp);
+
+    /// Thrown (instead of terminating) by `bug`/`error` while a `CaptureDiagnostics` is active
+    struct Abort {};
+    /// Redirect diagnostics from the current thread into a stream (for passes that run in parallel)
+    ///
+    /// The owner is responsible for writing out the captured text and terminating if `Abort` was thrown.
+    class CaptureDiagnostics
+    {
+        ::std::ostream* m_saved;
+    public:
+        CaptureDiagnostics(::std::ostream& os);
+        ~CaptureDiagnostics();
+        CaptureDiagnostics(const CaptureDiagnostics&) = delete;
+    };
 };
 struct SpanInner
 {
-    friend struct Span;
-private:
-    size_t  reference_count;
-public:
     Span    parent_span;
     RcString    filename;
 
@@ -89,20 +88,22 @@ public:
     unsigned int start_ofs;
     unsigned int end_line;
     unsigned int end_ofs;
-
-private:
-    static SpanInner* alloc(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs) {
-        auto* rv = new SpanInner();
-        rv->reference_count = 1;
-        rv->parent_span = parent;
-        rv->filename = ::std::move(filename);
-        rv->start_line = start_line;
-        rv->start_ofs = start_ofs;
-        rv->end_line = end_line;
-        rv->end_ofs = end_ofs;
-        return rv;
-    }
 };
+namespace span_table {
+    static const unsigned CHUNK_BITS = 16;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = (size_t(1) << 32) >> CHUNK_BITS;
+    /// Chunks are allocated on demand, and never moved or freed
+    extern ::std::atomic<SpanInner*>   g_chunks[MAX_CHUNKS];
+}
+inline const SpanInner& Span::get(uint32_t id)
+{
+    if( id == 0 )
+        return s_empty_span;
+    return span_table::g_chunks[id >> span_table::CHUNK_BITS].load(::std::memory_order_acquire)[id & (span_table::CHUNK_SIZE - 1)];
+}
+inline const SpanInner& Span::operator*() const { return get(m_id); }
+inline const SpanInner* Span::operator->() const { return &get(m_id); }
 
 template<typename T>
 struct Spanned
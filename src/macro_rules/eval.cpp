@@ -16,6 +16,7 @@
 #include <ast/expr.hpp>
 #include <ast/crate.hpp>
 #include <hir/hir.hpp>  // HIR::Crate
+#include <debug_inner.hpp>  // DebugCounter
 
  // Map of: LoopIndex=>(Path=>Count)
 typedef std::map<unsigned, std::map< std::vector<unsigned>, unsigned > >    loop_counts_t;
@@ -167,6 +168,12 @@ public:
     }
 };
 
+namespace {
+    DebugCounter    s_macro_invocations("macro_rules invocations");
+    DebugCounter    s_macro_arms_tried("macro_rules arms tried");
+    DebugCounter    s_macro_arms_skipped("macro_rules arms skipped by first-token dispatch");
+}
+
 // === Prototypes ===
 unsigned int Macro_InvokeRules_MatchPattern(const Span& sp, const MacroRules& rules, TokenTree input, const AST::Crate& crate, AST::Module& mod,  ParameterMappings& bound_tts);
 void Macro_InvokeRules_CountSubstUses(ParameterMappings& bound_tts, const ::std::vector<MacroExpansionEnt>& contents);
@@ -1824,10 +1831,15 @@ unsigned int Macro_InvokeRules_MatchPattern(const Span& sp, const MacroRules& ru
     TRACE_FUNCTION_F(rules.m_rules.size() << " options");
     ASSERT_BUG(sp, rules.m_rules.size() > 0, "Empty macro_rules set");
 
+    s_macro_invocations.inc();
+
     ::std::vector< ::std::pair<size_t, ::std::vector<bool>> >    matches;
     ::std::vector< std::pair<size_t, eTokenType> >  fail_pos;
-    for(size_t i = 0; i < rules.m_rules.size(); i ++)
-    {
+    // Only try the arms that can accept the first input token
+    const auto& candidates = rules.dispatch().candidates( TokenStreamRO(input).next() );
+    s_macro_arms_skipped.add(rules.m_rules.size() - candidates.size());
+    // Try to match arm `i`, recording where it failed if it doesn't match
+    auto try_arm = [&](size_t i)->bool {
         auto lex = TokenStreamRO(input);
         auto arm_stream = MacroPatternStream(rules.m_rules[i].m_pattern);
 
@@ -1905,25 +1917,37 @@ unsigned int Macro_InvokeRules_MatchPattern(const Span& sp, const MacroRules& ru
         {
             matches.push_back( ::std::make_pair(i, arm_stream.take_history()) );
             DEBUG(i << " MATCHED");
+            return true;
         }
         else
         {
             DEBUG(i << " FAILED");
             fail_pos.push_back( std::make_pair(lex.position(), lex.next()) );
+            return false;
         }
+        };
+    for(auto i : candidates)
+    {
+        s_macro_arms_tried.inc();
+        // The first matching arm is used, so there's no need to try the rest
+        if( try_arm(i) )
+            break;
     }
 
     if( matches.size() == 0 )
     {
         // ERROR!
-        // TODO: Keep track of where each arm failed.
+        // - Report where every arm failed, not just the ones that the dispatch table tried (the rest fail on the first
+        //   token, but the full list makes it clear which arm was closest)
+        fail_pos.clear();
+        for(size_t i = 0; i < rules.m_rules.size(); i ++)
+            try_arm(i);
         TODO(sp, "No arm matched - " << fail_pos);
     }
     else
     {
         // yay!
 
-        // NOTE: There can be multiple arms active, take the first.
         auto i = matches[0].first;
         const auto& history = matches[0].second;
         DEBUG("Evalulating arm " << i);
@@ -175,9 +175,26 @@ struct MacroRulesArm
     MacroRulesArm& operator=(MacroRulesArm&&) = default;
 };
 
+/// Arm pre-selection for a `macro_rules!` block, keyed on the first input token
+///
+/// Built once (on first invocation), so each invocation only tries arms that can accept its leading token
+struct MacroRulesDispatch
+{
+    /// Candidate arms (in definition order) for each leading token type
+    ::std::map<eTokenType, ::std::vector<unsigned int>>  by_first_token;
+    /// Arms that don't start with a fixed token, candidates for any token type not in `by_first_token`
+    ::std::vector<unsigned int> any_first;
+
+    const ::std::vector<unsigned int>& candidates(eTokenType first) const {
+        auto it = by_first_token.find(first);
+        return it != by_first_token.end() ? it->second : any_first;
+    }
+};
+
 /// A sigle 'macro_rules!' block
 class MacroRules
 {
+    mutable ::std::unique_ptr<MacroRulesDispatch>   m_dispatch;
 public:
     /// Marks if this macro should be exported from the defining crate
     bool m_exported = false;
@@ -196,6 +213,9 @@ public:
     }
     virtual ~MacroRules();
     MacroRules(MacroRules&&) = default;
+
+    /// Get the arm dispatch table (populated on first call, `m_rules` must not change after this)
+    const MacroRulesDispatch& dispatch() const;
 };
 
 extern ::std::unique_ptr<TokenStream>   Macro_InvokeRules(const char *name, const MacroRules& rules, const Span& sp, TokenTree input, const AST::Crate& crate, AST::Module& mod);
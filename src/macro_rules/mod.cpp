@@ -291,6 +291,46 @@ MacroRulesPtr::~MacroRulesPtr()
 MacroRules::~MacroRules()
 {
 }
+const MacroRulesDispatch& MacroRules::dispatch() const
+{
+    if( !m_dispatch )
+    {
+        auto d = box$( MacroRulesDispatch() );
+        // Leading token type of each arm (TOK_NULL if not fixed)
+        ::std::vector<eTokenType>   arm_first;
+        for(const auto& arm : m_rules)
+        {
+            eTokenType  first = TOK_NULL;
+            if( !arm.m_pattern.empty() )
+            {
+                const auto& pat = arm.m_pattern.front();
+                if( pat.is_End() )
+                    first = TOK_EOF;
+                else if( const auto* e = pat.opt_ExpectTok() )
+                    first = e->type();
+            }
+            arm_first.push_back(first);
+            if( first != TOK_NULL )
+                d->by_first_token.insert(::std::make_pair(first, ::std::vector<unsigned int>()));
+        }
+        // Each bucket gets the arms starting with that token, and every arm that doesn't have a fixed start
+        for(unsigned int i = 0; i < arm_first.size(); i ++)
+        {
+            if( arm_first[i] == TOK_NULL )
+            {
+                d->any_first.push_back(i);
+                for(auto& b : d->by_first_token)
+                    b.second.push_back(i);
+            }
+            else
+            {
+                d->by_first_token.at(arm_first[i]).push_back(i);
+            }
+        }
+        m_dispatch = mv$(d);
+    }
+    return *m_dispatch;
+}
 MacroRulesArm::~MacroRulesArm()
 {
 }
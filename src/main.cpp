@@ -20,21 +20,26 @@
 #include <main_bindings.hpp>
 #include "resolve/main_bindings.hpp"
 #include "hir/main_bindings.hpp"
+#include "hir/impl_index.hpp"
 #include "hir_conv/main_bindings.hpp"
 #include "hir_typeck/main_bindings.hpp"
 #include "hir_expand/main_bindings.hpp"
 #include "mir/main_bindings.hpp"
+#include "mir/lower_cache.hpp"
 #include "trans/main_bindings.hpp"
 #include "trans/target.hpp"
 
 #include "expand/cfg.hpp"
 #include <target_detect.h>	// tools/common/target_detect.h
 #include <debug_inner.hpp>
+#include <memory_stats.hpp>
 
 #ifdef _WIN32
 # define NOGDI
 # include <Windows.h>
 # include <DbgHelp.h>
+#else
+# include <sys/stat.h>  // mkdir
 #endif
 
 TargetVersion	gTargetVersion = TargetVersion::Rustc1_29;
@@ -65,6 +70,8 @@ struct ProgramParams
 
     unsigned opt_level = 0;
     bool emit_debug_info = false;
+    // Number of threads used by the passes that support running in parallel
+    unsigned num_threads = 1;
 
     bool test_harness = false;
 
@@ -92,6 +99,13 @@ struct ProgramParams
         ::std::string   codegen_type;
         ::std::string   emit_build_command;
         ::std::string   panic_type;
+        unsigned    codegen_units = 1;
+        /// Directory for incremental compilation state (empty = disabled)
+        ::std::string   incremental_dir;
+        /// Export this crate's generic instantiations for use by downstream crates
+        bool    share_generics = false;
+        /// Emit a `.mir.idx` function index with monomir output (`-C mmir-index`)
+        bool    mmir_index = false;
     } codegen;
 
     ProgramParams(int argc, char *argv[]);
@@ -136,6 +150,7 @@ void init_debug_list()
         "Constant Evaluate",
 
         "Typecheck Outer",
+        "Load Lowering Cache",
         "Typecheck Expressions",
 
         "Expand HIR Annotate",
@@ -149,6 +164,7 @@ void init_debug_list()
 
         "Dump HIR",
         "Lower MIR",
+        "Save Lowering Cache",
         "MIR Validate",
         "MIR Validate Full Early",
         "Dump MIR",
@@ -632,9 +648,30 @@ int main(int argc, char *argv[])
         CompilePhaseV("Typecheck Outer", [&]() {
             Typecheck_ModuleLevel(*hir_crate);
             });
+
+        // Incremental: The caches are stored in the incremental directory, named after the output file
+        ::std::string   incremental_prefix;
+        if( params.codegen.incremental_dir != "" ) {
+            auto slash = params.outfile.find_last_of("/\\");
+            auto basename = slash == ::std::string::npos ? params.outfile : params.outfile.substr(slash+1);
+            incremental_prefix = params.codegen.incremental_dir + "/" + basename;
+            // NOTE: Only the last component is created, an existing directory is fine
+#ifdef _WIN32
+            CreateDirectoryA(params.codegen.incremental_dir.c_str(), NULL);
+#else
+            mkdir(params.codegen.incremental_dir.c_str(), 0755);
+#endif
+        }
+        // - Unchanged bodies get their previously lowered MIR, and aren't typechecked or lowered again
+        ::MIR::LowerCache   lower_cache;
+        if( incremental_prefix != "" ) {
+            CompilePhaseV("Load Lowering Cache", [&]() {
+                lower_cache.load(*hir_crate, incremental_prefix + ".mir_lower_cache");
+                });
+        }
         // Check the rest of the expressions (including function bodies)
         CompilePhaseV("Typecheck Expressions", [&]() {
-            Typecheck_Expressions(*hir_crate);
+            Typecheck_Expressions(*hir_crate, params.num_threads);
             });
         // === HIR Expansion ===
         // Annotate how each node's result is used
@@ -687,6 +724,11 @@ int main(int argc, char *argv[])
         CompilePhaseV("Lower MIR", [&]() {
             HIR_GenerateMIR(*hir_crate);
             });
+        if( incremental_prefix != "" ) {
+            CompilePhaseV("Save Lowering Cache", [&]() {
+                lower_cache.save(*hir_crate);
+                });
+        }
 
         if( params.debug.dump_mir )
         {
@@ -716,7 +758,11 @@ int main(int argc, char *argv[])
 
         // Optimise the MIR
         CompilePhaseV("MIR Optimise", [&]() {
-            MIR_OptimiseCrate(*hir_crate, params.debug.disable_mir_optimisations);
+            ::std::string   cache_path;
+            if( incremental_prefix != "" ) {
+                cache_path = incremental_prefix + ".mir_cache";
+            }
+            MIR_OptimiseCrate(*hir_crate, params.debug.disable_mir_optimisations, params.num_threads, cache_path);
             });
 
         if( params.debug.dump_mir )
@@ -749,6 +795,9 @@ int main(int argc, char *argv[])
         TransOptions    trans_opt;
         trans_opt.mode = params.codegen.codegen_type == "" ? "c" : params.codegen.codegen_type;
         trans_opt.build_command_file = params.codegen.emit_build_command;
+        trans_opt.codegen_units = params.codegen.codegen_units;
+        trans_opt.num_threads = params.num_threads;
+        trans_opt.mmir_index = params.codegen.mmir_index;
         trans_opt.opt_level = params.opt_level;
         trans_opt.panic_crate = params.codegen.panic_type == "" ? "panic_abort" : "panic_"+params.codegen.panic_type;
         for(const char* libdir : params.lib_search_dirs ) {
@@ -795,11 +844,17 @@ int main(int argc, char *argv[])
             Trans_AutoImpls(*hir_crate, items);
             });
         // - Generate monomorphised versions of all functions
-        CompilePhaseV("Trans Monomorph", [&]() { Trans_Monomorphise_List(*hir_crate, items); });
+        CompilePhaseV("Trans Monomorph", [&]() { Trans_Monomorphise_List(*hir_crate, items, params.num_threads); });
         // - Do post-monomorph inlining
-        CompilePhaseV("MIR Optimise Inline", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items); });
+        CompilePhaseV("MIR Optimise Inline", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items, params.num_threads); });
         // - Clean up no-unused functions
         CompilePhaseV("Trans Enumerate Cleanup", [&]() { Trans_Enumerate_Cleanup(*hir_crate, items); });
+        // - Record instantiations for downstream crates to link against (instead of emitting their own copies)
+        if( params.codegen.share_generics && trans_opt.mode == "c"
+            && (crate_type == ::AST::Crate::Type::RustLib || crate_type == ::AST::Crate::Type::RustDylib) )
+        {
+            CompilePhaseV("Trans Share Generics", [&]() { Trans_Enumerate_SharedGenerics(*hir_crate, items); });
+        }
 
         memory_dump("Trans");
 
@@ -833,8 +888,8 @@ int main(int argc, char *argv[])
             // 1. Generate code for the plugin itself
             TransList items = CompilePhase<TransList>("Trans Enumerate PM", [&]() { return Trans_Enumerate_Main(*hir_crate); });
             CompilePhaseV("Trans Auto Impls PM", [&]() { Trans_AutoImpls(*hir_crate, items); });
-            CompilePhaseV("Trans Monomorph PM", [&]() { Trans_Monomorphise_List(*hir_crate, items); });
-            CompilePhaseV("MIR Optimise Inline PM", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items); });
+            CompilePhaseV("Trans Monomorph PM", [&]() { Trans_Monomorphise_List(*hir_crate, items, params.num_threads); });
+            CompilePhaseV("MIR Optimise Inline PM", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items, params.num_threads); });
             // - Save a very basic HIR dump, making sure that there's no lang items in it (e.g. `mrustc-main`)
             CompilePhaseV("HIR Serialise", [&]() {
                 auto saved_lang_items = ::std::move(hir_crate->m_lang_items); hir_crate->m_lang_items.clear();
@@ -870,6 +925,13 @@ int main(int argc, char *argv[])
 
 ProgramParams::ProgramParams(int argc, char *argv[])
 {
+#ifndef _MSC_VER
+    // No minidump support, so use the built-in heap accounting instead (`--memory-stats` overrides the path)
+    if( getenv("MRUSTC_DUMPMEM") )
+    {
+        memory_stats::enable("mrustc-memory_stats.json");
+    }
+#endif
     if( const auto* a = getenv("MRUSTC_TARGET_VER") )
     {
         if( strcmp(a, "1.19") == 0 ) {
@@ -963,6 +1025,26 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     this->libraries.push_back( arg+1 );
                 }
                 continue ;
+            case 'j': {
+                const char* count_str;
+                if( arg[1] == '\0' ) {
+                    if( i == argc - 1 ) {
+                        ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                        exit(1);
+                    }
+                    count_str = argv[++i];
+                }
+                else {
+                    count_str = arg+1;
+                }
+                char* end;
+                auto count = ::std::strtoul(count_str, &end, 10);
+                if( *end != '\0' || count == 0 ) {
+                    ::std::cerr << "Invalid thread count for -j: '" << count_str << "'" << ::std::endl;
+                    exit(1);
+                }
+                this->num_threads = static_cast<unsigned>(count);
+                } continue;
             case 'C': {
                 ::std::string optname;
                 ::std::string optval;
@@ -1010,6 +1092,23 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     get_optval();
                     this->codegen.panic_type = optval;
                 }
+                else if( optname == "codegen-units" ) {
+                    get_optval();
+                    char* end;
+                    auto count = ::std::strtoul(optval.c_str(), &end, 10);
+                    if( *end != '\0' || count == 0 ) {
+                        ::std::cerr << "Invalid value for -C codegen-units: '" << optval << "'" << ::std::endl;
+                        exit(1);
+                    }
+                    this->codegen.codegen_units = static_cast<unsigned>(count);
+                }
+                else if( optname == "incremental" ) {
+                    get_optval();
+                    this->codegen.incremental_dir = optval;
+                }
+                else if( optname == "mmir-index" ) {
+                    this->codegen.mmir_index = true;
+                }
                 else {
                     ::std::cerr << "Unknown codegen option: '" << optname << "'" << ::std::endl;
                     exit(1);
@@ -1091,6 +1190,22 @@ ProgramParams::ProgramParams(int argc, char *argv[])
                     no_optval();
                     this->print_cfgs = true;
                 }
+                else if( optname == "no-intern-types" ) {
+                    no_optval();
+                    ::HIR::TypeRef::set_interning_enabled(false);
+                }
+                else if( optname == "no-impl-index" ) {
+                    no_optval();
+                    ::HIR::ImplTypeIndex::set_enabled(false);
+                }
+                else if( optname == "share-generics" ) {
+                    no_optval();
+                    this->codegen.share_generics = true;
+                }
+                else if( optname == "typeck-profile" ) {
+                    get_optval();
+                    Typecheck_EnableProfile(optval);
+                }
                 else {
                     ::std::cerr << "Unknown debug option: '" << optname << "'" << ::std::endl;
                     exit(1);
@@ -1264,6 +1379,14 @@ ProgramParams::ProgramParams(int argc, char *argv[])
             else if( strcmp(arg, "--test") == 0 ) {
                 this->test_harness = true;
             }
+            // `--phase-stats <file>`   - Write per-phase timing/memory statistics (JSON) to the given file
+            else if( const char* path = check_with_arg("phase-stats") ) {
+                debug_enable_phase_stats(path);
+            }
+            // `--memory-stats <file>`  - Write per-type live heap usage (JSON) at the end of each phase to the given file
+            else if( const char* path = check_with_arg("memory-stats") ) {
+                memory_stats::enable(path);
+            }
             else if( const char* edition_str = check_with_arg("edition") ) {
                 if( strcmp(edition_str, "2015") == 0 ) {
                     this->edition = AST::Edition::Rust2015;
@@ -1333,6 +1456,7 @@ void ProgramParams::show_help() const
         "-o <filename>      : Write compiler output (library or executable) to this file\n"
         "-O                 : Enable optimisation\n"
         "-g                 : Emit debugging information\n"
+        "-j <count>         : Use up to <count> threads for passes that support it\n"
         "--out-dir <dir>    : Specify the output directory (alternative to `-o`)\n"
         "--extern <crate>=<path>\n"
         "                   : Specify the path for a given crate (instead of searching for it)\n"
@@ -1343,6 +1467,8 @@ void ProgramParams::show_help() const
         "--cfg flag=\"val\"   : Set a string #[cfg]/cfg! flag\n"
         "--target <name>    : Compile code for the given target\n"
         "--test             : Generate a unit test executable\n"
+        "--phase-stats <file> : Write per-phase time/memory statistics (JSON) to <file>\n"
+        "--memory-stats <file> : Write per-phase heap usage by type (JSON) to <file>\n"
         "-C <option>        : Code-generation options\n"
         "-Z <option>        : Debugging/experimental options\n"
         ;
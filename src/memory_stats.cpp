@@ -0,0 +1,134 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * memory_stats.cpp
+ * - Per-type heap accounting
+ */
+#include <memory_stats.hpp>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>  // atexit
+
+namespace memory_stats {
+
+bool g_enabled = false;
+
+namespace {
+    struct Counters {
+        // NOTE: Signed, as objects allocated before accounting was enabled can still be freed
+        ::std::atomic<int64_t>  live_count { 0 };
+        ::std::atomic<int64_t>  live_bytes { 0 };
+        ::std::atomic<int64_t>  peak_bytes { 0 };
+        ::std::atomic<uint64_t> total_count { 0 };
+    };
+    Counters    g_counters[NUM_TAGS];
+
+    struct TagSnapshot {
+        int64_t live_count;
+        int64_t live_bytes;
+        int64_t peak_bytes;
+        uint64_t    total_count;
+    };
+    struct Snapshot {
+        const char* phase;
+        TagSnapshot tags[NUM_TAGS];
+    };
+    ::std::string   g_output_path;
+    ::std::vector<Snapshot> g_snapshots;
+
+    const char* tag_name(unsigned i) {
+        switch(static_cast<Tag>(i))
+        {
+        case Tag::HirTypeRef:   return "HIR::TypeRef";
+        case Tag::MirFunction:  return "MIR::Function";
+        case Tag::Span:         return "Span";
+        case Tag::RcString:     return "RcString";
+        case Tag::AstExprNode:  return "AST::ExprNode";
+        case Tag::HirExprNode:  return "HIR::ExprNode";
+        }
+        return "?";
+    }
+
+    void write_snapshots()
+    {
+        ::std::ofstream os(g_output_path);
+        if( !os.good() ) {
+            ::std::cerr << "Unable to open " << g_output_path << " for writing" << ::std::endl;
+            return ;
+        }
+        // One snapshot per line
+        // - `live`/`live_bytes` are the values at the end of the phase
+        // - `peak_bytes` and `allocs` cover just that phase
+        os << "{\n";
+        os << "\"snapshots\": [\n";
+        for(size_t i = 0; i < g_snapshots.size(); i ++)
+        {
+            const auto& s = g_snapshots[i];
+            os << "{\"phase\": \"" << s.phase << "\", \"types\": {";
+            for(unsigned t = 0; t < NUM_TAGS; t ++)
+            {
+                const auto& ts = s.tags[t];
+                auto prev_total = (i > 0 ? g_snapshots[i-1].tags[t].total_count : 0);
+                os << (t > 0 ? ", " : "")
+                    << "\"" << tag_name(t) << "\": {"
+                    << "\"live\": " << ts.live_count << ", "
+                    << "\"live_bytes\": " << ts.live_bytes << ", "
+                    << "\"peak_bytes\": " << ts.peak_bytes << ", "
+                    << "\"allocs\": " << (ts.total_count - prev_total)
+                    << "}";
+            }
+            os << "}}" << (i + 1 < g_snapshots.size() ? "," : "") << "\n";
+        }
+        os << "]\n";
+        os << "}\n";
+    }
+}
+
+void on_alloc(Tag tag, size_t size)
+{
+    auto& c = g_counters[static_cast<unsigned>(tag)];
+    c.live_count.fetch_add(1, ::std::memory_order_relaxed);
+    c.total_count.fetch_add(1, ::std::memory_order_relaxed);
+    auto bytes = c.live_bytes.fetch_add(size, ::std::memory_order_relaxed) + static_cast<int64_t>(size);
+    auto peak = c.peak_bytes.load(::std::memory_order_relaxed);
+    while( bytes > peak && !c.peak_bytes.compare_exchange_weak(peak, bytes, ::std::memory_order_relaxed) )
+        ;
+}
+void on_free(Tag tag, size_t size)
+{
+    auto& c = g_counters[static_cast<unsigned>(tag)];
+    c.live_count.fetch_sub(1, ::std::memory_order_relaxed);
+    c.live_bytes.fetch_sub(size, ::std::memory_order_relaxed);
+}
+
+void enable(const ::std::string& path)
+{
+    if( g_output_path == "" ) {
+        ::std::atexit(write_snapshots);
+    }
+    g_output_path = path;
+    g_enabled = true;
+}
+
+void snapshot(const char* phase)
+{
+    if( !g_enabled )
+        return ;
+    Snapshot    s;
+    s.phase = phase;
+    for(unsigned t = 0; t < NUM_TAGS; t ++)
+    {
+        auto& c = g_counters[t];
+        s.tags[t].live_count = c.live_count;
+        s.tags[t].live_bytes = c.live_bytes;
+        s.tags[t].peak_bytes = c.peak_bytes;
+        s.tags[t].total_count = c.total_count;
+        // Peak is tracked per-phase
+        c.peak_bytes = s.tags[t].live_bytes;
+    }
+    g_snapshots.push_back(s);
+}
+
+}   // namespace memory_stats
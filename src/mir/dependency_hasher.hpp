@@ -0,0 +1,113 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/dependency_hasher.hpp
+ * - Hashing of the items a body refers to, for the incremental caches
+ */
+#pragma once
+#include <hir/path.hpp>
+#include <hir/main_bindings.hpp>
+#include <debug.hpp>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+
+namespace MIR {
+
+/// Hashes the interfaces of the items that a body refers to (see `HIR_HashItem`), so that an edit only
+/// invalidates the cached bodies that use the edited item
+/// - Types are followed through their fields, as layout and `Copy`/`Drop` depend on the contained types
+/// - Item hashes are memoised, so a hasher created before typecheck gives the same results after it
+class DependencyHasher
+{
+    struct ItemInfo {
+        bool    found;
+        uint64_t    hash;
+        // Paths referenced by the definition (only for types)
+        ::std::set<::HIR::SimplePath>   children;
+    };
+    const ::HIR::Crate& m_crate;
+    bool    m_interface_only;
+    ::std::mutex    m_lock;
+    ::std::map<::HIR::SimplePath, ::std::shared_ptr<const ItemInfo>>    m_items;
+public:
+    DependencyHasher(const ::HIR::Crate& crate, bool interface_only=false):
+        m_crate(crate),
+        m_interface_only(interface_only)
+    {
+    }
+
+    /// Mark an item as not usable as a dependency (bodies that refer to it hash to zero)
+    void add_unhashable(const ::HIR::SimplePath& path)
+    {
+        auto info = ::std::make_shared<ItemInfo>();
+        info->found = false;
+        info->hash = 0;
+        ::std::lock_guard<::std::mutex> lh { m_lock };
+        m_items[path] = ::std::move(info);
+    }
+    /// Check if an item has already been hashed
+    bool is_known(const ::HIR::SimplePath& path)
+    {
+        ::std::lock_guard<::std::mutex> lh { m_lock };
+        return m_items.count(path) > 0;
+    }
+
+    /// Hash the items in `paths` (and the types they contain), returns zero if any couldn't be found
+    uint64_t hash_dependencies(::std::set<::HIR::SimplePath> paths)
+    {
+        ::std::vector<::HIR::SimplePath>    stack(paths.begin(), paths.end());
+        while( !stack.empty() )
+        {
+            auto p = ::std::move(stack.back());
+            stack.pop_back();
+            const auto& info = get_item(p);
+            for(const auto& c : info->children)
+            {
+                if( paths.insert(c).second )
+                    stack.push_back(c);
+            }
+        }
+
+        uint64_t    rv = 0xcbf29ce484222325;
+        auto push_u = [&](uint64_t v) {
+            for(size_t i = 0; i < sizeof(v); i ++) {
+                rv ^= (v >> (8*i)) & 0xFF;
+                rv *= 0x100000001b3;
+            }
+            };
+        // NOTE: `paths` is sorted, so the order is consistent between runs
+        for(const auto& p : paths)
+        {
+            const auto& info = get_item(p);
+            if( !info->found ) {
+                DEBUG("Unknown dependency " << p);
+                return 0;
+            }
+            push_u(info->hash);
+        }
+        return rv == 0 ? 1 : rv;
+    }
+private:
+    ::std::shared_ptr<const ItemInfo> get_item(const ::HIR::SimplePath& path)
+    {
+        {
+            ::std::lock_guard<::std::mutex> lh { m_lock };
+            auto it = m_items.find(path);
+            if( it != m_items.end() )
+                return it->second;
+        }
+        // NOTE: Hashed without the lock held, another thread may do the same item at the same time (the result is
+        // the same)
+        auto info = ::std::make_shared<ItemInfo>();
+        info->hash = 0;
+        info->found = HIR_HashItem(m_crate, path, info->hash, &info->children, m_interface_only);
+        info->children.erase(path);
+        ::std::lock_guard<::std::mutex> lh { m_lock };
+        return m_items.insert(::std::make_pair( path, ::std::move(info) )).first->second;
+    }
+};
+
+}   // namespace MIR
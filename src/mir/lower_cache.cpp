@@ -0,0 +1,339 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/lower_cache.cpp
+ * - Incremental compilation cache for typecheck and MIR lowering
+ */
+#include "lower_cache.hpp"
+#include "mir.hpp"
+#include "optimise_cache.hpp"
+#include "dependency_hasher.hpp"
+#include <hir/hir.hpp>
+#include <hir/expr.hpp>
+#include <hir/visitor.hpp>
+#include <hir/main_bindings.hpp>
+#include <hir_conv/main_bindings.hpp>   // ConvertHIR_Bind_Mir
+#include <hir_typeck/common.hpp>    // visit_ty_with
+#include <trans/target.hpp>
+#include <target_version.hpp>
+#include <version.hpp>
+#include <algorithm>
+
+struct MIR::LowerCache::State
+{
+    struct Body
+    {
+        /// Hash of the expression (before typecheck) and the signature
+        uint64_t    key;
+        /// Paths named by the expression and the signature
+        ::std::set<::HIR::SimplePath>   paths;
+    };
+
+    ::std::string   path;
+    uint64_t    environment_hash = 0;
+    /// Created before typecheck, so the item hashes used when saving match those that the next run sees
+    ::MIR::DependencyHasher dep_hasher;
+    /// Bodies that can be cached, by item path
+    ::std::map<::std::string, Body> bodies;
+
+    State(const ::HIR::Crate& crate, ::std::string path):
+        path(::std::move(path)),
+        dep_hasher(crate, /*interface_only=*/true)
+    {
+    }
+};
+
+namespace {
+    /// Visits every function in the crate, along with the impl (or trait) that it's in
+    class FunctionVisitor:
+        public ::HIR::Visitor
+    {
+    public:
+        typedef ::std::function<void(const ::HIR::ItemPath& ip, const ::HIR::TypeRef* impl_type, const ::HIR::GenericParams* impl_generics, ::HIR::Function& fcn)>  cb_t;
+    private:
+        cb_t    m_cb;
+        const ::HIR::TypeRef*   m_impl_type = nullptr;
+        const ::HIR::GenericParams* m_impl_generics = nullptr;
+    public:
+        FunctionVisitor(cb_t cb):
+            m_cb(::std::move(cb))
+        {}
+
+        void visit_type(::HIR::TypeRef& ty) override {
+            // Nothing to do (and the bodies of array sizes aren't cached)
+        }
+        void visit_function(::HIR::ItemPath p, ::HIR::Function& item) override {
+            m_cb(p, m_impl_type, m_impl_generics, item);
+        }
+
+        void visit_trait(::HIR::ItemPath p, ::HIR::Trait& item) override {
+            auto saved_type = m_impl_type;
+            auto saved_generics = m_impl_generics;
+            m_impl_type = nullptr;
+            m_impl_generics = &item.m_params;
+            ::HIR::Visitor::visit_trait(p, item);
+            m_impl_type = saved_type;
+            m_impl_generics = saved_generics;
+        }
+        void visit_type_impl(::HIR::TypeImpl& impl) override {
+            m_impl_type = &impl.m_type;
+            m_impl_generics = &impl.m_params;
+            ::HIR::Visitor::visit_type_impl(impl);
+            m_impl_type = nullptr;
+            m_impl_generics = nullptr;
+        }
+        void visit_trait_impl(const ::HIR::SimplePath& trait_path, ::HIR::TraitImpl& impl) override {
+            m_impl_type = &impl.m_type;
+            m_impl_generics = &impl.m_params;
+            ::HIR::Visitor::visit_trait_impl(trait_path, impl);
+            m_impl_type = nullptr;
+            m_impl_generics = nullptr;
+        }
+    };
+
+    /// Get the paths of every item in the crate (and of the variants and associated items within them)
+    void enumerate_item_paths(const ::HIR::Module& mod, const ::HIR::SimplePath& mod_path, ::std::set<::HIR::SimplePath>& out)
+    {
+        for(const auto& i : mod.m_mod_items)
+        {
+            auto p = mod_path + i.first;
+            if( const auto* m = i.second->ent.opt_Module() ) {
+                enumerate_item_paths(*m, p, out);
+                continue ;
+            }
+            if( const auto* e = i.second->ent.opt_Enum() ) {
+                if( const auto* vars = e->m_data.opt_Data() ) {
+                    for(const auto& v : *vars)
+                        out.insert(p + v.name);
+                }
+                else {
+                    for(const auto& v : e->m_data.as_Value().variants)
+                        out.insert(p + v.name);
+                }
+            }
+            if( const auto* t = i.second->ent.opt_Trait() ) {
+                for(const auto& v : t->m_values)
+                    out.insert(p + v.first);
+                for(const auto& v : t->m_types)
+                    out.insert(p + v.first);
+            }
+            out.insert(::std::move(p));
+        }
+        for(const auto& i : mod.m_value_items)
+            out.insert(mod_path + i.first);
+    }
+
+    /// Hash of the global state that can change the result of typechecking or lowering any body
+    uint64_t get_environment_hash(const ::HIR::Crate& crate)
+    {
+        uint64_t    rv = 0xcbf29ce484222325;
+        auto push_bytes = [&](const void* data, size_t len) {
+            for(size_t i = 0; i < len; i ++) {
+                rv ^= static_cast<const uint8_t*>(data)[i];
+                rv *= 0x100000001b3;
+            }
+            };
+        auto push_str = [&](const ::std::string& s) { push_bytes(s.c_str(), s.size() + 1); };
+        auto push_u = [&](uint64_t v) { push_bytes(&v, sizeof(v)); };
+
+        push_str(Version_GetString());
+        push_str(gsVersion_BuildTime);
+
+        const auto& tgt = Target_GetCurSpec();
+        push_str(tgt.m_family);
+        push_str(tgt.m_os_name);
+        push_str(tgt.m_env_name);
+        push_str(tgt.m_arch.m_name);
+        push_u(tgt.m_arch.m_pointer_bits);
+        push_u(tgt.m_arch.m_big_endian);
+
+        push_str(crate.m_crate_name.c_str());
+        push_u(static_cast<int>(crate.m_edition));
+        push_u(static_cast<int>(gTargetVersion));
+
+        // Lang items (sorted, as the map is unordered)
+        auto push_lang_items = [&](const ::HIR::Crate& c) {
+            ::std::vector<::std::pair<::std::string, const ::HIR::SimplePath*>>  items;
+            for(const auto& li : c.m_lang_items)
+                items.push_back(::std::make_pair( li.first, &li.second ));
+            ::std::sort(items.begin(), items.end());
+            push_str(c.m_crate_name.c_str());
+            for(const auto& li : items) {
+                push_str(li.first);
+                push_str(FMT(*li.second));
+            }
+            };
+        push_lang_items(crate);
+        ::std::vector<const ::HIR::Crate*>  ext_crates;
+        for(const auto& ec : crate.m_ext_crates)
+            ext_crates.push_back(&*ec.second.m_data);
+        ::std::sort(ext_crates.begin(), ext_crates.end(), [](const ::HIR::Crate* a, const ::HIR::Crate* b){ return a->m_crate_name < b->m_crate_name; });
+        for(const auto* ec : ext_crates)
+            push_lang_items(*ec);
+
+        // Impls that aren't on a named type could apply to anything, so aren't tracked per body
+        push_u(HIR_HashUnnamedImpls(crate, /*interface_only=*/true));
+        return rv;
+    }
+}
+
+MIR::LowerCache::LowerCache()
+{
+}
+MIR::LowerCache::~LowerCache()
+{
+}
+
+void MIR::LowerCache::load(::HIR::Crate& crate, ::std::string path)
+{
+    TRACE_FUNCTION_F(path);
+    m_state.reset(new State(crate, ::std::move(path)));
+    auto& st = *m_state;
+    st.environment_hash = get_environment_hash(crate);
+
+    // Enumerate the bodies that can be cached, and hash them (before typecheck changes them)
+    // - A function returning `impl Trait` only gets its real return type after its body is typechecked, so it (and
+    //   anything naming it, or the type it's on) is never cached.
+    bool disable = false;
+    ::std::vector<::std::pair<::std::string, ::HIR::Function*>> candidates;
+    ::std::map<::std::string, unsigned> path_counts;
+    FunctionVisitor fv { [&](const ::HIR::ItemPath& ip, const ::HIR::TypeRef* impl_type, const ::HIR::GenericParams* impl_generics, ::HIR::Function& fcn) {
+        if( !fcn.m_code )
+            return ;
+        auto p = FMT(ip);
+        path_counts[p] += 1;
+        if( visit_ty_with(fcn.m_return, [](const ::HIR::TypeRef& t){ return t.data().is_ErasedType(); }) )
+        {
+            if( !impl_type ) {
+                st.dep_hasher.add_unhashable( ip.parent && ip.parent->trait ? ip.parent->trait->clone() : ip.get_simple_path() );
+            }
+            else if( impl_type->data().is_Path() && impl_type->data().as_Path().path.m_data.is_Generic() ) {
+                st.dep_hasher.add_unhashable( impl_type->data().as_Path().path.m_data.as_Generic().m_path );
+            }
+            else {
+                DEBUG("Method returning an erased type on " << *impl_type << ", caching disabled");
+                disable = true;
+            }
+            return ;
+        }
+        // `const fn`s may be evaluated (and lowered) during typecheck
+        if( fcn.m_const || fcn.m_code.m_mir || !fcn.m_code.m_state )
+            return ;
+
+        State::Body body;
+        ::std::vector<const ::HIR::Pattern*>    arg_patterns;
+        ::std::vector<const ::HIR::TypeRef*>    sig_types;
+        for(const auto& a : fcn.m_args) {
+            arg_patterns.push_back(&a.first);
+            sig_types.push_back(&a.second);
+        }
+        sig_types.push_back(&fcn.m_return);
+        uint64_t    expr_hash = 0;
+        if( !HIR_HashExpr(fcn.m_code, arg_patterns, expr_hash, &body.paths) ) {
+            DEBUG(p << ": Not hashable");
+            return ;
+        }
+        auto sig_hash = HIR_HashSignature(impl_generics, &fcn.m_params, sig_types, &body.paths);
+        body.key = (expr_hash * 0x100000001b3) ^ sig_hash;
+        st.bodies.insert(::std::make_pair( p, ::std::move(body) ));
+        candidates.push_back(::std::make_pair( ::std::move(p), &fcn ));
+        } };
+    fv.visit_crate(crate);
+    // Hash every item now, as typecheck changes some of them (and the hashes are memoised, so saving gets the same
+    // values that the next load will)
+    {
+        ::std::set<::HIR::SimplePath>   all_items;
+        enumerate_item_paths(crate.m_root_module, ::HIR::SimplePath(crate.m_crate_name), all_items);
+        st.dep_hasher.hash_dependencies(::std::move(all_items));
+    }
+    if( disable ) {
+        st.bodies.clear();
+        return ;
+    }
+    // Paths aren't always unique (e.g. methods in impls that only differ by bounds)
+    for(const auto& pc : path_counts) {
+        if( pc.second > 1 )
+            st.bodies.erase(pc.first);
+    }
+
+    ::MIR::OptimiseCache    old_cache;
+    if( !HIR_DeserialiseMirCache(st.path, st.environment_hash, old_cache) )
+        return ;
+    ::std::map<::std::string, size_t>   old_entries;
+    for(size_t i = 0; i < old_cache.entries.size(); i ++)
+        old_entries.insert(::std::make_pair( old_cache.entries[i].path, i ));
+
+    size_t  num_reused = 0;
+    for(auto& c : candidates)
+    {
+        auto it_b = st.bodies.find(c.first);
+        auto it_e = old_entries.find(c.first);
+        if( it_b == st.bodies.end() || it_e == old_entries.end() )
+            continue ;
+        const auto& e = old_cache.entries[it_e->second];
+        auto& mir = old_cache.bodies[it_e->second];
+        if( e.original_hash != it_b->second.key || e.interface_hash == 0 )
+            continue ;
+        // The lowered MIR can name items that the expression doesn't (e.g. the traits that methods resolved to)
+        auto paths = it_b->second.paths;
+        HIR_HashMir(*mir, &paths);
+        if( st.dep_hasher.hash_dependencies(::std::move(paths)) != e.interface_hash ) {
+            DEBUG(c.first << ": Dependencies changed");
+            continue ;
+        }
+
+        DEBUG(c.first << ": Reused");
+        ConvertHIR_Bind_Mir(crate, *mir);
+        // Replace the expression with `loop {}` (typechecks against any return type, and is never lowered)
+        auto& code = c.second->m_code;
+        Span    sp = code->span();
+        code.reset(new ::HIR::ExprNode_Loop(sp, RcString(), ::HIR::ExprNodeP(new ::HIR::ExprNode_Block(sp))));
+        code.set_mir(::std::move(mir));
+        num_reused ++;
+    }
+    DEBUG("Reused " << num_reused << "/" << candidates.size() << " lowered bodies");
+}
+
+void MIR::LowerCache::save(::HIR::Crate& crate)
+{
+    if( !m_state )
+        return ;
+    TRACE_FUNCTION_F(m_state->path);
+    auto& st = *m_state;
+
+    ::MIR::OptimiseCache    new_cache;
+    ::std::vector<const ::MIR::Function*>   bodies;
+    new_cache.environment_hash = st.environment_hash;
+    FunctionVisitor fv { [&](const ::HIR::ItemPath& ip, const ::HIR::TypeRef* impl_type, const ::HIR::GenericParams* impl_generics, ::HIR::Function& fcn) {
+        if( !fcn.m_code || !fcn.m_code.m_mir )
+            return ;
+        auto p = FMT(ip);
+        auto it = st.bodies.find(p);
+        if( it == st.bodies.end() )
+            return ;
+        auto paths = it->second.paths;
+        HIR_HashMir(*fcn.m_code.m_mir, &paths);
+        auto dep_hash = st.dep_hasher.hash_dependencies(::std::move(paths));
+        if( dep_hash == 0 )
+            return ;
+        ::MIR::OptimiseCache::Entry e;
+        e.path = ::std::move(p);
+        e.original_hash = it->second.key;
+        e.interface_hash = dep_hash;
+        new_cache.entries.push_back(::std::move(e));
+        bodies.push_back(&*fcn.m_code.m_mir);
+        } };
+    fv.visit_crate(crate);
+    DEBUG("Saving " << bodies.size() << " lowered bodies");
+
+    try
+    {
+        HIR_SerialiseMirCache(st.path, new_cache, bodies);
+    }
+    catch(const ::std::exception& e)
+    {
+        // The cache is only an optimisation, so failing to save it isn't an error
+        WARNING(Span(), W0000, "Unable to save incremental cache to " << st.path << ": " << e.what());
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/lower_cache.hpp
+ * - Incremental compilation cache for typecheck and MIR lowering
+ */
+#pragma once
+#include <string>
+#include <memory>
+
+namespace HIR {
+    class Crate;
+}
+
+namespace MIR {
+
+/// Reuses the lowered MIR of function bodies that are unchanged since the previous run
+///
+/// `load` is called before typecheck of expressions: a body is reused if its expression tree (from before typecheck)
+/// and signature hash the same as last time, and the items named by it (or by its lowered MIR) have the same
+/// interfaces (see `HIR_HashItem`). Reused bodies get their MIR set and their expression replaced with a placeholder,
+/// so typecheck and lowering skip them. `save` is called after lowering, and records every body for the next run.
+///
+/// Bodies containing closures, generators or inline assembly, and functions returning `impl Trait` (and anything that
+/// uses them), are never reused.
+class LowerCache
+{
+    struct State;
+    ::std::unique_ptr<State>    m_state;
+public:
+    LowerCache();
+    ~LowerCache();
+
+    /// Load the previous results from `path`, and replace unchanged bodies with their cached MIR
+    void load(::HIR::Crate& crate, ::std::string path);
+    /// Save the lowered MIR of the crate (does nothing if `load` wasn't called)
+    void save(::HIR::Crate& crate);
+};
+
+}   // namespace MIR
@@ -17,7 +17,8 @@ extern void MIR_CheckCrate(/*const*/ ::HIR::Crate& crate);
 extern void MIR_CheckCrate_Full(/*const*/ ::HIR::Crate& crate);
 
 extern void MIR_CleanupCrate(::HIR::Crate& crate);
-extern void MIR_OptimiseCrate(::HIR::Crate& crate, bool minimal_optimisations);
-extern void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list);
+/// `cache_path` enables the incremental cache (results are loaded from and saved to this file)
+extern void MIR_OptimiseCrate(::HIR::Crate& crate, bool minimal_optimisations, unsigned num_threads, const ::std::string& cache_path="");
+extern void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list, unsigned num_threads);
 
 extern void HIR_GenerateMIR_Expr(const ::HIR::Crate& crate, const ::HIR::ItemPath& path, ::HIR::ExprPtr& expr_ptr, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& res_ty);
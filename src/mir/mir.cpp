@@ -847,3 +847,111 @@ bool MIR::SwitchValues::operator==(const SwitchValues& x) const
     return true;
 }
 
+
+::MIR::Function MIR::Function::clone() const
+{
+    struct H {
+        static ::MIR::Statement clone_stmt(const ::MIR::Statement& stmt)
+        {
+            TU_MATCH_HDRA( (stmt), {)
+            TU_ARMA(Assign, se) {
+                return ::MIR::Statement::make_Assign({ se.dst.clone(), se.src.clone() });
+                }
+            TU_ARMA(Asm, se) {
+                ::MIR::Statement::Data_Asm  rv;
+                rv.tpl = se.tpl;
+                for(const auto& v : se.outputs)
+                    rv.outputs.push_back(::std::make_pair(v.first, v.second.clone()));
+                for(const auto& v : se.inputs)
+                    rv.inputs.push_back(::std::make_pair(v.first, v.second.clone()));
+                rv.clobbers = se.clobbers;
+                rv.flags = se.flags;
+                return ::MIR::Statement(mv$(rv));
+                }
+            TU_ARMA(Asm2, se) {
+                ::std::vector<::MIR::AsmParam>  params;
+                for(const auto& p : se.params)
+                {
+                    TU_MATCH_HDRA( (p), {)
+                    TU_ARMA(Const, v)
+                        params.push_back( v.clone() );
+                    TU_ARMA(Sym, v)
+                        params.push_back( v.clone() );
+                    TU_ARMA(Reg, v)
+                        params.push_back(::MIR::AsmParam::make_Reg({
+                            v.dir,
+                            v.spec.clone(),
+                            v.input  ? box$(v.input->clone()) : std::unique_ptr<MIR::Param>(),
+                            v.output ? box$(v.output->clone()) : std::unique_ptr<MIR::LValue>()
+                            }));
+                    }
+                }
+                return ::MIR::Statement::make_Asm2({ se.options, se.lines, mv$(params) });
+                }
+            TU_ARMA(SetDropFlag, se) {
+                return ::MIR::Statement::make_SetDropFlag({ se.idx, se.new_val, se.other });
+                }
+            TU_ARMA(Drop, se) {
+                return ::MIR::Statement::make_Drop({ se.kind, se.slot.clone(), se.flag_idx });
+                }
+            TU_ARMA(ScopeEnd, se) {
+                return ::MIR::Statement::make_ScopeEnd({ se.slots });
+                }
+            }
+            throw "";
+        }
+        static ::MIR::Terminator clone_term(const ::MIR::Terminator& term)
+        {
+            TU_MATCH_HDRA( (term), {)
+            TU_ARMA(Incomplete, te) return ::MIR::Terminator::make_Incomplete({});
+            TU_ARMA(Return, te)     return ::MIR::Terminator::make_Return({});
+            TU_ARMA(Diverge, te)    return ::MIR::Terminator::make_Diverge({});
+            TU_ARMA(Goto, te)       return ::MIR::Terminator::make_Goto(te);
+            TU_ARMA(Panic, te)      return ::MIR::Terminator::make_Panic({ te.dst });
+            TU_ARMA(If, te) {
+                return ::MIR::Terminator::make_If({ te.cond.clone(), te.bb0, te.bb1 });
+                }
+            TU_ARMA(Switch, te) {
+                return ::MIR::Terminator::make_Switch({ te.val.clone(), te.targets });
+                }
+            TU_ARMA(SwitchValue, te) {
+                return ::MIR::Terminator::make_SwitchValue({ te.val.clone(), te.def_target, te.targets, te.values.clone() });
+                }
+            TU_ARMA(Call, te) {
+                ::MIR::CallTarget   tgt;
+                TU_MATCH_HDRA( (te.fcn), {)
+                TU_ARMA(Value, ste)
+                    tgt = ::MIR::CallTarget::make_Value( ste.clone() );
+                TU_ARMA(Path, ste)
+                    tgt = ::MIR::CallTarget::make_Path( ste.clone() );
+                TU_ARMA(Intrinsic, ste)
+                    tgt = ::MIR::CallTarget::make_Intrinsic({ ste.name, ste.params.clone() });
+                }
+                ::std::vector<::MIR::Param> args;
+                args.reserve(te.args.size());
+                for(const auto& a : te.args)
+                    args.push_back(a.clone());
+                return ::MIR::Terminator::make_Call({ te.ret_block, te.panic_block, te.ret_val.clone(), mv$(tgt), mv$(args) });
+                }
+            }
+            throw "";
+        }
+    };
+
+    ::MIR::Function rv;
+    rv.locals.reserve(this->locals.size());
+    for(const auto& ty : this->locals)
+        rv.locals.push_back(ty.clone());
+    rv.drop_flags = this->drop_flags;
+    rv.blocks.reserve(this->blocks.size());
+    for(const auto& bb : this->blocks)
+    {
+        ::MIR::BasicBlock   new_bb;
+        new_bb.statements.reserve(bb.statements.size());
+        for(const auto& stmt : bb.statements)
+            new_bb.statements.push_back( H::clone_stmt(stmt) );
+        new_bb.terminator = H::clone_term(bb.terminator);
+        rv.blocks.push_back( mv$(new_bb) );
+    }
+    return rv;
+}
@@ -13,6 +13,7 @@
 #include <hir/type.hpp>
 #include "../hir/asm.hpp"
 #include <int128.h>
+#include <memory_stats.hpp>
 
 struct MonomorphState;
 
@@ -730,6 +731,11 @@ public:
 
     // Cache filled/used by enumerate
     mutable EnumCachePtr trans_enum_state;
+
+    /// Deep copy (not including the enumerate cache)
+    Function clone() const;
+
+    MEMORY_STATS_ALLOCATOR(MirFunction)
 };
 
 };
@@ -3,17 +3,59 @@
  * - By John Hodge (Mutabah/thePowersGang)
  *
  * mir/mir_ptr.cpp
- * - Destructor for MIR function pointers (cold path code)
+ * - Out-of-line parts of MIR function pointers (destruction and lazy loading)
  */
 #include "mir_ptr.hpp"
 #include "mir.hpp"
+#include <mutex>
 
+struct MIR::FunctionPointer::Lazy
+{
+    ::std::mutex    lock;
+    ::std::unique_ptr<FunctionLoader>   loader;
+    ::std::function<void(::MIR::Function&)> post_load;
+};
+
+::MIR::FunctionPointer::FunctionPointer(::std::unique_ptr<FunctionLoader> loader):
+    ptr(nullptr),
+    lazy(new Lazy)
+{
+    lazy->loader = ::std::move(loader);
+}
 
 void ::MIR::FunctionPointer::reset()
 {
-    if( this->ptr ) {
-        delete this->ptr;
+    if( auto* p = this->ptr.load() ) {
+        delete p;
         this->ptr = nullptr;
     }
+    if( this->lazy ) {
+        delete this->lazy;
+        this->lazy = nullptr;
+    }
+}
+
+void ::MIR::FunctionPointer::set_post_load(::std::function<void(::MIR::Function&)> cb)
+{
+    assert(this->lazy);
+    ::std::lock_guard<::std::mutex> lh { this->lazy->lock };
+    assert(!this->ptr.load());
+    this->lazy->post_load = ::std::move(cb);
 }
 
+::MIR::Function* ::MIR::FunctionPointer::load_lazy() const
+{
+    ::std::lock_guard<::std::mutex> lh { this->lazy->lock };
+    // Another thread may have loaded it while this one waited for the lock
+    if( auto* p = this->ptr.load() ) {
+        return p;
+    }
+    auto* p = this->lazy->loader->load();
+    this->lazy->loader.reset();
+    if( this->lazy->post_load ) {
+        this->lazy->post_load(*p);
+        this->lazy->post_load = nullptr;
+    }
+    this->ptr.store(p, ::std::memory_order_release);
+    return p;
+}
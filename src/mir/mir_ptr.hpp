@@ -6,37 +6,70 @@
  * - Pointer to a blob of MIR
  */
 #pragma once
+#include <atomic>
+#include <memory>
+#include <functional>
 
 namespace MIR {
 
 class Function;
 
+/// Source of MIR that hasn't been loaded yet (e.g. a function body in an extern crate's metadata)
+class FunctionLoader
+{
+public:
+    virtual ~FunctionLoader() {}
+    virtual ::MIR::Function* load() = 0;
+};
+
 class FunctionPointer
 {
-    ::MIR::Function*    ptr;
+    struct Lazy;
+
+    mutable ::std::atomic<::MIR::Function*> ptr;
+    // Non-null if this was created with a loader (kept after loading, for the lock)
+    Lazy*   lazy;
 public:
-    FunctionPointer(): ptr(nullptr) {}
-    FunctionPointer(::MIR::Function* p): ptr(p) {}
-    FunctionPointer(FunctionPointer&& x): ptr(x.ptr) { x.ptr = nullptr; }
+    FunctionPointer(): ptr(nullptr), lazy(nullptr) {}
+    FunctionPointer(::MIR::Function* p): ptr(p), lazy(nullptr) {}
+    /// Lazily loaded MIR, the loader is called (once, thread-safe) on first access
+    FunctionPointer(::std::unique_ptr<FunctionLoader> loader);
+    FunctionPointer(FunctionPointer&& x): ptr(x.ptr.load()), lazy(x.lazy) { x.ptr = nullptr; x.lazy = nullptr; }
 
     ~FunctionPointer() {
         reset();
     }
     FunctionPointer& operator=(FunctionPointer&& x) {
         reset();
-        ptr = x.ptr;
+        ptr = x.ptr.load();
+        lazy = x.lazy;
         x.ptr = nullptr;
+        x.lazy = nullptr;
         return *this;
     }
 
     void reset();
 
-          ::MIR::Function* operator->()       { if(!ptr) throw ""; return ptr; }
-    const ::MIR::Function* operator->() const { if(!ptr) throw ""; return ptr; }
-          ::MIR::Function& operator*()       { if(!ptr) throw ""; return *ptr; }
-    const ::MIR::Function& operator*() const { if(!ptr) throw ""; return *ptr; }
+    /// Returns false if this is lazy and hasn't been loaded yet
+    bool is_loaded() const { return !lazy || ptr.load(::std::memory_order_acquire); }
+    /// Set a callback to run on lazily-loaded MIR before it's returned (e.g. to bind paths)
+    void set_post_load(::std::function<void(::MIR::Function&)> cb);
+
+          ::MIR::Function* operator->()       { return &get(); }
+    const ::MIR::Function* operator->() const { return &get(); }
+          ::MIR::Function& operator*()       { return get(); }
+    const ::MIR::Function& operator*() const { return get(); }
 
-    operator bool() const { return ptr != nullptr; }
+    operator bool() const { return ptr.load(::std::memory_order_relaxed) != nullptr || lazy != nullptr; }
+
+private:
+    ::MIR::Function& get() const {
+        auto* p = ptr.load(::std::memory_order_acquire);
+        if(!p && lazy) p = load_lazy();
+        if(!p) throw "";
+        return *p;
+    }
+    ::MIR::Function* load_lazy() const;
 };
 
 }
@@ -18,6 +18,14 @@
 #include <iomanip>
 #include <trans/target.hpp>
 #include <trans/trans_list.hpp> // Note: This is included for inlining after enumeration and monomorph
+#include <parallel.hpp>
+#include <mutex>
+#include <condition_variable>
+#include <version.hpp>
+#include <hir/main_bindings.hpp>    // HIR_HashMir and friends, for the incremental cache
+#include <hir_conv/main_bindings.hpp>   // ConvertHIR_Bind_Mir
+#include "optimise_cache.hpp"
+#include "dependency_hasher.hpp"
 
 #include <hir/expr.hpp> // HACK
 
@@ -435,6 +443,264 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
 
 namespace
 {
+    /// Owned copy of an `ItemPath` chain (the visitor's ones only live for the duration of the callback), so that a
+    /// deferred job reports the same path as the serial version
+    class OwnedItemPath
+    {
+        struct Node {
+            ::std::unique_ptr<::HIR::TypeRef>   ty;
+            ::std::unique_ptr<::HIR::SimplePath>    trait;
+            ::std::unique_ptr<::HIR::PathParams>    trait_params;
+            ::std::unique_ptr<::HIR::Path>  wrapped;
+            ::std::unique_ptr<::std::string>    name;
+            ::std::unique_ptr<::std::string>    crate_name;
+        };
+        ::std::vector<Node> m_nodes;
+        // NOTE: Points into `m_nodes` (and the previous entry), both are heap buffers so survive this being moved
+        ::std::vector<::HIR::ItemPath>  m_paths;
+    public:
+        OwnedItemPath(const ::HIR::ItemPath& ip)
+        {
+            ::std::vector<const ::HIR::ItemPath*>   chain;
+            for(const auto* p = &ip; p; p = p->parent)
+                chain.push_back(p);
+            m_nodes.reserve(chain.size());
+            m_paths.reserve(chain.size());
+            for(auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                const auto& src = **it;
+                m_nodes.push_back(Node());
+                auto& n = m_nodes.back();
+                m_paths.push_back(::HIR::ItemPath(""));
+                auto& dst = m_paths.back();
+                dst.crate_name = nullptr;
+                dst.parent = m_paths.size() > 1 ? &m_paths[m_paths.size()-2] : nullptr;
+                if( src.ty ) {
+                    n.ty.reset(new ::HIR::TypeRef(src.ty->clone()));
+                    dst.ty = n.ty.get();
+                }
+                if( src.trait ) {
+                    n.trait.reset(new ::HIR::SimplePath(src.trait->clone()));
+                    dst.trait = n.trait.get();
+                }
+                if( src.trait_params ) {
+                    n.trait_params.reset(new ::HIR::PathParams(src.trait_params->clone()));
+                    dst.trait_params = n.trait_params.get();
+                }
+                if( src.wrapped ) {
+                    n.wrapped.reset(new ::HIR::Path(src.wrapped->clone()));
+                    dst.wrapped = n.wrapped.get();
+                }
+                if( src.name ) {
+                    n.name.reset(new ::std::string(src.name));
+                    dst.name = n.name->c_str();
+                }
+                if( src.crate_name ) {
+                    n.crate_name.reset(new ::std::string(src.crate_name));
+                    dst.crate_name = n.crate_name->c_str();
+                }
+            }
+        }
+        OwnedItemPath(const OwnedItemPath&) = delete;
+        OwnedItemPath(OwnedItemPath&&) = default;
+        OwnedItemPath& operator=(OwnedItemPath&&) = default;
+
+        const ::HIR::ItemPath& get() const {
+            return m_paths.back();
+        }
+    };
+
+    /// State for the multi-threaded versions of `MIR_OptimiseCrate` and `MIR_OptimiseCrate_Inlining`
+    ///
+    /// Inlining reads the MIR of callees, so to produce the same output as a serial run a body must see callees that
+    /// come before it (in visit order) in their optimised form, and callees after it in their original form.
+    /// - Readers of an earlier body wait for it to complete.
+    /// - Readers of a later body get a snapshot of the original, taken before that body starts being optimised.
+    class ParallelOptimiseState
+    {
+    public:
+        struct Job {
+            ::std::string   path;
+            ::MIR::Function*    mir;
+            const ::HIR::Function::args_t*  args;   // `nullptr` for no arguments
+            ::HIR::TypeRef  ret_ty;
+            const ::HIR::GenericParams* impl_generics;
+            const ::HIR::GenericParams* item_generics;
+            // Path for diagnostics (`path` is the formatted version, used for lookups)
+            OwnedItemPath   item_path;
+        };
+        ::std::vector<Job>  m_jobs;
+    private:
+        enum class JobState {
+            Pending,
+            Running,
+            Done,
+        };
+        struct JobInfo {
+            JobState    state = JobState::Pending;
+            // Copy of the pre-optimisation MIR, for use by earlier bodies
+            ::std::unique_ptr<::MIR::Function>  original;
+
+            // Incremental cache: hashes of the MIR before and after optimisation (`result_hash` is set before the job
+            // is marked as done), and the other jobs that were read by this job.
+            uint64_t    original_hash = 0;
+            uint64_t    result_hash = 0;
+            // Hash of the items that the body refers to (zero if they couldn't all be found, so it can't be cached)
+            uint64_t    interface_hash = 0;
+            ::std::set<size_t>  callees;
+        };
+        // Populated before the worker threads start, read-only afterwards
+        ::std::map<const ::MIR::Function*, size_t>  m_job_for_mir;
+        ::std::map<::std::string, size_t>   m_job_for_path;
+
+        ::std::mutex    m_lock;
+        ::std::condition_variable   m_cond;
+        ::std::vector<JobInfo>  m_info;
+        // All jobs before this index are complete
+        size_t  m_first_incomplete = 0;
+        // All jobs before this index have had their snapshot released
+        size_t  m_first_unreleased = 0;
+    public:
+        /// Add a job, returns false if the job's MIR is already used by another job
+        bool add_job(Job job) {
+            if( !m_job_for_mir.insert(::std::make_pair( job.mir, m_jobs.size() )).second ) {
+                return false;
+            }
+            // Paths should be unique, but if they're not then don't use it for cache lookups
+            auto ins = m_job_for_path.insert(::std::make_pair( job.path, m_jobs.size() ));
+            if( !ins.second ) {
+                ins.first->second = SIZE_MAX;
+            }
+            m_jobs.push_back(mv$(job));
+            m_info.push_back(JobInfo());
+            return true;
+        }
+
+        /// Mark a job as started, taking a snapshot of the MIR if any earlier job could still read it
+        void start(size_t idx)
+        {
+            const auto& mir = *m_jobs[idx].mir;
+            bool need_snapshot;
+            {
+                ::std::lock_guard<::std::mutex> lh { m_lock };
+                need_snapshot = m_first_incomplete < idx && !m_info[idx].original;
+            }
+            // NOTE: Cloned outside the lock, the MIR can't be changed until this job is marked as running
+            ::std::unique_ptr<::MIR::Function>  snapshot;
+            if( need_snapshot ) {
+                snapshot = box$( mir.clone() );
+            }
+            ::std::lock_guard<::std::mutex> lh { m_lock };
+            if( m_first_incomplete < idx && !m_info[idx].original ) {
+                m_info[idx].original = mv$(snapshot);
+            }
+            m_info[idx].state = JobState::Running;
+        }
+        void complete(size_t idx)
+        {
+            ::std::lock_guard<::std::mutex> lh { m_lock };
+            m_info[idx].state = JobState::Done;
+            while( m_first_incomplete < m_info.size() && m_info[m_first_incomplete].state == JobState::Done )
+            {
+                m_first_incomplete ++;
+            }
+            // Snapshots are only needed while an earlier job is still running
+            for(; m_first_unreleased < m_info.size() && m_first_unreleased <= m_first_incomplete; m_first_unreleased ++)
+            {
+                m_info[m_first_unreleased].original.reset();
+            }
+            m_cond.notify_all();
+        }
+
+        /// Get the MIR that the job `cur_idx` should see for the given callee
+        const ::MIR::Function* get_callee(size_t cur_idx, const ::MIR::Function* mir)
+        {
+            auto it = m_job_for_mir.find(mir);
+            if( it == m_job_for_mir.end() || it->second == cur_idx ) {
+                return mir;
+            }
+            auto idx = it->second;
+            // NOTE: Only this job's thread touches its own `callees`
+            m_info[cur_idx].callees.insert(idx);
+            ::std::unique_lock<::std::mutex> lh { m_lock };
+            if( idx < cur_idx ) {
+                m_cond.wait(lh, [&]{ return m_info[idx].state == JobState::Done; });
+                return mir;
+            }
+            else {
+                auto& info = m_info[idx];
+                if( !info.original ) {
+                    ASSERT_BUG(Span(), info.state == JobState::Pending, "Later MIR body started without a snapshot - " << m_jobs[idx].path);
+                    info.original = box$( mir->clone() );
+                }
+                return &*info.original;
+            }
+        }
+
+        // --- Incremental cache support ---
+        /// Look up a job by its path, returns SIZE_MAX if not found (or not unique)
+        size_t find_job(const ::std::string& path) const
+        {
+            auto it = m_job_for_path.find(path);
+            return it == m_job_for_path.end() ? SIZE_MAX : it->second;
+        }
+        /// Set the hash of the un-optimised MIR (must be called before the workers start)
+        void set_original_hash(size_t idx, uint64_t hash) {
+            m_info[idx].original_hash = hash;
+        }
+        uint64_t get_original_hash(size_t idx) const {
+            return m_info[idx].original_hash;
+        }
+        /// Set the hash of the interfaces used by the job (must be called before the workers start)
+        void set_interface_hash(size_t idx, uint64_t hash) {
+            m_info[idx].interface_hash = hash;
+        }
+        uint64_t get_interface_hash(size_t idx) const {
+            return m_info[idx].interface_hash;
+        }
+        /// Get the hash of the version of `idx` that `cur_idx` would see from `get_callee`
+        uint64_t get_seen_hash(size_t cur_idx, size_t idx)
+        {
+            if( idx > cur_idx ) {
+                return m_info[idx].original_hash;
+            }
+            ::std::unique_lock<::std::mutex> lh { m_lock };
+            m_cond.wait(lh, [&]{ return m_info[idx].state == JobState::Done; });
+            return m_info[idx].result_hash;
+        }
+        /// Record the result of a job (must be called before `complete`)
+        void set_result(size_t idx, uint64_t result_hash, const ::std::set<size_t>* callees=nullptr)
+        {
+            ::std::lock_guard<::std::mutex> lh { m_lock };
+            m_info[idx].result_hash = result_hash;
+            if( callees ) {
+                m_info[idx].callees = *callees;
+            }
+        }
+        /// Build the cache entry for a completed job
+        ::MIR::OptimiseCache::Entry get_cache_entry(size_t idx) const
+        {
+            ::MIR::OptimiseCache::Entry rv;
+            rv.path = m_jobs[idx].path;
+            rv.original_hash = m_info[idx].original_hash;
+            rv.result_hash = m_info[idx].result_hash;
+            rv.interface_hash = m_info[idx].interface_hash;
+            for(auto c : m_info[idx].callees)
+            {
+                rv.deps.push_back(::MIR::OptimiseCache::Dependency {
+                    m_jobs[c].path,
+                    c < idx ? m_info[c].result_hash : m_info[c].original_hash
+                    });
+            }
+            return rv;
+        }
+    };
+    struct ParallelOptimiseWorker {
+        ParallelOptimiseState*  state;
+        size_t  job_idx;
+    };
+    thread_local const ParallelOptimiseWorker* tl_parallel_optimise_worker;
+
     enum class ValUsage {
         Move,   // Moving read (even if T: Copy)
         Read,   // Non-moving read (e.g. indexing or deref, TODO: &move pointers?)
@@ -717,13 +983,19 @@ namespace
                 MIR_BUG(state, "Enumeration failure - Function " << path << " not in TransList");
             }
             const auto& hir_fcn = *it->second->ptr;
-            if( it->second->monomorphised.code ) {
-                return &*it->second->monomorphised.code;
+            const auto* w = tl_parallel_optimise_worker;
+            if( it->second->use_shared ) {
+                // Code is in an upstream crate, treat as external
+                return nullptr;
+            }
+            else if( it->second->monomorphised.code ) {
+                const auto* mir = &*it->second->monomorphised.code;
+                return w ? w->state->get_callee(w->job_idx, mir) : mir;
             }
             else if( const auto* mir = hir_fcn.m_code.get_mir_opt() ) {
                 MIR_ASSERT(state, hir_fcn.m_params.m_types.empty(), "Enumeration failure - Function had params, but wasn't monomorphised - " << path);
                 // TODO: Check for trait methods too?
-                return mir;
+                return w ? w->state->get_callee(w->job_idx, mir) : mir;
             }
             else {
                 MIR_ASSERT(state, !hir_fcn.m_code, "LowerMIR failure - No MIR but HIR is present?! - " << path);
@@ -766,6 +1038,11 @@ namespace
             }
         TU_ARMA(Function, f) {
             params.fcn_params_def = &f->m_params;
+            if( const auto* w = tl_parallel_optimise_worker ) {
+                if( const auto* mir = f->m_code.get_mir_opt() ) {
+                    return w->state->get_callee(w->job_idx, mir);
+                }
+            }
             return f->m_code.get_mir_opt();
             }
         }
@@ -6434,29 +6711,263 @@ void MIR_SortBlocks(const StaticTraitResolve& resolve, const ::HIR::ItemPath& pa
 }
 
 
-void MIR_OptimiseCrate(::HIR::Crate& crate, bool do_minimal_optimisation)
+namespace {
+    /// Hash of the global state that can change the result of optimising any body
+    uint64_t MIR_Optimise_GetEnvironmentHash(const ::HIR::Crate& crate, bool do_minimal_optimisation)
+    {
+        uint64_t    rv = 0xcbf29ce484222325;
+        auto push_bytes = [&](const void* data, size_t len) {
+            for(size_t i = 0; i < len; i ++) {
+                rv ^= static_cast<const uint8_t*>(data)[i];
+                rv *= 0x100000001b3;
+            }
+            };
+        auto push_str = [&](const ::std::string& s) { push_bytes(s.c_str(), s.size() + 1); };
+        auto push_u = [&](uint64_t v) { push_bytes(&v, sizeof(v)); };
+
+        push_str(Version_GetString());
+        push_str(gsVersion_BuildTime);
+        push_u(do_minimal_optimisation);
+
+        const auto& tgt = Target_GetCurSpec();
+        push_str(tgt.m_family);
+        push_str(tgt.m_os_name);
+        push_str(tgt.m_env_name);
+        push_str(tgt.m_arch.m_name);
+        push_u(tgt.m_arch.m_pointer_bits);
+        push_u(tgt.m_arch.m_big_endian);
+        push_str(tgt.m_backend_c.m_c_compiler);
+        push_u(tgt.m_backend_c.m_emulated_i128);
+
+        // Impls that aren't on a named type could apply to anything, so aren't tracked per body
+        push_u(HIR_HashUnnamedImpls(crate));
+        return rv;
+    }
+}
+
+void MIR_OptimiseCrate(::HIR::Crate& crate, bool do_minimal_optimisation, unsigned num_threads, const ::std::string& cache_path)
 {
-    ::MIR::OuterVisitor ov { crate, [do_minimal_optimisation](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+    auto run_optimise = [do_minimal_optimisation](const StaticTraitResolve& res, const ::HIR::ItemPath& p, ::MIR::Function& mir, const ::HIR::Function::args_t& args, const ::HIR::TypeRef& ty) {
+        if( do_minimal_optimisation ) {
+            MIR_OptimiseMin(res, p, mir, args, ty);
+        }
+        else {
+            MIR_Optimise(res, p, mir, args, ty);
+        }
+        };
+
+    // The cache is enabled by `-C incremental` alone (like the lowering cache), with any number of threads
+    bool use_cache = cache_path != "";
+    // Debug output is only readable when run serially
+    if( debug_enabled() )
+    {
+        num_threads = 1;
+    }
+    if( num_threads <= 1 && !use_cache )
+    {
+        ::MIR::OuterVisitor ov { crate, [&](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+            {
+                //if( ! dynamic_cast<::HIR::ExprNode_Block*>(expr.get()) ) {
+                //    return ;
+                //}
+                auto& mir = expr.get_mir_or_error_mut(Span());
+                run_optimise(res, p, mir, args, ty);
+            }
+            };
+        ov.visit_crate(crate);
+        return ;
+    }
+
+    // Multi-threaded (or incremental): Enumerate all bodies (in the same order as the serial version) then optimise
+    // them in parallel
+    ParallelOptimiseState   state;
+    {
+        ::MIR::OuterVisitor ov { crate, [&](const auto& res, const auto& p, auto& expr, const auto& args, const auto& ty)
+            {
+                state.add_job(ParallelOptimiseState::Job {
+                    FMT(p),
+                    &expr.get_mir_or_error_mut(Span()),
+                    args.empty() ? nullptr : &args,
+                    ty.clone(),
+                    res.m_impl_generics,
+                    res.m_item_generics,
+                    OwnedItemPath(p)
+                    });
+            }
+            };
+        ov.visit_crate(crate);
+    }
+    DEBUG(state.m_jobs.size() << " bodies across " << num_threads << " threads");
+
+    // Incremental: Load the previous results, and hash the input MIR
+    ::MIR::OptimiseCache    old_cache;
+    ::std::multimap<::std::string, size_t>  old_entries;
+    ::std::atomic<size_t>   num_reused { 0 };
+    if( use_cache )
+    {
+        old_cache.environment_hash = MIR_Optimise_GetEnvironmentHash(crate, do_minimal_optimisation);
+        if( HIR_DeserialiseMirCache(cache_path, old_cache.environment_hash, old_cache) )
         {
-            //if( ! dynamic_cast<::HIR::ExprNode_Block*>(expr.get()) ) {
-            //    return ;
-            //}
-            auto& mir = expr.get_mir_or_error_mut(Span());
-            if( do_minimal_optimisation ) {
-                MIR_OptimiseMin(res, p, mir, args, ty);
+            for(size_t i = 0; i < old_cache.entries.size(); i ++)
+            {
+                old_entries.insert(::std::make_pair( old_cache.entries[i].path, i ));
+                // Bind now (instead of on use), as the deserialiser shares types between bodies
+                ConvertHIR_Bind_Mir(crate, *old_cache.bodies[i]);
             }
-            else {
-                MIR_Optimise(res, p, mir, args, ty);
+        }
+        ::MIR::DependencyHasher dep_hasher { crate };
+        parallel_for_each_index(num_threads, state.m_jobs.size(), [&](size_t idx) {
+            const auto& job = state.m_jobs[idx];
+            ::std::set<::HIR::SimplePath>   paths;
+            state.set_original_hash(idx, HIR_HashMir(*job.mir, &paths));
+
+            ::std::vector<const ::HIR::TypeRef*>    sig_types;
+            if( job.args ) {
+                for(const auto& a : *job.args)
+                    sig_types.push_back(&a.second);
             }
+            sig_types.push_back(&job.ret_ty);
+            auto sig_hash = HIR_HashSignature(job.impl_generics, job.item_generics, sig_types, &paths);
+
+            auto dep_hash = dep_hasher.hash_dependencies(mv$(paths));
+            state.set_interface_hash(idx, dep_hash == 0 ? 0 : (dep_hash ^ sig_hash) | 1);
+            });
+    }
+    // Find a cached result for a job, checking that all of the bodies it read are unchanged
+    auto find_cached = [&](size_t idx)->const ::MIR::OptimiseCache::Entry* {
+        const auto& job = state.m_jobs[idx];
+        if( state.find_job(job.path) != idx )
+            return nullptr;
+        auto range = old_entries.equal_range(job.path);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            const auto& e = old_cache.entries[it->second];
+            if( e.original_hash != state.get_original_hash(idx) )
+                continue ;
+            if( e.interface_hash == 0 || e.interface_hash != state.get_interface_hash(idx) )
+                continue ;
+            bool valid = true;
+            for(const auto& dep : e.deps)
+            {
+                auto dep_idx = state.find_job(dep.path);
+                if( dep_idx == SIZE_MAX || dep_idx == idx || state.get_seen_hash(idx, dep_idx) != dep.hash ) {
+                    valid = false;
+                    break;
+                }
+            }
+            if( valid )
+                return &e;
         }
+        return nullptr;
         };
-    ov.visit_crate(crate);
+
+    static const ::HIR::Function::args_t    empty_args;
+    parallel_for_each_index(num_threads, state.m_jobs.size(), [&](size_t idx) {
+        const auto& job = state.m_jobs[idx];
+        StaticTraitResolve  resolve { crate };
+        resolve.set_both_generics_raw(job.impl_generics, job.item_generics);
+
+        ParallelOptimiseWorker  worker { &state, idx };
+        tl_parallel_optimise_worker = &worker;
+        struct Guard {
+            ParallelOptimiseState& state;
+            size_t  idx;
+            ~Guard() {
+                tl_parallel_optimise_worker = nullptr;
+                state.complete(idx);
+            }
+        } guard { state, idx };
+
+        state.start(idx);
+        auto& mir = *job.mir;
+        if( !use_cache )
+        {
+            run_optimise(resolve, job.item_path.get(), mir, job.args ? *job.args : empty_args, job.ret_ty);
+        }
+        else if( const auto* e = find_cached(idx) )
+        {
+            // NOTE: Replaced in-place, as other jobs refer to bodies by address.
+            mir = mv$(*old_cache.bodies[e - old_cache.entries.data()]);
+            ::std::set<size_t>  callees;
+            for(const auto& dep : e->deps)
+                callees.insert(state.find_job(dep.path));
+            state.set_result(idx, e->result_hash, &callees);
+            num_reused ++;
+        }
+        else
+        {
+            run_optimise(resolve, job.item_path.get(), mir, job.args ? *job.args : empty_args, job.ret_ty);
+            state.set_result(idx, HIR_HashMir(mir));
+        }
+        });
+
+    if( use_cache )
+    {
+        DEBUG("Reused " << num_reused << "/" << state.m_jobs.size() << " optimised bodies");
+        ::MIR::OptimiseCache    new_cache;
+        ::std::vector<const ::MIR::Function*>   bodies;
+        new_cache.environment_hash = old_cache.environment_hash;
+        for(size_t i = 0; i < state.m_jobs.size(); i ++)
+        {
+            new_cache.entries.push_back( state.get_cache_entry(i) );
+            bodies.push_back( state.m_jobs[i].mir );
+        }
+        try
+        {
+            HIR_SerialiseMirCache(cache_path, new_cache, bodies);
+        }
+        catch(const ::std::exception& e)
+        {
+            // The cache is only an optimisation, so failing to save it isn't an error
+            WARNING(Span(), W0000, "Unable to save incremental cache to " << cache_path << ": " << e.what());
+        }
+    }
 }
 
-void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
+void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list, unsigned num_threads)
 {
     ::StaticTraitResolve    resolve { crate };
 
+    /// Run inlining on one function, returns true if anything was inlined
+    auto run_inline = [&list](const StaticTraitResolve& resolve, const ::HIR::Path& path, TransList_Function& fcn_ent)->bool {
+        auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.ptr);
+        auto& mono_fcn = fcn_ent.monomorphised;
+
+        ::std::string s = FMT(path);
+        ::HIR::ItemPath ip(s);
+
+        bool rv = false;
+        if( fcn_ent.use_shared )
+        {
+            // Not monomorphised, code is in an upstream crate
+        }
+        else if( mono_fcn.code )
+        {
+            rv = MIR_OptimiseInline(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty, list);
+
+            MIR_Cleanup(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty);
+        }
+        else if( hir_fcn.m_code )
+        {
+            auto& mir = hir_fcn.m_code.get_mir_or_error_mut(Span());
+            rv = MIR_OptimiseInline(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return, list);
+            mir.trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
+
+            MIR_Cleanup(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return);
+        }
+        else
+        {
+            // Extern, no optimisations
+        }
+        return rv;
+        };
+
+    // Debug output is only readable when run serially
+    if( debug_enabled() )
+    {
+        num_threads = 1;
+    }
+
     bool did_inline_on_pass;
 
     size_t  MAX_ITERATIONS = 5; // TODO: Tune this.
@@ -6465,36 +6976,66 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
     {
         did_inline_on_pass = false;
 
-        for(auto& fcn_ent : list.m_functions)
+        // Multi-threaded: Each pass is split into jobs (in list order), and callees are read as the serial pass would
+        // see them (see `ParallelOptimiseState`)
+        if( num_threads > 1 )
         {
-            const auto& path = fcn_ent.first;
-            //const auto& pp = fcn_ent.second->pp;
-            auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.second->ptr);
-            auto& mono_fcn = fcn_ent.second->monomorphised;
-
-            ::std::string s = FMT(path);
-            ::HIR::ItemPath ip(s);
-
-            if( mono_fcn.code )
+            ParallelOptimiseState   state;
+            ::std::vector<::std::pair<const ::HIR::Path*, TransList_Function*>>   fcns;
+            bool can_parallel = true;
+            for(auto& fcn_ent : list.m_functions)
             {
-                did_inline_on_pass |= MIR_OptimiseInline(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty, list);
-
-                MIR_Cleanup(resolve, ip, *mono_fcn.code, mono_fcn.arg_tys, mono_fcn.ret_ty);
+                ::MIR::Function* mir = nullptr;
+                if( fcn_ent.second->use_shared ) {
+                    continue ;
+                }
+                else if( fcn_ent.second->monomorphised.code ) {
+                    mir = &*fcn_ent.second->monomorphised.code;
+                }
+                else if( fcn_ent.second->ptr->m_code ) {
+                    mir = &const_cast<::HIR::Function*>(fcn_ent.second->ptr)->m_code.get_mir_or_error_mut(Span());
+                }
+                else {
+                    continue ;
+                }
+                // NOTE: If the same body is listed twice, the serial pass would optimise it twice - not parallelisable.
+                if( !state.add_job(ParallelOptimiseState::Job { FMT(fcn_ent.first), mir, nullptr, ::HIR::TypeRef(), nullptr, nullptr, OwnedItemPath(::HIR::ItemPath(fcn_ent.first)) }) ) {
+                    can_parallel = false;
+                    break;
+                }
+                fcns.push_back(::std::make_pair( &fcn_ent.first, &*fcn_ent.second ));
             }
-            else if( hir_fcn.m_code )
+            if( can_parallel )
             {
-                auto& mir = hir_fcn.m_code.get_mir_or_error_mut(Span());
-                bool did_opt = MIR_OptimiseInline(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return, list);
-                mir.trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
-                did_inline_on_pass |= did_opt;
+                DEBUG(fcns.size() << " bodies across " << num_threads << " threads");
+                ::std::atomic<bool> did_inline { false };
+                parallel_for_each_index(num_threads, fcns.size(), [&](size_t idx) {
+                    StaticTraitResolve  resolve { crate };
+                    ParallelOptimiseWorker  worker { &state, idx };
+                    tl_parallel_optimise_worker = &worker;
+                    struct Guard {
+                        ParallelOptimiseState& state;
+                        size_t  idx;
+                        ~Guard() {
+                            tl_parallel_optimise_worker = nullptr;
+                            state.complete(idx);
+                        }
+                    } guard { state, idx };
 
-                MIR_Cleanup(resolve, ip, mir, hir_fcn.m_args, hir_fcn.m_return);
-            }
-            else
-            {
-                // Extern, no optimisations
+                    state.start(idx);
+                    if( run_inline(resolve, *fcns[idx].first, *fcns[idx].second) ) {
+                        did_inline = true;
+                    }
+                    });
+                did_inline_on_pass = did_inline;
+                continue ;
             }
         }
+
+        for(auto& fcn_ent : list.m_functions)
+        {
+            did_inline_on_pass |= run_inline(resolve, fcn_ent.first, *fcn_ent.second);
+        }
     } while( did_inline_on_pass && num_iterations < MAX_ITERATIONS );
 
     if( did_inline_on_pass )
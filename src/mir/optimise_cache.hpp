@@ -0,0 +1,51 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/optimise_cache.hpp
+ * - Incremental compilation cache for MIR optimisation
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "mir_ptr.hpp"
+
+namespace MIR {
+
+/// Results of a previous `MIR_OptimiseCrate` run, saved alongside the crate's output
+///
+/// A body's cached result is reused if its unoptimised MIR is unchanged, and every other body that was read while
+/// optimising it (i.e. inlined) hashes to the same value as it did then.
+///
+/// Also used by `LowerCache` for lowered MIR: `original_hash` is then the hash of the expression before typecheck, and
+/// `result_hash`/`deps` are unused.
+struct OptimiseCache
+{
+    struct Dependency
+    {
+        ::std::string   path;
+        uint64_t    hash;
+    };
+    struct Entry
+    {
+        ::std::string   path;
+        /// Hash of the MIR before optimisation
+        uint64_t    original_hash = 0;
+        /// Hash of the optimised MIR
+        uint64_t    result_hash = 0;
+        /// Hash of the interfaces of the items that the body (and its signature) refers to, see `HIR_HashItem`
+        uint64_t    interface_hash = 0;
+        /// Bodies read during optimisation, and the hash of the version that was seen
+        ::std::vector<Dependency>   deps;
+    };
+
+    /// Hash of the global state that can influence any result (compiler version, target, options, impls on
+    /// primitive/generic types)
+    uint64_t    environment_hash = 0;
+    ::std::vector<Entry>    entries;
+    /// Optimised MIR for each entry (only populated when loaded)
+    ::std::vector<::MIR::FunctionPointer>  bodies;
+};
+
+}   // namespace MIR
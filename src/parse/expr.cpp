@@ -1319,9 +1319,9 @@ ExprNodeP Parse_ExprVal(TokenStream& lex)
     case TOK_FLOAT:
         return NEWNODE( AST::ExprNode_Float, tok.floatval(), tok.datatype() );
     case TOK_STRING:
-        return NEWNODE( AST::ExprNode_String, tok.str() );
+        return NEWNODE( AST::ExprNode_String, tok.str_owned() );
     case TOK_BYTESTRING:
-        return NEWNODE( AST::ExprNode_ByteString, tok.str() );
+        return NEWNODE( AST::ExprNode_ByteString, tok.str_owned() );
     case TOK_RWORD_TRUE:
         return NEWNODE( AST::ExprNode_Bool, true );
     case TOK_RWORD_FALSE:
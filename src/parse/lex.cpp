@@ -16,6 +16,14 @@
 #include <algorithm>    // std::count
 #include <limits>       // std::numeric_limits
 #include <cctype>
+#include <iterator> // istreambuf_iterator
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define LEX_USE_SSE2
+#endif
+#ifdef _MSC_VER
+# include <intrin.h>    // _BitScanForward
+#endif
 //#define TRACE_CHARS
 //#define TRACE_RAW_TOKENS
 
@@ -24,33 +32,144 @@ Lexer::Lexer(const ::std::string& filename, AST::Edition edition, ParseState ps)
     m_path(filename.c_str()),
     m_line(1),
     m_line_ofs(0),
-    m_istream_fp(filename != "-" ? new std::ifstream(filename.c_str()) : nullptr),
-    m_istream(filename != "-" ? *m_istream_fp : std::cin),
+    m_pos(0),
     m_last_char_valid(false),
     m_edition(edition),
     m_hygiene( Ident::Hygiene::new_scope() )
 {
-    if( m_istream_fp )
+    if( filename == "-" )
     {
-        if( !m_istream_fp->is_open() )
+        m_buffer.assign( ::std::istreambuf_iterator<char>(::std::cin), ::std::istreambuf_iterator<char>() );
+    }
+    else
+    {
+        // Read the whole file in one go, the lexer then works directly on the buffer
+        ::std::ifstream is(filename, ::std::ios_base::in|::std::ios_base::binary);
+        if( !is.is_open() )
         {
             throw ::std::runtime_error("Unable to open file '" + filename + "'");
         }
+        is.seekg(0, ::std::ios_base::end);
+        auto size = is.tellg();
+        if( size != ::std::streampos(-1) )
+        {
+            m_buffer.resize(static_cast<size_t>(size));
+            is.seekg(0);
+            is.read(&m_buffer[0], m_buffer.size());
+            // The file may have shrunk since the size was read
+            m_buffer.resize(static_cast<size_t>(is.gcount()));
+        }
+        else
+        {
+            // Can't get the size (e.g. a pipe), read in chunks until the end
+            is.clear();
+            char    chunk[64*1024];
+            while( is.read(chunk, sizeof(chunk)) || is.gcount() > 0 )
+            {
+                m_buffer.insert(m_buffer.end(), chunk, chunk + is.gcount());
+            }
+        }
+
         // Consume the BOM
-        if( this->getc_byte() == '\xef' )
+        if( m_buffer.size() > 0 && m_buffer[0] == '\xef' )
         {
-            if( this->getc_byte() != '\xbb' ) {
+            if( m_buffer.size() < 2 || m_buffer[1] != '\xbb' ) {
                 throw ::std::runtime_error("Incomplete BOM - missing \\xBB in second position");
             }
-            if( this->getc_byte() != '\xbf' ) {
+            if( m_buffer.size() < 3 || m_buffer[2] != '\xbf' ) {
                 throw ::std::runtime_error("Incomplete BOM - missing \\xBF in second position");
             }
-            m_line_ofs = 0;
+            m_pos = 3;
         }
-        else
+    }
+}
+
+namespace {
+    /// Get the length of the run of bytes starting at `p` that pass `byte_test`
+    template<typename ByteTest>
+    inline size_t count_run(const char* p, const char* end, ByteTest byte_test)
+    {
+        const char* start = p;
+        while( p != end && byte_test(static_cast<uint8_t>(*p)) )
+            p ++;
+        return p - start;
+    }
+#ifdef LEX_USE_SSE2
+    inline unsigned count_trailing_zeros(unsigned v) {
+# ifdef _MSC_VER
+        unsigned long rv;
+        _BitScanForward(&rv, v);
+        return rv;
+# else
+        return __builtin_ctz(v);
+# endif
+    }
+    /// As above, but checking 16 bytes at a time with `vec_test` (which must be equivalent to `byte_test`)
+    template<typename ByteTest, typename VecTest>
+    inline size_t count_run(const char* p, const char* end, ByteTest byte_test, VecTest vec_test)
+    {
+        const char* start = p;
+        while( end - p >= 16 )
         {
-            m_istream.unget();
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned fail_mask = ~static_cast<unsigned>(_mm_movemask_epi8(vec_test(v))) & 0xFFFF;
+            if( fail_mask != 0 )
+                return (p - start) + count_trailing_zeros(fail_mask);
+            p += 16;
         }
+        return (p - start) + count_run(p, end, byte_test);
+    }
+    inline __m128i vec_eq(__m128i v, char c) {
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+    }
+    inline __m128i vec_in_range(__m128i v, char lo, char hi) {
+        // NOTE: Signed comparisons, only valid for ASCII ranges (which is all that is needed)
+        return _mm_and_si128( _mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v) );
+    }
+#endif
+
+    /// Spaces and tabs
+    size_t count_blanks(const char* p, const char* end)
+    {
+        auto byte_test = [](uint8_t c) { return c == ' ' || c == '\t'; };
+#ifdef LEX_USE_SSE2
+        return count_run(p, end, byte_test, [](__m128i v) {
+            return _mm_or_si128( vec_eq(v, ' '), vec_eq(v, '\t') );
+            });
+#else
+        return count_run(p, end, byte_test);
+#endif
+    }
+    /// ASCII identifier characters
+    size_t count_ident_chars(const char* p, const char* end)
+    {
+        auto byte_test = [](uint8_t c) { return ('0' <= c && c <= '9') || ('a' <= (c|0x20) && (c|0x20) <= 'z') || c == '_'; };
+#ifdef LEX_USE_SSE2
+        return count_run(p, end, byte_test, [](__m128i v) {
+            auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            return _mm_or_si128( _mm_or_si128(vec_in_range(v, '0', '9'), vec_in_range(lower, 'a', 'z')), vec_eq(v, '_') );
+            });
+#else
+        return count_run(p, end, byte_test);
+#endif
+    }
+    /// ASCII characters other than newlines and the two stop characters
+    size_t count_plain_ascii(const char* p, const char* end, char stop1, char stop2)
+    {
+        auto byte_test = [=](uint8_t c) {
+            return c < 128 && c != '\n' && c != '\r' && c != static_cast<uint8_t>(stop1) && c != static_cast<uint8_t>(stop2);
+            };
+#ifdef LEX_USE_SSE2
+        return count_run(p, end, byte_test, [=](__m128i v) {
+            auto fail = _mm_or_si128(
+                _mm_or_si128( _mm_cmplt_epi8(v, _mm_setzero_si128()), vec_eq(v, '\n') ),
+                _mm_or_si128( vec_eq(v, '\r'), _mm_or_si128(vec_eq(v, stop1), vec_eq(v, stop2)) )
+                );
+            return _mm_andnot_si128(fail, _mm_set1_epi8(-1));
+            });
+#else
+        return count_run(p, end, byte_test);
+#endif
     }
 }
 
@@ -373,6 +492,10 @@ Token Lexer::getTokenInt()
             return Token(TOK_NEWLINE);
         if( ch.isspace() )
         {
+            // Fast path: skip over spaces and tabs directly
+            auto n = count_blanks(m_buffer.data() + m_pos, m_buffer.data() + m_buffer.size());
+            m_pos += n;
+            m_line_ofs += n;
             while( (ch = this->getc()).isspace() && ch != '\n' )
                 ;
             this->ungetc();
@@ -541,6 +664,7 @@ Token Lexer::getTokenInt()
                             }
                             else {
                                 str += ch;
+                                this->append_plain_ascii(str, '"', '\\');
                             }
                         }
                         return Token(TOK_BYTESTRING, mv$(str));
@@ -617,6 +741,7 @@ Token Lexer::getTokenInt()
                 while(ch != '\n' && ch != '\r')
                 {
                     str += ch;
+                    this->append_plain_ascii(str, '\n', '\n');
                     ch = this->getc();
                 }
                 this->ungetc();
@@ -679,6 +804,7 @@ Token Lexer::getTokenInt()
                         }
                         else {
                             str += ch;
+                            this->append_plain_ascii(str, '/', '*');
                         }
                     }
                     ch = this->getc();
@@ -744,6 +870,7 @@ Token Lexer::getTokenInt()
                     else
                     {
                         str += ch;
+                        this->append_plain_ascii(str, '"', '\\');
                     }
                 }
                 return Token(TOK_STRING, mv$(str));
@@ -839,9 +966,40 @@ Token Lexer::getTokenInt_RawString(bool is_byte)
 Token Lexer::getTokenInt_Identifier(Codepoint leader, Codepoint leader2, bool parse_reserved_word)
 {
     ::std::string   str;
-    if( leader2 != '\0' )
-        str += leader;
-    auto ch = leader2 == '\0' ? leader : leader2;
+    Codepoint   ch;
+    // Fast path: If the leader was the last character read, scan the rest of the ASCII identifier in the buffer
+    if( leader2 == '\0' && !m_last_char_valid && leader.v < 128 && m_pos > 0 && m_buffer[m_pos-1] == static_cast<char>(leader.v) )
+    {
+        size_t start = m_pos - 1;
+        auto n = count_ident_chars(m_buffer.data() + m_pos, m_buffer.data() + m_buffer.size());
+        m_pos += n;
+        m_line_ofs += n;
+        const char* s = m_buffer.data() + start;
+        size_t len = n + 1;
+
+        ch = this->getc();
+        // If the identifier didn't continue with a non-ASCII character, intern straight from the buffer
+        if( ch.v < 128 )
+        {
+            this->ungetc();
+            if(parse_reserved_word)
+            {
+                auto v = Lex_FindReservedWord(::std::string(s, len), this->m_edition);
+                if( v != TOK_NULL)
+                {
+                    return Token(v);
+                }
+            }
+            return Token(TOK_IDENT, Ident(this->realGetHygiene(), RcString::new_interned(s, len)));
+        }
+        str.assign(s, len);
+    }
+    else
+    {
+        if( leader2 != '\0' )
+            str += leader;
+        ch = leader2 == '\0' ? leader : leader2;
+    }
     while( issym(ch) )
     {
         str += ch;
@@ -1101,18 +1259,15 @@ uint32_t Lexer::parseEscape(char enclosing)
 
 char Lexer::getc_byte()
 {
-    int rv = m_istream.get();
-    if( rv == EOF )
+    if( m_pos == m_buffer.size() )
         throw Lexer::EndOfFile();
+    char rv = m_buffer[m_pos++];
 
     if( rv == '\r' )
     {
-        if( m_istream.get() != '\n' )
-        {
-            m_istream.unget();
-        }
-        else
+        if( m_pos < m_buffer.size() && m_buffer[m_pos] == '\n' )
         {
+            m_pos ++;
             rv = '\n';
         }
     }
@@ -1217,6 +1372,17 @@ void Lexer::ungetc()
     assert(!m_last_char_valid);
     m_last_char_valid = true;
 }
+/// Fast path: Append the following run of ASCII characters (excluding newlines and the stop characters) to `out`
+///
+/// Must only be called when there's no pending `ungetc`
+void Lexer::append_plain_ascii(::std::string& out, char stop1, char stop2)
+{
+    assert(!m_last_char_valid);
+    auto n = count_plain_ascii(m_buffer.data() + m_pos, m_buffer.data() + m_buffer.size(), stop1, stop2);
+    out.append(m_buffer.data() + m_pos, n);
+    m_pos += n;
+    m_line_ofs += n;
+}
 
 // --------------------------------------------------------------------
 // Codepoint - Unicode codepoint.
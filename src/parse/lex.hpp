@@ -39,8 +39,9 @@ class Lexer:
     unsigned int m_line;
     unsigned int m_line_ofs;
 
-    ::std::unique_ptr<::std::ifstream>  m_istream_fp;
-    ::std::istream& m_istream;
+    /// Entire contents of the source file
+    ::std::string   m_buffer;
+    size_t  m_pos;
     bool    m_last_char_valid;
     Codepoint   m_last_char;
     ::std::vector<Token>    m_next_tokens;
@@ -81,6 +82,7 @@ private:
     }
 
     void ungetc();
+    void append_plain_ascii(::std::string& out, char stop1, char stop2);
     Codepoint getc_num();
     Codepoint getc();
     Codepoint getc_cp();
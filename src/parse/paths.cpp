@@ -107,7 +107,7 @@ AST::Path Parse_Path(TokenStream& lex, bool is_abs, eParsePathGenericMode generi
             return AST::Path("", Parse_PathNodes(lex, generic_mode));
         }
         else if( GET_TOK(tok, lex) == TOK_STRING ) {
-            auto cratename = RcString::new_interned(tok.str());
+            auto cratename = RcString::new_interned(tok.str_owned());
             GET_CHECK_TOK(tok, lex, TOK_DOUBLE_COLON);
             return AST::Path(cratename, Parse_PathNodes(lex, generic_mode));
         }
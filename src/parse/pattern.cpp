@@ -262,9 +262,9 @@ AST::Pattern::Value Parse_PatternValue(TokenStream& lex)
     case TOK_RWORD_FALSE:
         return AST::Pattern::Value::make_Integer({CORETYPE_BOOL, U128(0)});
     case TOK_STRING:
-        return AST::Pattern::Value::make_String( mv$(tok.str()) );
+        return AST::Pattern::Value::make_String( tok.str_owned() );
     case TOK_BYTESTRING:
-        return AST::Pattern::Value::make_ByteString({ mv$(tok.str()) });
+        return AST::Pattern::Value::make_ByteString({ tok.str_owned() });
     case TOK_INTERPOLATED_EXPR: {
         auto e = tok.take_frag_node();
         // TODO: Visitor?
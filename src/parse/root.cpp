@@ -795,7 +795,7 @@ AST::Named<AST::Item> Parse_Trait_Item(TokenStream& lex)
         {
             abi = "C";
             if( GET_TOK(tok, lex) == TOK_STRING )
-                abi = tok.str();
+                abi = tok.str_owned();
             else
                 PUTBACK(tok, lex);
 
@@ -1278,7 +1278,7 @@ void Parse_Impl_Item(TokenStream& lex, AST::Impl& impl)
         {
             abi = "C";
             if( GET_TOK(tok, lex) == TOK_STRING )
-                abi = tok.str();
+                abi = tok.str_owned();
             else
                 PUTBACK(tok, lex);
 
@@ -1482,7 +1482,7 @@ void Parse_Use_Root(TokenStream& lex, ::std::vector<AST::UseItem::Ent>& entries)
         if( LOOK_AHEAD(lex) == TOK_STRING )
         {
             GET_CHECK_TOK(tok, lex, TOK_STRING);
-            path = ::AST::Path(RcString::new_interned(tok.str()), {});
+            path = ::AST::Path(RcString::new_interned(tok.str_owned()), {});
         }
         else if( lex.edition_after(AST::Edition::Rust2018) )
         {
@@ -1770,7 +1770,7 @@ namespace {
         // `extern "<ABI>" fn ...`
         // `extern "<ABI>" { ...`
         case TOK_STRING: {
-            ::std::string abi = tok.str();
+            ::std::string abi = tok.str_owned();
             switch(GET_TOK(tok, lex))
             {
             // `extern "<ABI>" fn ...`
@@ -1816,7 +1816,7 @@ namespace {
             // `extern crate "crate-name" as crate_name;`
             // NOTE: rustc doesn't allow this, keep in mrustc for for reparse support
             case TOK_STRING:
-                item_data = ::AST::Item::make_Crate({ RcString::new_interned(tok.str()) });
+                item_data = ::AST::Item::make_Crate({ RcString::new_interned(tok.str_owned()) });
                 GET_CHECK_TOK(tok, lex, TOK_RWORD_AS);
                 GET_CHECK_TOK(tok, lex, TOK_IDENT);
                 item_name = tok.ident().name;
@@ -1868,7 +1868,7 @@ namespace {
                     GET_TOK(tok, lex);
                     if( lex.lookahead(0) == TOK_STRING ) {
                         GET_TOK(tok, lex);
-                        return tok.str();
+                        return tok.str_owned();
                     }
                     else {
                         return "C";
@@ -1885,7 +1885,7 @@ namespace {
             item_data = ::AST::Item( Parse_FunctionDefWithCode(lex, abi, false,  true,true/*unsafe,const*/) );
             break; }
         case TOK_RWORD_EXTERN: {
-            auto abi = lex.lookahead(0) == TOK_STRING ? lex.getToken().str() : "C";
+            auto abi = lex.lookahead(0) == TOK_STRING ? lex.getToken().str_owned() : "C";
             GET_CHECK_TOK(tok, lex, TOK_RWORD_FN);
             GET_CHECK_TOK(tok, lex, TOK_IDENT);
             item_name = tok.ident().name;
@@ -1933,7 +1933,7 @@ namespace {
         case TOK_RWORD_EXTERN: {
             ::std::string   abi = "C";
             if(GET_TOK(tok, lex) == TOK_STRING) {
-                abi = mv$(tok.str());
+                abi = tok.str_owned();
             }
             else {
                 PUTBACK(tok, lex);
@@ -59,7 +59,7 @@ Token::Token(enum eTokenType type, Ident i):
 }
 Token::Token(enum eTokenType type, ::std::string str):
     m_type(type),
-    m_data(Data::make_String(mv$(str)))
+    m_data(Data::make_String(RcString(str)))
 {
 }
 Token::Token(U128 val, enum eCoreType datatype):
@@ -299,8 +299,8 @@ enum eTokenType Token::typefromstr(const ::std::string& s)
 }
 
 struct EscapedString {
-    const ::std::string& s;
-    EscapedString(const ::std::string& s): s(s) {}
+    const RcString& s;
+    EscapedString(const RcString& s): s(s) {}
 
     friend ::std::ostream& operator<<(::std::ostream& os, const EscapedString& x) {
         for(auto b : x.s) {
@@ -337,7 +337,7 @@ struct EscapedString {
 
     case TOK_NEWLINE:    return "\n";
     case TOK_WHITESPACE: return " ";
-    case TOK_COMMENT:    return "/*" + m_data.as_String() + "*/";
+    case TOK_COMMENT:    return FMT("/*" << m_data.as_String() << "*/");
     case TOK_INTERPOLATED_TYPE:
         reinterpret_cast<const ::TypeRef*>(m_data.as_Fragment())->print(ss, false);
         return ss.str();
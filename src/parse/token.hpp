@@ -67,7 +67,8 @@ class Token
     TAGGED_UNION(Data, None,
     (None, struct {}),
     (Ident, Ident),
-    (String, ::std::string),
+    // Reference counted, so cloning a token (e.g. during macro expansion) doesn't copy the text
+    (String, RcString),
     (Integer, struct {
         enum eCoreType  m_datatype;
         U128    m_intval;
@@ -127,8 +128,8 @@ public:
     bool has_data() const { return !m_data.is_None(); }
 
     const Ident& ident() const { return m_data.as_Ident(); }
-    ::std::string& str() { return m_data.as_String(); }
-    const ::std::string& str() const { return m_data.as_String(); }
+    const RcString& str() const { return m_data.as_String(); }
+    ::std::string str_owned() const { const auto& s = m_data.as_String(); return ::std::string(s.c_str(), s.size()); }
     enum eCoreType  datatype() const { TU_MATCH_DEF(Data, (m_data), (e), (assert(!"Getting datatype of invalid token type");), (Integer, return e.m_datatype;), (Float, return e.m_datatype;)) throw ""; }
     U128 intval() const { return m_data.as_Integer().m_intval; }
     double floatval() const { return m_data.as_Float().m_floatval; }
@@ -11,21 +11,31 @@
 
 TokenTree TokenTree::clone() const
 {
-    if( m_subtrees.size() == 0 ) {
+    if( !m_subtrees ) {
         return TokenTree(m_edition, m_hygiene, m_tok.clone());
     }
     else {
-        ::std::vector< TokenTree>   ents;
-        ents.reserve( m_subtrees.size() );
-        for(const auto& sub : m_subtrees)
+        // Sub-trees are immutable while shared, so just add another reference
+        TokenTree   rv(m_edition, m_hygiene, Token());
+        rv.m_subtrees = m_subtrees;
+        return rv;
+    }
+}
+void TokenTree::make_unique()
+{
+    if( m_subtrees && m_subtrees.use_count() > 1 )
+    {
+        ::std::vector<TokenTree>    ents;
+        ents.reserve( m_subtrees->size() );
+        for(const auto& sub : *m_subtrees)
             ents.push_back( sub.clone() );
-        return TokenTree(m_edition, m_hygiene, mv$(ents) );
+        m_subtrees = ::std::make_shared< ::std::vector<TokenTree> >( mv$(ents) );
     }
 }
 
 ::std::ostream& operator<<(::std::ostream& os, const TokenTree& tt)
 {
-    if( tt.m_subtrees.size() == 0 )
+    if( tt.size() == 0 )
     {
         switch(tt.m_tok.type())
         {
@@ -48,7 +58,7 @@ TokenTree TokenTree::clone() const
         os << "/*" << tt.m_edition << " " << tt.m_hygiene << " TT*/";
         // NOTE: All TTs (except the outer tt on a macro invocation) include the grouping
         bool first = true;
-        for(const auto& i : tt.m_subtrees) {
+        for(const auto& i : *tt.m_subtrees) {
             if(!first)
                 os << " ";
             os << i;
@@ -11,6 +11,7 @@
 #include "token.hpp"
 #include <ident.hpp>
 #include <vector>
+#include <memory>
 
 namespace  AST {
     enum class Edition;
@@ -21,7 +22,8 @@ class TokenTree
     AST::Edition    m_edition;
     Ident::Hygiene m_hygiene;
     Token   m_tok;
-    ::std::vector<TokenTree>    m_subtrees;
+    /// Child trees, shared between clones (copy-on-write, see `operator[]`)
+    ::std::shared_ptr< ::std::vector<TokenTree> >   m_subtrees;
 public:
     virtual ~TokenTree() {}
     TokenTree() {}
@@ -49,7 +51,7 @@ public:
     TokenTree(AST::Edition edition, Ident::Hygiene hygiene, ::std::vector<TokenTree> subtrees):
         m_edition(edition),
         m_hygiene( ::std::move(hygiene) ),
-        m_subtrees( ::std::move(subtrees) )
+        m_subtrees( ::std::make_shared< ::std::vector<TokenTree> >(::std::move(subtrees)) )
     {
     }
 
@@ -59,16 +61,19 @@ public:
         return m_tok.type() != TOK_NULL;
     }
     size_t size() const {
-        return m_subtrees.size();
+        return m_subtrees ? m_subtrees->size() : 0;
     }
-    const TokenTree& operator[](unsigned int idx) const { assert(idx < m_subtrees.size()); return m_subtrees[idx]; }
-          TokenTree& operator[](unsigned int idx)       { assert(idx < m_subtrees.size()); return m_subtrees[idx]; }
+    const TokenTree& operator[](unsigned int idx) const { assert(idx < size()); return (*m_subtrees)[idx]; }
+    // NOTE: Mutable access un-shares this level of the tree (children stay shared until accessed)
+          TokenTree& operator[](unsigned int idx)       { assert(idx < size()); make_unique(); return (*m_subtrees)[idx]; }
     const Token& tok() const { return m_tok; }
           Token& tok()       { return m_tok; }
     const Ident::Hygiene& hygiene() const { return m_hygiene; }
     const AST::Edition& get_edition() const { return m_edition; }
 
     friend ::std::ostream& operator<<(::std::ostream& os, const TokenTree& tt);
+private:
+    void make_unique();
 };
 
 #endif // TOKENTREE_HPP_INCLUDED
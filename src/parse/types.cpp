@@ -222,7 +222,7 @@ TypeRef Parse_Type_Fn(TokenStream& lex, ::AST::HigherRankedBounds hrbs)
     if( tok.type() == TOK_RWORD_EXTERN )
     {
         if( GET_TOK(tok, lex) == TOK_STRING ) {
-            abi = tok.str();
+            abi = tok.str_owned();
             if( abi == "" )
                 ERROR(lex.point_span(), E0000, "Empty ABI");
             GET_TOK(tok, lex);
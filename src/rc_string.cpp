@@ -6,18 +6,21 @@
  * - Reference-counted string
  */
 #include <rc_string.hpp>
+#include <memory_stats.hpp>
 #include <cstring>
 #include <string>
 #include <iostream>
 #include <algorithm>    // std::max
+#include <mutex>
 
 RcString::RcString(const char* s, size_t len):
     m_ptr(nullptr)
 {
     if( len > 0 )
     {
-        size_t nwords = (len+1 + sizeof(unsigned int)-1) / sizeof(unsigned int);
-        m_ptr = reinterpret_cast<Inner*>(malloc(sizeof(Inner) + (nwords - 1) * sizeof(unsigned int)));
+        m_ptr = reinterpret_cast<Inner*>(malloc(Inner::alloc_size(len)));
+        if( memory_stats::g_enabled )
+            memory_stats::on_alloc(memory_stats::Tag::RcString, Inner::alloc_size(len));
         m_ptr->refcount = 1;
         m_ptr->size = static_cast<unsigned>(len);
         m_ptr->ordering = 0;
@@ -33,10 +36,11 @@ RcString::~RcString()
 {
     if(m_ptr)
     {
-        m_ptr->refcount -= 1;
         //::std::cout << "RcString(" << m_ptr << " \"" << *this << "\") - " << *m_ptr << " refs left (drop)" << ::std::endl;
-        if( m_ptr->refcount == 0 )
+        if( (m_ptr->refcount -= 1) == 0 )
         {
+            if( memory_stats::g_enabled )
+                memory_stats::on_free(memory_stats::Tag::RcString, Inner::alloc_size(m_ptr->size));
             free(m_ptr);
         }
         m_ptr = nullptr;
@@ -90,33 +94,51 @@ struct Cmp_RcString_Raw {
 };
 // A set with a comparison function that always checks bytes (avoiding recursion with the cache)
 ::std::set<RcString,Cmp_RcString_Raw>    RcString_interned_strings;
-bool    RcString_interned_ordering_valid;
+// Protects the above set, and the re-population of the ordering cache
+::std::mutex    RcString_interned_lock;
+// Generation of the ordering cache, odd while the cache is invalid (i.e. a new string has been interned)
+// - Readers check that this hasn't changed while they read the ordering values (a sequence lock)
+::std::atomic<unsigned>  RcString_interned_generation;
 
 RcString RcString::new_interned(const char* s, size_t len)
 {
     if(len == 0)
         return RcString();
+    ::std::lock_guard<::std::mutex>  lh { RcString_interned_lock };
     auto ret = RcString_interned_strings.insert(RcString(s, len));
     // Set interned and invalidate the cache if an insert happened
     if(ret.second)
     {
         ret.first->m_ptr->ordering = 1;
-        RcString_interned_ordering_valid = false;
+        if( RcString_interned_generation % 2 == 0 )
+            RcString_interned_generation += 1;
     }
     return *ret.first;
 }
 Ordering RcString::ord_interned(const RcString& s) const
 {
     assert(s.is_interned() && this->is_interned());
-    if(!RcString_interned_ordering_valid)
+    for(;;)
     {
-        // Populate cache
-        unsigned i = 1;
-        for(auto& e : RcString_interned_strings)
-            e.m_ptr->ordering = i++;
-        RcString_interned_ordering_valid = true;
+        auto gen = RcString_interned_generation.load();
+        if( gen % 2 != 0 )
+        {
+            // Populate cache
+            ::std::lock_guard<::std::mutex>  lh { RcString_interned_lock };
+            if( RcString_interned_generation % 2 != 0 )
+            {
+                unsigned i = 1;
+                for(auto& e : RcString_interned_strings)
+                    e.m_ptr->ordering = i++;
+                RcString_interned_generation += 1;
+            }
+            continue ;
+        }
+        auto rv = ::ord(this->m_ptr->ordering.load(), s.m_ptr->ordering.load());
+        // If the cache was repopulated while reading, try again
+        if( RcString_interned_generation.load() == gen )
+            return rv;
     }
-    return ::ord(this->m_ptr->ordering, s.m_ptr->ordering);
 }
 
 size_t std::hash<RcString>::operator()(const RcString& s) const noexcept
@@ -7,41 +7,161 @@
  */
 #include <functional>
 #include <iostream>
+#include <mutex>
 #include <span.hpp>
 #include <parse/lex.hpp>
 #include <common.hpp>
 
 SpanInner Span::s_empty_span;
 
-Span::Span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
-    m_ptr(SpanInner::alloc( parent, ::std::move(filename), start_line, start_ofs, end_line, end_ofs ))
-{}
-Span::Span(Span parent, const Position& pos):
-    m_ptr(SpanInner::alloc( parent, pos.filename, pos.line,pos.ofs, pos.line,pos.ofs ))
-{
-}
-Span::Span(const Span& x):
-    m_ptr(x.m_ptr)
-{
-    m_ptr->reference_count += 1;
+namespace span_table {
+    ::std::atomic<SpanInner*>   g_chunks[MAX_CHUNKS];
 }
-Span::~Span()
-{
-    if(m_ptr && m_ptr != &s_empty_span)
+namespace {
+    // Zero is reserved for the empty span
+    ::std::atomic<uint32_t> s_next_span_id { 1 };
+    ::std::mutex    s_chunk_alloc_lock;
+
+    /// Creates a new span table entry (the caller must hold the lock of the shard it'll be added to)
+    uint32_t new_span_entry(const Span& parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs)
     {
-        m_ptr->reference_count --;
-        if( m_ptr->reference_count == 0 )
+        uint32_t id = s_next_span_id.fetch_add(1, ::std::memory_order_relaxed);
+        if( id == 0 || id == UINT32_MAX ) {
+            s_next_span_id.store(UINT32_MAX);
+            ERROR(parent, E0000, "Too many distinct source locations (the span table is limited to " << UINT32_MAX << " entries)");
+        }
+        auto& chunk_ptr = span_table::g_chunks[id >> span_table::CHUNK_BITS];
+        auto* chunk = chunk_ptr.load(::std::memory_order_acquire);
+        if( !chunk )
         {
-            delete m_ptr;
+            ::std::lock_guard<::std::mutex> lh { s_chunk_alloc_lock };
+            chunk = chunk_ptr.load(::std::memory_order_relaxed);
+            if( !chunk )
+            {
+                chunk = new SpanInner[span_table::CHUNK_SIZE];
+                chunk_ptr.store(chunk, ::std::memory_order_release);
+            }
         }
-        m_ptr = nullptr;
+        if( memory_stats::g_enabled )
+            memory_stats::on_alloc(memory_stats::Tag::Span, sizeof(SpanInner));
+
+        auto& ent = chunk[id & (span_table::CHUNK_SIZE - 1)];
+        ent.parent_span = parent;
+        ent.filename = ::std::move(filename);
+        ent.start_line = start_line;
+        ent.start_ofs = start_ofs;
+        ent.end_line = end_line;
+        ent.end_ofs = end_ofs;
+        return id;
     }
+
+    /// Interning of spans, so identical spans (e.g. from re-parsing the same tokens, or repeated macro expansions) share
+    /// an entry and the table only grows with the number of distinct source locations.
+    /// - Split into shards (by hash) to reduce contention, each an open-addressed table of span IDs
+    class SpanInterner
+    {
+        static const size_t NUM_SHARDS = 64;
+        struct Shard {
+            ::std::mutex    lock;
+            ::std::vector<uint32_t> slots;  // Zero for empty
+            size_t  count = 0;
+        };
+        Shard   m_shards[NUM_SHARDS];
+
+        static const SpanInner& entry(uint32_t id)
+        {
+            return span_table::g_chunks[id >> span_table::CHUNK_BITS].load(::std::memory_order_acquire)[id & (span_table::CHUNK_SIZE - 1)];
+        }
+        static bool is_match(uint32_t id, const Span& parent, const RcString& filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs)
+        {
+            const auto& e = entry(id);
+            return e.start_line == start_line && e.start_ofs == start_ofs && e.end_line == end_line && e.end_ofs == end_ofs
+                && e.parent_span == parent && e.filename == filename;
+        }
+        static size_t hash_of(const SpanInner& e) {
+            return hash_of(e.parent_span, e.filename, e.start_line, e.start_ofs, e.end_line, e.end_ofs);
+        }
+    public:
+        static size_t hash_of(const Span& parent, const RcString& filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs)
+        {
+            uint64_t    h = 0xcbf29ce484222325;
+            auto push = [&](uint64_t v) { h = (h ^ v) * 0x100000001b3; };
+            for(char c : filename)
+                push(static_cast<uint8_t>(c));
+            // NOTE: Entries never move, so the parent's address identifies it
+            push(reinterpret_cast<uintptr_t>(&*parent));
+            push(start_line);
+            push(start_ofs);
+            push(end_line);
+            push(end_ofs);
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+
+        uint32_t get(const Span& parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs)
+        {
+            auto hash = hash_of(parent, filename, start_line, start_ofs, end_line, end_ofs);
+            auto& shard = m_shards[hash % NUM_SHARDS];
+            hash /= NUM_SHARDS;
+            ::std::lock_guard<::std::mutex> lh { shard.lock };
+            if( shard.slots.empty() )
+                shard.slots.resize(256);
+            auto mask = shard.slots.size() - 1;
+            for(size_t i = hash & mask; ; i = (i + 1) & mask)
+            {
+                auto id = shard.slots[i];
+                if( id == 0 )
+                {
+                    id = new_span_entry(parent, ::std::move(filename), start_line, start_ofs, end_line, end_ofs);
+                    shard.slots[i] = id;
+                    shard.count ++;
+                    // Keep the load under 50%
+                    if( shard.count * 2 > shard.slots.size() )
+                        grow(shard);
+                    return id;
+                }
+                if( is_match(id, parent, filename, start_line, start_ofs, end_line, end_ofs) )
+                    return id;
+            }
+        }
+    private:
+        static void grow(Shard& shard)
+        {
+            ::std::vector<uint32_t> new_slots(shard.slots.size() * 2);
+            auto mask = new_slots.size() - 1;
+            for(auto id : shard.slots)
+            {
+                if( id == 0 )
+                    continue;
+                size_t i = (hash_of(entry(id)) / NUM_SHARDS) & mask;
+                while( new_slots[i] != 0 )
+                    i = (i + 1) & mask;
+                new_slots[i] = id;
+            }
+            shard.slots = ::std::move(new_slots);
+        }
+    } s_interner;
+
+    uint32_t alloc_span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs)
+    {
+        return s_interner.get(parent, ::std::move(filename), start_line, start_ofs, end_line, end_ofs);
+    }
+}
+
+Span::Span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
+    m_id(alloc_span( parent, ::std::move(filename), start_line, start_ofs, end_line, end_ofs ))
+{}
+Span::Span(Span parent, const Position& pos):
+    m_id(alloc_span( parent, pos.filename, pos.line,pos.ofs, pos.line,pos.ofs ))
+{
 }
 
 namespace {
+    /// Set by `Span::CaptureDiagnostics`
+    thread_local ::std::ostream*    tl_diagnostic_sink = nullptr;
+
     void print_span_message(const Span& sp, ::std::function<void(::std::ostream&)> tag, ::std::function<void(::std::ostream&)> msg)
     {
-        auto& sink = ::std::cerr;
+        auto& sink = tl_diagnostic_sink ? *tl_diagnostic_sink : ::std::cerr;
         sink << sp->filename << ":" << sp->start_line << ": ";
         tag(sink);
         sink << ":";
@@ -56,9 +176,21 @@ namespace {
         sink << ::std::flush;
     }
 }
+Span::CaptureDiagnostics::CaptureDiagnostics(::std::ostream& os):
+    m_saved(tl_diagnostic_sink)
+{
+    tl_diagnostic_sink = &os;
+}
+Span::CaptureDiagnostics::~CaptureDiagnostics()
+{
+    tl_diagnostic_sink = m_saved;
+}
+
 void Span::bug(::std::function<void(::std::ostream&)> msg) const
 {
     print_span_message(*this, [](auto& os){os << "BUG";}, msg);
+    if( tl_diagnostic_sink )
+        throw Span::Abort();
 #ifndef _WIN32
     abort();
 #else
@@ -68,6 +200,8 @@ void Span::bug(::std::function<void(::std::ostream&)> msg) const
 
 void Span::error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const {
     print_span_message(*this, [&](auto& os){os << "error:" << tag;}, msg);
+    if( tl_diagnostic_sink )
+        throw Span::Abort();
 #ifndef _WIN32
     abort();
 #else
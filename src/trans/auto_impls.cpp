@@ -196,9 +196,8 @@ void Trans_AutoImpl_Clone(State& state, ::HIR::TypeRef ty)
     impl.m_methods.insert(::std::make_pair( RcString::new_interned("clone"), ::HIR::TraitImpl::ImplEnt< ::HIR::Function> { false, ::std::move(fcn) } ));
 
     // Add impl to the crate
-    auto& list = state.crate.m_trait_impls[state.lang_Clone].get_list_for_type_mut(impl.m_type);
-    list.push_back( box$(impl) );
-    state.crate.m_all_trait_impls[state.lang_Clone].get_list_for_type_mut(list.back()->m_type).push_back( list.back().get() );
+    const auto& impl_ptr = state.crate.m_trait_impls[state.lang_Clone].push( box$(impl) );
+    state.crate.m_all_trait_impls[state.lang_Clone].push( impl_ptr.get() );
 }
 
 namespace {
@@ -304,9 +303,14 @@ void Trans_AutoImpls(::HIR::Crate& crate, TransList& trans_list)
             //DEBUG("add_function(" << p << ")");
             auto e = trans_list.add_function(::std::move(p));
 
-            const auto* impl_list = impl_list_it->second.get_list_for_type(ty);
-            ASSERT_BUG(Span(), impl_list, "No impl list of Clone for " << ty);
-            auto& impl = **::std::find_if( impl_list->begin(), impl_list->end(), [&](const auto& i){ return i->m_type == ty; });
+            const ::HIR::TraitImpl* impl_ptr = nullptr;
+            impl_list_it->second.iterate_for_type(ty, [](const ::HIR::TypeRef& t)->const ::HIR::TypeRef& { return t; }, [&](const ::std::unique_ptr<::HIR::TraitImpl>& i) {
+                if( i->m_type == ty )
+                    impl_ptr = i.get();
+                return impl_ptr != nullptr;
+                });
+            ASSERT_BUG(Span(), impl_ptr, "No impl of Clone for " << ty);
+            const auto& impl = *impl_ptr;
             assert( impl.m_methods.size() == 1 );
             e->ptr = &impl.m_methods.begin()->second.data;
         }
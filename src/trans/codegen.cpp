@@ -23,11 +23,11 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
     ::std::unique_ptr<CodeGenerator>    codegen;
     if( opt.mode == "monomir" )
     {
-        codegen = Trans_Codegen_GetGenerator_MonoMir(crate, outfile);
+        codegen = Trans_Codegen_GetGenerator_MonoMir(crate, outfile, opt);
     }
     else if( opt.mode == "c" )
     {
-        codegen = Trans_Codegen_GetGeneratorC(crate, outfile);
+        codegen = Trans_Codegen_GetGeneratorC(crate, outfile, opt);
     }
     else
     {
@@ -19,6 +19,7 @@
 #include "target.hpp"
 #include "allocator.hpp"
 #include <iomanip>
+#include <parallel.hpp>
 
 namespace {
     struct FmtShell
@@ -186,10 +187,24 @@ namespace {
         ::std::string   m_outfile_path;
         ::std::string   m_outfile_path_c;
 
-        ::std::ofstream m_of;
+        struct OutputFile
+        {
+            ::std::string   path;
+            ::std::filebuf  buf;
+        };
+        // When split into multiple units, types/prototypes/helpers go to a shared header and function bodies are
+        // distributed between the units using a hash of the symbol name (so the partitioning is stable between builds).
+        // Statics and the entrypoint shims always live in the first unit (`<outfile>.c`)
+        ::std::unique_ptr<OutputFile>   m_header_file;
+        ::std::vector< ::std::unique_ptr<OutputFile> >  m_unit_files;
+
+        // Output stream, redirected to whichever of the above files is currently being written
+        ::std::ostream  m_of;
         const ::MIR::TypeResolve* m_mir_res;
 
         Compiler    m_compiler = Compiler::Gcc;
+        // Hash of the crate name, appended to the symbol names of local-linkage items (see `emit_local_symbol_name`)
+        ::std::string   m_local_symbol_suffix;
         struct {
             bool emulated_i128 = false;
             bool disallow_empty_structs = false;
@@ -199,14 +214,22 @@ namespace {
         ::std::set< ::HIR::TypeRef> m_emitted_fn_types;
         ::std::set< const TypeRepr*>    m_embedded_tags;
     public:
-        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile):
+        CodeGenerator_C(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
             m_crate(crate),
             m_resolve(crate),
             m_outfile_path(outfile),
             m_outfile_path_c(outfile + ".c"),
-            m_of(m_outfile_path_c)
+            m_of(nullptr)
         {
-            ASSERT_BUG(Span(), m_of.is_open(), "Failed to open `" << m_outfile_path_c << "` for writing");
+            {
+                uint64_t    h = 0xcbf29ce484222325;
+                for(char c : ::std::string(m_crate.m_crate_name.c_str()))
+                {
+                    h ^= static_cast<uint8_t>(c);
+                    h *= 0x100000001b3;
+                }
+                m_local_symbol_suffix = FMT(::std::hex << h);
+            }
             m_options.emulated_i128 = Target_GetCurSpec().m_backend_c.m_emulated_i128;
             switch(Target_GetCurSpec().m_backend_c.m_codegen_mode)
             {
@@ -228,6 +251,39 @@ namespace {
                 break;
             }
 
+            unsigned codegen_units = opt.codegen_units;
+            if( codegen_units > 1 && m_compiler == Compiler::Msvc )
+            {
+                // Cross-unit generic instantiations rely on weak symbols, which MSVC doesn't have for functions
+                WARNING(Span(), W0000, "Multiple codegen units are not supported with MSVC, using a single unit");
+                codegen_units = 1;
+            }
+            for(unsigned i = 0; i < codegen_units; i ++)
+            {
+                m_unit_files.push_back( open_output(i == 0 ? m_outfile_path_c : FMT(m_outfile_path << "." << i << ".c")) );
+            }
+            if( this->is_split() )
+            {
+                m_header_file = open_output(m_outfile_path + ".h");
+                auto slash_pos = m_header_file->path.find_last_of("/\\");
+                auto header_name = (slash_pos == ::std::string::npos ? m_header_file->path : m_header_file->path.substr(slash_pos+1));
+                for(auto& f : m_unit_files)
+                {
+                    select_output(*f);
+                    m_of
+                        << "/*\n"
+                        << " * AUTOGENERATED by mrustc\n"
+                        << " */\n"
+                        << "#include \"" << header_name << "\"\n"
+                        ;
+                }
+                select_output(*m_header_file);
+            }
+            else
+            {
+                select_output(*m_unit_files[0]);
+            }
+
             m_of
                 << "/*\n"
                 << " * AUTOGENERATED by mrustc\n"
@@ -780,10 +836,159 @@ namespace {
 
         ~CodeGenerator_C() {}
 
+    private:
+        static ::std::unique_ptr<OutputFile> open_output(::std::string path)
+        {
+            auto rv = ::std::unique_ptr<OutputFile>(new OutputFile { ::std::move(path), {} });
+            rv->buf.open(rv->path, ::std::ios::out);
+            ASSERT_BUG(Span(), rv->buf.is_open(), "Failed to open `" << rv->path << "` for writing");
+            return rv;
+        }
+        void select_output(OutputFile& f)
+        {
+            if( m_of.rdbuf() )
+            {
+                ASSERT_BUG(Span(), !m_of.bad(), "Error set on output stream");
+            }
+            m_of.rdbuf(&f.buf);
+        }
+        void close_output(OutputFile& f)
+        {
+            bool ok = f.buf.close() != nullptr;
+            ASSERT_BUG(Span(), ok, "Error set on output stream for: " << f.path);
+        }
+        bool is_split() const
+        {
+            return m_unit_files.size() > 1;
+        }
+        /// Push the compiler and the options used to compile generated C (GCC-compatible compilers only)
+        /// - Returns the position of the first argument that can go in a command file
+        size_t push_gcc_compile_args(StringList& args, const TransOptions& opt) const
+        {
+#ifdef __CYGWIN__
+            bool is_cygwin = true;
+#else
+            bool is_cygwin = false;
+#endif
+            // Pick the compiler
+            // - from `CC_${TRIPLE}` environment variable, with all '-' in TRIPLE replaced by '_'
+            // - from the `CC` environment variable
+            // - `${TRIPLE}-gcc` (if available)
+            // - `gcc` as fallback
+            {
+                std::string varname = "CC_" +  Target_GetCurSpec().m_backend_c.m_c_compiler;
+                std::replace(varname.begin(), varname.end(), '-', '_');
+
+                if( getenv(varname.c_str()) ) {
+                    args.push_back( getenv(varname.c_str()) );
+                }
+                else if( getenv("CC") ) {
+                        args.push_back( getenv("CC") );
+                }
+                else if (system(("command -v " + Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" + " >/dev/null 2>&1").c_str()) == 0) {
+                    args.push_back( Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" );
+                }
+                else {
+                    args.push_back("gcc");
+                }
+            }
+            size_t arg_file_start = args.get_vec().size();
+            for( const auto& a : Target_GetCurSpec().m_backend_c.m_compiler_opts )
+            {
+                args.push_back( a.c_str() );
+            }
+            if (is_cygwin) {
+                args.push_back("-Os");
+            } else {
+            switch(opt.opt_level)
+            {
+            case 0: break;
+            case 1:
+                args.push_back("-O1");
+                break;
+            case 2:
+                args.push_back("-O2");
+                break;
+            }
+            }
+            if( opt.emit_debug_info )
+            {
+                args.push_back("-g");
+            }
+            args.push_back("-fPIC");
+            if (is_cygwin) {
+                args.push_back("-s");
+                args.push_back("-Wa,-mbig-obj");
+            }
+            return arg_file_start;
+        }
+        /// Select the shared header (or the only unit)
+        void select_header()
+        {
+            select_output(m_header_file ? *m_header_file : *m_unit_files[0]);
+        }
+        /// Select the unit that holds the body of the given function
+        void select_unit_for(const ::HIR::Path& p)
+        {
+            if( this->is_split() )
+            {
+                // FNV-1a of the symbol name, so a function stays in the same unit as long as its name doesn't change
+                uint64_t    h = 0xcbf29ce484222325;
+                for(char c : FMT(Trans_Mangle(p)))
+                {
+                    h ^= static_cast<uint8_t>(c);
+                    h *= 0x100000001b3;
+                }
+                select_output(*m_unit_files[h % m_unit_files.size()]);
+            }
+        }
+        /// Emit the linkage specifier for a function defined by this crate
+        /// - Shared generic instantiations (`-Z share-generics`) can be emitted by several crates, so are public weak symbols
+        void emit_function_linkage(const ::HIR::Path& p, bool is_extern_def)
+        {
+            if( m_crate.m_shared_generics.count(p) )
+            {
+                m_of << "__attribute__((weak)) ";
+            }
+            else if( is_extern_def )
+            {
+                emit_local_linkage();
+            }
+        }
+        /// Emit the assembler name of a symbol that uses `emit_local_linkage` (goes after the declarator of the prototype)
+        /// - When split, hidden visibility doesn't stop a static link merging the symbol with another crate's copy of the
+        ///   same instantiation (which may be from different code, e.g. another version of the generic), so the symbol
+        ///   name gets a suffix unique to this crate.
+        void emit_local_symbol_name(const ::HIR::Path& p)
+        {
+            if( this->is_split() )
+            {
+                // Split output is only supported with GCC (checked in the constructor)
+                m_of << " asm(\"" << (Target_GetCurSpec().m_os_name == "macos" ? "_" : "") << Trans_Mangle(p) << "_L" << m_local_symbol_suffix << "\")";
+            }
+        }
+        /// Emit the linkage specifier for symbols that are private to this crate's generated code
+        /// - With multiple units these need to be visible to other units, so use (hidden) weak symbols instead of `static`
+        void emit_local_linkage()
+        {
+            if( this->is_split() )
+            {
+                m_of << "__attribute__((weak,visibility(\"hidden\"))) ";
+            }
+            else
+            {
+                m_of << "static ";
+            }
+        }
+    public:
+
         void finalise(const TransOptions& opt, CodegenOutput out_ty, const ::std::string& hir_file) override
         {
             const bool create_shims = (out_ty == CodegenOutput::Executable);
 
+            // `main` and the shims go in the first unit
+            select_output(*m_unit_files[0]);
+
             // TODO: Support dynamic libraries too
             // - No main, but has the rest.
             // - Well... for cdylibs that's the case, for rdylibs it's not
@@ -948,9 +1153,15 @@ namespace {
                 }
             }
 
-            m_of.flush();
-            m_of.close();
-            ASSERT_BUG(Span(), !m_of.bad(), "Error set on output stream for: " << m_outfile_path_c);
+            ASSERT_BUG(Span(), !m_of.bad(), "Error set on output stream");
+            if( m_header_file )
+            {
+                close_output(*m_header_file);
+            }
+            for(auto& f : m_unit_files)
+            {
+                close_output(*f);
+            }
 
             class LinkList: private StringList
             {
@@ -1186,58 +1397,42 @@ namespace {
             bool is_cygwin = false;
 #endif
             size_t  arg_file_start = 0;
-            switch( m_compiler )
-            {
-            case Compiler::Gcc:
-                // Pick the compiler
-                // - from `CC_${TRIPLE}` environment variable, with all '-' in TRIPLE replaced by '_'
-                // - from the `CC` environment variable
-                // - `${TRIPLE}-gcc` (if available)
-                // - `gcc` as fallback
+            // Commands to compile each unit (only used when split into multiple units)
+            ::std::vector<StringList>   unit_commands;
+            // Inputs for the final compiler invocation: either the generated C, or the objects for each unit
+            auto push_inputs = [&](StringList& args) {
+                if( this->is_split() )
                 {
-                    std::string varname = "CC_" +  Target_GetCurSpec().m_backend_c.m_c_compiler;
-                    std::replace(varname.begin(), varname.end(), '-', '_');
-
-                    if( getenv(varname.c_str()) ) {
-                        args.push_back( getenv(varname.c_str()) );
-                    }
-                    else if( getenv("CC") ) {
-                            args.push_back( getenv("CC") );
-                    }
-                    else if (system(("command -v " + Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" + " >/dev/null 2>&1").c_str()) == 0) {
-                        args.push_back( Target_GetCurSpec().m_backend_c.m_c_compiler + "-gcc" );
-                    }
-                    else {
-                        args.push_back("gcc");
+                    for(const auto& f : m_unit_files)
+                    {
+                        args.push_back(f->path + ".o");
                     }
                 }
-                arg_file_start = args.get_vec().size();
-                for( const auto& a : Target_GetCurSpec().m_backend_c.m_compiler_opts )
-                {
-                    args.push_back( a.c_str() );
-                }
-                if (is_cygwin) {
-                    args.push_back("-Os");
-                } else {
-                switch(opt.opt_level)
+                else
                 {
-                case 0: break;
-                case 1:
-                    args.push_back("-O1");
-                    break;
-                case 2:
-                    args.push_back("-O2");
-                    break;
-                }
+                    args.push_back(m_outfile_path_c.c_str());
                 }
-                if( opt.emit_debug_info )
+                };
+            switch( m_compiler )
+            {
+            case Compiler::Gcc:
+                arg_file_start = push_gcc_compile_args(args, opt);
+                if( this->is_split() )
                 {
-                    args.push_back("-g");
-                }
-                args.push_back("-fPIC");
-                if (is_cygwin) {
-                    args.push_back("-s");
-                    args.push_back("-Wa,-mbig-obj");
+                    // Compile each unit to its own object, the command below then links/combines those objects
+                    for(const auto& f : m_unit_files)
+                    {
+                        unit_commands.push_back(StringList());
+                        auto& unit_args = unit_commands.back();
+                        for(const char* a : args)
+                        {
+                            unit_args.push_back(::std::string(a));
+                        }
+                        unit_args.push_back("-c");
+                        unit_args.push_back("-o");
+                        unit_args.push_back(f->path + ".o");
+                        unit_args.push_back(f->path.c_str());
+                    }
                 }
                 args.push_back("-o");
                 switch(out_ty)
@@ -1252,7 +1447,7 @@ namespace {
                     break;
                 }
                 if (!is_cygwin) {
-                args.push_back(m_outfile_path_c.c_str());
+                push_inputs(args);
                 }
                 switch(out_ty)
                 {
@@ -1302,11 +1497,20 @@ namespace {
                     break;
                 case CodegenOutput::StaticLibrary:
                 case CodegenOutput::Object:
-                    args.push_back("-c");
+                    if( this->is_split() )
+                    {
+                        // Combine the unit objects into a single relocatable object
+                        args.push_back("-r");
+                        args.push_back("-nostdlib");
+                    }
+                    else
+                    {
+                        args.push_back("-c");
+                    }
                     break;
                 }
                 if (is_cygwin) {
-                    args.push_back(m_outfile_path_c.c_str());
+                    push_inputs(args);
                 }
                 break;
             case Compiler::Msvc:
@@ -1400,50 +1604,43 @@ namespace {
                 break;
             }
 
-            ::std::stringstream cmd_ss;
-            if (is_windows)
-            {
-                cmd_ss << "echo \"\" & ";
-            }
-            std::string command_file = m_outfile_path + "_cmd.txt";
-            std::ofstream   command_file_stream;
-            bool use_arg_file = arg_file_start > 0;
-            if(use_arg_file) {
-                command_file_stream.open(command_file);
-                ASSERT_BUG(Span(), command_file_stream.is_open(), "Failed to open command file `" << command_file << "` for writing");
-            }
-            size_t i = -1;
-            for(const auto& arg : args.get_vec())
-            {
-                i ++;
-                auto& out_ss = (use_arg_file && i >= arg_file_start ? static_cast<::std::ostream&>(command_file_stream) : cmd_ss);
-                if(strcmp(arg, "&") == 0 && is_windows) {
-                    out_ss << "&";
+            auto format_command = [&](const StringList& args, const ::std::string& command_file)->::std::string {
+                ::std::stringstream cmd_ss;
+                if (is_windows)
+                {
+                    cmd_ss << "echo \"\" & ";
                 }
-                else {
-                    if( is_windows && strchr(arg, ' ') == nullptr ) {
-                        out_ss << arg << " ";
+                std::ofstream   command_file_stream;
+                bool use_arg_file = arg_file_start > 0;
+                if(use_arg_file) {
+                    command_file_stream.open(command_file);
+                    ASSERT_BUG(Span(), command_file_stream.is_open(), "Failed to open command file `" << command_file << "` for writing");
+                }
+                size_t i = -1;
+                for(const auto& arg : args.get_vec())
+                {
+                    i ++;
+                    auto& out_ss = (use_arg_file && i >= arg_file_start ? static_cast<::std::ostream&>(command_file_stream) : cmd_ss);
+                    if(strcmp(arg, "&") == 0 && is_windows) {
+                        out_ss << "&";
                     }
                     else {
-                        out_ss << "\"" << FmtShell(arg, is_windows) << "\" ";
+                        if( is_windows && strchr(arg, ' ') == nullptr ) {
+                            out_ss << arg << " ";
+                        }
+                        else {
+                            out_ss << "\"" << FmtShell(arg, is_windows) << "\" ";
+                        }
                     }
                 }
-            }
-            if(use_arg_file) {
-                cmd_ss << "@\"" << FmtShell(command_file, is_windows) << "\"";
-                command_file_stream.close();
-                ASSERT_BUG(Span(), !command_file_stream.bad(), "Error set on output stream for: " << m_outfile_path_c);
-            }
-            //DEBUG("- " << cmd_ss.str());
-            ::std::cout << "Running command - " << cmd_ss.str() << ::std::endl;
-            if( opt.build_command_file != "" )
-            {
-                ::std::cerr << "INVOKE CC: " << cmd_ss.str() << ::std::endl;
-                ::std::ofstream(opt.build_command_file) << cmd_ss.str() << ::std::endl;
-            }
-            else
-            {
-                int ec = system(cmd_ss.str().c_str());
+                if(use_arg_file) {
+                    cmd_ss << "@\"" << FmtShell(command_file, is_windows) << "\"";
+                    command_file_stream.close();
+                    ASSERT_BUG(Span(), !command_file_stream.bad(), "Error set on output stream for: " << command_file);
+                }
+                return cmd_ss.str();
+                };
+            auto check_exit_code = [](int ec) {
                 if( ec == -1 )
                 {
                     ::std::cerr << "C Compiler failed to execute (system returned -1)" << ::std::endl;
@@ -1455,6 +1652,42 @@ namespace {
                     ::std::cerr << "C Compiler failed to execute - error code " << ec << ::std::endl;
                     exit(1);
                 }
+                };
+
+            ::std::vector<::std::string>    unit_cmds;
+            for(size_t i = 0; i < unit_commands.size(); i ++)
+            {
+                unit_cmds.push_back( format_command(unit_commands[i], FMT(m_unit_files[i]->path << "_cmd.txt")) );
+            }
+            auto cmd = format_command(args, m_outfile_path + "_cmd.txt");
+            for(const auto& unit_cmd : unit_cmds)
+            {
+                ::std::cout << "Running command - " << unit_cmd << ::std::endl;
+            }
+            ::std::cout << "Running command - " << cmd << ::std::endl;
+            if( opt.build_command_file != "" )
+            {
+                ::std::ofstream build_command_stream(opt.build_command_file);
+                for(const auto& unit_cmd : unit_cmds)
+                {
+                    ::std::cerr << "INVOKE CC: " << unit_cmd << ::std::endl;
+                    build_command_stream << unit_cmd << ::std::endl;
+                }
+                ::std::cerr << "INVOKE CC: " << cmd << ::std::endl;
+                build_command_stream << cmd << ::std::endl;
+            }
+            else
+            {
+                // Compile the units (up to `-j` at once), then run the final link/combine
+                ::std::vector<int>  unit_exit_codes(unit_cmds.size());
+                parallel_for_each_index(opt.num_threads, unit_cmds.size(), [&](size_t i) {
+                    unit_exit_codes[i] = system(unit_cmds[i].c_str());
+                    });
+                for(int ec : unit_exit_codes)
+                {
+                    check_exit_code(ec);
+                }
+                check_exit_code( system(cmd.c_str()) );
             }
 
             // HACK! Static libraries aren't implemented properly yet, just touch the output file
@@ -2304,6 +2537,17 @@ namespace {
 
             TRACE_FUNCTION_F(p);
             auto type = params.monomorph(m_resolve, item.m_type);
+            if( this->is_split() )
+            {
+                // Declare in the shared header, and provide the (tentative) definition in the first unit
+                m_of << "extern ";
+                emit_static_ty(type, p, /*is_proto=*/true);
+                if( item.m_params.is_generic() ) {
+                    emit_local_symbol_name(p);
+                }
+                m_of << ";\n";
+                select_output(*m_unit_files[0]);
+            }
             switch(item.m_linkage.type)
             {
             case HIR::Linkage::Type::External:
@@ -2336,12 +2580,13 @@ namespace {
                 }
             }
             if( item.m_params.is_generic() ) {
-                m_of << "static ";
+                emit_local_linkage();
             }
-            emit_static_ty(type, p, /*is_proto=*/true);
+            emit_static_ty(type, p, /*is_proto=*/!this->is_split());
             m_of << ";";
             m_of << "\t// static " << p << " : " << type;
             m_of << "\n";
+            select_header();
 
             m_mir_res = nullptr;
         }
@@ -2356,8 +2601,9 @@ namespace {
             auto type = params.monomorph(m_resolve, item.m_type);
             // statics that are zero do not require initializers, since they will be initialized to zero on program startup.
             if( !is_zero_literal(type, encoded, params)) {
+                select_output(*m_unit_files[0]);
                 if( item.m_params.is_generic() ) {
-                    m_of << "static ";
+                    emit_local_linkage();
                 }
                 bool is_packed = emit_static_ty(type, p, /*is_proto=*/false);
                 m_of << " = ";
@@ -2420,6 +2666,7 @@ namespace {
                 m_of << ";";
                 m_of << "\t// static " << p << " : " << type << " = " << encoded;
                 m_of << "\n";
+                select_header();
             }
             //else {
             //    m_of << "//";
@@ -2654,10 +2901,7 @@ namespace {
                     m_of << "#define " << Trans_Mangle(p) << " " << item.m_linkage.name << "\n";
                 }
             }
-            if( is_extern_def )
-            {
-                m_of << "static ";
-            }
+            emit_function_linkage(p, is_extern_def);
             switch(item.m_linkage.type)
             {
             case HIR::Linkage::Type::External:
@@ -2677,6 +2921,9 @@ namespace {
                 break;
             }
             emit_function_header(p, item, params);
+            if( is_extern_def && !m_crate.m_shared_generics.count(p) ) {
+                emit_local_symbol_name(p);
+            }
             m_of << ";\n";
 
             m_mir_res = nullptr;
@@ -2695,10 +2942,9 @@ namespace {
             ::MIR::TypeResolve  mir_res { sp, m_resolve, FMT_CB(ss, ss << p;), ret_type, arg_types, *code };
             m_mir_res = &mir_res;
 
+            select_unit_for(p);
             m_of << "// " << p << "\n";
-            if( is_extern_def ) {
-                m_of << "static ";
-            }
+            emit_function_linkage(p, is_extern_def);
             emit_function_header(p, item, params);
             m_of << "\n";
             m_of << "{\n";
@@ -2985,6 +3231,7 @@ namespace {
             }
             m_of << "}\n";
             m_of.flush();
+            select_header();
             m_mir_res = nullptr;
         }
 
@@ -7474,7 +7721,7 @@ namespace {
     Span CodeGenerator_C::sp;
 }
 
-::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile)
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGeneratorC(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
 {
-    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile));
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_C(crate, outfile, opt));
 }
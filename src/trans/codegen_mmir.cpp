@@ -12,9 +12,11 @@
 #include <mir/helpers.hpp>
 #include "mangling.hpp"
 #include "target.hpp"
+#include <mmir_index.hpp>
 
 #include <iomanip>
 #include <fstream>
+#include <algorithm>
 
 namespace
 {
@@ -249,12 +251,22 @@ namespace
         ::std::ofstream m_of;
         const ::MIR::TypeResolve* m_mir_res;
 
+        // Function bodies written so far (for the `.mir.idx` index, only populated with `-C mmir-index`)
+        struct IndexEnt {
+            ::std::string   name;
+            uint64_t    body_ofs;
+            uint64_t    body_len;
+        };
+        bool    m_emit_index;
+        ::std::vector<IndexEnt> m_index;
+
     public:
-        CodeGenerator_MonoMir(const ::HIR::Crate& crate, const ::std::string& outfile):
+        CodeGenerator_MonoMir(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt):
             m_crate(crate),
             m_resolve(crate),
             m_outfile_path(outfile),
-            m_of(m_outfile_path + ".mir")
+            m_of(m_outfile_path + ".mir"),
+            m_emit_index(opt.mmir_index)
         {
             for( const auto& crate_name : m_crate.m_ext_crates_ordered )
             {
@@ -278,7 +290,7 @@ namespace
                 else
                 {
                     m_of << "\t0: {\n";
-                    m_of << "\t\tCALL RETURN = " << fmt(::HIR::GenericPath(c_start_path)) << "(arg0, arg1) goto 1 else 1;\n";
+                    m_of << "\t\tCALL RETURN = " << fmt(::HIR::GenericPath(c_start_path)) << "(arg0, arg1) goto 1 else 1\n";
                 }
                 m_of << "\t}\n";
                 m_of << "\t1: {\n";
@@ -303,8 +315,14 @@ namespace
             }
 
             m_of.flush();
+            uint64_t mir_size = m_of.tellp();
             m_of.close();
 
+            if( m_emit_index )
+            {
+                write_index(mir_size);
+            }
+
             // HACK! Create the output file, but keep it empty
             {
                 ::std::ofstream of( m_outfile_path );
@@ -780,7 +798,9 @@ namespace
             {
                 m_of << " = \"" << item.m_linkage.name << "\":\"" << item.m_abi << "\"";
             }
-            m_of << " {\n";
+            m_of << " ";
+            uint64_t body_ofs = m_of.tellp();
+            m_of << "{\n";
             // - Locals
             for(unsigned int i = 0; i < code->locals.size(); i ++) {
                 DEBUG("var" << i << " : " << code->locals[i]);
@@ -1107,12 +1127,57 @@ namespace
 
             m_of << "}\n";
 
+            if( m_emit_index )
+            {
+                uint64_t body_end = m_of.tellp();
+                m_index.push_back(IndexEnt { FMT(fmt(p)), body_ofs, body_end - body_ofs });
+            }
 
             m_mir_res = nullptr;
         }
 
 
     private:
+        /// Write the function index (see `mmir_index.hpp`) for the just-closed .mir file
+        void write_index(uint64_t mir_size)
+        {
+            ::std::sort(m_index.begin(), m_index.end(), [](const IndexEnt& a, const IndexEnt& b){ return a.name < b.name; });
+
+            ::std::vector<mmir_index::FunctionEnt>  ents;
+            ::std::string   strtab;
+            ents.reserve(m_index.size());
+            for(const auto& e : m_index)
+            {
+                mmir_index::FunctionEnt ent;
+                ent.name_ofs = static_cast<uint32_t>(strtab.size());
+                ent.name_len = static_cast<uint32_t>(e.name.size());
+                ent.body_ofs = e.body_ofs;
+                ent.body_len = e.body_len;
+                ents.push_back(ent);
+                strtab += e.name;
+            }
+
+            mmir_index::Header  hdr;
+            ::std::memcpy(hdr.magic, mmir_index::MAGIC, sizeof(hdr.magic));
+            hdr.mir_size = mir_size;
+            {
+                ::std::ifstream mir_if(m_outfile_path + ".mir", ::std::ios::binary);
+                hdr.mir_hash = mmir_index::hash_file(mir_if);
+            }
+            hdr.function_count = static_cast<uint32_t>(ents.size());
+            hdr.strtab_size = static_cast<uint32_t>(strtab.size());
+
+            ::std::ofstream of(m_outfile_path + ".mir.idx", ::std::ios::binary);
+            of.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+            of.write(reinterpret_cast<const char*>(ents.data()), ents.size() * sizeof(ents[0]));
+            of.write(strtab.data(), strtab.size());
+            if( !of.good() )
+            {
+                ::std::cerr << "Error writing " << m_outfile_path << ".mir.idx" << ::std::endl;
+                exit(1);
+            }
+        }
+
         const ::HIR::TypeRef& monomorphise_fcn_return(::HIR::TypeRef& tmp, const ::HIR::Function& item, const Trans_Params& params)
         {
             bool has_erased = visit_ty_with(item.m_return, [&](const auto& x) { return x.data().is_ErasedType(); });
@@ -1149,7 +1214,7 @@ namespace
     Span CodeGenerator_MonoMir::sp;
 }
 
-::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGenerator_MonoMir(const ::HIR::Crate& crate, const ::std::string& outfile)
+::std::unique_ptr<CodeGenerator> Trans_Codegen_GetGenerator_MonoMir(const ::HIR::Crate& crate, const ::std::string& outfile, const TransOptions& opt)
 {
-    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_MonoMir(crate, outfile));
+    return ::std::unique_ptr<CodeGenerator>(new CodeGenerator_MonoMir(crate, outfile, opt));
 }
@@ -30,19 +30,52 @@ namespace {
         ::std::deque<TransList_Function*>  fcn_queue;
         ::std::vector<TransList_Function*> fcns_to_type_visit;
 
+        /// Instantiations emitted by loaded crates (see `-Z share-generics`)
+        ::std::vector<const ::std::set<::HIR::Path>*>  shared_generics;
+
         EnumState(const ::HIR::Crate& crate):
             crate(crate)
             , resolve(crate)
-        {}
+        {
+            for(const auto& ec : crate.m_ext_crates)
+            {
+                if( !ec.second.m_data->m_shared_generics.empty() )
+                {
+                    shared_generics.push_back(&ec.second.m_data->m_shared_generics);
+                }
+            }
+        }
+
+        bool is_shared_generic(const ::HIR::Path& p) const
+        {
+            for(const auto* s : shared_generics)
+            {
+                if( s->count(p) )
+                    return true;
+            }
+            return false;
+        }
 
         void enum_fcn(::HIR::Path p, const ::HIR::Function& fcn, Trans_Params pp)
         {
+            // Only functions from other crates (no HIR) can have been instantiated by a loaded crate
+            bool use_shared = !fcn.m_code && !shared_generics.empty() && is_shared_generic(p);
             if(auto* e = rv.add_function(mv$(p)))
             {
                 fcns_to_type_visit.push_back(e);
                 e->ptr = &fcn;
                 e->pp = mv$(pp);
-                fcn_queue.push_back(e);
+                if( use_shared )
+                {
+                    // Link against the upstream copy, no need to enumerate the body
+                    DEBUG("Shared instantiation " << *e->path);
+                    e->force_prototype = true;
+                    e->use_shared = true;
+                }
+                else
+                {
+                    fcn_queue.push_back(e);
+                }
             }
         }
     };
@@ -450,6 +483,32 @@ void Trans_Enumerate_Cleanup(const ::HIR::Crate& crate, TransList& list)
 #endif
 }
 
+void Trans_Enumerate_SharedGenerics(::HIR::Crate& crate, const TransList& list)
+{
+    // Shared instantiations are emitted as weak symbols (other crates may emit the same one), which MSVC doesn't have for functions
+    if( Target_GetCurSpec().m_backend_c.m_codegen_mode == CodegenMode::Msvc )
+    {
+        WARNING(Span(), W0000, "Shared generics are not supported with MSVC");
+        return ;
+    }
+    for(const auto& ent : list.m_functions)
+    {
+        const auto& fcn_ent = *ent.second;
+        // Only functions monomorphised (and emitted) by this crate
+        if( !fcn_ent.monomorphised.code || fcn_ent.force_prototype )
+            continue ;
+        // Functions implementing an external ABI keep their own linkage
+        if( fcn_ent.ptr->m_linkage.name != "" )
+            continue ;
+        // Leave small bodies (that the inliner would accept) for downstream crates to instantiate, so they can still be inlined
+        if( fcn_ent.monomorphised.code->blocks.size() <= 3 )
+            continue ;
+        DEBUG("Shared " << ent.first);
+        crate.m_shared_generics.insert( ent.first.clone() );
+    }
+    DEBUG(crate.m_shared_generics.size() << " shared instantiations");
+}
+
 /// Common post-processing
 void Trans_Enumerate_CommonPost_Run(EnumState& state)
 {
@@ -735,7 +794,7 @@ namespace
             DEBUG("Add type " << ty << (shallow ? " (Shallow)": "") << " " << i);
         }
 
-        void __attribute__ ((noinline)) visit_function(const ::HIR::Path& path, const ::HIR::Function& fcn, const Trans_Params& pp)
+        void __attribute__ ((noinline)) visit_function(const ::HIR::Path& path, const ::HIR::Function& fcn, const Trans_Params& pp, bool signature_only)
         {
             Span    sp;
             auto& tv = *this;
@@ -776,7 +835,7 @@ namespace
             for(const auto& arg : fcn.m_args)
                 tv.visit_type( monomorph(arg.second) );
 
-            if( fcn.m_code.m_mir )
+            if( fcn.m_code.m_mir && !signature_only )
             {
                 const auto& mir = *fcn.m_code.m_mir;
                 for(const auto& ty : mir.locals)
@@ -929,7 +988,7 @@ void Trans_Enumerate_Types(EnumState& state)
             const auto& pp = p->pp;
 
             TRACE_FUNCTION_F("Function " << fcn_path);
-            tv.visit_function(fcn_path, fcn, pp);
+            tv.visit_function(fcn_path, fcn, pp, /*signature_only=*/p->use_shared);
         }
         state.fcns_to_type_visit.clear();
         // TODO: Similarly restrict revisiting of statics.
@@ -19,6 +19,12 @@ struct TransOptions
     unsigned int opt_level = 0;
     bool emit_debug_info = false;
     ::std::string   build_command_file;
+    /// Number of C files to split the generated code across (compiled in parallel)
+    unsigned int codegen_units = 1;
+    /// Maximum number of units compiled at once (from `-j`)
+    unsigned int num_threads = 1;
+    /// (MMIR backend) Also write a binary function index (`.mir.idx`) for fast loading by standalone_miri
+    bool mmir_index = false;
 
     ::std::string   panic_crate;
 
@@ -39,9 +45,11 @@ extern TransList Trans_Enumerate_Public(::HIR::Crate& crate);
 
 /// Re-run enumeration on monomorphised functions, removing now-unused items
 extern void Trans_Enumerate_Cleanup(const ::HIR::Crate& crate, TransList& list);
+/// Record the generic instantiations that this crate's codegen will emit for use by downstream crates
+extern void Trans_Enumerate_SharedGenerics(::HIR::Crate& crate, const TransList& list);
 
 extern void Trans_AutoImpls(::HIR::Crate& crate, TransList& trans_list);
 
-extern void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list);
+extern void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list, unsigned num_threads);
 
 extern void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, const ::std::string& hir_file);
@@ -11,6 +11,7 @@
 #include <hir/hir.hpp>
 #include <mir/operations.hpp>   // Needed for post-monomorph checks and optimisations
 #include <hir_conv/constant_evaluation.hpp>
+#include <parallel.hpp>
 
 namespace {
     ::MIR::LValue monomorph_LValue(const ::StaticTraitResolve& resolve, const Trans_Params& params, const ::MIR::LValue& tpl)
@@ -398,7 +399,7 @@ namespace {
 }
 
 /// Monomorphise all functions in a TransList
-void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list)
+void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list, unsigned num_threads)
 {
     ::StaticTraitResolve    resolve { crate };
 
@@ -478,48 +479,68 @@ void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list)
         }
     }
 
+    // Functions: Each is monomorphised from the (read-only) generic MIR into its own entry, so they can be done in any
+    // order (and in parallel).
+    ::std::vector<::std::pair<const ::HIR::Path*, TransList_Function*>>   fcns;
     for(auto& fcn_ent : list.m_functions)
     {
         const auto& fcn = *fcn_ent.second->ptr;
         // Trait methods (which are the only case where `Self` can exist in the argument list at this stage) always need to be monomorphised.
         bool is_method = ( fcn.m_args.size() > 0 && visit_ty_with(fcn.m_args[0].second, [&](const auto& x){return x == ::HIR::TypeRef("Self",0xFFFF);}) );
-        if(fcn_ent.second->pp.has_types() || is_method)
+        if( fcn_ent.second->use_shared )
         {
-            const auto& path = fcn_ent.first;
-            const auto& pp = fcn_ent.second->pp;
-            TRACE_FUNCTION_FR("FUNCTION " << path, "FUNCTION " << path);
-            ASSERT_BUG(Span(), fcn.m_code.m_mir, "No code for " << path);
-
-            // TODO: Get the item params too
-            if( fcn_ent.second->pp.pp_impl.has_params() ) {
-                assert(pp.gdef_impl);
-            }
-            resolve.set_both_generics_raw(pp.gdef_impl, &fcn.m_params);
-
-            auto mir = Trans_Monomorphise(resolve, fcn_ent.second->pp, fcn.m_code.m_mir);
-
-            // TODO: Should these be moved to their own pass? Potentially not, the extra pass should just be an inlining optimise pass
-            auto ret_type = pp.monomorph(resolve, fcn.m_return);
-            ::HIR::Function::args_t args;
-            for(const auto& a : fcn.m_args)
-                args.push_back(::std::make_pair( ::HIR::Pattern{}, pp.monomorph(resolve, a.second) ));
-
-            //::std::string s = FMT(path);
-            ::HIR::ItemPath ip(path);
-            MIR_Validate(resolve, ip, *mir, args, ret_type);
-            MIR_Cleanup(resolve, ip, *mir, args, ret_type);
-            MIR_Optimise(resolve, ip, *mir, args, ret_type, /*do_inline*/false);
-            MIR_Validate(resolve, ip, *mir, args, ret_type);
-
-            fcn_ent.second->monomorphised.ret_ty = ::std::move(ret_type);
-            fcn_ent.second->monomorphised.arg_tys = ::std::move(args);
-            fcn_ent.second->monomorphised.code = ::std::move(mir);
-            resolve.clear_both_generics();
+            DEBUG("Shared: FUNCTION " << fcn_ent.first);
+        }
+        else if(fcn_ent.second->pp.has_types() || is_method)
+        {
+            fcns.push_back(::std::make_pair( &fcn_ent.first, &*fcn_ent.second ));
         }
         else
         {
             DEBUG("Non-generic: FUNCTION " << fcn_ent.first);
         }
     }
+
+    // Debug output is only readable when run serially
+    if( debug_enabled() )
+    {
+        num_threads = 1;
+    }
+    DEBUG(fcns.size() << " functions across " << num_threads << " threads");
+    parallel_for_each_index(num_threads, fcns.size(), [&](size_t idx) {
+        const auto& path = *fcns[idx].first;
+        auto& fcn_ent = *fcns[idx].second;
+        const auto& fcn = *fcn_ent.ptr;
+        const auto& pp = fcn_ent.pp;
+        TRACE_FUNCTION_FR("FUNCTION " << path, "FUNCTION " << path);
+        ASSERT_BUG(Span(), fcn.m_code.m_mir, "No code for " << path);
+
+        // TODO: Get the item params too
+        if( pp.pp_impl.has_params() ) {
+            assert(pp.gdef_impl);
+        }
+        // NOTE: `StaticTraitResolve` has internal caches, so each job needs its own
+        ::StaticTraitResolve    resolve { crate };
+        resolve.set_both_generics_raw(pp.gdef_impl, &fcn.m_params);
+
+        auto mir = Trans_Monomorphise(resolve, pp, fcn.m_code.m_mir);
+
+        // TODO: Should these be moved to their own pass? Potentially not, the extra pass should just be an inlining optimise pass
+        auto ret_type = pp.monomorph(resolve, fcn.m_return);
+        ::HIR::Function::args_t args;
+        for(const auto& a : fcn.m_args)
+            args.push_back(::std::make_pair( ::HIR::Pattern{}, pp.monomorph(resolve, a.second) ));
+
+        //::std::string s = FMT(path);
+        ::HIR::ItemPath ip(path);
+        MIR_Validate(resolve, ip, *mir, args, ret_type);
+        MIR_Cleanup(resolve, ip, *mir, args, ret_type);
+        MIR_Optimise(resolve, ip, *mir, args, ret_type, /*do_inline*/false);
+        MIR_Validate(resolve, ip, *mir, args, ret_type);
+
+        fcn_ent.monomorphised.ret_ty = ::std::move(ret_type);
+        fcn_ent.monomorphised.arg_tys = ::std::move(args);
+        fcn_ent.monomorphised.code = ::std::move(mir);
+        });
 }
 
@@ -10,11 +10,14 @@
 #include "../expand/cfg.hpp"
 #include <fstream>
 #include <map>
+#include <unordered_map>
+#include <mutex>
 #include <hir/hir.hpp>
 #include <hir_typeck/helpers.hpp>
 #include <hir_conv/main_bindings.hpp>   // ConvertHIR_ConstantEvaluate_Enum
 #include <climits>  // UINT_MAX
 #include <toml.h>   // tools/common
+#include <debug_inner.hpp>  // DebugCounter
 
 const TargetArch ARCH_X86_64 = {
     "x86_64",
@@ -2054,25 +2057,41 @@ namespace {
         return rv;
     }
 
-    // TODO: Thread safety on this cache?
-    static ::std::map<::HIR::TypeRef, ::std::unique_ptr<TypeRepr>>  s_cache;
+    static ::std::unordered_map<::HIR::TypeRef, ::std::unique_ptr<TypeRepr>>  s_cache;
+    DebugCounter    s_cache_hit("Target_GetTypeRepr cache hit");
+    DebugCounter    s_cache_miss("Target_GetTypeRepr cache miss");
+    // NOTE: Only held for lookups and insertions, reprs are computed without it (so workers don't serialise on it)
+    static ::std::mutex s_cache_lock;
 
     void set_type_repr(const Span& sp, const ::HIR::TypeRef& ty, ::std::unique_ptr<TypeRepr> repr)
     {
-        auto ires = s_cache.insert(::std::make_pair( ty.clone(), mv$(repr) ));
-        ASSERT_BUG(sp, ires.second, "set_type_repr called for type that already has a repr: " << ty);
-        DEBUG("Set repr for " << ires.first->first);
+        ::std::lock_guard<::std::mutex> lh { s_cache_lock };
+        auto ires = s_cache.insert(::std::make_pair( ty.intern(), mv$(repr) ));
+        // Another thread may have computed the same (enum) repr concurrently, keep the first
+        if( ires.second )
+        {
+            DEBUG("Set repr for " << ires.first->first);
+        }
     }
 }
 const TypeRepr* Target_GetTypeRepr(const Span& sp, const StaticTraitResolve& resolve, const ::HIR::TypeRef& ty)
 {
-    auto it = s_cache.find(ty);
-    if( it != s_cache.end() )
     {
-        return it->second.get();
+        ::std::lock_guard<::std::mutex> lh { s_cache_lock };
+        auto it = s_cache.find(ty);
+        if( it != s_cache.end() )
+        {
+            s_cache_hit.inc();
+            return it->second.get();
+        }
     }
+    s_cache_miss.inc();
+
+    auto repr = make_type_repr(sp, resolve, ty);
 
-    auto ires = s_cache.insert(::std::make_pair( ty.clone(), make_type_repr(sp, resolve, ty) ));
+    // Re-check on insert, another thread may have created it in the meantime (in which case theirs is used)
+    ::std::lock_guard<::std::mutex> lh { s_cache_lock };
+    auto ires = s_cache.insert(::std::make_pair( ty.intern(), mv$(repr) ));
     if(ires.second)
     {
         DEBUG("Created repr for " << ires.first->first);
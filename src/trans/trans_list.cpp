@@ -101,5 +101,5 @@ TransList_Const* TransList::add_const(::HIR::Path p)
 
 ::HIR::TypeRef Trans_Params::monomorph(const ::StaticTraitResolve& resolve, const ::HIR::TypeRef& ty) const
 {
-    return resolve.monomorph_expand(sp, ty, *this);
+    return resolve.monomorph_expand(sp, ty, *this).intern();
 }
@@ -84,11 +84,15 @@ struct TransList_Function
     CachedFunction  monomorphised;
     /// Forces the function to not be emited as code (just emit the signature)
     bool    force_prototype;
+    /// The code is provided by an upstream crate's shared instantiation (see `-Z share-generics`)
+    /// - Implies `force_prototype`, and the function is not monomorphised (so can't be inlined)
+    bool    use_shared;
 
     TransList_Function(const ::HIR::Path& path):
         path(&path),
         ptr(nullptr),
-        force_prototype(false)
+        force_prototype(false),
+        use_shared(false)
     {}
 };
 struct TransList_Static
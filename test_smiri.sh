@@ -8,3 +8,18 @@ echo "--- mrustc -o output-mmir/hello"
 ./bin/mrustc rustc-1.19.0-src/src/test/run-pass/hello.rs -O -C codegen-type=monomir -o output-mmir/hello -L output-mmir/ > output-mmir/hello_dbg.txt || exit 1
 echo "--- standalone_miri output-mmir/hello.mir"
 ./bin/standalone_miri output-mmir/hello.mir --logfile smiri_hello.log
+echo "--- mrustc -o output-mmir/libnocore_shim.rlib"
+./bin/mrustc samples/smiri/nocore_shim.rs -O --crate-type rlib -C codegen-type=monomir -o output-mmir/libnocore_shim.rlib > output-mmir/nocore_shim_dbg.txt || exit 1
+echo "--- mrustc -o output-mmir/pointer_chase"
+./bin/mrustc samples/smiri/pointer_chase.rs -O -C codegen-type=monomir -o output-mmir/pointer_chase -L output-mmir/ > output-mmir/pointer_chase_dbg.txt || exit 1
+echo "--- standalone_miri output-mmir/pointer_chase.mir"
+# NOTE: The `#[start]` return value isn't used as the exit code, so check the printed one
+./bin/standalone_miri output-mmir/pointer_chase.mir --stats | grep "Return code: 00 00 00 00 00 00 00 00"
+echo "--- mrustc -o output-mmir/interp_bench"
+./bin/mrustc samples/smiri/interp_bench.rs -O -C codegen-type=monomir -o output-mmir/interp_bench -L output-mmir/ > output-mmir/interp_bench_dbg.txt || exit 1
+echo "--- standalone_miri output-mmir/interp_bench.mir"
+./bin/standalone_miri output-mmir/interp_bench.mir --stats | grep "Return code: 00 00 00 00 00 00 00 00"
+echo "--- mrustc -o output-mmir/threads"
+./bin/mrustc samples/smiri/threads.rs -O -C codegen-type=monomir -o output-mmir/threads -L output-mmir/ > output-mmir/threads_dbg.txt || exit 1
+echo "--- standalone_miri output-mmir/threads.mir"
+./bin/standalone_miri output-mmir/threads.mir | grep "Return code: 00 00 00 00 00 00 00 00"
@@ -0,0 +1,173 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * tools/impl_bench/main.cpp
+ * - Trait impl lookup benchmark
+ *
+ * Runs a fixed set of queries (primitives, references, slices, pointers, ...) against every trait with impls in the
+ * given crates, both with and without the type index on `ImplGroup::non_named`.
+ *
+ * Usage:
+ *   impl_bench [-n <iterations>] output/libcore.rlib output/liballoc.rlib output/libstd.rlib
+ */
+#include <hir/hir.hpp>
+#include <hir/main_bindings.hpp>
+#include <target_version.hpp>
+#include <debug_inner.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+TargetVersion gTargetVersion;
+
+struct Args
+{
+    Args(int argc, const char* const argv[]);
+
+    unsigned    iterations = 5;
+    ::std::vector<::std::string>    files;
+};
+
+namespace {
+    ::std::vector<::HIR::TypeRef> make_queries()
+    {
+        using ::HIR::CoreType;
+        using ::HIR::BorrowType;
+        using ::HIR::TypeRef;
+        ::std::vector<TypeRef>  rv;
+        for(auto ct : { CoreType::Usize, CoreType::Isize, CoreType::U8, CoreType::I8, CoreType::U16, CoreType::I16,
+                CoreType::U32, CoreType::I32, CoreType::U64, CoreType::I64, CoreType::U128, CoreType::I128,
+                CoreType::F32, CoreType::F64, CoreType::Bool, CoreType::Char })
+        {
+            rv.push_back(TypeRef(ct));
+            rv.push_back(TypeRef::new_borrow(BorrowType::Shared, TypeRef(ct)));
+            rv.push_back(TypeRef::new_slice(TypeRef(ct)));
+            rv.push_back(TypeRef::new_array(TypeRef(ct), 4));
+        }
+        rv.push_back(TypeRef::new_borrow(BorrowType::Shared, TypeRef(CoreType::Str)));
+        rv.push_back(TypeRef::new_borrow(BorrowType::Unique, TypeRef(CoreType::Str)));
+        rv.push_back(TypeRef::new_borrow(BorrowType::Shared, TypeRef::new_slice(TypeRef(CoreType::U8))));
+        rv.push_back(TypeRef::new_borrow(BorrowType::Unique, TypeRef::new_slice(TypeRef(CoreType::U8))));
+        rv.push_back(TypeRef::new_borrow(BorrowType::Shared, TypeRef::new_borrow(BorrowType::Shared, TypeRef(CoreType::Str))));
+        rv.push_back(TypeRef::new_pointer(BorrowType::Shared, TypeRef(CoreType::U8)));
+        rv.push_back(TypeRef::new_pointer(BorrowType::Unique, TypeRef(CoreType::U8)));
+        rv.push_back(TypeRef::new_unit());
+        rv.push_back(TypeRef::new_tuple(make_vec2(TypeRef(CoreType::U32), TypeRef(CoreType::U32))));
+        rv.push_back(TypeRef::new_infer(0, ::HIR::InferClass::Integer));
+        return rv;
+    }
+
+    struct Result {
+        size_t  queries = 0;
+        size_t  candidates = 0;
+        size_t  matches = 0;
+    };
+    Result run_queries(const ::std::vector<::HIR::CratePtr>& crates, const ::std::vector<::HIR::TypeRef>& queries)
+    {
+        auto ty_res = [](const ::HIR::TypeRef& t)->const ::HIR::TypeRef& { return t; };
+        Result  rv;
+        for(const auto& crate : crates)
+        {
+            for(const auto& ig : crate->m_trait_impls)
+            {
+                for(const auto& ty : queries)
+                {
+                    rv.queries ++;
+                    ig.second.iterate_for_type(ty, ty_res, [&](const ::std::unique_ptr<::HIR::TraitImpl>& impl) {
+                        rv.candidates ++;
+                        if( impl->matches_type(ty, ty_res) )
+                            rv.matches ++;
+                        return false;
+                        });
+                }
+            }
+        }
+        return rv;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    debug_init_phases("IMPLBENCH_DEBUG", {
+        "Load",
+        "Query",
+        });
+
+    Args    args(argc, argv);
+
+    ::std::vector<::HIR::CratePtr>  crates;
+    {
+        auto ph = DebugTimedPhase("Load");
+        for(const auto& f : args.files)
+        {
+            crates.push_back(HIR_Deserialise(f));
+        }
+    }
+    size_t  n_non_named = 0;
+    for(const auto& crate : crates)
+        for(const auto& ig : crate->m_trait_impls)
+            n_non_named += ig.second.non_named.size();
+    ::std::cout << crates.size() << " crates, " << n_non_named << " trait impls on un-named types" << ::std::endl;
+
+    auto queries = make_queries();
+    auto ph = DebugTimedPhase("Query");
+    Result  results[2];
+    double  best_s[2] = { 0, 0 };
+    for(int indexed = 0; indexed < 2; indexed ++)
+    {
+        ::HIR::ImplTypeIndex::set_enabled(indexed != 0);
+        for(unsigned i = 0; i < args.iterations; i ++)
+        {
+            auto start = ::std::chrono::steady_clock::now();
+            results[indexed] = run_queries(crates, queries);
+            double  dur = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - start).count();
+            if( i == 0 || dur < best_s[indexed] )
+                best_s[indexed] = dur;
+        }
+        ::std::cout
+            << (indexed ? "Indexed" : "Linear ") << ": "
+            << results[indexed].queries << " queries, "
+            << results[indexed].candidates << " candidates, "
+            << results[indexed].matches << " matches - best "
+            << static_cast<uint64_t>(best_s[indexed] * 1e6) << "us" << ::std::endl;
+    }
+    if( results[0].matches != results[1].matches )
+    {
+        ::std::cerr << "Match count differs with the index enabled" << ::std::endl;
+        return 1;
+    }
+    ::std::cout << "Speedup: " << (best_s[0] / best_s[1]) << "x" << ::std::endl;
+    return 0;
+}
+
+Args::Args(int argc, const char* const argv[])
+{
+    for(int i = 1; i < argc; i ++)
+    {
+        const char* arg = argv[i];
+        if( arg[0] != '-' )
+        {
+            this->files.push_back(arg);
+        }
+        else if( ::std::strcmp(arg, "-n") == 0 && i+1 < argc )
+        {
+            this->iterations = ::std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            ::std::cerr << "Usage: impl_bench [-n <iterations>] <crate.rlib> ..." << ::std::endl;
+            exit(1);
+        }
+    }
+    if( this->files.empty() )
+    {
+        ::std::cerr << "Usage: impl_bench [-n <iterations>] <crate.rlib> ..." << ::std::endl;
+        exit(1);
+    }
+    if( this->iterations == 0 )
+        this->iterations = 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * tools/lex_bench/main.cpp
+ * - Lexer throughput microbenchmark
+ *
+ * Usage:
+ *   find rustc-1.54.0-src/library rustc-1.54.0-src/compiler -name '*.rs' > files.txt
+ *   lex_bench [-n <iterations>] [-l files.txt] [file.rs ...]
+ */
+#include <parse/lex.hpp>
+#include <parse/parseerror.hpp>
+#include <target_version.hpp>
+#include <debug_inner.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+TargetVersion gTargetVersion;
+
+struct Args
+{
+    Args(int argc, const char* const argv[]);
+
+    unsigned    iterations = 5;
+    ::std::vector<::std::string>    files;
+};
+
+int main(int argc, const char* argv[])
+{
+    debug_init_phases("LEXBENCH_DEBUG", {
+        "Lex",
+        });
+
+    Args    args(argc, argv);
+
+    auto ph = DebugTimedPhase("Lex");
+    size_t  n_bytes = 0;
+    size_t  n_tokens = 0;
+    size_t  n_failed = 0;
+    double  best_s = 0;
+    for(unsigned i = 0; i < args.iterations; i ++)
+    {
+        size_t  this_bytes = 0;
+        size_t  this_tokens = 0;
+        size_t  this_failed = 0;
+        auto start = ::std::chrono::steady_clock::now();
+        for(const auto& f : args.files)
+        {
+            try
+            {
+                Lexer   lex(f, AST::Edition::Rust2018, ParseState());
+                while( lex.getToken().type() != TOK_EOF )
+                    this_tokens ++;
+            }
+            catch(const ::std::exception& e)
+            {
+                if( i == 0 )
+                    ::std::cerr << f << ": " << e.what() << ::std::endl;
+                this_failed ++;
+                continue ;
+            }
+            ::std::ifstream is(f, ::std::ios_base::binary|::std::ios_base::ate);
+            this_bytes += static_cast<size_t>(is.tellg());
+        }
+        double  dur = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - start).count();
+        ::std::cout << "Iteration " << i << ": " << dur << "s" << ::std::endl;
+        if( i == 0 || dur < best_s )
+            best_s = dur;
+        n_bytes = this_bytes;
+        n_tokens = this_tokens;
+        n_failed = this_failed;
+    }
+
+    ::std::cout
+        << args.files.size() << " files (" << n_failed << " failed), "
+        << n_bytes << " bytes, " << n_tokens << " tokens" << ::std::endl
+        << "Best: " << best_s << "s - "
+        << (n_bytes / best_s / (1024*1024)) << " MiB/s, "
+        << (n_tokens / best_s / 1e6) << " Mtokens/s" << ::std::endl
+        ;
+    return 0;
+}
+
+Args::Args(int argc, const char* const argv[])
+{
+    for(int i = 1; i < argc; i ++)
+    {
+        const char* arg = argv[i];
+        if( arg[0] != '-' )
+        {
+            this->files.push_back(arg);
+        }
+        else if( ::std::strcmp(arg, "-n") == 0 && i+1 < argc )
+        {
+            this->iterations = ::std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if( ::std::strcmp(arg, "-l") == 0 && i+1 < argc )
+        {
+            ::std::ifstream is(argv[++i]);
+            if( !is.good() ) {
+                ::std::cerr << "Unable to open " << argv[i] << ::std::endl;
+                exit(1);
+            }
+            ::std::string   line;
+            while( ::std::getline(is, line) )
+            {
+                if( line != "" )
+                    this->files.push_back(line);
+            }
+        }
+        else
+        {
+            ::std::cerr << "Usage: lex_bench [-n <iterations>] [-l <file list>] [file.rs ...]" << ::std::endl;
+            exit(1);
+        }
+    }
+    if( this->iterations == 0 )
+        this->iterations = 1;
+}
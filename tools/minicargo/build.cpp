@@ -23,8 +23,11 @@ extern int _putenv_s(const char*, const char*);
 #include "debug.h"
 #include "stringlist.h"
 #include <vector>
+#include <map>
 #include <algorithm>
+#include <chrono>
 #include <sstream>  // stringstream
+#include <cstring>  // strlen
 #include <fstream>  // ifstream
 #include <cstdlib>  // setenv
 #ifndef DISABLE_MULTITHREAD
@@ -37,12 +40,17 @@ extern int _putenv_s(const char*, const char*);
 #include <cassert>
 #ifdef _WIN32
 # include <Windows.h>
+# include <Psapi.h>
+# ifdef _MSC_VER
+#  pragma comment(lib, "psapi.lib")
+# endif
 #else
 # include <unistd.h>    // getcwd/chdir
 # include <spawn.h>
 # include <sys/types.h>
 # include <sys/stat.h>
 # include <sys/wait.h>
+# include <sys/resource.h>  // wait4
 # include <fcntl.h>
 # include <limits.h> // PATH_MAX
 #endif
@@ -108,21 +116,51 @@ class Builder
 {
     const BuildOptions& m_opts;
     ::helpers::path m_compiler_path;
+    /// Hash of the compiler executable's contents (only when `BuildOptions::content_hash` is set)
+    uint64_t    m_compiler_hash = 0;
     size_t m_total_targets;
     mutable size_t m_targets_built;
+#ifndef DISABLE_MULTITHREAD
+    mutable ::std::mutex    m_phase_stats_lock;
+#endif
+    /// Statistics files written by compiler invocations in this run (see `BuildOptions::phase_stats`)
+    mutable ::std::vector<::helpers::path>  m_phase_stats_files;
+
+public:
+    /// Result of building a package from the build list
+    struct JobStats
+    {
+        /// Set if the compiler was run (i.e. the package wasn't up to date)
+        bool    compiled = false;
+        /// Peak memory usage of the compiler
+        uint64_t    peak_rss_kb = 0;
+    };
+private:
+    /// Indexed by build list index
+    mutable ::std::vector<JobStats> m_job_stats;
 
 public:
     Builder(const BuildOptions& opts, size_t total_targets);
 
+    const JobStats& job_stats(size_t index) const { return m_job_stats.at(index); }
+
     bool build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index) const;
     bool build_library(const PackageManifest& manifest, bool is_for_host, size_t index) const;
     ::helpers::path build_build_script(const PackageManifest& manifest, bool is_for_host, bool* out_is_rebuilt) const;
 
+    /// Combine the statistics from every compiler invocation into one file
+    void write_phase_stats(const ::helpers::path& outfile) const;
+
 private:
     ::std::string get_crate_suffix(const PackageManifest& manifest) const;
+    /// Hash of everything except source files that influences a compiler invocation (see `BuildOptions::content_hash`)
+    uint64_t get_invocation_hash(const StringList& args, const StringListKV& env) const;
+    /// Combine the invocation hash with the contents of the source files listed in the depfile, returns an empty
+    /// string if the depfile or any source is missing.
+    ::std::string get_fingerprint(uint64_t invocation_hash, const ::helpers::path& outfile, const ::helpers::path& depfile) const;
     ::std::string get_build_script_out(const PackageManifest& manifest) const;
     ::helpers::path get_crate_path(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, const char** crate_type, ::std::string* out_crate_suffix) const;
-    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const;
+    bool spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, uint64_t* out_peak_rss_kb=nullptr) const;
 
     ::helpers::path build_and_run_script(const PackageManifest& manifest, bool is_for_host) const;
 
@@ -180,6 +218,65 @@ public:
     }
 };
 
+namespace {
+    /// 64-bit FNV-1a, used to fingerprint build inputs
+    class ContentHash
+    {
+        uint64_t    m_val = 0xcbf29ce484222325ull;
+    public:
+        void write(const void* data, size_t len) {
+            const auto* p = static_cast<const uint8_t*>(data);
+            for(size_t i = 0; i < len; i ++) {
+                m_val ^= p[i];
+                m_val *= 0x100000001b3ull;
+            }
+        }
+        // NOTE: Includes the terminator, so adjacent strings can't run together
+        void write_str(const char* s) {
+            write(s, strlen(s) + 1);
+        }
+        void write_u64(uint64_t v) {
+            write(&v, sizeof(v));
+        }
+        uint64_t value() const { return m_val; }
+    };
+    bool hash_file(const ::helpers::path& path, uint64_t& out)
+    {
+        ::std::ifstream is(path.str(), ::std::ios::binary);
+        if( !is.good() )
+            return false;
+        ContentHash h;
+        char    buf[64*1024];
+        while( is.read(buf, sizeof(buf)) || is.gcount() > 0 )
+        {
+            h.write(buf, static_cast<size_t>(is.gcount()));
+        }
+        out = h.value();
+        return true;
+    }
+
+    /// The fingerprint of a build output is stored next to it
+    ::helpers::path get_fingerprint_path(const ::helpers::path& outfile) {
+        return outfile + ".fingerprint";
+    }
+    ::std::string read_fingerprint(const ::helpers::path& outfile)
+    {
+        ::std::ifstream is(get_fingerprint_path(outfile).str());
+        ::std::string   rv;
+        is >> rv;
+        return rv;
+    }
+    void write_fingerprint(const ::helpers::path& outfile, const ::std::string& fingerprint)
+    {
+        if( fingerprint == "" ) {
+            remove(get_fingerprint_path(outfile).str().c_str());
+            return ;
+        }
+        ::std::ofstream os(get_fingerprint_path(outfile).str());
+        os << fingerprint << "\n";
+    }
+}
+
 #ifndef DISABLE_MULTITHREAD
 static ::std::mutex s_cout_mutex;
 #endif
@@ -310,17 +407,104 @@ BuildList::BuildList(const PackageManifest& manifest, const BuildOptions& opts):
         }
     }
 }
+namespace {
+    /// Wall time and memory usage of previous package builds, used to order (and limit) a parallel build
+    ///
+    /// Stored as `<package> <wall seconds> <peak RSS KiB>` lines in the output directory
+    class BuildHistory
+    {
+    public:
+        struct Record {
+            double  wall_s;
+            uint64_t    peak_rss_kb;
+        };
+    private:
+        ::helpers::path m_path;
+        ::std::map<::std::string, Record>   m_records;
+    public:
+        BuildHistory(::helpers::path path):
+            m_path(::std::move(path))
+        {
+            ::std::ifstream is(m_path.str());
+            ::std::string   key;
+            Record  r;
+            while( is >> key >> r.wall_s >> r.peak_rss_kb )
+            {
+                m_records[key] = r;
+            }
+        }
+
+        const Record* get(const ::std::string& key) const {
+            auto it = m_records.find(key);
+            return it == m_records.end() ? nullptr : &it->second;
+        }
+        void set(const ::std::string& key, Record r) {
+            m_records[key] = r;
+        }
+
+        void save() const
+        {
+            ::std::ofstream os(m_path.str());
+            if( !os.good() ) {
+                ::std::cerr << "Unable to open " << m_path << " for writing" << ::std::endl;
+                return ;
+            }
+            for(const auto& e : m_records)
+            {
+                os << e.first << " " << e.second.wall_s << " " << e.second.peak_rss_kb << "\n";
+            }
+        }
+    };
+
+    /// Total physical memory, in KiB (0 if unknown)
+    uint64_t get_physical_memory_kb()
+    {
+#ifdef _WIN32
+        MEMORYSTATUSEX  ms;
+        ms.dwLength = sizeof(ms);
+        if( !GlobalMemoryStatusEx(&ms) )
+            return 0;
+        return ms.ullTotalPhys / 1024;
+#elif defined(_SC_PHYS_PAGES)
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long page_size = sysconf(_SC_PAGESIZE);
+        if( pages <= 0 || page_size <= 0 )
+            return 0;
+        return static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size) / 1024;
+#else
+        return 0;
+#endif
+    }
+}
+
 bool BuildList::build(BuildOptions opts, unsigned num_jobs)
 {
     bool include_build = !opts.build_script_overrides.is_valid();
     Builder builder { opts, m_list.size() };
 
+    BuildHistory    history { opts.output_dir / "minicargo_history.txt" };
+    auto get_history_key = [&](const Entry& e) {
+        return ::format(e.package->name(), "-", e.package->version(), (e.is_host && opts.target_name ? "-host" : ""));
+        };
+
     // Pre-count how many dependencies are remaining for each package
     struct BuildState
     {
         ::std::vector<unsigned> num_deps_remaining;
         ::std::vector<unsigned> build_queue;
 
+        /// Estimated time to build each package and the longest chain of packages that depend on it
+        ::std::vector<double>   priority;
+        /// Estimated peak memory usage of the compiler for each package
+        ::std::vector<uint64_t> est_mem_kb;
+        /// Don't start jobs that would take the total estimated memory usage over this (0 = no limit)
+        uint64_t    mem_limit_kb = 0;
+
+        unsigned    num_active = 0;
+        uint64_t    mem_in_use_kb = 0;
+        unsigned    peak_active = 0;
+        uint64_t    peak_mem_kb = 0;
+
         int complete_package(unsigned index, const ::std::vector<Entry>& list)
         {
             int rv = 0;
@@ -341,13 +525,38 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
             return rv;
         }
 
+        /// Take the ready package with the highest priority that fits in the memory budget, returns UINT_MAX if
+        /// none can be started yet.
         unsigned get_next()
         {
-            assert(!this->build_queue.empty());
-            unsigned rv = this->build_queue.back();
-            this->build_queue.pop_back();
+            size_t  best = SIZE_MAX;
+            for(size_t i = 0; i < this->build_queue.size(); i ++)
+            {
+                auto idx = this->build_queue[i];
+                // NOTE: A job is always allowed to start if nothing else is running, even if it's over budget
+                if( this->mem_limit_kb != 0 && this->num_active > 0 && this->mem_in_use_kb + this->est_mem_kb[idx] > this->mem_limit_kb )
+                    continue;
+                if( best == SIZE_MAX || this->priority[idx] > this->priority[this->build_queue[best]] )
+                    best = i;
+            }
+            if( best == SIZE_MAX )
+                return UINT_MAX;
+            unsigned rv = this->build_queue[best];
+            this->build_queue.erase(this->build_queue.begin() + best);
+
+            this->num_active ++;
+            this->mem_in_use_kb += this->est_mem_kb[rv];
+            this->peak_active = ::std::max(this->peak_active, this->num_active);
+            this->peak_mem_kb = ::std::max(this->peak_mem_kb, this->mem_in_use_kb);
             return rv;
         }
+        /// Release the resources claimed by `get_next`
+        void finish_package(unsigned index)
+        {
+            assert(this->num_active > 0);
+            this->num_active --;
+            this->mem_in_use_kb -= this->est_mem_kb[index];
+        }
     };
     BuildState  state;
     state.num_deps_remaining.reserve(m_list.size());
@@ -381,138 +590,149 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
         state.num_deps_remaining.push_back( n_deps );
     }
 
-    // Actually do the build
-    if( num_jobs > 1 )
+    // Estimate the cost of each package from previous builds
+    // - Packages without history are assumed to be average
     {
-#ifndef DISABLE_MULTITHREAD
-        class Semaphore
+        ::std::vector<double>   est_s(m_list.size(), -1.0);
+        state.est_mem_kb.resize(m_list.size());
+        double  total_s = 0;
+        uint64_t    total_mem_kb = 0;
+        size_t  n_known = 0;
+        for(size_t i = 0; i < m_list.size(); i ++)
         {
-            ::std::mutex    mutex;
-            ::std::condition_variable   condvar;
-            unsigned    count = 0;
-        public:
-            void notify_max() {
-                ::std::lock_guard<::std::mutex> lh { this->mutex };
-                count = UINT_MAX;
-                condvar.notify_all();
+            if( const auto* r = history.get(get_history_key(m_list[i])) )
+            {
+                est_s[i] = r->wall_s;
+                state.est_mem_kb[i] = r->peak_rss_kb;
+                total_s += r->wall_s;
+                total_mem_kb += r->peak_rss_kb;
+                n_known ++;
             }
-            void notify() {
-                ::std::lock_guard<::std::mutex> lh { this->mutex };
-                if( count == UINT_MAX )
-                    return;
-                ++ count;
-                condvar.notify_one();
+        }
+        double  default_s = n_known > 0 ? total_s / n_known : 1.0;
+        uint64_t    default_mem_kb = n_known > 0 ? total_mem_kb / n_known : 0;
+        DEBUG(n_known << "/" << m_list.size() << " packages have history, default " << default_s << "s " << default_mem_kb << "KiB");
+
+        // Dependents are always later in the list, so walk backwards to get the critical path length
+        state.priority.resize(m_list.size());
+        for(size_t i = m_list.size(); i --; )
+        {
+            if( est_s[i] < 0 ) {
+                est_s[i] = default_s;
+                state.est_mem_kb[i] = default_mem_kb;
             }
-            void wait() {
-                ::std::unique_lock<::std::mutex> lh { this->mutex };
-                while( count == 0 )
-                {
-                    condvar.wait(lh);
-                }
-                if( count == UINT_MAX )
-                    return;
-                -- count;
+            double  longest_dep = 0;
+            for(auto d : m_list[i].dependents)
+            {
+                assert(d > i);
+                longest_dep = ::std::max(longest_dep, state.priority[d]);
             }
+            state.priority[i] = est_s[i] + longest_dep;
+        }
+    }
+    if( opts.memory_limit_mb < 0 ) {
+        state.mem_limit_kb = get_physical_memory_kb();
+    }
+    else {
+        state.mem_limit_kb = static_cast<uint64_t>(opts.memory_limit_mb) * 1024;
+    }
+
+    // Wall time of each package build (for the history and utilisation report)
+    ::std::vector<double>   job_wall_s(m_list.size());
+    auto build_one = [&](unsigned cur)->bool {
+        auto start = ::std::chrono::steady_clock::now();
+        bool rv = builder.build_library(*m_list[cur].package, m_list[cur].is_host, cur);
+        job_wall_s[cur] = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - start).count();
+        return rv;
         };
-        struct Queue
+    // Record the packages that were compiled in this run (even if the build failed)
+    auto save_history = [&]() {
+        for(size_t i = 0; i < m_list.size(); i ++)
         {
-            Semaphore   dead_threads;
-            Semaphore   avaliable_tasks;
+            const auto& s = builder.job_stats(i);
+            if( s.compiled ) {
+                history.set(get_history_key(m_list[i]), BuildHistory::Record { job_wall_s[i], s.peak_rss_kb });
+            }
+        }
+        history.save();
+        };
+    auto build_start = ::std::chrono::steady_clock::now();
 
+    // Actually do the build
+    if( num_jobs > 1 )
+    {
+#ifndef DISABLE_MULTITHREAD
+        // All workers take the highest priority task from the shared queue as soon as there's a free slot
+        struct Queue
+        {
             ::std::mutex    mutex;
+            ::std::condition_variable   condvar;
             BuildState  state;
 
-            unsigned    num_active;
             bool    failure;
-            bool    complete;   // Set if num_active==0 and tasks.empty()
 
             Queue(BuildState x):
                 state(::std::move(x)),
-                num_active(0),
-                failure(false),
-                complete(false)
+                failure(false)
             {
             }
-
-            void signal_all() {
-                avaliable_tasks.notify_max();
-            }
         };
-        struct H {
-            static void thread_body(unsigned my_idx, const ::std::vector<Entry>* list_p, Queue* queue_p, const Builder* builder)
+        Queue   queue { ::std::move(state) };
+
+        auto thread_body = [&](unsigned my_idx) {
+            ::std::unique_lock<::std::mutex> lh { queue.mutex };
+            for(;;)
             {
-                const auto& list = *list_p;
-                auto& queue = *queue_p;
-                try
+                DEBUG("Thread " << my_idx << ": waiting");
+                unsigned cur = UINT_MAX;
+                queue.condvar.wait(lh, [&]() {
+                    if( queue.failure )
+                        return true;
+                    // If the queue is empty, and there's no active jobs, stop.
+                    if( queue.state.build_queue.empty() && queue.state.num_active == 0 )
+                        return true;
+                    cur = queue.state.get_next();
+                    return cur != UINT_MAX;
+                    });
+                if( cur == UINT_MAX )
                 {
-                    for(;;)
-                    {
-                        DEBUG("Thread " << my_idx << ": waiting");
-                        queue.avaliable_tasks.wait();
-
-                        if( queue.complete || queue.failure )
-                        {
-                            DEBUG("Thread " << my_idx << ": Terminating");
-                            break;
-                        }
-
-                        unsigned cur;
-                        {
-                            ::std::lock_guard<::std::mutex> sl { queue.mutex };
-                            cur = queue.state.get_next();
-                            queue.num_active ++;
-                        }
-
-                        DEBUG("Thread " << my_idx << ": Starting " << cur << " - " << list[cur].package->name());
-                        if( ! builder->build_library(*list[cur].package, list[cur].is_host, cur) )
-                        {
-                            queue.failure = true;
-                            queue.signal_all();
-                        }
-                        else
-                        {
-                            ::std::lock_guard<::std::mutex> sl { queue.mutex };
-                            queue.num_active --;
-                            int v = queue.state.complete_package(cur, list);
-                            while(v--)
-                            {
-                                queue.avaliable_tasks.notify();
-                            }
+                    DEBUG("Thread " << my_idx << ": Terminating");
+                    break;
+                }
+                lh.unlock();
 
-                            // If the queue is empty, and there's no active jobs, stop.
-                            if( queue.state.build_queue.empty() && queue.num_active == 0 )
-                            {
-                                queue.complete = true;
-                                queue.signal_all();
-                            }
-                        }
-                    }
+                DEBUG("Thread " << my_idx << ": Starting " << cur << " - " << m_list[cur].package->name());
+                bool ok;
+                try
+                {
+                    ok = build_one(cur);
                 }
                 catch(const std::exception& e)
                 {
                     ::std::cerr << "EXCEPTION: " << e.what() << ::std::endl;
-                    queue.failure = true;
-                    queue.signal_all();
+                    ok = false;
                 }
 
-                queue.dead_threads.notify();
+                lh.lock();
+                queue.state.finish_package(cur);
+                if( !ok )
+                {
+                    queue.failure = true;
+                }
+                else
+                {
+                    queue.state.complete_package(cur, m_list);
+                }
+                queue.condvar.notify_all();
             }
-        };
-        Queue   queue { state };
-
+            };
 
         ::std::vector<::std::thread>    threads;
         threads.reserve(num_jobs);
         DEBUG("Spawning " << num_jobs << " worker threads");
         for(unsigned i = 0; i < num_jobs; i++)
         {
-            threads.push_back(::std::thread(H::thread_body, i, &this->m_list, &queue, &builder));
-        }
-
-        DEBUG("Poking jobs");
-        for(auto i = queue.state.build_queue.size(); i --;)
-        {
-            queue.avaliable_tasks.notify();
+            threads.push_back(::std::thread(thread_body, i));
         }
 
         // All jobs are done, wait for each thread to complete
@@ -524,6 +744,7 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
 
         if( queue.failure )
         {
+            save_history();
             return false;
         }
         state = ::std::move(queue.state);
@@ -532,10 +753,12 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
         {
             auto cur = state.get_next();
 
-            if( ! builder.build_library(*m_list[cur].package, m_list[cur].is_host, cur) )
+            if( ! build_one(cur) )
             {
+                save_history();
                 return false;
             }
+            state.finish_package(cur);
             state.complete_package(cur, m_list);
         }
 #endif
@@ -546,10 +769,12 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
         {
             auto cur = state.get_next();
 
-            if( ! builder.build_library(*m_list[cur].package, m_list[cur].is_host, cur) )
+            if( ! build_one(cur) )
             {
+                save_history();
                 return false;
             }
+            state.finish_package(cur);
             state.complete_package(cur, m_list);
         }
     }
@@ -563,7 +788,7 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
             auto queue = ::std::move(state.build_queue);
             for(auto idx : queue)
             {
-                ::std::cout << pass << ": " << m_list[idx].package->name() << ::std::endl;
+                ::std::cout << pass << ": " << m_list[idx].package->name() << " (priority " << state.priority[idx] << "s)" << ::std::endl;
             }
             for(auto idx : queue)
             {
@@ -574,6 +799,29 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
         // TODO: Binaries?
         return false;
     }
+    save_history();
+
+    // Report how well the job slots were used
+    {
+        double  wall_s = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - build_start).count();
+        double  busy_s = 0;
+        size_t  n_compiled = 0;
+        for(size_t i = 0; i < m_list.size(); i ++)
+        {
+            busy_s += job_wall_s[i];
+            if( builder.job_stats(i).compiled )
+                n_compiled ++;
+        }
+        unsigned    n_slots = ::std::max(num_jobs, 1u);
+        double  utilisation = wall_s > 0 ? busy_s / (wall_s * n_slots) * 100 : 0;
+        ::std::cout << "BUILD SUMMARY: " << m_list.size() << " packages (" << n_compiled << " compiled) in " << wall_s << "s"
+            << ", " << n_slots << " jobs " << static_cast<int>(utilisation) << "% utilised (" << busy_s << "s busy)"
+            << ", peak " << state.peak_active << " concurrent using ~" << (state.peak_mem_kb / 1024) << " MiB"
+            ;
+        if( state.mem_limit_kb != 0 )
+            ::std::cout << " (limit " << (state.mem_limit_kb / 1024) << " MiB)";
+        ::std::cout << ::std::endl;
+    }
 
     // DEBUG ASSERT
     {
@@ -591,29 +839,191 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs)
     }
 
     // Now that all libraries are done, build the binaries (if present)
+    bool rv = false;
     switch(opts.mode)
     {
     case BuildOptions::Mode::Normal:
-        return this->m_root_manifest.foreach_binaries([&](const auto& bin_target) {
+        rv = this->m_root_manifest.foreach_binaries([&](const auto& bin_target) {
             return builder.build_target(this->m_root_manifest, bin_target, /*is_for_host=*/false, ~0u);
             });
+        break;
     case BuildOptions::Mode::Test:
         // TODO: What about unit tests?
-        return this->m_root_manifest.foreach_ty(PackageTarget::Type::Test, [&](const auto& test_target) {
+        rv = this->m_root_manifest.foreach_ty(PackageTarget::Type::Test, [&](const auto& test_target) {
             return builder.build_target(this->m_root_manifest, test_target, /*is_for_host=*/true, ~0u);
             });
+        break;
     //case BuildOptions::Mode::Examples:
     }
-    throw "unreachable";
+
+    if( rv && opts.phase_stats )
+    {
+        builder.write_phase_stats(opts.output_dir / "phase_stats.json");
+    }
+    return rv;
 }
 
 
+void Builder::write_phase_stats(const ::helpers::path& outfile) const
+{
+    struct PhaseTotal {
+        ::std::string   name;
+        double  wall_s = 0;
+        double  cpu_s = 0;
+        double  peak_rss_kb = 0;    // Maximum across crates
+        double  peak_rss_delta_kb = 0;  // Maximum across crates
+        double  allocs = 0;
+        double  alloc_bytes = 0;
+        unsigned    count = 0;
+    };
+    struct CounterTotal {
+        ::std::string   name;
+        double  value = 0;
+    };
+    struct CrateTotal {
+        ::std::string   file;
+        double  wall_s = 0;
+        double  cpu_s = 0;
+        double  peak_rss_kb = 0;
+    };
+    // The compiler writes one phase per line, so this only needs to find the fields within a line
+    struct H {
+        static bool get_field(const ::std::string& line, const char* key, double& out) {
+            auto pat = ::format("\"", key, "\": ");
+            auto pos = line.find(pat);
+            if( pos == ::std::string::npos )
+                return false;
+            out = ::std::strtod(line.c_str() + pos + pat.size(), nullptr);
+            return true;
+        }
+        static bool get_name(const ::std::string& line, const char* key, ::std::string& out) {
+            auto pat = ::format("{\"", key, "\": \"");
+            auto pos = line.find(pat);
+            if( pos == ::std::string::npos )
+                return false;
+            out.clear();
+            for(pos += pat.size(); pos < line.size() && line[pos] != '"'; pos ++)
+            {
+                if( line[pos] == '\\' && pos + 1 < line.size() )
+                    pos ++;
+                out += line[pos];
+            }
+            return true;
+        }
+    };
+
+    ::std::vector<PhaseTotal>   phases;
+    ::std::vector<CounterTotal> counters;
+    ::std::vector<CrateTotal>   crates;
+    for(const auto& path : m_phase_stats_files)
+    {
+        ::std::ifstream is(path.str());
+        if( !is.good() ) {
+            // Not rebuilt in this run, or the compiler failed before writing it
+            continue ;
+        }
+        CrateTotal  ct;
+        ct.file = path.str();
+        ::std::string   line;
+        while( ::std::getline(is, line) )
+        {
+            ::std::string   name;
+            if( H::get_name(line, "counter", name) )
+            {
+                auto it = ::std::find_if(counters.begin(), counters.end(), [&](const CounterTotal& c){ return c.name == name; });
+                if( it == counters.end() ) {
+                    counters.push_back(CounterTotal());
+                    counters.back().name = name;
+                    it = counters.end() - 1;
+                }
+                double  v;
+                if( H::get_field(line, "value", v) )    it->value += v;
+                continue ;
+            }
+            if( !H::get_name(line, "name", name) )
+                continue ;
+            auto it = ::std::find_if(phases.begin(), phases.end(), [&](const PhaseTotal& p){ return p.name == name; });
+            if( it == phases.end() ) {
+                phases.push_back(PhaseTotal());
+                phases.back().name = name;
+                it = phases.end() - 1;
+            }
+            double  v;
+            if( H::get_field(line, "wall_s", v) )   { it->wall_s += v; ct.wall_s += v; }
+            if( H::get_field(line, "cpu_s", v) )    { it->cpu_s += v; ct.cpu_s += v; }
+            if( H::get_field(line, "peak_rss_kb", v) ) { it->peak_rss_kb = ::std::max(it->peak_rss_kb, v); ct.peak_rss_kb = ::std::max(ct.peak_rss_kb, v); }
+            if( H::get_field(line, "peak_rss_delta_kb", v) )    it->peak_rss_delta_kb = ::std::max(it->peak_rss_delta_kb, v);
+            if( H::get_field(line, "allocs", v) )   it->allocs += v;
+            if( H::get_field(line, "alloc_bytes", v) )  it->alloc_bytes += v;
+            it->count += 1;
+        }
+        crates.push_back(::std::move(ct));
+    }
+
+    ::std::ofstream os(outfile.str());
+    if( !os.good() ) {
+        ::std::cerr << "Unable to open " << outfile << " for writing" << ::std::endl;
+        return ;
+    }
+    auto escape = [](const ::std::string& s) {
+        ::std::string   rv;
+        for(char c : s) {
+            if( c == '"' || c == '\\' )
+                rv += '\\';
+            rv += c;
+        }
+        return rv;
+        };
+    os << ::std::fixed;
+    os << "{\n";
+    os << "\"crates\": [\n";
+    for(size_t i = 0; i < crates.size(); i ++)
+    {
+        const auto& c = crates[i];
+        os << "{\"file\": \"" << escape(c.file) << "\", \"wall_s\": " << c.wall_s << ", \"cpu_s\": " << c.cpu_s
+            << ", \"peak_rss_kb\": " << static_cast<uint64_t>(c.peak_rss_kb)
+            << "}" << (i + 1 < crates.size() ? "," : "") << "\n";
+    }
+    os << "],\n";
+    os << "\"phases\": [\n";
+    for(size_t i = 0; i < phases.size(); i ++)
+    {
+        const auto& p = phases[i];
+        os << "{\"name\": \"" << escape(p.name) << "\", \"wall_s\": " << p.wall_s << ", \"cpu_s\": " << p.cpu_s
+            << ", \"peak_rss_kb\": " << static_cast<uint64_t>(p.peak_rss_kb)
+            << ", \"peak_rss_delta_kb\": " << static_cast<uint64_t>(p.peak_rss_delta_kb)
+            << ", \"allocs\": " << static_cast<uint64_t>(p.allocs)
+            << ", \"alloc_bytes\": " << static_cast<uint64_t>(p.alloc_bytes)
+            << ", \"crates\": " << p.count
+            << "}" << (i + 1 < phases.size() ? "," : "") << "\n";
+    }
+    os << "],\n";
+    os << "\"counters\": [\n";
+    for(size_t i = 0; i < counters.size(); i ++)
+    {
+        const auto& c = counters[i];
+        os << "{\"counter\": \"" << escape(c.name) << "\", \"value\": " << static_cast<uint64_t>(c.value)
+            << "}" << (i + 1 < counters.size() ? "," : "") << "\n";
+    }
+    os << "]\n";
+    os << "}\n";
+    ::std::cout << "Phase statistics for " << crates.size() << " crates written to " << outfile << ::std::endl;
+}
+
 Builder::Builder(const BuildOptions& opts, size_t total_targets):
     m_opts(opts),
     m_total_targets(total_targets),
-    m_targets_built(0)
+    m_targets_built(0),
+    m_job_stats(total_targets)
 {
     m_compiler_path = get_mrustc_path();
+    if( m_opts.content_hash )
+    {
+        if( !hash_file(m_compiler_path, m_compiler_hash) ) {
+            throw ::std::runtime_error(::format("Unable to read compiler ", m_compiler_path, " for hashing"));
+        }
+        DEBUG("Compiler hash " << ::std::hex << m_compiler_hash << ::std::dec);
+    }
 }
 
 ::std::string Builder::get_crate_suffix(const PackageManifest& manifest) const
@@ -852,6 +1262,67 @@ namespace {
     }
 }
 
+uint64_t Builder::get_invocation_hash(const StringList& args, const StringListKV& env) const
+{
+    ContentHash h;
+    h.write_u64(m_compiler_hash);
+    // Flags (including features and build script output)
+    const auto& argv = args.get_vec();
+    for(const auto* a : argv)
+        h.write_str(a);
+    for(auto kv : env)
+    {
+        h.write_str(kv.first);
+        h.write_str(kv.second);
+    }
+    // Outputs of dependencies (using their fingerprint if they have one, as that's cheaper than hashing the file)
+    for(size_t i = 0; i + 1 < argv.size(); i ++)
+    {
+        if( strcmp(argv[i], "--extern") != 0 )
+            continue ;
+        const char* path = strchr(argv[i+1], '=');
+        path = (path ? path + 1 : argv[i+1]);
+        auto fp = read_fingerprint(path);
+        if( fp != "" ) {
+            h.write_str(fp.c_str());
+        }
+        else {
+            uint64_t    v = 0;
+            if( !hash_file(path, v) ) {
+                DEBUG("Unable to hash dependency " << path);
+            }
+            h.write_u64(v);
+        }
+    }
+    return h.value();
+}
+::std::string Builder::get_fingerprint(uint64_t invocation_hash, const ::helpers::path& outfile, const ::helpers::path& depfile) const
+{
+    auto depfile_ents = load_depfile(depfile);
+    auto it = depfile_ents.find(outfile);
+    if( it == depfile_ents.end() )
+    {
+        DEBUG("No depfile entry for " << outfile);
+        return "";
+    }
+    ContentHash h;
+    h.write_u64(invocation_hash);
+    for(const auto& f : it->second)
+    {
+        uint64_t    v;
+        if( !hash_file(f, v) )
+        {
+            DEBUG("Unable to hash source " << f);
+            return "";
+        }
+        h.write_str(f.str().c_str());
+        h.write_u64(v);
+    }
+    ::std::stringstream ss;
+    ss << ::std::hex << h.value();
+    return ss.str();
+}
+
 bool Builder::build_target(const PackageManifest& manifest, const PackageTarget& target, bool is_for_host, size_t index) const
 {
     const bool is_rustc = (m_compiler_path.basename() == "rustc" || m_compiler_path.basename() == "rustc.exe");
@@ -863,77 +1334,6 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
 
     size_t this_target_idx = (index != ~0u ? m_targets_built++ : ~0u);
 
-    // TODO: Determine if it needs re-running
-    // Rerun if:
-    // > `outfile` is missing
-    // > mrustc/minicargo is newer than `outfile`
-    // > build script has changed
-    // > any input file has changed (requires depfile from mrustc)
-    bool force_rebuild = false;
-    auto ts_result = Timestamp::for_file(outfile);
-    if( force_rebuild ) {
-        DEBUG("Building " << outfile << " - Force");
-    }
-    else if( ts_result == Timestamp::infinite_past() ) {
-        // Rebuild (missing)
-        DEBUG("Building " << outfile << " - Missing");
-    }
-    else if( !getenv("MINICARGO_IGNTOOLS") && ( ts_result < Timestamp::for_file(m_compiler_path) /*|| ts_result < Timestamp::for_file("bin/minicargo")*/ ) ) {
-        // Rebuild (older than mrustc/minicargo)
-        DEBUG("Building " << outfile << " - Older than mrustc ( " << ts_result << " < " << Timestamp::for_file(m_compiler_path) << ")");
-    }
-    else {
-        // Check dependencies. (from depfile)
-        auto depfile_ents = load_depfile(depfile);
-        auto it = depfile_ents.find(outfile);
-        bool has_new_file = false;
-        if( it != depfile_ents.end() )
-        {
-            for(const auto& f : it->second)
-            {
-                auto dep_ts = Timestamp::for_file(f);
-                if( ts_result < dep_ts )
-                {
-                    has_new_file = true;
-                    DEBUG("Rebuilding " << outfile << ", older than " << f);
-                    break;
-                }
-            }
-        }
-
-        if( !has_new_file )
-        {
-            // Don't rebuild (no need to)
-            DEBUG("Not building " << outfile << " - not out of date");
-            return true;
-        }
-    }
-
-    for(const auto& cmd : manifest.build_script_output().pre_build_commands)
-    {
-        // TODO: Run commands specified by build script (override)
-        TODO("Run command `" << cmd << "` from build script override");
-    }
-
-    {
-#ifndef DISABLE_MULTITHREAD
-        ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
-#endif
-        set_console_colour(std::cout, TerminalColour::Green);
-        // TODO: Determine what number and total targets there are
-        if( index != ~0u ) {
-            //::std::cout << "(" << index << "/" << m_total_targets << ") ";
-            ::std::cout << "(" << this_target_idx << "/" << m_total_targets << ") ";
-        }
-        ::std::cout << "BUILDING ";
-        if(target.m_name != manifest.name())
-            ::std::cout << target.m_name << " from ";
-        ::std::cout << manifest.name() << " v" << manifest.version();
-        if( !manifest.active_features().empty() )
-            ::std::cout << " with features [" << manifest.active_features() << "]";
-        set_console_colour(std::cout, TerminalColour::Default);
-        ::std::cout << ::std::endl;
-    }
     StringList  args;
     args.push_back(::helpers::path(manifest.manifest_path()).parent() / ::helpers::path(target.m_path));
     args.push_back("-o"); args.push_back(outfile);
@@ -979,7 +1379,6 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     {
         args.push_back("-C"); args.push_back("codegen-type=monomir");
     }
-
     for(const auto& d : m_opts.lib_search_dirs)
     {
         args.push_back("-L");
@@ -1076,37 +1475,137 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     }
     push_env_common(env, manifest);
 
-    // TODO: If emitting command files (i.e. cross-compiling), concatenate the contents of `outfile + ".sh"` onto a
-    // master file.
-    // - Will probably want to do this as a final stage after building everything.
-    return this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt");
-}
-::helpers::path Builder::build_build_script(const PackageManifest& manifest, bool is_for_host, bool* out_is_rebuilt) const
-{
-    // - Output dir is the same as the library.
-    auto outfile = this->get_output_dir(is_for_host) / get_build_script_out(manifest) + "_run" EXESUF;
-
+    // TODO: Determine if it needs re-running
+    // Rerun if:
+    // > `outfile` is missing
+    // > mrustc/minicargo is newer than `outfile`
+    // > build script has changed
+    // > any input file has changed (requires depfile from mrustc)
+    // With `content_hash`, the first three are replaced by comparing against the fingerprint from the last build
+    bool force_rebuild = false;
     auto ts_result = Timestamp::for_file(outfile);
-    if( ts_result == Timestamp::infinite_past() ) {
+    uint64_t    invocation_hash = (m_opts.content_hash ? this->get_invocation_hash(args, env) : 0);
+    ::std::string   old_fingerprint = (m_opts.content_hash ? read_fingerprint(outfile) : "");
+    if( force_rebuild ) {
+        DEBUG("Building " << outfile << " - Force");
+    }
+    else if( ts_result == Timestamp::infinite_past() ) {
+        // Rebuild (missing)
         DEBUG("Building " << outfile << " - Missing");
     }
-    else if( !getenv("MINICARGO_IGNTOOLS") && (ts_result < Timestamp::for_file(m_compiler_path)) ) {
+    else if( old_fingerprint != "" ) {
+        if( old_fingerprint == this->get_fingerprint(invocation_hash, outfile, depfile) ) {
+            DEBUG("Not building " << outfile << " - fingerprint unchanged");
+            return true;
+        }
+        DEBUG("Building " << outfile << " - fingerprint changed");
+    }
+    else if( !getenv("MINICARGO_IGNTOOLS") && ( ts_result < Timestamp::for_file(m_compiler_path) /*|| ts_result < Timestamp::for_file("bin/minicargo")*/ ) ) {
         // Rebuild (older than mrustc/minicargo)
         DEBUG("Building " << outfile << " - Older than mrustc ( " << ts_result << " < " << Timestamp::for_file(m_compiler_path) << ")");
     }
-    else
+    else {
+        // Check dependencies. (from depfile)
+        auto depfile_ents = load_depfile(depfile);
+        auto it = depfile_ents.find(outfile);
+        bool has_new_file = false;
+        if( it != depfile_ents.end() )
+        {
+            for(const auto& f : it->second)
+            {
+                auto dep_ts = Timestamp::for_file(f);
+                if( ts_result < dep_ts )
+                {
+                    has_new_file = true;
+                    DEBUG("Rebuilding " << outfile << ", older than " << f);
+                    break;
+                }
+            }
+        }
+
+        if( !has_new_file )
+        {
+            // Don't rebuild (no need to)
+            DEBUG("Not building " << outfile << " - not out of date");
+            // Up to date going by timestamps, so record a fingerprint to avoid needing to rebuild in future
+            if( m_opts.content_hash ) {
+                write_fingerprint(outfile, this->get_fingerprint(invocation_hash, outfile, depfile));
+            }
+            return true;
+        }
+    }
+
+    for(const auto& cmd : manifest.build_script_output().pre_build_commands)
     {
-        *out_is_rebuilt = false;
-        return outfile;
+        // TODO: Run commands specified by build script (override)
+        TODO("Run command `" << cmd << "` from build script override");
+    }
+
+    {
+#ifndef DISABLE_MULTITHREAD
+        ::std::lock_guard<::std::mutex> lh { s_cout_mutex };
+#endif
+        set_console_colour(std::cout, TerminalColour::Green);
+        // TODO: Determine what number and total targets there are
+        if( index != ~0u ) {
+            //::std::cout << "(" << index << "/" << m_total_targets << ") ";
+            ::std::cout << "(" << this_target_idx << "/" << m_total_targets << ") ";
+        }
+        ::std::cout << "BUILDING ";
+        if(target.m_name != manifest.name())
+            ::std::cout << target.m_name << " from ";
+        ::std::cout << manifest.name() << " v" << manifest.version();
+        if( !manifest.active_features().empty() )
+            ::std::cout << " with features [" << manifest.active_features() << "]";
+        set_console_colour(std::cout, TerminalColour::Default);
+        ::std::cout << ::std::endl;
+    }
+    // NOTE: Added after the fingerprint is calculated, as it doesn't change the output
+    if( m_opts.phase_stats && !is_rustc )
+    {
+        auto stats_file = outfile + ".phase_stats.json";
+        args.push_back("--phase-stats"); args.push_back(stats_file);
+#ifndef DISABLE_MULTITHREAD
+        ::std::lock_guard<::std::mutex> lh { m_phase_stats_lock };
+#endif
+        m_phase_stats_files.push_back(stats_file);
     }
 
-    // TODO: Load+check a depfile (requires mrustc to emit one)
+    // TODO: If emitting command files (i.e. cross-compiling), concatenate the contents of `outfile + ".sh"` onto a
+    // master file.
+    // - Will probably want to do this as a final stage after building everything.
+    // Remove any existing fingerprint (even if not using `content_hash`), as it will be stale once the output is replaced
+    write_fingerprint(outfile, "");
+    uint64_t    peak_rss_kb = 0;
+    bool rv = this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt", &peak_rss_kb);
+    if( index < m_job_stats.size() )
+    {
+        // NOTE: Only the thread building this package touches this entry
+        m_job_stats[index].compiled = true;
+        m_job_stats[index].peak_rss_kb = peak_rss_kb;
+    }
+    // The depfile has now been updated to list the sources that were actually used
+    if( rv && m_opts.content_hash ) {
+        write_fingerprint(outfile, this->get_fingerprint(invocation_hash, outfile, depfile));
+    }
+    return rv;
+}
+::helpers::path Builder::build_build_script(const PackageManifest& manifest, bool is_for_host, bool* out_is_rebuilt) const
+{
+    // - Output dir is the same as the library.
+    auto outfile = this->get_output_dir(is_for_host) / get_build_script_out(manifest) + "_run" EXESUF;
+    auto depfile = outfile + ".d";
+    const bool is_rustc = (m_compiler_path.basename() == "rustc" || m_compiler_path.basename() == "rustc.exe");
 
     StringList  args;
     args.push_back( ::helpers::path(manifest.manifest_path()).parent() / ::helpers::path(manifest.build_script()) );
     args.push_back("--crate-name"); args.push_back("build");
     args.push_back("--crate-type"); args.push_back("bin");
     args.push_back("-o"); args.push_back(outfile);
+    // TODO: Load+check the depfile when not using `content_hash`
+    if( m_opts.content_hash && !is_rustc ) {
+        args.push_back("-C"); args.push_back(format("emit-depfile=",depfile));
+    }
     args.push_back("-L"); args.push_back(this->get_output_dir(true).str()); // NOTE: Forces `is_for_host` to true here.
     if( this->m_opts.enable_debug )
     {
@@ -1156,8 +1655,36 @@ bool Builder::build_target(const PackageManifest& manifest, const PackageTarget&
     // TODO: If there's any dependencies marked as `links = foo` then grab `DEP_FOO_<varname>` from its metadata
     // (build script output)
 
+    auto ts_result = Timestamp::for_file(outfile);
+    uint64_t    invocation_hash = (m_opts.content_hash ? this->get_invocation_hash(args, env) : 0);
+    ::std::string   old_fingerprint = (m_opts.content_hash ? read_fingerprint(outfile) : "");
+    if( ts_result == Timestamp::infinite_past() ) {
+        DEBUG("Building " << outfile << " - Missing");
+    }
+    else if( old_fingerprint != "" ) {
+        if( old_fingerprint == this->get_fingerprint(invocation_hash, outfile, depfile) ) {
+            *out_is_rebuilt = false;
+            return outfile;
+        }
+        DEBUG("Building " << outfile << " - fingerprint changed");
+    }
+    else if( !getenv("MINICARGO_IGNTOOLS") && (ts_result < Timestamp::for_file(m_compiler_path)) ) {
+        // Rebuild (older than mrustc/minicargo)
+        DEBUG("Building " << outfile << " - Older than mrustc ( " << ts_result << " < " << Timestamp::for_file(m_compiler_path) << ")");
+    }
+    else
+    {
+        *out_is_rebuilt = false;
+        return outfile;
+    }
+
+    // Remove any existing fingerprint (even if not using `content_hash`), as it will be stale once the output is replaced
+    write_fingerprint(outfile, "");
     if( this->spawn_process_mrustc(args, ::std::move(env), outfile + "_dbg.txt") )
     {
+        if( m_opts.content_hash ) {
+            write_fingerprint(outfile, this->get_fingerprint(invocation_hash, outfile, depfile));
+        }
         *out_is_rebuilt = true;
         return outfile;
     }
@@ -1302,10 +1829,10 @@ bool Builder::build_library(const PackageManifest& manifest, bool is_for_host, s
 
     return this->build_target(manifest, manifest.get_library(), is_for_host, index);
 }
-bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile) const
+bool Builder::spawn_process_mrustc(const StringList& args, StringListKV env, const ::helpers::path& logfile, uint64_t* out_peak_rss_kb/*=nullptr*/) const
 {
     //env.push_back("MRUSTC_DEBUG", "");
-    auto rv = spawn_process(m_compiler_path.str().c_str(), args, env, logfile);
+    auto rv = spawn_process(m_compiler_path.str().c_str(), args, env, logfile, {}, out_peak_rss_kb);
     if(getenv("MINICARGO_RUN_ONCE") || getenv("MINICARGO_RUNONCE"))
     {
         if(rv) {
@@ -1426,7 +1953,7 @@ void argv_quote_windows(const std::string& arg, std::stringstream& cmdline)
 }
 #endif
 
-bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory/*={}*/)
+bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory/*={}*/, uint64_t* out_peak_rss_kb/*=nullptr*/)
 {
     if( getenv("MINICARGO_DUMPENV") )
     {
@@ -1507,6 +2034,11 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
     WaitForSingleObject(pi.hProcess, INFINITE);
     DWORD status = 1;
     GetExitCodeProcess(pi.hProcess, &status);
+    if( out_peak_rss_kb )
+    {
+        PROCESS_MEMORY_COUNTERS pmc;
+        *out_peak_rss_kb = GetProcessMemoryInfo(pi.hProcess, &pmc, sizeof(pmc)) ? pmc.PeakWorkingSetSize / 1024 : 0;
+    }
     if (status != 0)
     {
 #ifndef DISABLE_MULTITHREAD
@@ -1600,7 +2132,16 @@ bool spawn_process(const char* exe_name, const StringList& args, const StringLis
     }
     posix_spawn_file_actions_destroy(&fa);
     int status = -1;
-    waitpid(pid, &status, 0);
+    struct rusage   ru;
+    wait4(pid, &status, 0, &ru);
+    if( out_peak_rss_kb )
+    {
+# ifdef __APPLE__
+        *out_peak_rss_kb = ru.ru_maxrss / 1024; // bytes
+# else
+        *out_peak_rss_kb = ru.ru_maxrss;    // kilobytes
+# endif
+    }
     if( status != 0 )
     {
 #ifndef DISABLE_MULTITHREAD
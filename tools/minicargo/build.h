@@ -9,6 +9,7 @@
 
 #include "manifest.h"
 #include <path.h>
+#include <cstdint>
 
 class StringList;
 class StringListKV;
@@ -21,6 +22,13 @@ struct BuildOptions
     ::std::vector<::helpers::path>  lib_search_dirs;
     bool emit_mmir = false;
     bool enable_debug = false;
+    /// Have the compiler write per-phase statistics, and aggregate them into `<output_dir>/phase_stats.json`
+    bool phase_stats = false;
+    /// Limit on the (estimated) total memory usage of concurrent build jobs in MiB, -1 = physical memory size, 0 = unlimited
+    long memory_limit_mb = -1;
+    /// Decide what needs rebuilding by hashing the inputs (sources, compiler, flags, and dependencies) instead of
+    /// comparing timestamps
+    bool content_hash = false;
     const char* target_name = nullptr;  // if null, host is used
     enum class Mode {
         /// Build the binary/library
@@ -49,4 +57,4 @@ public:
 };
 
 extern const helpers::path& get_mrustc_path();
-extern bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory={});
+extern bool spawn_process(const char* exe_name, const StringList& args, const StringListKV& env, const ::helpers::path& logfile, const ::helpers::path& working_directory={}, uint64_t* out_peak_rss_kb=nullptr);
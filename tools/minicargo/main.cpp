@@ -46,6 +46,8 @@ struct ProgramOptions
 
     // Number of build jobs to run at a time
     unsigned build_jobs = 1;
+    // Memory budget for concurrent build jobs (MiB), -1 = physical memory size, 0 = unlimited
+    long memory_limit_mb = -1;
 
     // Pause for user input before quitting (useful for MSVC debugging)
     bool pause_before_quit = false;
@@ -56,6 +58,12 @@ struct ProgramOptions
     /// Enable debug output (`-g` passed)
     bool enable_debug = false;
 
+    /// Collect per-phase compiler statistics
+    bool phase_stats = false;
+
+    /// Use content hashes (instead of timestamps) to determine what to rebuild
+    bool content_hash = false;
+
     bool no_default_features = false;
     ::std::vector<::std::string>    features;
 
@@ -225,6 +233,9 @@ int main(int argc, const char* argv[])
         build_opts.lib_search_dirs.reserve(opts.lib_search_dirs.size());
         build_opts.emit_mmir = opts.emit_mmir;
         build_opts.enable_debug = opts.enable_debug;
+        build_opts.phase_stats = opts.phase_stats;
+        build_opts.memory_limit_mb = opts.memory_limit_mb;
+        build_opts.content_hash = opts.content_hash;
         build_opts.target_name = opts.target;
         for(const auto* d : opts.lib_search_dirs)
             build_opts.lib_search_dirs.push_back( ::helpers::path(d) );
@@ -405,6 +416,19 @@ int ProgramOptions::parse(int argc, const char* argv[])
             else if( ::std::strcmp(arg, "--test") == 0 ) {
                 this->test = true;
             }
+            else if( ::std::strcmp(arg, "--phase-stats") == 0 ) {
+                this->phase_stats = true;
+            }
+            else if( ::std::strcmp(arg, "--content-hash") == 0 ) {
+                this->content_hash = true;
+            }
+            else if( ::std::strcmp(arg, "--memory-limit") == 0 ) {
+                if(i+1 == argc) {
+                    ::std::cerr << "Flag " << arg << " takes an argument" << ::std::endl;
+                    return 1;
+                }
+                this->memory_limit_mb = ::std::strtol(argv[++i], nullptr, 10);
+            }
             else {
                 ::std::cerr << "Unknown flag " << arg << ::std::endl;
                 return 1;
@@ -441,8 +465,11 @@ void ProgramOptions::help() const
         << "--output-dir,-o <dir>    : Specify the compiler output directory\n"
         << "-L <dir>                 : Search for pre-built crates (e.g. libstd) in the specified directory\n"
         << "-j <count>               : Run at most <count> build tasks at once (default is to run only one)\n"
+        << "--memory-limit <MiB>     : Don't start tasks that would exceed this much memory, from previous builds (default is physical memory, 0 for no limit)\n"
         << "-n                       : Don't build any packages, just list the packages that would be built\n"
         << "-g                       : Pass `-g` to compiler\n"
+        << "--phase-stats            : Collect per-phase compiler statistics into <output-dir>/phase_stats.json\n"
+        << "--content-hash           : Only rebuild if the hash of the sources, compiler, flags, or dependencies changes (instead of using timestamps)\n"
         << "--no-default-features    : \n"
         << "--features <list>        : \n"
         ;
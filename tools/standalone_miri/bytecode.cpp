@@ -0,0 +1,355 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * bytecode.cpp
+ * - Lowering of function bodies to the pre-resolved form
+ */
+#include "bytecode.hpp"
+#include "module_tree.hpp"
+#include "debug.hpp"
+
+namespace {
+    /// Returns true if the layout of `ty` is known (i.e. it isn't `!` or an undefined composite)
+    bool has_layout(const ::HIR::TypeRef& ty)
+    {
+        if( ty == RawType::Unreachable )
+            return false;
+        if( ty.inner_type == RawType::Composite && !ty.composite_type().populated )
+            return false;
+        return true;
+    }
+    /// Returns true if `ty` is a sized type (that can be passed to `get_size`)
+    bool is_sized(const ::HIR::TypeRef& ty)
+    {
+        return has_layout(ty) && ty.get_meta_type() == RawType::Unreachable;
+    }
+
+    struct Lowering
+    {
+        const ModuleTree&   tree;
+        const ::Function&   fcn;
+        Bytecode::Function& out;
+
+        const ::HIR::TypeRef* add_type(::HIR::TypeRef ty)
+        {
+            out.types.push_back(::std::move(ty));
+            return &out.types.back();
+        }
+
+        // Returns false if the lvalue can't be resolved ahead of time
+        bool lower_lvalue(const ::MIR::LValue& lv, Bytecode::LValue& rv)
+        {
+            rv.idx = 0;
+            rv.static_ptr = nullptr;
+            rv.steps.clear();
+            switch(lv.m_root.tag())
+            {
+            case ::MIR::LValue::Storage::TAGDEAD:   throw "";
+            case ::MIR::LValue::Storage::TAG_Return:
+                rv.root = Bytecode::LValue::Root::Return;
+                rv.ty = &fcn.ret_ty;
+                break;
+            case ::MIR::LValue::Storage::TAG_Local:
+                rv.root = Bytecode::LValue::Root::Local;
+                rv.idx = lv.m_root.as_Local();
+                if( rv.idx >= fcn.m_mir.locals.size() )
+                    return false;
+                rv.ty = &fcn.m_mir.locals[rv.idx];
+                break;
+            case ::MIR::LValue::Storage::TAG_Argument:
+                rv.root = Bytecode::LValue::Root::Argument;
+                rv.idx = lv.m_root.as_Argument();
+                if( rv.idx >= fcn.args.size() )
+                    return false;
+                rv.ty = &fcn.args[rv.idx];
+                break;
+            case ::MIR::LValue::Storage::TAG_Static:
+                rv.root = Bytecode::LValue::Root::Static;
+                rv.static_ptr = tree.get_static_opt(lv.m_root.as_Static());
+                if( !rv.static_ptr )
+                    return false;
+                rv.ty = &rv.static_ptr->ty;
+                break;
+            }
+
+            for(const auto& w : lv.m_wrappers)
+            {
+                const auto& ty = *rv.ty;
+                if( !has_layout(ty) )
+                    return false;
+                Bytecode::LValue::Step  step;
+                step.is_slice = false;
+                step.ofs = 0;
+                step.size = SIZE_MAX;
+                step.deref = Bytecode::DerefInfo { false, 0, false, 0, 0 };
+                step.src_ty = rv.ty;
+                switch(w.tag())
+                {
+                case ::MIR::LValue::Wrapper::TAGDEAD:   throw "";
+                case ::MIR::LValue::Wrapper::TAG_Field:
+                case ::MIR::LValue::Wrapper::TAG_Downcast: {
+                    const auto* wrapper = ty.get_wrapper();
+                    if( wrapper && wrapper->type != TypeWrapper::Ty::Slice && wrapper->type != TypeWrapper::Ty::Array )
+                        return false;
+                    if( !wrapper && ty.inner_type != RawType::Composite )
+                        return false;
+                    auto idx = w.is_Field() ? w.as_Field() : w.as_Downcast();
+                    if( !wrapper && idx >= ty.composite_type().fields.size() )
+                        return false;
+                    if( wrapper && wrapper->type == TypeWrapper::Ty::Array && idx >= wrapper->size )
+                        return false;
+                    auto inner_ty = ty.get_field(idx, step.ofs);
+                    // Only fields shrink the value to the field size (downcasts keep the size)
+                    if( w.is_Field() && is_sized(inner_ty) )
+                        step.size = inner_ty.get_size();
+                    rv.ty = add_type(::std::move(inner_ty));
+
+                    // Merge with a preceding offset
+                    if( !rv.steps.empty() && rv.steps.back().op == Bytecode::LValue::Step::Op::Offset )
+                    {
+                        auto& prev = rv.steps.back();
+                        if( step.size == SIZE_MAX || prev.size == SIZE_MAX || step.size <= prev.size )
+                        {
+                            prev.ofs += step.ofs;
+                            if( step.size != SIZE_MAX )
+                                prev.size = step.size;
+                            prev.ty = rv.ty;
+                            continue ;
+                        }
+                    }
+                    step.op = Bytecode::LValue::Step::Op::Offset;
+                    } break;
+                case ::MIR::LValue::Wrapper::TAG_Deref: {
+                    const auto* wrapper = ty.get_wrapper();
+                    if( !wrapper || (wrapper->type != TypeWrapper::Ty::Borrow && wrapper->type != TypeWrapper::Ty::Pointer) )
+                        return false;
+                    auto inner_ty = ty.get_inner();
+                    if( !has_layout(inner_ty) )
+                        return false;
+                    step.op = Bytecode::LValue::Step::Op::Deref;
+                    step.deref = Bytecode::DerefInfo::for_type(inner_ty);
+                    rv.ty = add_type(::std::move(inner_ty));
+                    } break;
+                case ::MIR::LValue::Wrapper::TAG_Index: {
+                    const auto* wrapper = ty.get_wrapper();
+                    if( !wrapper || (wrapper->type != TypeWrapper::Ty::Array && wrapper->type != TypeWrapper::Ty::Slice) )
+                        return false;
+                    if( w.as_Index() >= fcn.m_mir.locals.size() )
+                        return false;
+                    auto inner_ty = ty.get_inner();
+                    if( !is_sized(inner_ty) )
+                        return false;
+                    step.op = Bytecode::LValue::Step::Op::Index;
+                    step.is_slice = (wrapper->type == TypeWrapper::Ty::Slice);
+                    step.ofs = w.as_Index();
+                    step.size = inner_ty.get_size();
+                    rv.ty = add_type(::std::move(inner_ty));
+                    } break;
+                }
+                step.ty = rv.ty;
+                rv.steps.push_back(::std::move(step));
+            }
+            return true;
+        }
+
+        bool lower_param(const ::MIR::Param& p, Bytecode::Param& rv)
+        {
+            if( const auto* e = p.opt_LValue() )
+            {
+                rv.is_const = false;
+                return lower_lvalue(*e, rv.lv);
+            }
+            else if( const auto* e = p.opt_Constant() )
+            {
+                ::HIR::TypeRef  ty;
+                rv.is_const = true;
+                if( !Bytecode::const_to_value(*e, ty, rv.val) )
+                    return false;
+                rv.ty = add_type(::std::move(ty));
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        Bytecode::Instr lower_statement(const ::MIR::Statement& stmt)
+        {
+            Bytecode::Instr rv;
+            if( !stmt.is_Assign() )
+                return rv;
+            const auto& se = stmt.as_Assign();
+            if( !lower_lvalue(se.dst, rv.dst) )
+                return rv;
+            switch(se.src.tag())
+            {
+            case ::MIR::RValue::TAG_Use:
+                // NOTE: Unsized values can't be copied using a fixed size
+                if( lower_lvalue(se.src.as_Use(), rv.src_l.lv) && is_sized(*rv.src_l.lv.ty) )
+                {
+                    rv.src_l.is_const = false;
+                    rv.size = rv.src_l.lv.ty->get_size();
+                    rv.op = Bytecode::Op::Copy;
+                }
+                break;
+            case ::MIR::RValue::TAG_Constant: {
+                ::HIR::TypeRef  ty;
+                if( Bytecode::const_to_value(se.src.as_Constant(), ty, rv.src_l.val) )
+                {
+                    rv.src_l.is_const = true;
+                    rv.src_l.ty = add_type(::std::move(ty));
+                    rv.op = Bytecode::Op::Const;
+                }
+                } break;
+            case ::MIR::RValue::TAG_BinOp: {
+                const auto& re = se.src.as_BinOp();
+                if( lower_param(re.val_l, rv.src_l) && lower_param(re.val_r, rv.src_r) )
+                {
+                    rv.rvalue = &se.src;
+                    rv.op = Bytecode::Op::BinOp;
+                }
+                } break;
+            default:
+                break;
+            }
+            return rv;
+        }
+
+        Bytecode::Instr lower_terminator(const ::MIR::Terminator& term)
+        {
+            Bytecode::Instr rv;
+            switch(term.tag())
+            {
+            case ::MIR::Terminator::TAG_Goto:
+                rv.op = Bytecode::Op::Goto;
+                rv.targets.push_back(term.as_Goto());
+                break;
+            case ::MIR::Terminator::TAG_Return:
+                rv.op = Bytecode::Op::Return;
+                break;
+            case ::MIR::Terminator::TAG_If: {
+                const auto& te = term.as_If();
+                if( lower_lvalue(te.cond, rv.src_l.lv) )
+                {
+                    rv.src_l.is_const = false;
+                    rv.targets.push_back(te.bb0);
+                    rv.targets.push_back(te.bb1);
+                    rv.op = Bytecode::Op::If;
+                }
+                } break;
+            case ::MIR::Terminator::TAG_Switch: {
+                const auto& te = term.as_Switch();
+                if( !lower_lvalue(te.val, rv.src_l.lv) )
+                    break;
+                const auto& ty = *rv.src_l.lv.ty;
+                if( ty.get_wrapper() || ty.inner_type != RawType::Composite )
+                    break;
+                const auto& dt = ty.composite_type();
+                if( dt.variants.empty() || dt.variants.size() != te.targets.size() )
+                    break;
+                ::HIR::TypeRef  tag_ty;
+                rv.ofs = ty.get_field_ofs(dt.tag_path.base_field, dt.tag_path.other_indexes, tag_ty);
+                rv.size = tag_ty.get_size();
+                rv.src_l.is_const = false;
+                rv.targets = te.targets;
+                rv.op = Bytecode::Op::Switch;
+                } break;
+            default:
+                break;
+            }
+            return rv;
+        }
+    };
+}
+
+Bytecode::DerefInfo Bytecode::DerefInfo::for_type(const ::HIR::TypeRef& ty)
+{
+    DerefInfo   rv { false, 0, false, 0, 0 };
+    const auto meta_ty = ty.get_meta_type();
+    if( meta_ty != RawType::Unreachable )
+    {
+        rv.has_meta = true;
+        rv.meta_size = meta_ty.get_size();
+        if( ty.has_slice_meta(rv.slice_inner_size) )
+        {
+            // - `get_wrapper` will return non-null for `[T]`, special-case `str`
+            rv.has_slice_meta = true;
+            rv.size = (ty != RawType::Str && ty.get_wrapper() == nullptr ? ty.get_size() : 0);
+        }
+    }
+    else
+    {
+        rv.size = ty.get_size();
+    }
+    return rv;
+}
+
+bool Bytecode::const_to_value(const ::MIR::Constant& c, ::HIR::TypeRef& ty, Value& out_val)
+{
+    switch(c.tag())
+    {
+    case ::MIR::Constant::TAG_Int: {
+        const auto& ce = c.as_Int();
+        ty = ::HIR::TypeRef(ce.t);
+        out_val = Value(ty);
+        out_val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian
+        // TODO: If the write was clipped, sign-extend
+        // TODO: i128/u128 need the upper bytes cleared+valid
+        return true; }
+    case ::MIR::Constant::TAG_Uint: {
+        const auto& ce = c.as_Uint();
+        ty = ::HIR::TypeRef(ce.t);
+        out_val = Value(ty);
+        out_val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian
+        // i128/u128 need the upper bytes cleared+valid
+        if( ce.t.raw_type == RawType::U128 ) {
+            uint64_t    zero = 0;
+            out_val.write_bytes(8, &zero, 8);
+        }
+        return true; }
+    case ::MIR::Constant::TAG_Bool: {
+        const auto& ce = c.as_Bool();
+        ty = ::HIR::TypeRef(RawType::Bool);
+        out_val = Value(ty);
+        out_val.write_bytes(0, &ce.v, 1);
+        return true; }
+    case ::MIR::Constant::TAG_Float: {
+        const auto& ce = c.as_Float();
+        ty = ::HIR::TypeRef(ce.t);
+        out_val = Value(ty);
+        if( ce.t.raw_type == RawType::F64 ) {
+            out_val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian/format?
+        }
+        else if( ce.t.raw_type == RawType::F32 ) {
+            float v = static_cast<float>(ce.v);
+            out_val.write_bytes(0, &v, ::std::min(ty.get_size(), sizeof(v)));  // TODO: Endian/format?
+        }
+        else {
+            throw ::std::runtime_error("BUG: Invalid type in Constant::Float");
+        }
+        return true; }
+    default:
+        return false;
+    }
+}
+
+Bytecode::Function Bytecode::Function::lower(const ModuleTree& tree, const ::Function& fcn)
+{
+    Function    rv;
+    Lowering    state { tree, fcn, rv };
+    rv.blocks.reserve(fcn.m_mir.blocks.size());
+    for(const auto& bb : fcn.m_mir.blocks)
+    {
+        Block   blk;
+        blk.statements.reserve(bb.statements.size());
+        for(const auto& stmt : bb.statements)
+        {
+            blk.statements.push_back( state.lower_statement(stmt) );
+        }
+        blk.terminator = state.lower_terminator(bb.terminator);
+        rv.blocks.push_back(::std::move(blk));
+    }
+    return rv;
+}
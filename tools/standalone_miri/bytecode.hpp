@@ -0,0 +1,143 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * bytecode.hpp
+ * - Pre-resolved form of function bodies (HEADER)
+ *
+ * Function bodies are lowered once after loading, resolving the type, offset and size of every lvalue (except for
+ * the dynamic parts - dereferences and indexing), and pre-building constant values. Statements and terminators that
+ * don't have a pre-resolved form are left as `Op::Generic`, and are interpreted directly from the MIR.
+ */
+#pragma once
+#include <deque>
+#include <vector>
+#include "hir_sim.hpp"
+#include "value.hpp"
+#include "../../src/mir/mir.hpp"
+
+struct Function;
+struct Static;
+class ModuleTree;
+
+namespace Bytecode {
+
+/// Layout information needed to dereference a pointer to a type
+struct DerefInfo
+{
+    /// The pointer has metadata (size of which is `meta_size`)
+    bool    has_meta;
+    size_t  meta_size;
+    /// The metadata is an element count, with each element being `slice_inner_size` bytes
+    bool    has_slice_meta;
+    size_t  slice_inner_size;
+    /// Size of the target (if there's no metadata), or the fixed portion of the target (if `has_slice_meta` is set)
+    size_t  size;
+
+    static DerefInfo for_type(const ::HIR::TypeRef& ty);
+};
+
+/// Pre-resolved lvalue
+struct LValue
+{
+    enum class Root
+    {
+        Return,
+        Local,
+        Argument,
+        Static,
+    } root = Root::Return;
+    unsigned    idx = 0;
+    const ::Static* static_ptr = nullptr;
+
+    struct Step
+    {
+        enum class Op
+        {
+            /// Add `ofs` to the offset, and set the size to `size` (unless it is SIZE_MAX)
+            /// - Folded from a chain of Field/Downcast wrappers
+            Offset,
+            /// Dereference the pointer, using `deref`
+            Deref,
+            /// Index an array or slice by the local `ofs`, with element size `size` (`is_slice` indicating a slice)
+            Index,
+        } op;
+        bool    is_slice;
+        size_t  ofs;
+        size_t  size;
+        DerefInfo   deref;
+        /// Type of the value before/after this step
+        const ::HIR::TypeRef*   src_ty;
+        const ::HIR::TypeRef*   ty;
+    };
+    ::std::vector<Step> steps;
+
+    /// Type of the result
+    const ::HIR::TypeRef*   ty = nullptr;
+};
+
+/// Pre-resolved `MIR::Param` (lvalue or constant)
+struct Param
+{
+    bool    is_const = false;
+    LValue  lv;
+    Value   val;
+    /// Type of the constant
+    const ::HIR::TypeRef*   ty = nullptr;
+};
+
+enum class Op
+{
+    /// Interpret the MIR statement/terminator
+    Generic,
+
+    /// `dst = src_l` (copy of `size` bytes)
+    Copy,
+    /// `dst = <constant src_l>`
+    Const,
+    /// `dst = src_l <op> src_r`
+    BinOp,
+
+    /// Terminator: Jump to `targets[0]`
+    Goto,
+    /// Terminator: Return from the function
+    Return,
+    /// Terminator: Jump to `targets[0]` if `src_l` is true, else `targets[1]`
+    If,
+    /// Terminator: Read the tag (`size` bytes at `ofs`) of the enum `src_l`, and jump to the matching entry of `targets`
+    Switch,
+};
+
+struct Instr
+{
+    Op  op = Op::Generic;
+    LValue  dst;
+    Param   src_l;
+    Param   src_r;
+    /// Original rvalue (for `BinOp`)
+    const ::MIR::RValue*    rvalue = nullptr;
+    size_t  ofs = 0;
+    size_t  size = 0;
+    ::std::vector<unsigned> targets;
+};
+
+struct Block
+{
+    ::std::vector<Instr>    statements;
+    Instr   terminator;
+};
+
+struct Function
+{
+    /// Storage for types created during lowering (e.g. field types), referenced by `LValue`
+    ::std::deque<::HIR::TypeRef>    types;
+    ::std::vector<Block>    blocks;
+
+    /// Lower the body of `fcn`
+    static Function lower(const ModuleTree& tree, const ::Function& fcn);
+};
+
+/// Build the value of a plain constant (integer, float, or boolean), returning false for any other constant
+bool const_to_value(const ::MIR::Constant& c, ::HIR::TypeRef& ty, Value& out_val);
+
+}   // namespace Bytecode
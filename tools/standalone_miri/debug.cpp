@@ -34,7 +34,8 @@ void DebugSink::set_output_file(const ::std::string& s)
 }
 bool DebugSink::enabled(const char* fcn_name)
 {
-    return true;
+    // Trace/debug output is only generated when there's a log file to write it to
+    return static_cast<bool>(s_out_file);
 }
 DebugSink DebugSink::get(const char* fcn_name, const char* file, unsigned line, DebugLevel lvl)
 {
@@ -169,6 +169,21 @@ void Lexer::check(const char* s)
     }
 }
 
+void Lexer::seek(uint64_t ofs)
+{
+    m_if.clear();
+    m_if.seekg(ofs);
+    if( !m_if.good() )
+    {
+        ::std::cerr << "Unable to seek to " << ofs << " in '" << m_filename << "'" << ::std::endl;
+        throw "ERROR";
+    }
+    m_cur_line = 1;
+    m_line_base = ofs;
+    m_next_valid = false;
+    advance();
+}
+
 void Lexer::advance()
 {
     if( m_next_valid )
@@ -561,6 +576,14 @@ void Lexer::advance()
 
 ::std::ostream& operator<<(::std::ostream& os, const Lexer& x)
 {
-    os << x.m_filename << ":" << x.m_cur_line << ": ";
+    if( x.m_line_base != 0 )
+    {
+        // Line numbers after a seek are only known relative to the seek target
+        os << x.m_filename << ":@" << x.m_line_base << "+" << (x.m_cur_line - 1) << ": ";
+    }
+    else
+    {
+        os << x.m_filename << ":" << x.m_cur_line << ": ";
+    }
     return os;
 }
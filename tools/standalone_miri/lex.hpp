@@ -52,6 +52,8 @@ class Lexer
 {
     ::std::string   m_filename;
     unsigned m_cur_line;
+    // Byte offset that `m_cur_line` is counted from (non-zero after a `seek`)
+    uint64_t    m_line_base = 0;
     ::std::ifstream m_if;
     Token   m_cur;
     bool    m_next_valid = false;
@@ -72,6 +74,9 @@ public:
     bool consume_if(char ch) { if(next() == ch) { consume(); return true; } return false; }
     bool consume_if(const char* s) { if(next() == s) { consume(); return true; } return false; }
 
+    /// Discard the current token, and restart lexing at byte offset `ofs`
+    void seek(uint64_t ofs);
+
     friend ::std::ostream& operator<<(::std::ostream& os, const Lexer& x);
 
 private:
@@ -11,8 +11,10 @@
 #include "value.hpp"
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
 #include "debug.hpp"
 #include "miri.hpp"
+#include "profiler.hpp"
 #include "../../src/common.hpp"
 #include <target_version.hpp>
 
@@ -26,6 +28,12 @@ struct ProgramOptions
 
     // Output logfile
     ::std::string   logfile;
+    // Interpret the MIR directly, instead of using the pre-resolved form
+    bool    no_bytecode = false;
+    // Print the number of instructions executed (and the rate)
+    bool    show_stats = false;
+    // Write a per-function instruction profile here (and folded stacks to `<profile>.folded`)
+    ::std::string   profile;
     // Arguments for the program
     ::std::vector<const char*>  args;
 
@@ -68,6 +76,10 @@ int main(int argc, const char* argv[])
     {
         tree.load_file(opts.infile);
         tree.validate();
+        if( !opts.no_bytecode )
+        {
+            tree.lower_functions();
+        }
     }
     catch(const DebugExceptionTodo& /*e*/)
     {
@@ -103,22 +115,41 @@ int main(int argc, const char* argv[])
     auto argv_ty = ::HIR::TypeRef(RawType::I8).wrap(TypeWrapper::Ty::Pointer, 0 ).wrap(TypeWrapper::Ty::Pointer, 0);
     auto val_argv = Value::new_pointer_ofs(argv_ty, 0, RelocationPtr::new_alloc(argv_alloc));
 
+    // Write the profile however execution ends (a partial profile is still useful if the interpreter errors)
+    struct ProfileWriter {
+        const ::std::string& path;
+        Profiler    profiler;
+        ~ProfileWriter() {
+            if( path != "" )
+                profiler.write(path);
+        }
+    } profile_writer { opts.profile };
+
     // Catch various exceptions from the interpreter
     try
     {
         GlobalState global(tree);
+        if( opts.profile != "" )
+        {
+            global.m_profiler = &profile_writer.profiler;
+        }
         InterpreterThread   root_thread(global);
 
         ::std::vector<Value>    args;
         args.push_back(::std::move(val_argc));
         args.push_back(::std::move(val_argv));
         Value   rv;
-        root_thread.start("main#", ::std::move(args));
-        while( !root_thread.step_one(rv) )
-        {
-        }
+        auto start_time = ::std::chrono::steady_clock::now();
+        root_thread.run("main#", ::std::move(args), rv);
+        double  dur = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - start_time).count();
 
         LOG_NOTICE("Return code: " << rv);
+        if( opts.show_stats )
+        {
+            auto count = root_thread.instruction_count();
+            ::std::cerr << count << " instructions in " << ::std::fixed << ::std::setprecision(3) << dur << "s"
+                << " (" << static_cast<uint64_t>(dur > 0 ? count / dur : 0) << " instructions/s)" << ::std::endl;
+        }
     }
     catch(const DebugExceptionTodo& /*e*/)
     {
@@ -205,6 +236,19 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 const char* opt = argv[++argidx];
                 this->logfile = opt;
             }
+            else if( ::std::strcmp(arg, "--no-bytecode") == 0 ) {
+                this->no_bytecode = true;
+            }
+            else if( ::std::strcmp(arg, "--stats") == 0 ) {
+                this->show_stats = true;
+            }
+            else if( ::std::strcmp(arg, "--profile") == 0 ) {
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->profile = argv[++argidx];
+            }
             //else if( ::std::strcmp(arg, "--api") == 0 ) {
             //}
             else {
@@ -222,5 +266,5 @@ int ProgramOptions::parse(int argc, const char* argv[])
 
 void ProgramOptions::show_help(const char* prog) const
 {
-    ::std::cout << "USAGE: " << prog << " <infile> <... args>" << ::std::endl;
+    ::std::cout << "USAGE: " << prog << " [--logfile <file>] [--no-bytecode] [--stats] [--profile <file>] <infile> <... args>" << ::std::endl;
 }
@@ -111,6 +111,7 @@ struct MirHelpers
                 {
                     ty = ty.get_inner();
                     vr.m_offset += ty.get_size() * idx;
+                    vr.m_size = ty.get_size();
                 }
                 else if( wrapper->type == TypeWrapper::Ty::Slice )
                 {
@@ -119,6 +120,7 @@ struct MirHelpers
                     auto len = vr.m_metadata->read_usize(0);
                     LOG_ASSERT(idx < len, "Slice index out of range");
                     vr.m_offset += ty.get_size() * idx;
+                    vr.m_size = ty.get_size();
                     vr.m_metadata.reset();
                 }
                 else
@@ -151,80 +153,154 @@ struct MirHelpers
             TU_ARM(w, Deref, _) {
                 auto ptr_ty = ::std::move(ty);
                 ty = ptr_ty.get_inner();
-                LOG_DEBUG("Deref - " << vr << " into " << ty);
-
-                LOG_ASSERT(vr.m_size >= POINTER_SIZE, "Deref pointer isn't large enough to be a pointer");
-                // TODO: Move the metadata machinery into `deref` (or at least the logic needed to get the value size)
-                //auto inner_val = vr.deref(0, ty);
-                size_t ofs = vr.read_usize(0);
-                LOG_ASSERT(ofs != 0, "Dereferencing NULL pointer");
-                auto alloc = vr.get_relocation(0);
-                if( alloc )
-                {
-                    // TODO: It's valid to dereference (but not read) a non-null invalid pointer.
-                    LOG_ASSERT(ofs >= alloc.get_base(), "Dereferencing invalid pointer - " << ofs << " into " << alloc);
-                    ofs -= alloc.get_base();
-                }
-                else
-                {
-                }
+                vr = deref_value(vr, ptr_ty, ty, Bytecode::DerefInfo::for_type(ty));
+                } break;
+            }
+        }
+        return vr;
+    }
+    // Dereference the pointer `vr` (of type `ptr_ty`), pointing to a value of type `ty`
+    ValueRef deref_value(const ValueRef& vr, const ::HIR::TypeRef& ptr_ty, const ::HIR::TypeRef& ty, const Bytecode::DerefInfo& info)
+    {
+        LOG_DEBUG("Deref - " << vr << " into " << ty);
+
+        LOG_ASSERT(vr.m_size >= POINTER_SIZE, "Deref pointer isn't large enough to be a pointer");
+        // TODO: Move the metadata machinery into `deref` (or at least the logic needed to get the value size)
+        //auto inner_val = vr.deref(0, ty);
+        size_t ofs = vr.read_usize(0);
+        LOG_ASSERT(ofs != 0, "Dereferencing NULL pointer");
+        auto alloc = vr.get_relocation(0);
+        if( alloc )
+        {
+            // TODO: It's valid to dereference (but not read) a non-null invalid pointer.
+            LOG_ASSERT(ofs >= alloc.get_base(), "Dereferencing invalid pointer - " << ofs << " into " << alloc);
+            ofs -= alloc.get_base();
+        }
+        else
+        {
+        }
 
-                // There MUST be a relocation at this point with a valid allocation.
-                LOG_TRACE("Interpret " << alloc << " + " << ofs << " as value of type " << ty);
-                // NOTE: No alloc can happen when dereferencing a zero-sized pointer
-                if( alloc.is_alloc() )
-                {
-                    //LOG_DEBUG("Deref - lvr=" << ::MIR::LValue::CRef(lv, &w - &lv.m_wrappers.front()) << " alloc=" << alloc.alloc());
-                }
-                else
-                {
-                    LOG_ASSERT(ty.get_meta_type() != RawType::Unreachable || ty.get_size() > 0, "Dereference (giving a non-ZST) with no allocation");
-                }
-                size_t size;
+        // There MUST be a relocation at this point with a valid allocation.
+        LOG_TRACE("Interpret " << alloc << " + " << ofs << " as value of type " << ty);
+        // NOTE: No alloc can happen when dereferencing a zero-sized pointer
+        if( alloc.is_alloc() )
+        {
+            //LOG_DEBUG("Deref - lvr=" << ::MIR::LValue::CRef(lv, &w - &lv.m_wrappers.front()) << " alloc=" << alloc.alloc());
+        }
+        else
+        {
+            LOG_ASSERT(info.has_meta || info.size > 0, "Dereference (giving a non-ZST) with no allocation");
+        }
+        size_t size;
+
+        ::std::shared_ptr<Value>    meta_val;
+        // If the type has metadata, store it.
+        if( info.has_meta )
+        {
+            LOG_ASSERT(vr.m_size == POINTER_SIZE + info.meta_size, "Deref of " << ty << ", but pointer isn't correct size");
+            meta_val = ::std::make_shared<Value>( vr.read_value(POINTER_SIZE, info.meta_size) );
 
-                const auto meta_ty = ty.get_meta_type();
-                ::std::shared_ptr<Value>    meta_val;
-                // If the type has metadata, store it.
-                if( meta_ty != RawType::Unreachable )
+            if( info.has_slice_meta ) {
+                // Slice metadata, add the base size (if it's a struct) to the variable size
+                size = info.size + meta_val->read_usize(0) * info.slice_inner_size;
+            }
+            //else if( ty == RawType::TraitObject) {
+            //    // NOTE: Getting the size from the allocation is semi-valid, as you can't sub-slice trait objects
+            //    size = alloc.get_size() - ofs;
+            //}
+            else {
+                LOG_DEBUG("> Meta " << *meta_val << ", size = " << alloc.get_size() << " - " << ofs);
+                // TODO: if the inner type is a trait object, then check that it has an allocation.
+                size = alloc.get_size() - ofs;
+            }
+        }
+        else
+        {
+            LOG_DEBUG("sizeof(" << ty << ") = " << info.size);
+            LOG_ASSERT(vr.m_size == POINTER_SIZE, "Deref of a value that isn't a pointer-sized value (size=" << vr << ") - " << vr << ": " << ptr_ty);
+            size = info.size;
+            if( !alloc && size > 0 ) {
+                LOG_ERROR("Deref of a non-ZST pointer with no relocation - " << vr);
+            }
+        }
+
+        LOG_DEBUG("Deref - New VR: alloc=" << alloc << ", ofs=" << ofs << ", size=" << size);
+        auto rv = ValueRef(::std::move(alloc), ofs, size);
+        rv.m_metadata = ::std::move(meta_val);
+        return rv;
+    }
+
+    // Get a pre-resolved lvalue (see bytecode.hpp)
+    ValueRef get_value_ref(const Bytecode::LValue& lv)
+    {
+        auto vr = [&]()->ValueRef {
+            switch(lv.root)
+            {
+            case Bytecode::LValue::Root::Return:    return ValueRef(this->frame.ret);
+            case Bytecode::LValue::Root::Local:     return ValueRef(this->frame.locals[lv.idx]);
+            case Bytecode::LValue::Root::Argument:  return ValueRef(this->frame.args.at(lv.idx));
+            case Bytecode::LValue::Root::Static:    return ValueRef(this->thread.m_global.m_statics.at(lv.static_ptr));
+            }
+            throw "";
+            }();
+        for(const auto& step : lv.steps)
+        {
+            switch(step.op)
+            {
+            case Bytecode::LValue::Step::Op::Offset:
+                vr.m_offset += step.ofs;
+                if( step.size != SIZE_MAX )
                 {
-                    auto meta_size = meta_ty.get_size();
-                    LOG_ASSERT(vr.m_size == POINTER_SIZE + meta_size, "Deref of " << ty << ", but pointer isn't correct size");
-                    meta_val = ::std::make_shared<Value>( vr.read_value(POINTER_SIZE, meta_size) );
-
-                    size_t    slice_inner_size;
-                    if( ty.has_slice_meta(slice_inner_size) ) {
-                        // Slice metadata, add the base size (if it's a struct) to the variable size
-                        // - `get_wrapper` will return non-null for `[T]`, special-case `str`
-                        size = (ty != RawType::Str && ty.get_wrapper() == nullptr ? ty.get_size() : 0) + meta_val->read_usize(0) * slice_inner_size;
-                    }
-                    //else if( ty == RawType::TraitObject) {
-                    //    // NOTE: Getting the size from the allocation is semi-valid, as you can't sub-slice trait objects
-                    //    size = alloc.get_size() - ofs;
-                    //}
-                    else {
-                        LOG_DEBUG("> Meta " << *meta_val << ", size = " << alloc.get_size() << " - " << ofs);
-                        // TODO: if the inner type is a trait object, then check that it has an allocation.
-                        size = alloc.get_size() - ofs;
-                    }
+                    LOG_ASSERT(vr.m_size >= step.size, "Field didn't fit in the value - " << step.size << " required, but " << vr.m_size << " available");
+                    vr.m_size = step.size;
                 }
-                else
+                break;
+            case Bytecode::LValue::Step::Op::Deref:
+                vr = deref_value(vr, *step.src_ty, *step.ty, step.deref);
+                break;
+            case Bytecode::LValue::Step::Op::Index: {
+                auto idx = this->frame.locals[step.ofs].read_usize(0);
+                if( step.is_slice )
                 {
-                    LOG_DEBUG("sizeof(" << ty << ") = " << ty.get_size());
-                    LOG_ASSERT(vr.m_size == POINTER_SIZE, "Deref of a value that isn't a pointer-sized value (size=" << vr << ") - " << vr << ": " << ptr_ty);
-                    size = ty.get_size();
-                    if( !alloc && size > 0 ) {
-                        LOG_ERROR("Deref of a non-ZST pointer with no relocation - " << vr);
-                    }
+                    LOG_ASSERT(vr.m_metadata, "No slice metadata");
+                    auto len = vr.m_metadata->read_usize(0);
+                    LOG_ASSERT(idx < len, "Slice index out of range");
+                    vr.m_metadata.reset();
                 }
-
-                LOG_DEBUG("Deref - New VR: alloc=" << alloc << ", ofs=" << ofs << ", size=" << size);
-                vr = ValueRef(::std::move(alloc), ofs, size);
-                vr.m_metadata = ::std::move(meta_val);
+                vr.m_offset += step.size * idx;
+                vr.m_size = step.size;
                 } break;
             }
         }
         return vr;
     }
+    void write_lvalue(const Bytecode::LValue& lv, Value val)
+    {
+        auto base_value = get_value_ref(lv);
+        if( val.size() > 0 )
+        {
+            if(!base_value.m_value) {
+                base_value.m_alloc.alloc().write_value(base_value.m_offset, ::std::move(val));
+            }
+            else {
+                base_value.m_value->write_value(base_value.m_offset, ::std::move(val));
+            }
+        }
+    }
+    ValueRef get_value_ref_param(const Bytecode::Param& p, Value& tmp)
+    {
+        if( p.is_const )
+        {
+            tmp = Value(p.val);
+            return ValueRef(tmp, 0, tmp.size());
+        }
+        return get_value_ref(p.lv);
+    }
+    const ::HIR::TypeRef& get_param_ty(const Bytecode::Param& p)
+    {
+        return p.is_const ? *p.ty : *p.lv.ty;
+    }
+
     ValueRef get_value_ref(const ::MIR::LValue& lv)
     {
         ::HIR::TypeRef  tmp;
@@ -304,43 +380,12 @@ struct MirHelpers
         switch(c.tag())
         {
         case ::MIR::Constant::TAGDEAD:  throw "";
-        TU_ARM(c, Int, ce) {
-            ty = ::HIR::TypeRef(ce.t);
-            Value val = Value(ty);
-            val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian
-            // TODO: If the write was clipped, sign-extend
-            // TODO: i128/u128 need the upper bytes cleared+valid
-            return val;
-            } break;
-        TU_ARM(c, Uint, ce) {
-            ty = ::HIR::TypeRef(ce.t);
-            Value val = Value(ty);
-            val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian
-            // i128/u128 need the upper bytes cleared+valid
-            if( ce.t.raw_type == RawType::U128 ) {
-                uint64_t    zero = 0;
-                val.write_bytes(8, &zero, 8);
-            }
-            return val;
-            } break;
-        TU_ARM(c, Bool, ce) {
-            Value val = Value(::HIR::TypeRef { RawType::Bool });
-            val.write_bytes(0, &ce.v, 1);
-            return val;
-            } break;
-        TU_ARM(c, Float, ce) {
-            ty = ::HIR::TypeRef(ce.t);
-            Value val = Value(ty);
-            if( ce.t.raw_type == RawType::F64 ) {
-                val.write_bytes(0, &ce.v, ::std::min(ty.get_size(), sizeof(ce.v)));  // TODO: Endian/format?
-            }
-            else if( ce.t.raw_type == RawType::F32 ) {
-                float v = static_cast<float>(ce.v);
-                val.write_bytes(0, &v, ::std::min(ty.get_size(), sizeof(v)));  // TODO: Endian/format?
-            }
-            else {
-                throw ::std::runtime_error("BUG: Invalid type in Constant::Float");
-            }
+        case ::MIR::Constant::TAG_Int:
+        case ::MIR::Constant::TAG_Uint:
+        case ::MIR::Constant::TAG_Bool:
+        case ::MIR::Constant::TAG_Float: {
+            Value   val;
+            Bytecode::const_to_value(c, ty, val);
             return val;
             } break;
         TU_ARM(c, Const, ce) {
@@ -408,6 +453,336 @@ struct MirHelpers
         return param_to_value(p, ty);
     }
 
+    // Determine the variant index of the enum `v` (with type `ty`), given the location of the tag
+    size_t get_variant(const ValueRef& v, const ::HIR::TypeRef& ty, size_t tag_ofs, size_t tag_size)
+    {
+        const auto& dt = ty.composite_type();
+
+        ::std::vector<char> tag_data( tag_size );
+        v.read_bytes(tag_ofs, const_cast<char*>(tag_data.data()), tag_data.size());
+        // If there's a relocation, force down the default route
+        bool has_reloc = static_cast<bool>(v.get_relocation(tag_ofs));
+
+        // TODO: Convert the variant list into something that makes it easier to switch on.
+        size_t found_target = SIZE_MAX;
+        size_t default_target = SIZE_MAX;
+        for(size_t i = 0; i < dt.variants.size(); i ++)
+        {
+            const auto& var = dt.variants[i];
+            if( var.tag_data.size() == 0 )
+            {
+                // Save as the default, error for multiple defaults
+                if( default_target != SIZE_MAX )
+                {
+                    LOG_FATAL("Two variants with no tag in Switch - " << ty);
+                }
+                default_target = i;
+            }
+            else
+            {
+                // Read the value bytes
+                LOG_ASSERT(var.tag_data.size() == tag_data.size(), "Mismatch in tag data size");
+                if( ! has_reloc && ::std::memcmp(tag_data.data(), var.tag_data.data(), tag_data.size()) == 0 )
+                {
+                    LOG_DEBUG("Explicit match " << i);
+                    found_target = i;
+                    break ;
+                }
+            }
+        }
+
+        if( found_target == SIZE_MAX && default_target != SIZE_MAX )
+        {
+            LOG_DEBUG("Default match " << default_target);
+            found_target = default_target;
+        }
+        if( found_target == SIZE_MAX )
+        {
+            LOG_FATAL("Terminator::Switch on " << ty << " didn't find a variant");
+        }
+        return found_target;
+    }
+
+    // Evaluate a binary operation (`src` is the `RValue::BinOp`) on the given values
+    Value binop(const ::MIR::RValue& src, const ValueRef& v_l, const ::HIR::TypeRef& ty_l, const ValueRef& v_r, const ::HIR::TypeRef& ty_r)
+    {
+        const auto& re = src.as_BinOp();
+        Value   new_val;
+        switch(re.op)
+        {
+        case ::MIR::eBinOp::EQ:
+        case ::MIR::eBinOp::NE:
+        case ::MIR::eBinOp::GT:
+        case ::MIR::eBinOp::GE:
+        case ::MIR::eBinOp::LT:
+        case ::MIR::eBinOp::LE: {
+            LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
+            int res = 0;
+
+            auto reloc_l = v_l.get_relocation(0);
+            auto reloc_r = v_r.get_relocation(0);
+
+            // TODO: Stop treating the relocation as hidden information? Just use different pointers instead
+            // - Each allocation has its own address range (track the ranges when an allocation is created/released)
+
+            // TODO: Handle comparison of the relocations too
+            // - If both sides have a relocation:
+            //   > EQ/NE always valid
+            //   > others require the same relocation
+            // - If one side has a relocation:
+            //   > EQ/NE only allow zero on the non-reloc side
+            //   > others are invalid?
+            if( reloc_l && reloc_r )
+            {
+                // Both have relocations, check if they're equal
+                if( reloc_l != reloc_r )
+                {
+                    res = (reloc_l < reloc_r ? -1 : 1);
+                }
+                else
+                {
+                    // Equal: Allow all comparisons
+                }
+            }
+            else if( reloc_l || reloc_r )
+            {
+                // Only one side
+                // - Ordering is a bug
+                // - Equalities are allowed, but only for `0`?
+                //  > TODO: If the side with no reloation doesn't have value `0` then error?
+                switch(re.op)
+                {
+                case ::MIR::eBinOp::EQ:
+                case ::MIR::eBinOp::NE:
+                    // - Allow success, as addresses can be masked down
+                    break;
+                default:
+                    if( reloc_l )
+                        res = 1;
+                    else// if( reloc_r )
+                        res = -1;
+                    //LOG_FATAL("Unable to order " << v_l << " and " << v_r << " - different relocations");
+                    break;
+                }
+            }
+            else
+            {
+                // No relocations, no need to check more
+            }
+
+            if( const auto* w = ty_l.get_wrapper() )
+            {
+                if( w->type == TypeWrapper::Ty::Pointer )
+                {
+                    // TODO: Technically only EQ/NE are valid.
+
+                    res = res != 0 ? res : Ops::do_compare(v_l.read_usize(0), v_r.read_usize(0));
+
+                    // Compare fat metadata.
+                    if( res == 0 && v_l.m_size > POINTER_SIZE )
+                    {
+                        reloc_l = v_l.get_relocation(POINTER_SIZE);
+                        reloc_r = v_r.get_relocation(POINTER_SIZE);
+
+                        if( res == 0 && reloc_l != reloc_r )
+                        {
+                            res = (reloc_l < reloc_r ? -1 : 1);
+                        }
+                        res = res != 0 ? res : Ops::do_compare(v_l.read_usize(POINTER_SIZE), v_r.read_usize(POINTER_SIZE));
+                    }
+                }
+                else
+                {
+                    LOG_TODO("BinOp comparisons - " << src << " w/ " << ty_l);
+                }
+            }
+            else
+            {
+                switch(ty_l.inner_type)
+                {
+                case RawType::U64:  res = res != 0 ? res : Ops::do_compare(v_l.read_u64(0), v_r.read_u64(0));   break;
+                case RawType::U32:  res = res != 0 ? res : Ops::do_compare(v_l.read_u32(0), v_r.read_u32(0));   break;
+                case RawType::U16:  res = res != 0 ? res : Ops::do_compare(v_l.read_u16(0), v_r.read_u16(0));   break;
+                case RawType::U8 :  res = res != 0 ? res : Ops::do_compare(v_l.read_u8 (0), v_r.read_u8 (0));   break;
+                case RawType::I64:  res = res != 0 ? res : Ops::do_compare(v_l.read_i64(0), v_r.read_i64(0));   break;
+                case RawType::I32:  res = res != 0 ? res : Ops::do_compare(v_l.read_i32(0), v_r.read_i32(0));   break;
+                case RawType::I16:  res = res != 0 ? res : Ops::do_compare(v_l.read_i16(0), v_r.read_i16(0));   break;
+                case RawType::I8 :  res = res != 0 ? res : Ops::do_compare(v_l.read_i8 (0), v_r.read_i8 (0));   break;
+                case RawType::USize: res = res != 0 ? res : Ops::do_compare(v_l.read_usize(0), v_r.read_usize(0)); break;
+                case RawType::ISize: res = res != 0 ? res : Ops::do_compare(v_l.read_isize(0), v_r.read_isize(0)); break;
+                case RawType::Char: res = res != 0 ? res : Ops::do_compare(v_l.read_u32(0), v_r.read_u32(0)); break;
+                case RawType::Bool: res = res != 0 ? res : Ops::do_compare(v_l.read_u8(0), v_r.read_u8(0)); break;  // TODO: `read_bool` that checks for bool values?
+                case RawType::U128: res = res != 0 ? res : Ops::do_compare(v_l.read_u128(0), v_r.read_u128(0));   break;
+                case RawType::I128: res = res != 0 ? res : Ops::do_compare(v_l.read_i128(0), v_r.read_i128(0));   break;
+                default:
+                    LOG_TODO("BinOp comparisons - " << src << " w/ " << ty_l);
+                }
+            }
+            bool res_bool;
+            switch(re.op)
+            {
+            case ::MIR::eBinOp::EQ: res_bool = (res == 0);  break;
+            case ::MIR::eBinOp::NE: res_bool = (res != 0);  break;
+            case ::MIR::eBinOp::GT: res_bool = (res == 1);  break;
+            case ::MIR::eBinOp::GE: res_bool = (res == 1 || res == 0);  break;
+            case ::MIR::eBinOp::LT: res_bool = (res == -1); break;
+            case ::MIR::eBinOp::LE: res_bool = (res == -1 || res == 0); break;
+                break;
+            default:
+                LOG_BUG("Unknown comparison");
+            }
+            new_val = Value(::HIR::TypeRef(RawType::Bool));
+            new_val.write_u8(0, res_bool ? 1 : 0);
+            } break;
+        case ::MIR::eBinOp::BIT_SHL:
+        case ::MIR::eBinOp::BIT_SHR: {
+            LOG_ASSERT(ty_l.get_wrapper() == nullptr, "Bitwise operator on non-primitive - " << ty_l);
+            LOG_ASSERT(ty_r.get_wrapper() == nullptr, "Bitwise operator with non-primitive - " << ty_r);
+            size_t max_bits = ty_l.get_size() * 8;
+            uint8_t shift;
+            auto check_cast_u = [&](auto v){ LOG_ASSERT(0 <= v && v <= max_bits, "Shift out of range - " << v); return static_cast<uint8_t>(v); };
+            auto check_cast_s = [&](auto v){ LOG_ASSERT(v <= static_cast<int64_t>(max_bits), "Shift out of range - " << v); return static_cast<uint8_t>(v); };
+            switch(ty_r.inner_type)
+            {
+            case RawType::U64:  shift = check_cast_u(v_r.read_u64(0));    break;
+            case RawType::U32:  shift = check_cast_u(v_r.read_u32(0));    break;
+            case RawType::U16:  shift = check_cast_u(v_r.read_u16(0));    break;
+            case RawType::U8 :  shift = check_cast_u(v_r.read_u8 (0));    break;
+            case RawType::I64:  shift = check_cast_s(v_r.read_i64(0));    break;
+            case RawType::I32:  shift = check_cast_s(v_r.read_i32(0));    break;
+            case RawType::I16:  shift = check_cast_s(v_r.read_i16(0));    break;
+            case RawType::I8 :  shift = check_cast_s(v_r.read_i8 (0));    break;
+            case RawType::USize:  shift = check_cast_u(v_r.read_usize(0));    break;
+            case RawType::ISize:  shift = check_cast_s(v_r.read_isize(0));    break;
+            default:
+                LOG_TODO("BinOp shift RHS unknown type - " << src << " w/ " << ty_r);
+            }
+            new_val = Value(ty_l);
+            switch(ty_l.inner_type)
+            {
+            case RawType::U128: new_val.write_u128(0, Ops::do_bitwise(v_l.read_u128(0), U128(shift), re.op));   break;
+            case RawType::U64:  new_val.write_u64(0, Ops::do_bitwise(v_l.read_u64(0), static_cast<uint64_t>(shift), re.op));   break;
+            case RawType::U32:  new_val.write_u32(0, Ops::do_bitwise(v_l.read_u32(0), static_cast<uint32_t>(shift), re.op));   break;
+            case RawType::U16:  new_val.write_u16(0, Ops::do_bitwise(v_l.read_u16(0), static_cast<uint16_t>(shift), re.op));   break;
+            case RawType::U8 :  new_val.write_u8 (0, Ops::do_bitwise(v_l.read_u8 (0), static_cast<uint8_t >(shift), re.op));   break;
+            case RawType::USize: new_val.write_usize(0, Ops::do_bitwise(v_l.read_usize(0), static_cast<uint64_t>(shift), re.op));   break;
+            // Is signed allowed? (yes)
+            // - What's the exact semantics? For now assuming it's unsigned+reinterpret
+            case RawType::ISize: new_val.write_usize(0, Ops::do_bitwise(v_l.read_usize(0), static_cast<uint64_t>(shift), re.op));   break;
+            default:
+                LOG_TODO("BinOp shift LHS unknown type - " << src << " w/ " << ty_l);
+            }
+            } break;
+        case ::MIR::eBinOp::BIT_AND:
+        case ::MIR::eBinOp::BIT_OR:
+        case ::MIR::eBinOp::BIT_XOR:
+            LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
+            LOG_ASSERT(ty_l.get_wrapper() == nullptr, "Bitwise operator on non-primitive - " << ty_l);
+            new_val = Value(ty_l);
+            switch(ty_l.inner_type)
+            {
+            case RawType::U128:
+            case RawType::I128:
+                new_val.write_u128( 0, Ops::do_bitwise(v_l.read_u128(0), v_r.read_u128(0), re.op) );
+                break;
+            case RawType::U64:
+            case RawType::I64:
+                new_val.write_u64( 0, Ops::do_bitwise(v_l.read_u64(0), v_r.read_u64(0), re.op) );
+                break;
+            case RawType::U32:
+            case RawType::I32:
+                new_val.write_u32( 0, static_cast<uint32_t>(Ops::do_bitwise(v_l.read_u32(0), v_r.read_u32(0), re.op)) );
+                break;
+            case RawType::U16:
+            case RawType::I16:
+                new_val.write_u16( 0, static_cast<uint16_t>(Ops::do_bitwise(v_l.read_u16(0), v_r.read_u16(0), re.op)) );
+                break;
+            case RawType::U8:
+            case RawType::I8:
+            case RawType::Bool:
+                new_val.write_u8 ( 0, static_cast<uint8_t >(Ops::do_bitwise(v_l.read_u8 (0), v_r.read_u8 (0), re.op)) );
+                break;
+            case RawType::USize:
+            case RawType::ISize:
+                new_val.write_usize( 0, Ops::do_bitwise(v_l.read_usize(0), v_r.read_usize(0), re.op) );
+                break;
+            default:
+                LOG_TODO("BinOp bitwise - " << src << " w/ " << ty_l);
+            }
+            // If the LHS had a relocation, propagate it over
+            if( auto r = v_l.get_relocation(0) )
+            {
+                // TODO: Only propagate the allocation if the mask was of the high bits?
+                LOG_DEBUG("- Restore relocation " << r);
+                new_val.set_reloc(0, ::std::min(POINTER_SIZE, new_val.size()), r);
+            }
+
+            break;
+        default:
+            LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
+            auto val_l = PrimitiveValueVirt::from_value(ty_l, v_l);
+            auto val_r = PrimitiveValueVirt::from_value(ty_r, v_r);
+            RelocationPtr   new_val_reloc;
+            switch(re.op)
+            {
+            case ::MIR::eBinOp::ADD:
+                LOG_ASSERT(!v_r.get_relocation(0), "RHS of `+` has a relocation");
+                new_val_reloc = v_l.get_relocation(0);
+                val_l.get().add( val_r.get() );
+                break;
+            case ::MIR::eBinOp::SUB:
+                val_l.get().subtract( val_r.get() );
+                if( auto r_l = v_l.get_relocation(0) )
+                {
+                    if( auto r_r = v_r.get_relocation(0) )
+                    {
+                        // Pointer difference, no relocation in output
+                        if( r_l != r_r ) {
+                            LOG_DEBUG("Different relocations: " << r_l << " and " << r_r);
+                            if( r_l < r_r ) {
+                                // Subtraction should result in a negative value (a large negative?)
+                                // - Bias by `-r_r.size()`
+                                auto ofs = (r_l.get_size() + 1 + 0x1000-1) & ~(0x1000-1);
+                                val_l.get().add_imm(-static_cast<int64_t>(ofs));
+                            }
+                            else {
+                                // - Bias by `r_r.size()`
+                                auto ofs = (r_r.get_size() + 1 + 0x1000-1) & ~(0x1000-1);
+                                val_l.get().add_imm(static_cast<int64_t>(ofs));
+                            }
+                        }
+                        else {
+                            LOG_DEBUG("Equal relocations: " << r_l << " and " << r_r);
+                        }
+                    }
+                    else
+                    {
+                        new_val_reloc = ::std::move(r_l);
+                    }
+                }
+                else
+                {
+                    LOG_ASSERT(!v_r.get_relocation(0), "RHS of `-` has a relocation but LHS does not");
+                }
+                break;
+            case ::MIR::eBinOp::MUL:    val_l.get().multiply( val_r.get() ); break;
+            case ::MIR::eBinOp::DIV:    val_l.get().divide( val_r.get() ); break;
+            case ::MIR::eBinOp::MOD:    val_l.get().modulo( val_r.get() ); break;
+
+            default:
+                LOG_TODO("Unsupported binary operator?");
+            }
+            new_val = Value(ty_l);
+            val_l.get().write_to_value(new_val, 0);
+            if( new_val_reloc )
+            {
+                new_val.set_reloc(0, ::std::min(POINTER_SIZE, new_val.size()), ::std::move(new_val_reloc));
+            }
+            break;
+        }
+        return new_val;
+    }
+
     ValueRef get_value_ref_param(const ::MIR::Param& p, Value& tmp, ::HIR::TypeRef& ty)
     {
         switch(p.tag())
@@ -425,9 +800,52 @@ struct MirHelpers
     }
 };
 
-GlobalState::GlobalState(const ModuleTree& modtree):
-    m_modtree(modtree)
+void InterpreterLock::lock()
 {
+    ::std::unique_lock<::std::mutex>  lh { m_mutex };
+    auto ticket = m_next_ticket++;
+    m_cond.wait(lh, [&]{ return m_now_serving == ticket; });
+}
+void InterpreterLock::unlock()
+{
+    {
+        ::std::lock_guard<::std::mutex>  lh { m_mutex };
+        m_now_serving ++;
+    }
+    m_cond.notify_all();
+}
+bool InterpreterLock::has_waiters()
+{
+    ::std::lock_guard<::std::mutex>  lh { m_mutex };
+    return m_next_ticket != m_now_serving + 1;
+}
+void InterpreterLock::wait()
+{
+    ::std::unique_lock<::std::mutex>  lh { m_mutex };
+    // Note the generation before releasing, so a notify from the next holder can't be missed
+    auto gen = m_generation;
+    m_now_serving ++;
+    m_cond.notify_all();
+    m_wake.wait(lh, [&]{ return m_generation != gen; });
+    auto ticket = m_next_ticket++;
+    m_cond.wait(lh, [&]{ return m_now_serving == ticket; });
+}
+void InterpreterLock::notify_all()
+{
+    {
+        ::std::lock_guard<::std::mutex>  lh { m_mutex };
+        m_generation ++;
+    }
+    m_wake.notify_all();
+}
+
+GlobalState::GlobalState(ModuleTree& modtree):
+    m_modtree(modtree),
+    m_lock(new InterpreterLock())
+{
+    // The creating (main) thread starts out as the interpreting thread
+    m_lock->lock();
+
     // Generate statics
     m_modtree.iterate_statics([this](RcString name, const Static& s) {
         auto val = Value(s.ty);
@@ -524,6 +942,91 @@ GlobalState::GlobalState(const ModuleTree& modtree):
     m_fcn_overrides.insert(::std::make_pair( "ZRG4cD8std0_0_03sys4unixB_021sanitize_standard_fds0g", cb_nop )); // 1.54
 }
 
+GlobalState::~GlobalState()
+{
+    // Threads still running when the program completes are abandoned (as they would be on process exit)
+    // - This thread keeps the interpreter lock, so they stay blocked (and the lock is leaked for them to wait on)
+    bool any_running = false;
+    for(auto& t : m_threads)
+    {
+        if( t.second->handle.joinable() )
+        {
+            t.second->handle.detach();
+        }
+        if( !t.second->finished )
+        {
+            any_running = true;
+            // NOTE: Also leak the thread state, as it's referenced by the abandoned thread
+            t.second.release();
+        }
+    }
+    if( any_running )
+    {
+        m_lock.release();
+    }
+}
+void GlobalState::yield()
+{
+    if( m_lock->has_waiters() )
+    {
+        m_lock->unlock();
+        m_lock->lock();
+    }
+}
+void GlobalState::wait_blocked()
+{
+    m_lock->wait();
+}
+void GlobalState::notify_blocked()
+{
+    m_lock->notify_all();
+}
+unsigned GlobalState::spawn_thread(const ::HIR::Path& entry, Value arg)
+{
+    auto id = m_next_thread_id++;
+    auto* t = new HostThread();
+    m_threads.insert(::std::make_pair( id, ::std::unique_ptr<HostThread>(t) ));
+    t->id = id;
+    t->entry = entry;
+    t->arg = ::std::move(arg);
+
+    // NOTE: Only pointers are captured, as all interpreter state (including refcounts) must only be touched with the
+    // lock held.
+    t->handle = ::std::thread([this, t]() {
+        m_lock->lock();
+        try
+        {
+            InterpreterThread   thread(*this, t->id);
+            thread.run(t->entry.n, ::make_vec1(::std::move(t->arg)), t->result);
+        }
+        catch(const DebugExceptionTodo& /*e*/)
+        {
+            ::std::cerr << "TODO Hit (in thread " << t->id << ")" << ::std::endl;
+            ::std::exit(1);
+        }
+        catch(const DebugExceptionError& /*e*/)
+        {
+            ::std::cerr << "Error encountered (in thread " << t->id << ")" << ::std::endl;
+            ::std::exit(1);
+        }
+        catch(const ::std::exception& e)
+        {
+            ::std::cerr << "Exception encountered (in thread " << t->id << "): " << e.what() << ::std::endl;
+            ::std::exit(1);
+        }
+        catch(...)
+        {
+            ::std::cerr << "Unknown exception encountered (in thread " << t->id << ")" << ::std::endl;
+            ::std::exit(1);
+        }
+        t->finished = true;
+        // Wake any `pthread_join` waiting on this thread
+        notify_blocked();
+        m_lock->unlock();
+        });
+    return id;
+}
+
 // ====================================================================
 //
 // ====================================================================
@@ -548,13 +1051,22 @@ InterpreterThread::~InterpreterThread()
         ::std::cout << ::std::endl;
     }
 }
-void InterpreterThread::start(const RcString& p, ::std::vector<Value> args)
+void InterpreterThread::run(const RcString& p, ::std::vector<Value> args, Value& out_thread_result)
 {
+    // Number of instructions between checks for other threads waiting to run
+    const size_t    YIELD_INTERVAL = 1024;
+
     assert( this->m_stack.empty() );
-    Value   v;
-    if( this->call_path(v, HIR::Path { p }, ::std::move(args)) )
+    if( this->call_path(out_thread_result, HIR::Path { p }, ::std::move(args)) )
     {
-        LOG_TODO("Handle immediate return thread entry");
+        return ;
+    }
+    while( !this->step_one(out_thread_result) )
+    {
+        if( m_instruction_count % YIELD_INTERVAL == 0 )
+        {
+            m_global.yield();
+        }
     }
 }
 bool InterpreterThread::step_one(Value& out_thread_result)
@@ -563,6 +1075,10 @@ bool InterpreterThread::step_one(Value& out_thread_result)
     assert( !this->m_stack.back().cb );
     auto& cur_frame = this->m_stack.back();
     auto instr_idx = this->m_instruction_count++;
+    if( m_global.m_profiler )
+    {
+        this->profile_step();
+    }
     TRACE_FUNCTION_R("#" << instr_idx << " " << cur_frame.fcn->my_path << " BB" << cur_frame.bb_idx << "/" << cur_frame.stmt_idx, "#" << instr_idx);
     const auto& bb = cur_frame.fcn->m_mir.blocks.at( cur_frame.bb_idx );
 
@@ -574,6 +1090,59 @@ bool InterpreterThread::step_one(Value& out_thread_result)
 
     MirHelpers  state { *this, cur_frame };
 
+    // Run pre-resolved instructions directly, anything else is interpreted from the MIR below
+    if( cur_frame.code )
+    {
+        const auto& blk = cur_frame.code->blocks[cur_frame.bb_idx];
+        const bool is_term = !(cur_frame.stmt_idx < blk.statements.size());
+        const auto& instr = is_term ? blk.terminator : blk.statements[cur_frame.stmt_idx];
+        if( instr.op != Bytecode::Op::Generic )
+        {
+            if( is_term )
+                LOG_DEBUG("=== F" << cur_frame.frame_index << "  BB" << cur_frame.bb_idx << "/TERM: " << bb.terminator);
+            else
+                LOG_DEBUG("=== F" << cur_frame.frame_index << " BB" << cur_frame.bb_idx << "/" << cur_frame.stmt_idx << ": " << bb.statements[cur_frame.stmt_idx]);
+        }
+        switch(instr.op)
+        {
+        case Bytecode::Op::Generic:
+            break;
+        case Bytecode::Op::Copy:
+            state.write_lvalue(instr.dst, state.get_value_ref(instr.src_l.lv).read_value(0, instr.size));
+            cur_frame.stmt_idx += 1;
+            return false;
+        case Bytecode::Op::Const:
+            state.write_lvalue(instr.dst, instr.src_l.val);
+            cur_frame.stmt_idx += 1;
+            return false;
+        case Bytecode::Op::BinOp: {
+            Value   tmp_l, tmp_r;
+            auto v_l = state.get_value_ref_param(instr.src_l, tmp_l);
+            auto v_r = state.get_value_ref_param(instr.src_r, tmp_r);
+            state.write_lvalue(instr.dst, state.binop(*instr.rvalue, v_l, state.get_param_ty(instr.src_l), v_r, state.get_param_ty(instr.src_r)));
+            cur_frame.stmt_idx += 1;
+            return false; }
+        case Bytecode::Op::Goto:
+            cur_frame.bb_idx = instr.targets[0];
+            cur_frame.stmt_idx = 0;
+            return false;
+        case Bytecode::Op::Return:
+            LOG_DEBUG("RETURN " << cur_frame.ret);
+            return this->pop_stack(out_thread_result);
+        case Bytecode::Op::If: {
+            uint8_t v = state.get_value_ref(instr.src_l.lv).read_u8(0);
+            LOG_ASSERT(v == 0 || v == 1, "");
+            cur_frame.bb_idx = instr.targets[v ? 0 : 1];
+            cur_frame.stmt_idx = 0;
+            return false; }
+        case Bytecode::Op::Switch: {
+            auto v = state.get_value_ref(instr.src_l.lv);
+            cur_frame.bb_idx = instr.targets[ state.get_variant(v, *instr.src_l.lv.ty, instr.ofs, instr.size) ];
+            cur_frame.stmt_idx = 0;
+            return false; }
+        }
+    }
+
     if( cur_frame.stmt_idx < bb.statements.size() )
     {
         const auto& stmt = bb.statements[cur_frame.stmt_idx];
@@ -953,279 +1522,7 @@ bool InterpreterThread::step_one(Value& out_thread_result)
                 auto v_l = state.get_value_ref_param(re.val_l, tmp_l, ty_l);
                 auto v_r = state.get_value_ref_param(re.val_r, tmp_r, ty_r);
                 LOG_DEBUG(v_l << " (" << ty_l <<") ? " << v_r << " (" << ty_r <<")");
-
-                switch(re.op)
-                {
-                case ::MIR::eBinOp::EQ:
-                case ::MIR::eBinOp::NE:
-                case ::MIR::eBinOp::GT:
-                case ::MIR::eBinOp::GE:
-                case ::MIR::eBinOp::LT:
-                case ::MIR::eBinOp::LE: {
-                    LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
-                    int res = 0;
-
-                    auto reloc_l = v_l.get_relocation(0);
-                    auto reloc_r = v_r.get_relocation(0);
-
-                    // TODO: Stop treating the relocation as hidden information? Just use different pointers instead
-                    // - Each allocation has its own address range (track the ranges when an allocation is created/released)
-
-                    // TODO: Handle comparison of the relocations too
-                    // - If both sides have a relocation:
-                    //   > EQ/NE always valid
-                    //   > others require the same relocation
-                    // - If one side has a relocation:
-                    //   > EQ/NE only allow zero on the non-reloc side
-                    //   > others are invalid?
-                    if( reloc_l && reloc_r )
-                    {
-                        // Both have relocations, check if they're equal
-                        if( reloc_l != reloc_r )
-                        {
-                            res = (reloc_l < reloc_r ? -1 : 1);
-                        }
-                        else
-                        {
-                            // Equal: Allow all comparisons
-                        }
-                    }
-                    else if( reloc_l || reloc_r )
-                    {
-                        // Only one side
-                        // - Ordering is a bug
-                        // - Equalities are allowed, but only for `0`?
-                        //  > TODO: If the side with no reloation doesn't have value `0` then error?
-                        switch(re.op)
-                        {
-                        case ::MIR::eBinOp::EQ:
-                        case ::MIR::eBinOp::NE:
-                            // - Allow success, as addresses can be masked down
-                            break;
-                        default:
-                            if( reloc_l )
-                                res = 1;
-                            else// if( reloc_r )
-                                res = -1;
-                            //LOG_FATAL("Unable to order " << v_l << " and " << v_r << " - different relocations");
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        // No relocations, no need to check more
-                    }
-
-                    if( const auto* w = ty_l.get_wrapper() )
-                    {
-                        if( w->type == TypeWrapper::Ty::Pointer )
-                        {
-                            // TODO: Technically only EQ/NE are valid.
-
-                            res = res != 0 ? res : Ops::do_compare(v_l.read_usize(0), v_r.read_usize(0));
-
-                            // Compare fat metadata.
-                            if( res == 0 && v_l.m_size > POINTER_SIZE )
-                            {
-                                reloc_l = v_l.get_relocation(POINTER_SIZE);
-                                reloc_r = v_r.get_relocation(POINTER_SIZE);
-
-                                if( res == 0 && reloc_l != reloc_r )
-                                {
-                                    res = (reloc_l < reloc_r ? -1 : 1);
-                                }
-                                res = res != 0 ? res : Ops::do_compare(v_l.read_usize(POINTER_SIZE), v_r.read_usize(POINTER_SIZE));
-                            }
-                        }
-                        else
-                        {
-                            LOG_TODO("BinOp comparisons - " << se.src << " w/ " << ty_l);
-                        }
-                    }
-                    else
-                    {
-                        switch(ty_l.inner_type)
-                        {
-                        case RawType::U64:  res = res != 0 ? res : Ops::do_compare(v_l.read_u64(0), v_r.read_u64(0));   break;
-                        case RawType::U32:  res = res != 0 ? res : Ops::do_compare(v_l.read_u32(0), v_r.read_u32(0));   break;
-                        case RawType::U16:  res = res != 0 ? res : Ops::do_compare(v_l.read_u16(0), v_r.read_u16(0));   break;
-                        case RawType::U8 :  res = res != 0 ? res : Ops::do_compare(v_l.read_u8 (0), v_r.read_u8 (0));   break;
-                        case RawType::I64:  res = res != 0 ? res : Ops::do_compare(v_l.read_i64(0), v_r.read_i64(0));   break;
-                        case RawType::I32:  res = res != 0 ? res : Ops::do_compare(v_l.read_i32(0), v_r.read_i32(0));   break;
-                        case RawType::I16:  res = res != 0 ? res : Ops::do_compare(v_l.read_i16(0), v_r.read_i16(0));   break;
-                        case RawType::I8 :  res = res != 0 ? res : Ops::do_compare(v_l.read_i8 (0), v_r.read_i8 (0));   break;
-                        case RawType::USize: res = res != 0 ? res : Ops::do_compare(v_l.read_usize(0), v_r.read_usize(0)); break;
-                        case RawType::ISize: res = res != 0 ? res : Ops::do_compare(v_l.read_isize(0), v_r.read_isize(0)); break;
-                        case RawType::Char: res = res != 0 ? res : Ops::do_compare(v_l.read_u32(0), v_r.read_u32(0)); break;
-                        case RawType::Bool: res = res != 0 ? res : Ops::do_compare(v_l.read_u8(0), v_r.read_u8(0)); break;  // TODO: `read_bool` that checks for bool values?
-                        case RawType::U128: res = res != 0 ? res : Ops::do_compare(v_l.read_u128(0), v_r.read_u128(0));   break;
-                        case RawType::I128: res = res != 0 ? res : Ops::do_compare(v_l.read_i128(0), v_r.read_i128(0));   break;
-                        default:
-                            LOG_TODO("BinOp comparisons - " << se.src << " w/ " << ty_l);
-                        }
-                    }
-                    bool res_bool;
-                    switch(re.op)
-                    {
-                    case ::MIR::eBinOp::EQ: res_bool = (res == 0);  break;
-                    case ::MIR::eBinOp::NE: res_bool = (res != 0);  break;
-                    case ::MIR::eBinOp::GT: res_bool = (res == 1);  break;
-                    case ::MIR::eBinOp::GE: res_bool = (res == 1 || res == 0);  break;
-                    case ::MIR::eBinOp::LT: res_bool = (res == -1); break;
-                    case ::MIR::eBinOp::LE: res_bool = (res == -1 || res == 0); break;
-                        break;
-                    default:
-                        LOG_BUG("Unknown comparison");
-                    }
-                    new_val = Value(::HIR::TypeRef(RawType::Bool));
-                    new_val.write_u8(0, res_bool ? 1 : 0);
-                    } break;
-                case ::MIR::eBinOp::BIT_SHL:
-                case ::MIR::eBinOp::BIT_SHR: {
-                    LOG_ASSERT(ty_l.get_wrapper() == nullptr, "Bitwise operator on non-primitive - " << ty_l);
-                    LOG_ASSERT(ty_r.get_wrapper() == nullptr, "Bitwise operator with non-primitive - " << ty_r);
-                    size_t max_bits = ty_l.get_size() * 8;
-                    uint8_t shift;
-                    auto check_cast_u = [&](auto v){ LOG_ASSERT(0 <= v && v <= max_bits, "Shift out of range - " << v); return static_cast<uint8_t>(v); };
-                    auto check_cast_s = [&](auto v){ LOG_ASSERT(v <= static_cast<int64_t>(max_bits), "Shift out of range - " << v); return static_cast<uint8_t>(v); };
-                    switch(ty_r.inner_type)
-                    {
-                    case RawType::U64:  shift = check_cast_u(v_r.read_u64(0));    break;
-                    case RawType::U32:  shift = check_cast_u(v_r.read_u32(0));    break;
-                    case RawType::U16:  shift = check_cast_u(v_r.read_u16(0));    break;
-                    case RawType::U8 :  shift = check_cast_u(v_r.read_u8 (0));    break;
-                    case RawType::I64:  shift = check_cast_s(v_r.read_i64(0));    break;
-                    case RawType::I32:  shift = check_cast_s(v_r.read_i32(0));    break;
-                    case RawType::I16:  shift = check_cast_s(v_r.read_i16(0));    break;
-                    case RawType::I8 :  shift = check_cast_s(v_r.read_i8 (0));    break;
-                    case RawType::USize:  shift = check_cast_u(v_r.read_usize(0));    break;
-                    case RawType::ISize:  shift = check_cast_s(v_r.read_isize(0));    break;
-                    default:
-                        LOG_TODO("BinOp shift RHS unknown type - " << se.src << " w/ " << ty_r);
-                    }
-                    new_val = Value(ty_l);
-                    switch(ty_l.inner_type)
-                    {
-                    case RawType::U128: new_val.write_u128(0, Ops::do_bitwise(v_l.read_u128(0), U128(shift), re.op));   break;
-                    case RawType::U64:  new_val.write_u64(0, Ops::do_bitwise(v_l.read_u64(0), static_cast<uint64_t>(shift), re.op));   break;
-                    case RawType::U32:  new_val.write_u32(0, Ops::do_bitwise(v_l.read_u32(0), static_cast<uint32_t>(shift), re.op));   break;
-                    case RawType::U16:  new_val.write_u16(0, Ops::do_bitwise(v_l.read_u16(0), static_cast<uint16_t>(shift), re.op));   break;
-                    case RawType::U8 :  new_val.write_u8 (0, Ops::do_bitwise(v_l.read_u8 (0), static_cast<uint8_t >(shift), re.op));   break;
-                    case RawType::USize: new_val.write_usize(0, Ops::do_bitwise(v_l.read_usize(0), static_cast<uint64_t>(shift), re.op));   break;
-                    // Is signed allowed? (yes)
-                    // - What's the exact semantics? For now assuming it's unsigned+reinterpret
-                    case RawType::ISize: new_val.write_usize(0, Ops::do_bitwise(v_l.read_usize(0), static_cast<uint64_t>(shift), re.op));   break;
-                    default:
-                        LOG_TODO("BinOp shift LHS unknown type - " << se.src << " w/ " << ty_l);
-                    }
-                    } break;
-                case ::MIR::eBinOp::BIT_AND:
-                case ::MIR::eBinOp::BIT_OR:
-                case ::MIR::eBinOp::BIT_XOR:
-                    LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
-                    LOG_ASSERT(ty_l.get_wrapper() == nullptr, "Bitwise operator on non-primitive - " << ty_l);
-                    new_val = Value(ty_l);
-                    switch(ty_l.inner_type)
-                    {
-                    case RawType::U128:
-                    case RawType::I128:
-                        new_val.write_u128( 0, Ops::do_bitwise(v_l.read_u128(0), v_r.read_u128(0), re.op) );
-                        break;
-                    case RawType::U64:
-                    case RawType::I64:
-                        new_val.write_u64( 0, Ops::do_bitwise(v_l.read_u64(0), v_r.read_u64(0), re.op) );
-                        break;
-                    case RawType::U32:
-                    case RawType::I32:
-                        new_val.write_u32( 0, static_cast<uint32_t>(Ops::do_bitwise(v_l.read_u32(0), v_r.read_u32(0), re.op)) );
-                        break;
-                    case RawType::U16:
-                    case RawType::I16:
-                        new_val.write_u16( 0, static_cast<uint16_t>(Ops::do_bitwise(v_l.read_u16(0), v_r.read_u16(0), re.op)) );
-                        break;
-                    case RawType::U8:
-                    case RawType::I8:
-                    case RawType::Bool:
-                        new_val.write_u8 ( 0, static_cast<uint8_t >(Ops::do_bitwise(v_l.read_u8 (0), v_r.read_u8 (0), re.op)) );
-                        break;
-                    case RawType::USize:
-                    case RawType::ISize:
-                        new_val.write_usize( 0, Ops::do_bitwise(v_l.read_usize(0), v_r.read_usize(0), re.op) );
-                        break;
-                    default:
-                        LOG_TODO("BinOp bitwise - " << se.src << " w/ " << ty_l);
-                    }
-                    // If the LHS had a relocation, propagate it over
-                    if( auto r = v_l.get_relocation(0) )
-                    {
-                        // TODO: Only propagate the allocation if the mask was of the high bits?
-                        LOG_DEBUG("- Restore relocation " << r);
-                        new_val.set_reloc(0, ::std::min(POINTER_SIZE, new_val.size()), r);
-                    }
-
-                    break;
-                default:
-                    LOG_ASSERT(ty_l == ty_r, "BinOp type mismatch - " << ty_l << " != " << ty_r);
-                    auto val_l = PrimitiveValueVirt::from_value(ty_l, v_l);
-                    auto val_r = PrimitiveValueVirt::from_value(ty_r, v_r);
-                    RelocationPtr   new_val_reloc;
-                    switch(re.op)
-                    {
-                    case ::MIR::eBinOp::ADD:
-                        LOG_ASSERT(!v_r.get_relocation(0), "RHS of `+` has a relocation");
-                        new_val_reloc = v_l.get_relocation(0);
-                        val_l.get().add( val_r.get() );
-                        break;
-                    case ::MIR::eBinOp::SUB:
-                        val_l.get().subtract( val_r.get() );
-                        if( auto r_l = v_l.get_relocation(0) )
-                        {
-                            if( auto r_r = v_r.get_relocation(0) )
-                            {
-                                // Pointer difference, no relocation in output
-                                if( r_l != r_r ) {
-                                    LOG_DEBUG("Different relocations: " << r_l << " and " << r_r);
-                                    if( r_l < r_r ) {
-                                        // Subtraction should result in a negative value (a large negative?)
-                                        // - Bias by `-r_r.size()`
-                                        auto ofs = (r_l.get_size() + 1 + 0x1000-1) & ~(0x1000-1);
-                                        val_l.get().add_imm(-static_cast<int64_t>(ofs));
-                                    }
-                                    else {
-                                        // - Bias by `r_r.size()`
-                                        auto ofs = (r_r.get_size() + 1 + 0x1000-1) & ~(0x1000-1);
-                                        val_l.get().add_imm(static_cast<int64_t>(ofs));
-                                    }
-                                }
-                                else {
-                                    LOG_DEBUG("Equal relocations: " << r_l << " and " << r_r);
-                                }
-                            }
-                            else
-                            {
-                                new_val_reloc = ::std::move(r_l);
-                            }
-                        }
-                        else
-                        {
-                            LOG_ASSERT(!v_r.get_relocation(0), "RHS of `-` has a relocation but LHS does not");
-                        }
-                        break;
-                    case ::MIR::eBinOp::MUL:    val_l.get().multiply( val_r.get() ); break;
-                    case ::MIR::eBinOp::DIV:    val_l.get().divide( val_r.get() ); break;
-                    case ::MIR::eBinOp::MOD:    val_l.get().modulo( val_r.get() ); break;
-
-                    default:
-                        LOG_TODO("Unsupported binary operator?");
-                    }
-                    new_val = Value(ty_l);
-                    val_l.get().write_to_value(new_val, 0);
-                    if( new_val_reloc )
-                    {
-                        new_val.set_reloc(0, ::std::min(POINTER_SIZE, new_val.size()), ::std::move(new_val_reloc));
-                    }
-                    break;
-                }
+                new_val = state.binop(se.src, v_l, ty_l, v_r, ty_r);
                 } break;
             TU_ARM(se.src, UniOp, re) {
                 ::HIR::TypeRef  ty;
@@ -1519,50 +1816,7 @@ bool InterpreterThread::step_one(Value& out_thread_result)
             // Get offset, read the value.
             ::HIR::TypeRef  tag_ty;
             size_t tag_ofs = ty.get_field_ofs(dt.tag_path.base_field, dt.tag_path.other_indexes, tag_ty);
-
-            ::std::vector<char> tag_data( tag_ty.get_size() );
-            v.read_bytes(tag_ofs, const_cast<char*>(tag_data.data()), tag_data.size());
-            // If there's a relocation, force down the default route
-            bool has_reloc = static_cast<bool>(v.get_relocation(tag_ofs));
-
-            // TODO: Convert the variant list into something that makes it easier to switch on.
-            size_t found_target = SIZE_MAX;
-            size_t default_target = SIZE_MAX;
-            for(size_t i = 0; i < dt.variants.size(); i ++)
-            {
-                const auto& var = dt.variants[i];
-                if( var.tag_data.size() == 0 )
-                {
-                    // Save as the default, error for multiple defaults
-                    if( default_target != SIZE_MAX )
-                    {
-                        LOG_FATAL("Two variants with no tag in Switch - " << ty);
-                    }
-                    default_target = i;
-                }
-                else
-                {
-                    // Read the value bytes
-                    LOG_ASSERT(var.tag_data.size() == tag_data.size(), "Mismatch in tag data size");
-                    if( ! has_reloc && ::std::memcmp(tag_data.data(), var.tag_data.data(), tag_data.size()) == 0 )
-                    {
-                        LOG_DEBUG("Explicit match " << i);
-                        found_target = i;
-                        break ;
-                    }
-                }
-            }
-
-            if( found_target == SIZE_MAX && default_target != SIZE_MAX )
-            {
-                LOG_DEBUG("Default match " << default_target);
-                found_target = default_target;
-            }
-            if( found_target == SIZE_MAX )
-            {
-                LOG_FATAL("Terminator::Switch on " << ty << " didn't find a variant");
-            }
-            cur_frame.bb_idx = te.targets.at(found_target);
+            cur_frame.bb_idx = te.targets.at( state.get_variant(v, ty, tag_ofs, tag_ty.get_size()) );
             } break;
         TU_ARM(bb.terminator, SwitchValue, te) {
             ::HIR::TypeRef ty;
@@ -1765,6 +2019,43 @@ bool InterpreterThread::step_one(Value& out_thread_result)
 
     return false;
 }
+void InterpreterThread::profile_step()
+{
+    // Allocations since the last instruction were made by that instruction
+    if( m_prof_last_node )
+    {
+        m_prof_last_node->allocations += Allocation::total_count() - m_prof_last_alloc;
+    }
+
+    // Re-synchronise the profiler stack after a call/return (checked using the frame index, as a return then call can
+    // leave the depth unchanged)
+    if( m_prof_stack.empty() || m_prof_stack.back().first != m_stack.back().frame_index )
+    {
+        size_t depth = 0;
+        auto it = m_stack.begin();
+        for(; it != m_stack.end(); ++it)
+        {
+            if( it->cb )
+                continue;
+            if( depth == m_prof_stack.size() || m_prof_stack[depth].first != it->frame_index )
+                break;
+            depth ++;
+        }
+        m_prof_stack.resize(depth);
+        for(; it != m_stack.end(); ++it)
+        {
+            if( it->cb )
+                continue;
+            auto* parent = m_prof_stack.empty() ? m_global.m_profiler->root() : m_prof_stack.back().second;
+            m_prof_stack.push_back(::std::make_pair( it->frame_index, m_global.m_profiler->enter(parent, it->fcn) ));
+        }
+    }
+
+    auto* node = m_prof_stack.back().second;
+    node->instructions += 1;
+    m_prof_last_node = node;
+    m_prof_last_alloc = Allocation::total_count();
+}
 bool InterpreterThread::pop_stack(Value& out_thread_result)
 {
     assert( !this->m_stack.empty() );
@@ -1833,6 +2124,7 @@ unsigned InterpreterThread::StackFrame::s_next_frame_index = 0;
 InterpreterThread::StackFrame::StackFrame(const Function& fcn, ::std::vector<Value> args):
     frame_index(s_next_frame_index++),
     fcn(&fcn),
+    code(fcn.m_bytecode.get()),
     ret( fcn.ret_ty == RawType::Unreachable ? Value() : Value(fcn.ret_ty) ),
     args( ::std::move(args) ),
     locals( ),
@@ -8,10 +8,16 @@
 #pragma once
 #include "module_tree.hpp"
 #include "value.hpp"
+#include "profiler.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 struct ThreadState
 {
     static unsigned s_next_tls_key;
+    // Interpreted thread ID (0 for the main thread), also used as the `pthread_t` value
+    unsigned    id = 0;
     unsigned call_stack_depth;
     ::std::vector< ::std::pair<uint64_t, RelocationPtr> > tls_values;
 
@@ -38,17 +44,85 @@ struct ThreadState
 
 class InterpreterThread;
 
+/// Lock held by whichever host thread is currently interpreting
+/// - Handed out in request order (a ticket lock), so a thread that yields can't immediately re-acquire it
+/// - This is a global interpreter lock: interpreted threads are concurrent, but never run in parallel
+class InterpreterLock
+{
+    ::std::mutex    m_mutex;
+    ::std::condition_variable   m_cond;
+    uint64_t    m_next_ticket = 0;
+    uint64_t    m_now_serving = 0;
+    // Blocked threads sleep on `m_wake` until `m_generation` changes
+    ::std::condition_variable   m_wake;
+    uint64_t    m_generation = 0;
+public:
+    void lock();
+    void unlock();
+    /// Check if any other thread is waiting for the lock (must be called by the holder)
+    bool has_waiters();
+    /// Release the lock and sleep until another holder calls `notify_all`, then re-acquire
+    void wait();
+    /// Wake all threads sleeping in `wait` (must be called by the holder)
+    void notify_all();
+};
+
+/// An interpreted thread running on its own host thread
+struct HostThread
+{
+    unsigned    id;
+    ::HIR::Path entry;
+    Value   arg;
+
+    ::std::thread   handle;
+    // Set (while holding the interpreter lock) once the thread has completed
+    bool    finished = false;
+    Value   result;
+};
+
 struct GlobalState
 {
     typedef bool    override_handler_t(InterpreterThread& thread, Value& ret, const ::HIR::Path& path, ::std::vector<Value> args);
 
-    const ModuleTree& m_modtree;
+    ModuleTree& m_modtree;
 
     std::map<const Static*, Value>  m_statics;
 
     std::map<RcString, override_handler_t*>  m_fcn_overrides;
 
-    GlobalState(const ModuleTree& modtree);
+    // Instruction profile (null if not profiling)
+    Profiler*   m_profiler = nullptr;
+
+    // Interpreted threads run on their own host threads, but only the holder of this lock interprets.
+    // NOTE: Leaked if threads are still running when the program completes (they stay blocked on it until exit)
+    ::std::unique_ptr<InterpreterLock>  m_lock;
+    ::std::map<unsigned, ::std::unique_ptr<HostThread>>   m_threads;
+    unsigned    m_next_thread_id = 1;
+
+    // State of pthread mutexes/rwlocks, keyed by address
+    // NOTE: Entries are removed by `pthread_mutex_destroy`, so references to them aren't held across `wait_blocked`
+    struct SyncState {
+        // Exclusive owner (valid if `count` is non-zero), and recursion count
+        unsigned    owner = 0;
+        unsigned    count = 0;
+        // Number of shared (read) holders of a rwlock
+        unsigned    readers = 0;
+    };
+    ::std::map<const void*, SyncState>  m_sync;
+
+    GlobalState(ModuleTree& modtree);
+    ~GlobalState();
+
+    /// Let other threads run (if any are waiting), called periodically by running threads
+    void yield();
+    /// Sleep until another thread changes the state of a thread/lock/condition variable (see `notify_blocked`)
+    /// - May wake spuriously, so callers re-check their condition (and re-look up any state) in a loop
+    void wait_blocked();
+    /// Wake threads in `wait_blocked`, called after any change that could unblock them
+    void notify_blocked();
+
+    /// Start running `entry(arg)` on a new thread, returning its ID
+    unsigned spawn_thread(const ::HIR::Path& entry, Value arg);
 };
 
 class InterpreterThread
@@ -62,6 +136,8 @@ class InterpreterThread
 
         ::std::function<bool(Value&,Value)> cb;
         const Function* fcn;
+        // Pre-resolved form of the function body (null if not available)
+        const Bytecode::Function*   code;
         Value ret;
         ::std::vector<Value>    args;
         ::std::vector<Value>    locals;
@@ -84,21 +160,34 @@ class InterpreterThread
     size_t  m_instruction_count;
     ::std::vector<StackFrame>   m_stack;
 
+    // Profiler call tree node for each (non-wrapper) frame in `m_stack`, paired with the frame index
+    ::std::vector<::std::pair<unsigned, Profiler::Node*>>   m_prof_stack;
+    // Node that executed the previous instruction, and the allocation count before it
+    Profiler::Node* m_prof_last_node = nullptr;
+    uint64_t    m_prof_last_alloc = 0;
+
 public:
-    InterpreterThread(GlobalState& m_global):
+    InterpreterThread(GlobalState& m_global, unsigned id = 0):
         m_global(m_global),
         m_instruction_count(0)
     {
+        m_thread.id = id;
     }
     ~InterpreterThread();
 
-    void start(const RcString& p, ::std::vector<Value> args);
+    size_t instruction_count() const { return m_instruction_count; }
+
+    /// Run `p` until it returns (with the interpreter lock held), periodically letting other threads run
+    void run(const RcString& p, ::std::vector<Value> args, Value& out_thread_result);
     // Returns `true` if the call stack empties
     bool step_one(Value& out_thread_result);
 
 private:
     bool pop_stack(Value& out_thread_result);
 
+    // Attribute the current instruction to the current call stack
+    void profile_step();
+
     // Returns true if the call was resolved instantly
     bool call_path(Value& ret_val, const HIR::Path& p, ::std::vector<Value> args);
     // Returns true if the call was resolved instantly
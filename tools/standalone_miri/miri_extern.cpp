@@ -67,6 +67,42 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
             }
             return reinterpret_cast<const char*>(v.read_pointer_const(0, len + 1));  // Final read will trigger an error if the NUL isn't there
         }
+
+        // Emulated pthread mutexes/rwlocks, keyed by the address of the lock object
+        // - Blocked threads sleep (releasing the interpreter lock) until another thread releases something
+        // - The state is looked up again after every wake, as the entry may have been destroyed in the meantime
+        static GlobalState::SyncState& sync_state(GlobalState& global, const void* key)
+        {
+            return global.m_sync[key];
+        }
+        static GlobalState::SyncState& sync_state(GlobalState& global, const Value& ptr)
+        {
+            return sync_state(global, ptr.read_pointer_const(0, 1));
+        }
+        static void lock_exclusive(GlobalState& global, const void* key, unsigned thread_id)
+        {
+            // NOTE: Recursion is allowed (PTHREAD_MUTEX_RECURSIVE behaviour), relocking a normal mutex would deadlock
+            for(;;)
+            {
+                auto& s = sync_state(global, key);
+                if( !((s.count > 0 && s.owner != thread_id) || s.readers > 0) )
+                {
+                    s.owner = thread_id;
+                    s.count += 1;
+                    return ;
+                }
+                global.wait_blocked();
+            }
+        }
+        static void unlock_exclusive(GlobalState& global, GlobalState::SyncState& s, unsigned thread_id)
+        {
+            LOG_ASSERT(s.count > 0 && s.owner == thread_id, "Unlocking a lock not held by this thread (" << thread_id << ")");
+            s.count -= 1;
+            if( s.count == 0 )
+            {
+                global.notify_blocked();
+            }
+        }
     };
     if( link_name == "__rust_allocate" || link_name == "__rust_alloc" || link_name == "__rust_alloc_zeroed" )
     {
@@ -472,24 +508,77 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     }
     else if( link_name == "pthread_self" )
     {
+        rv = Value::new_usize(m_thread.id);
+    }
+    else if( link_name == "pthread_mutex_init" || link_name == "pthread_mutex_destroy" )
+    {
+        m_global.m_sync.erase( args.at(0).read_pointer_const(0, 1) );
         rv = Value::new_i32(0);
     }
-    else if( link_name == "pthread_mutex_init"
-        || link_name == "pthread_mutex_lock"
-        || link_name == "pthread_mutex_trylock"
-        || link_name == "pthread_mutex_unlock"
-        || link_name == "pthread_mutex_destroy"
-        )
+    else if( link_name == "pthread_mutex_lock" )
     {
+        FfiHelpers::lock_exclusive(m_global, args.at(0).read_pointer_const(0, 1), m_thread.id);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_mutex_trylock" )
+    {
+        auto key = args.at(0).read_pointer_const(0, 1);
+        auto& s = FfiHelpers::sync_state(m_global, key);
+        if( (s.count > 0 && s.owner != m_thread.id) || s.readers > 0 )
+        {
+            rv = Value::new_i32(EBUSY);
+        }
+        else
+        {
+            FfiHelpers::lock_exclusive(m_global, key, m_thread.id);
+            rv = Value::new_i32(0);
+        }
+    }
+    else if( link_name == "pthread_mutex_unlock" )
+    {
+        FfiHelpers::unlock_exclusive(m_global, FfiHelpers::sync_state(m_global, args.at(0)), m_thread.id);
         rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_rwlock_rdlock" )
     {
+        auto key = args.at(0).read_pointer_const(0, 1);
+        while( FfiHelpers::sync_state(m_global, key).count > 0 )
+        {
+            m_global.wait_blocked();
+        }
+        FfiHelpers::sync_state(m_global, key).readers += 1;
         rv = Value::new_i32(0);
     }
+    else if( link_name == "pthread_rwlock_wrlock" )
+    {
+        auto key = args.at(0).read_pointer_const(0, 1);
+        auto& s = FfiHelpers::sync_state(m_global, key);
+        if( s.count > 0 && s.owner == m_thread.id )
+        {
+            rv = Value::new_i32(EDEADLK);
+        }
+        else
+        {
+            FfiHelpers::lock_exclusive(m_global, key, m_thread.id);
+            rv = Value::new_i32(0);
+        }
+    }
     else if( link_name == "pthread_rwlock_unlock" )
     {
-        // TODO: Check that this thread holds the lock?
+        auto& s = FfiHelpers::sync_state(m_global, args.at(0));
+        if( s.count > 0 )
+        {
+            FfiHelpers::unlock_exclusive(m_global, s, m_thread.id);
+        }
+        else
+        {
+            LOG_ASSERT(s.readers > 0, "pthread_rwlock_unlock on an unlocked rwlock");
+            s.readers -= 1;
+            if( s.readers == 0 )
+            {
+                m_global.notify_blocked();
+            }
+        }
         rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_mutexattr_init" || link_name == "pthread_mutexattr_settype" || link_name == "pthread_mutexattr_destroy" )
@@ -533,47 +622,80 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     else if( link_name == "pthread_create" )
     {
         auto thread_handle_out = args.at(0).read_pointer_valref_mut(0, sizeof(pthread_t));
-        auto attrs = args.at(1).read_pointer_const(0, sizeof(pthread_attr_t));
+        // NOTE: Attributes (e.g. stack size) are ignored, the host thread's defaults are used
         auto fcn_path = args.at(2).read_pointer_fcn(0);
         auto arg = args.at(3);
-        LOG_NOTICE("TODO: pthread_create(" << thread_handle_out << ", " << attrs << ", " << fcn_path << ", " << arg << ")");
-        // TODO: Create a new interpreter context with this thread, use co-operative scheduling
-        // HACK: Just run inline
-        if( true )
-        {
-            auto tls = ::std::move(m_thread.tls_values);
-            this->m_stack.push_back(StackFrame::make_wrapper([=](Value& out_rv, Value /*rv*/)mutable ->bool {
-                out_rv = Value::new_i32(0);
-                m_thread.tls_values = ::std::move(tls);
-                return true;
-                }));
-
-            // TODO: Catch the panic out of this.
-            if( this->call_path(rv, fcn_path, { ::std::move(arg) }) )
-            {
-                bool v = this->pop_stack(rv);
-                assert( v == false );
-                return true;
-            }
-            else
+        auto id = m_global.spawn_thread(fcn_path, ::std::move(arg));
+        LOG_DEBUG("pthread_create(" << thread_handle_out << ", " << fcn_path << ") = " << id);
+        thread_handle_out.m_alloc.alloc().write_usize(thread_handle_out.m_offset, id);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_join" )
+    {
+        auto id = static_cast<unsigned>(args.at(0).read_usize(0));
+        auto it = m_global.m_threads.find(id);
+        // Sleep until the thread finishes (looking it up again after each wake, in case it was joined elsewhere)
+        while( it != m_global.m_threads.end() && !it->second->finished )
+        {
+            m_global.wait_blocked();
+            it = m_global.m_threads.find(id);
+        }
+        if( it == m_global.m_threads.end() )
+        {
+            rv = Value::new_i32(ESRCH);
+        }
+        else
+        {
+            auto& t = *it->second;
+            t.handle.join();
+            if( args.at(1).get_relocation(0) )
             {
-                return false;
+                auto retval_out = args.at(1).read_pointer_valref_mut(0, POINTER_SIZE);
+                retval_out.m_alloc.alloc().write_value(retval_out.m_offset, ::std::move(t.result));
             }
-        }
-        else {
-            //this->m_parent.create_thread(fcn_path, arg);
-            rv = Value::new_i32(EPERM);
+            m_global.m_threads.erase(it);
+            rv = Value::new_i32(0);
         }
     }
     else if( link_name == "pthread_detach" )
     {
         // "detach" - Prevent the need to explitly join a thread
+        // - The host thread is cleaned up when the program exits
         rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_cond_init" || link_name == "pthread_cond_destroy" )
     {
         rv = Value::new_i32(0);
     }
+    else if( link_name == "pthread_cond_wait" || link_name == "pthread_cond_timedwait" )
+    {
+        // Release the mutex and sleep until woken, then re-acquire
+        // - Condition variables may wake spuriously, so waking on any notify (not just a signal of this one) is allowed
+        // - A timed wait only lets other threads run once (a spurious wake), so it can't hang if nothing signals
+        auto key = args.at(1).read_pointer_const(0, 1);
+        auto& s = FfiHelpers::sync_state(m_global, key);
+        LOG_ASSERT(s.count > 0 && s.owner == m_thread.id, link_name << " without holding the mutex");
+        auto count = s.count;
+        s.count = 0;
+        m_global.notify_blocked();
+        if( link_name == "pthread_cond_timedwait" )
+        {
+            m_global.yield();
+        }
+        else
+        {
+            m_global.wait_blocked();
+        }
+        FfiHelpers::lock_exclusive(m_global, key, m_thread.id);
+        FfiHelpers::sync_state(m_global, key).count = count;
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_cond_signal" || link_name == "pthread_cond_broadcast" )
+    {
+        // Wakes all waiters on any condition variable (allowed, as they may wake spuriously)
+        m_global.notify_blocked();
+        rv = Value::new_i32(0);
+    }
     else if( link_name == "pthread_key_create" )
     {
         auto key_ref = args.at(0).read_pointer_valref_mut(0, 4);
@@ -90,6 +90,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
 
         rv = Value::new_usize(found_index);
     }
+    // Atomics: Only the holder of the interpreter lock runs, and it's never released part-way through an intrinsic, so
+    // these plain accesses are already atomic (and sequentially consistent) with respect to other interpreted threads.
+    // NOTE: They aren't host atomics, which is only valid while the interpreter lock serialises all threads.
     else if( name == "atomic_fence" || name == "atomic_fence_acq" )
     {
         rv = Value();
@@ -10,7 +10,9 @@
 #include "lex.hpp"
 #include "value.hpp"
 #include <iostream>
+#include <fstream>
 #include <algorithm>    // std::find
+#include <mmir_index.hpp>
 #include "debug.hpp"
 
 ModuleTree::ModuleTree()
@@ -21,6 +23,10 @@ struct Parser
 {
     ModuleTree& tree;
     Lexer  lex;
+    // Function index for this file (empty if there isn't one), bodies found in it are skipped and loaded on first use
+    mmir_index::View    index;
+    const ::std::string*    index_file = nullptr;
+
     Parser(ModuleTree& tree, const ::std::string& path):
         tree(tree),
         lex(path)
@@ -48,6 +54,25 @@ void ModuleTree::load_file(const ::std::string& path)
     TRACE_FUNCTION_R(path, "");
     auto parse = Parser { *this, path };
 
+    // Load the function index (if present and up to date with the .mir file)
+    ::std::vector<char> index_data;
+    {
+        ::std::ifstream idx_if(path + ".idx", ::std::ios::binary | ::std::ios::ate);
+        if( idx_if.good() )
+        {
+            index_data.resize(idx_if.tellg());
+            idx_if.seekg(0);
+            idx_if.read(index_data.data(), index_data.size());
+            ::std::ifstream mir_if(path, ::std::ios::binary);
+            parse.index = mmir_index::View(index_data.data(), idx_if.good() ? index_data.size() : 0, mir_if);
+            parse.index_file = &*loaded_files.find(path);
+            if( !parse.index.is_valid() )
+            {
+                LOG_NOTICE("Ignoring invalid/stale index " << path << ".idx");
+            }
+        }
+    }
+
     while(parse.parse_one())
     {
         // Keep going!
@@ -63,16 +88,43 @@ void ModuleTree::validate()
     }
 #endif
 
-    for(const auto& fcn : this->functions)
+    for(auto& fcn : this->functions)
     {
-        // TODO: This doesn't actually happen yet (this combination can't be parsed)
-        if( fcn.second.external.link_name != "" && !fcn.second.m_mir.blocks.empty() )
+        if( fcn.second.external.link_name != "" && fcn.second.has_body() )
         {
             LOG_DEBUG(fcn.first << " = '" << fcn.second.external.link_name << "'");
             ext_functions.insert(::std::make_pair( fcn.second.external.link_name, &fcn.second ));
         }
     }
 }
+void ModuleTree::lower_functions()
+{
+    TRACE_FUNCTION_R("", "");
+    m_lower_bodies = true;
+    for(auto& fcn : this->functions)
+    {
+        if( fcn.second.m_mir.blocks.empty() )
+            continue ;
+        fcn.second.m_bytecode = ::std::make_unique<Bytecode::Function>( Bytecode::Function::lower(*this, fcn.second) );
+    }
+}
+// Parse a function body that was skipped by `load_file`
+void ModuleTree::load_body(Function& fcn)
+{
+    if( !fcn.m_lazy_body.file )
+        return ;
+    TRACE_FUNCTION_R(fcn.my_path, "");
+
+    auto parse = Parser { *this, *fcn.m_lazy_body.file };
+    parse.lex.seek(fcn.m_lazy_body.ofs);
+    fcn.m_mir = parse.parse_body();
+    fcn.m_lazy_body = Function::LazyBody {};
+
+    if( m_lower_bodies )
+    {
+        fcn.m_bytecode = ::std::make_unique<Bytecode::Function>( Bytecode::Function::lower(*this, fcn) );
+    }
+}
 // Parse a single item from a .mir file
 bool Parser::parse_one()
 {
@@ -121,10 +173,21 @@ bool Parser::parse_one()
             ext.link_abi = ::std::move(lex.check_consume(TokenClass::String).strval);
         }
         ::MIR::Function body;
+        Function::LazyBody  lazy_body;
+        const mmir_index::FunctionEnt* index_ent = nullptr;
         if( lex.consume_if(';') )
         {
             LOG_DEBUG(lex << "extern fn " << p);
         }
+        else if( lex.next() == '{' && (index_ent = index.find(p.c_str(), p.size())) )
+        {
+            // Indexed, skip the body and parse it on first use
+            lazy_body.file = index_file;
+            lazy_body.ofs = index_ent->body_ofs;
+            lex.seek(index_ent->body_ofs + index_ent->body_len);
+
+            LOG_DEBUG(lex << "fn " << p << " (deferred)");
+        }
         else
         {
             body = parse_body();
@@ -132,7 +195,9 @@ bool Parser::parse_one()
             LOG_DEBUG(lex << "fn " << p);
         }
         auto p2 = p;
-        tree.functions.insert( ::std::make_pair(::std::move(p), Function { ::std::move(p2), ::std::move(arg_tys), rv_ty, ::std::move(ext), ::std::move(body) }) );
+        auto f = Function { ::std::move(p2), ::std::move(arg_tys), rv_ty, ::std::move(ext), ::std::move(body) };
+        f.m_lazy_body = lazy_body;
+        tree.functions.insert( ::std::make_pair(::std::move(p), ::std::move(f)) );
     }
     else if( lex.consume_if("static") )
     {
@@ -1334,31 +1399,34 @@ const DataType* Parser::get_composite(RcString gp)
     return it->second.get();
 }
 
-const Function& ModuleTree::get_function(const HIR::Path& p) const
+const Function& ModuleTree::get_function(const HIR::Path& p)
 {
     auto it = functions.find(p.n);
     if(it == functions.end())
     {
         LOG_ERROR("Unable to find function " << p << " for invoke");
     }
+    load_body(it->second);
     return it->second;
 }
-const Function* ModuleTree::get_function_opt(const HIR::Path& p) const
+const Function* ModuleTree::get_function_opt(const HIR::Path& p)
 {
     auto it = functions.find(p.n);
     if(it == functions.end())
     {
         return nullptr;
     }
+    load_body(it->second);
     return &it->second;
 }
-const Function* ModuleTree::get_ext_function(const char* name) const
+const Function* ModuleTree::get_ext_function(const char* name)
 {
     auto it = ext_functions.find(name);
     if( it == ext_functions.end() )
     {
         return nullptr;
     }
+    load_body(*it->second);
     return it->second;
 }
 const Static& ModuleTree::get_static(const HIR::Path& p) const
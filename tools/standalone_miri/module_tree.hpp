@@ -15,6 +15,7 @@
 #include "../../src/mir/mir.hpp"
 #include "hir_sim.hpp"
 #include "value.hpp"
+#include "bytecode.hpp"
 
 struct Function
 {
@@ -28,6 +29,18 @@ struct Function
         ::std::string   link_abi;
     } external;
     ::MIR::Function m_mir;
+    // Pre-resolved form of `m_mir` (null if not lowered)
+    ::std::unique_ptr<Bytecode::Function>   m_bytecode;
+
+    // Location of the body if parsing it was deferred (using a `.mir.idx` index), see `ModuleTree::load_body`
+    struct LazyBody {
+        const ::std::string*    file = nullptr;
+        uint64_t    ofs = 0;
+    } m_lazy_body;
+
+    bool has_body() const {
+        return !m_mir.blocks.empty() || m_lazy_body.file;
+    }
 };
 struct Static
 {
@@ -77,16 +90,24 @@ class ModuleTree
 
     ::std::set<FunctionType>    function_types; // note: insertion doesn't invaliate pointers.
 
-    ::std::map<RcString, const Function*> ext_functions;
+    ::std::map<RcString, Function*> ext_functions;
+
+    // Set by `lower_functions`, lazily-loaded bodies are lowered when loaded
+    bool    m_lower_bodies = false;
+
+    void load_body(Function& fcn);
 public:
     ModuleTree();
 
     void load_file(const ::std::string& path);
     void validate();
+    // Lower all function bodies to their pre-resolved form (see bytecode.hpp)
+    void lower_functions();
 
-    const Function& get_function(const HIR::Path& p) const;
-    const Function* get_function_opt(const HIR::Path& p) const;
-    const Function* get_ext_function(const char* name) const;
+    // NOTE: These parse the function's body if it hasn't been loaded yet
+    const Function& get_function(const HIR::Path& p);
+    const Function* get_function_opt(const HIR::Path& p);
+    const Function* get_ext_function(const char* name);
 
     const Static& get_static(const HIR::Path& p) const;
     const Static* get_static_opt(const HIR::Path& p) const;
@@ -0,0 +1,132 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * profiler.cpp
+ * - Per-function instruction profiling
+ */
+#include "profiler.hpp"
+#include "module_tree.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+Profiler::Node* Profiler::enter(Node* parent, const Function* fcn)
+{
+    auto& slot = parent->children[fcn];
+    if( !slot )
+    {
+        slot.reset(new Node(fcn, parent));
+    }
+    slot->calls += 1;
+    return slot.get();
+}
+
+namespace {
+    struct FunctionTotals
+    {
+        uint64_t    instructions_excl = 0;
+        uint64_t    instructions_incl = 0;
+        uint64_t    allocations_excl = 0;
+        uint64_t    allocations_incl = 0;
+        uint64_t    calls = 0;
+    };
+    struct SubtreeTotals
+    {
+        uint64_t    instructions;
+        uint64_t    allocations;
+    };
+
+    // Accumulate per-function totals for the subtree at `node`, and write its folded stacks
+    // - `active` counts the instances of each function on the current stack, so that recursive calls are only counted
+    //   once in the inclusive totals
+    SubtreeTotals walk(
+        const Profiler::Node& node,
+        ::std::string& stack,
+        ::std::map<const Function*, unsigned>& active,
+        ::std::map<const Function*, FunctionTotals>& totals,
+        ::std::ostream& folded
+        )
+    {
+        auto stack_len = stack.size();
+        if( !stack.empty() )
+            stack += ';';
+        stack += node.fcn->my_path.c_str();
+        if( node.instructions > 0 )
+        {
+            folded << stack << " " << node.instructions << "\n";
+        }
+
+        SubtreeTotals   rv { node.instructions, node.allocations };
+        auto& count = active[node.fcn];
+        count += 1;
+        for(const auto& c : node.children)
+        {
+            auto t = walk(*c.second, stack, active, totals, folded);
+            rv.instructions += t.instructions;
+            rv.allocations += t.allocations;
+        }
+        count -= 1;
+
+        auto& ft = totals[node.fcn];
+        ft.instructions_excl += node.instructions;
+        ft.allocations_excl += node.allocations;
+        ft.calls += node.calls;
+        if( count == 0 )
+        {
+            ft.instructions_incl += rv.instructions;
+            ft.allocations_incl += rv.allocations;
+        }
+
+        stack.resize(stack_len);
+        return rv;
+    }
+}
+
+void Profiler::write(const ::std::string& path) const
+{
+    ::std::ofstream folded(path + ".folded");
+    if( !folded.good() )
+    {
+        ::std::cerr << "Unable to open " << path << ".folded for writing" << ::std::endl;
+        return ;
+    }
+
+    ::std::map<const Function*, FunctionTotals>  totals;
+    {
+        ::std::string   stack;
+        ::std::map<const Function*, unsigned>    active;
+        for(const auto& c : m_root.children)
+        {
+            walk(*c.second, stack, active, totals, folded);
+        }
+    }
+
+    ::std::ofstream os(path);
+    if( !os.good() )
+    {
+        ::std::cerr << "Unable to open " << path << " for writing" << ::std::endl;
+        return ;
+    }
+    // Most expensive (by own instructions) first, ties broken by name so the output is stable
+    ::std::vector<::std::pair<const Function*, FunctionTotals>>    sorted(totals.begin(), totals.end());
+    ::std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        if( a.second.instructions_excl != b.second.instructions_excl )
+            return a.second.instructions_excl > b.second.instructions_excl;
+        return a.first->my_path < b.first->my_path;
+        });
+    // NOTE: Tab-separated with a header line, for use with `sort -t$'\t' -k<n>` and spreadsheets
+    os << "instructions_excl\tinstructions_incl\tallocations_excl\tallocations_incl\tcalls\tfunction\n";
+    for(const auto& e : sorted)
+    {
+        const auto& t = e.second;
+        os << t.instructions_excl
+            << "\t" << t.instructions_incl
+            << "\t" << t.allocations_excl
+            << "\t" << t.allocations_incl
+            << "\t" << t.calls
+            << "\t" << e.first->my_path
+            << "\n";
+    }
+}
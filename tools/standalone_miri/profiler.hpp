@@ -0,0 +1,47 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * profiler.hpp
+ * - Per-function instruction profiling (HEADER)
+ */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+struct Function;
+
+/// Call tree of executed instructions, written out as a per-function summary and as folded stacks (for flamegraphs)
+class Profiler
+{
+public:
+    /// A function at a particular call stack
+    struct Node
+    {
+        const Function* fcn;
+        Node*   parent;
+        ::std::map<const Function*, ::std::unique_ptr<Node>>  children;
+
+        /// Instructions executed in this function (excluding callees)
+        uint64_t    instructions = 0;
+        /// Allocations made by those instructions
+        uint64_t    allocations = 0;
+        /// Number of times this function was called from the parent
+        uint64_t    calls = 0;
+
+        Node(const Function* fcn, Node* parent): fcn(fcn), parent(parent) {}
+    };
+private:
+    Node    m_root;
+public:
+    Profiler(): m_root(nullptr, nullptr) {}
+
+    Node* root() { return &m_root; }
+    /// Record a call to `fcn` from `parent`, returning the node for the callee
+    Node* enter(Node* parent, const Function* fcn);
+
+    /// Write the per-function summary (tab-separated) to `path`, and the folded stacks to `path`.folded
+    void write(const ::std::string& path) const;
+};
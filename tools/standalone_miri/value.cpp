@@ -36,12 +36,21 @@ namespace {
     }
     void copy_bits(uint8_t* dst, size_t dst_ofs, const uint8_t* src, size_t src_ofs,  size_t len)
     {
-        // Even number of bytes, fast copy
-        if( dst_ofs % 8 == 0 && src_ofs % 8 == 0 && len % 8 == 0 )
+        // Same alignment, copy whole bytes in one go
+        if( dst_ofs % 8 == src_ofs % 8 )
         {
-            for(size_t i = 0; i < len/8; i ++)
+            // Leading bits, up to a byte boundary
+            while( len > 0 && dst_ofs % 8 != 0 )
             {
-                dst[dst_ofs/8 + i] = src[src_ofs/8 + i];
+                set_bit( dst, dst_ofs, get_bit(src, src_ofs) );
+                dst_ofs ++;
+                src_ofs ++;
+                len --;
+            }
+            ::std::memcpy(dst + dst_ofs/8, src + src_ofs/8, len/8);
+            for(size_t i = len & ~size_t(7); i < len; i ++)
+            {
+                set_bit( dst, dst_ofs+i, get_bit(src, src_ofs+i) );
             }
         }
         else
@@ -52,6 +61,52 @@ namespace {
             }
         }
     }
+    // Check that bits `ofs .. ofs+len` are all set (a 64-bit word at a time where possible)
+    bool all_bits_set(const uint8_t* p, size_t ofs, size_t len)
+    {
+        while( len > 0 && ofs % 8 != 0 )
+        {
+            if( !get_bit(p, ofs) )
+                return false;
+            ofs ++;
+            len --;
+        }
+        const uint8_t* bp = p + ofs/8;
+        size_t nbytes = len / 8;
+        for(; nbytes >= 8; nbytes -= 8, bp += 8)
+        {
+            uint64_t w;
+            ::std::memcpy(&w, bp, 8);
+            if( w != UINT64_MAX )
+                return false;
+        }
+        for(; nbytes > 0; nbytes --, bp ++)
+        {
+            if( *bp != 0xFF )
+                return false;
+        }
+        for(size_t i = len & ~size_t(7); i < len; i ++)
+        {
+            if( !get_bit(p, ofs + i) )
+                return false;
+        }
+        return true;
+    }
+    // Set bits `ofs .. ofs+len`
+    void set_bits(uint8_t* p, size_t ofs, size_t len)
+    {
+        while( len > 0 && ofs % 8 != 0 )
+        {
+            set_bit(p, ofs, true);
+            ofs ++;
+            len --;
+        }
+        ::std::memset(p + ofs/8, 0xFF, len/8);
+        for(size_t i = len & ~size_t(7); i < len; i ++)
+        {
+            set_bit(p, ofs + i, true);
+        }
+    }
 };
 
 ::std::ostream& operator<<(::std::ostream& os, const Allocation* x)
@@ -93,20 +148,52 @@ bool FfiLayout::is_valid_read(size_t o, size_t s) const
 }
 
 uint64_t Allocation::s_next_index = 0;
+::std::vector<Allocation*>  Allocation::s_pool;
+
+namespace {
+    // Allocations up to this size are returned to the pool when released (keeping their storage)
+    const size_t POOL_MAX_SIZE = 64;
+    const size_t POOL_MAX_COUNT = 4096;
+}
 
 AllocationHandle Allocation::new_alloc(size_t size, ::std::string tag)
 {
-    Allocation* rv = new Allocation();
+    Allocation* rv;
+    if( size <= POOL_MAX_SIZE && !s_pool.empty() )
+    {
+        rv = s_pool.back();
+        s_pool.pop_back();
+        rv->is_freed = false;
+        rv->m_data.assign( (size + 8-1) / 8, 0 );
+        rv->m_mask.assign( (size + 8-1) / 8, 0 );
+    }
+    else
+    {
+        rv = new Allocation();
+        rv->m_data.resize( (size + 8-1) / 8 );    // QWORDS
+        rv->m_mask.resize( (size + 8-1) / 8 );    // bitmap bytes
+    }
     rv->m_index = s_next_index++;
     rv->m_tag = ::std::move(tag);
     rv->refcount = 1;
     rv->m_size = size;
-    rv->m_data.resize( (size + 8-1) / 8 );    // QWORDS
-    rv->m_mask.resize( (size + 8-1) / 8 );    // bitmap bytes
     //LOG_DEBUG(rv << " ALLOC");
     LOG_DEBUG(rv);
     return AllocationHandle(rv);
 }
+void Allocation::release(Allocation* a)
+{
+    if( a->m_size <= POOL_MAX_SIZE && s_pool.size() < POOL_MAX_COUNT )
+    {
+        // NOTE: Relocations are cleared now, so the allocations they reference are released immediately
+        a->relocations.clear();
+        s_pool.push_back(a);
+    }
+    else
+    {
+        delete a;
+    }
+}
 AllocationHandle::AllocationHandle(const AllocationHandle& x):
     m_ptr(x.m_ptr)
 {
@@ -126,7 +213,7 @@ AllocationHandle::~AllocationHandle()
         //LOG_DEBUG(m_ptr << " REF-- " << m_ptr->refcount);
         if(m_ptr->refcount == 0)
         {
-            delete m_ptr;
+            Allocation::release(m_ptr);
         }
     }
 }
@@ -277,7 +364,7 @@ void ValueCommonWrite::write_usize(size_t ofs, uint64_t v)
 {
     this->write_bytes(ofs, &v, POINTER_SIZE);
 }
-const ::HIR::Path& ValueCommonRead::read_pointer_fcn(size_t rd_ofs) const
+::HIR::Path ValueCommonRead::read_pointer_fcn(size_t rd_ofs) const
 {
     auto reloc = get_relocation(rd_ofs);
     auto ofs = read_usize(rd_ofs);
@@ -430,22 +517,16 @@ void Allocation::check_bytes_valid(size_t ofs, size_t size) const
     if( !in_bounds(ofs, size, this->size()) ) {
         LOG_FATAL("Out of range - " << ofs << "+" << size << " > " << this->size());
     }
-    for(size_t i = ofs; i < ofs + size; i++)
+    if( !all_bits_set(this->m_mask.data(), ofs, size) )
     {
-        if( !(this->m_mask[i/8] & (1 << (i%8))) )
-        {
-            LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
-            throw "ERROR";
-        }
+        LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
+        throw "ERROR";
     }
 }
 void Allocation::mark_bytes_valid(size_t ofs, size_t size)
 {
     assert( ofs+size <= this->m_mask.size() * 8 );
-    for(size_t i = ofs; i < ofs + size; i++)
-    {
-        this->m_mask[i/8] |= (1 << (i%8));
-    }
+    set_bits(this->m_mask.data(), ofs, size);
 }
 Value Allocation::read_value(size_t ofs, size_t size) const
 {
@@ -457,26 +538,16 @@ Value Allocation::read_value(size_t ofs, size_t size) const
     LOG_ASSERT( in_bounds(ofs, size, this->size()), "Read out of bounds (" << ofs << "+" << size << " > " << this->size() << ")" );
 
     // Determine if this can become an inline allocation.
-    bool has_reloc = false;
-    for(const auto& r : this->relocations)
-    {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            // NOTE: A relocation at offset zero is allowed
-            if( r.slot_ofs == ofs )
-                continue ;
-            has_reloc = true;
-        }
-    }
+    // NOTE: A relocation at offset zero is allowed
+    auto relocs_begin = reloc_lower(ofs);
+    auto relocs_end = ::std::find_if(relocs_begin, relocations.cend(), [&](const Relocation& r){ return r.slot_ofs >= ofs + size; });
+    bool has_reloc = relocs_end - relocs_begin > (relocs_begin != relocs_end && relocs_begin->slot_ofs == ofs ? 1 : 0);
     rv = Value::with_size(size, has_reloc);
     rv.write_bytes(0, this->data_ptr() + ofs, size);
 
-    for(const auto& r : this->relocations)
+    for(auto it = relocs_begin; it != relocs_end; ++it)
     {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            rv.set_reloc(r.slot_ofs - ofs, /*r.size*/POINTER_SIZE, r.backing_alloc);
-        }
+        rv.set_reloc(it->slot_ofs - ofs, /*r.size*/POINTER_SIZE, it->backing_alloc);
     }
     // Copy the mask bits
     copy_bits(rv.get_mask_mut(), 0, m_mask.data(), ofs, size);
@@ -530,7 +601,7 @@ void Allocation::write_value(size_t ofs, Value v)
             {
                 //LOG_TRACE("Insert " << r.backing_alloc);
                 r.slot_ofs += ofs;
-                this->relocations.push_back( ::std::move(r) );
+                this->insert_reloc( ::std::move(r) );
             }
         }
 
@@ -566,19 +637,7 @@ void Allocation::write_bytes(size_t ofs, const void* src, size_t count)
 
 
     // - Remove any relocations already within this region
-    auto& this_relocs = this->relocations;
-    for(auto it = this_relocs.begin(); it != this_relocs.end(); )
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + count)
-        {
-            //LOG_TRACE("Delete " << it->backing_alloc);
-            it = this_relocs.erase(it);
-        }
-        else 
-        {
-            ++it;
-        }
-    }
+    this->erase_relocs(ofs, count);
 
     ::std::memcpy(this->data_ptr() + ofs, src, count);
     mark_bytes_valid(ofs, count);
@@ -594,20 +653,10 @@ void Allocation::set_reloc(size_t ofs, size_t len, RelocationPtr reloc)
     LOG_ASSERT(ofs % POINTER_SIZE == 0, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
     LOG_ASSERT(len == POINTER_SIZE, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
     // Delete any existing relocation at this position
-    for(auto it = this->relocations.begin(); it != this->relocations.end();)
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + len )
-        {
-            // Slot starts in this updated region
-            // - TODO: Split in half?
-            it = this->relocations.erase(it);
-            continue ;
-        }
-        // TODO: What if the slot ends in the new region?
-        // What if the new region is in the middle of the slot
-        ++ it;
-    }
-    this->relocations.push_back(Relocation { ofs, /*len,*/ ::std::move(reloc) });
+    // - TODO: What if the slot ends in the new region?
+    //   What if the new region is in the middle of the slot
+    this->erase_relocs(ofs, len);
+    this->insert_reloc(Relocation { ofs, /*len,*/ ::std::move(reloc) });
 }
 ::std::ostream& operator<<(::std::ostream& os, const Allocation& x)
 {
@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <memory>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>	// memcpy
 #include <cassert>
@@ -239,7 +240,7 @@ struct ValueCommonRead
     }
 
     /// Read a pointer that should be a function pointer
-    const ::HIR::Path& read_pointer_fcn(size_t rd_ofs) const;
+    ::HIR::Path read_pointer_fcn(size_t rd_ofs) const;
     /// Read a pointer that must be FFI with the specified tag (or NULL)
     void* read_pointer_tagged_null(size_t rd_ofs, const char* tag) const;
     /// Read a pointer that must be FFI with the specified tag (cannot be NULL)
@@ -299,7 +300,11 @@ class Allocation:
 {
     friend class AllocationHandle;
 
+    // NOTE: The counters, pool, and refcounts aren't synchronised, as they're only used by the thread holding the
+    // interpreter lock (see `GlobalState::m_lock`)
     static uint64_t s_next_index;
+    // Released small allocations, reused by `new_alloc` to avoid re-allocating their storage
+    static ::std::vector<Allocation*>   s_pool;
 
     ::std::string   m_tag;
     size_t  refcount;
@@ -310,11 +315,32 @@ class Allocation:
 
     ::std::vector<uint64_t> m_data;
 public:
+    // Validity bitmap, one bit per byte
     ::std::vector<uint8_t> m_mask;
+    // Sorted by `slot_ofs`
     ::std::vector<Relocation>   relocations;
 public:
     virtual ~Allocation() {}
     static AllocationHandle new_alloc(size_t size, ::std::string tag);
+    /// Number of allocations made so far
+    static uint64_t total_count() { return s_next_index; }
+private:
+    // Called when the last handle is dropped
+    static void release(Allocation* a);
+
+    // Range of `relocations` with `ofs <= slot_ofs < ofs + len`
+    ::std::vector<Relocation>::const_iterator reloc_lower(size_t ofs) const {
+        return ::std::lower_bound(relocations.begin(), relocations.end(), ofs, [](const Relocation& r, size_t o){ return r.slot_ofs < o; });
+    }
+    void erase_relocs(size_t ofs, size_t len) {
+        auto b = reloc_lower(ofs);
+        auto e = ::std::find_if(b, relocations.cend(), [&](const Relocation& r){ return r.slot_ofs >= ofs + len; });
+        relocations.erase(b, e);
+    }
+    void insert_reloc(Relocation r) {
+        relocations.insert(reloc_lower(r.slot_ofs), ::std::move(r));
+    }
+public:
 
     const uint8_t* data_ptr() const { return reinterpret_cast<const uint8_t*>(this->m_data.data()); }
           uint8_t* data_ptr()       { return reinterpret_cast<      uint8_t*>(this->m_data.data()); }
@@ -322,10 +348,9 @@ public:
     const ::std::string& tag() const { return m_tag; }
 
     RelocationPtr get_relocation(size_t ofs) const override {
-        for(const auto& r : relocations) {
-            if(r.slot_ofs == ofs)
-                return r.backing_alloc;
-        }
+        auto it = reloc_lower(ofs);
+        if( it != relocations.end() && it->slot_ofs == ofs )
+            return it->backing_alloc;
         return RelocationPtr();
     }
     void mark_as_freed() {